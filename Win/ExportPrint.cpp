@@ -38,65 +38,65 @@ static int prevPhysMaterial;
 static int curPhysMaterial;
 static HINSTANCE g_hInst;
 
-// OBJ, OBJ, USD, MAGICS STL, VISCAM STL, ASCII STL, VRML2, SCHEMATIC
+// OBJ, OBJ, USD, MAGICS STL, VISCAM STL, ASCII STL, VRML2, SCHEMATIC, GLTF
 #define EP_TOOLTIP_COUNT 56
 TooltipDefinition g_epTT[EP_TOOLTIP_COUNT] = {
-    { IDC_WORLD_MIN_X,      {1,1,1,1,1,1,1,1}, L"Western edge of volume exported", L""},
-    { IDC_WORLD_MIN_Y,      {1,1,1,1,1,1,1,1}, L"Lower bound of volume exported", L""},
-    { IDC_WORLD_MIN_Z,      {1,1,1,1,1,1,1,1}, L"Northern edge of volume exported", L""},
-    { IDC_WORLD_MAX_X,      {1,1,1,1,1,1,1,1}, L"Eastern edge of volume exported", L""},
-    { IDC_WORLD_MAX_Y,      {1,1,1,1,1,1,1,1}, L"Upper bound of volume exported", L""},
-    { IDC_WORLD_MAX_Z,      {1,1,1,1,1,1,1,1}, L"Southern edge of volume exported", L""},
-    { IDC_CREATE_ZIP,       {1,1,1,1,1,1,1,1}, L"Put all exported files in a corresponding ZIP file", L""},
-    { IDC_CREATE_FILES,     {1,1,1,1,1,1,1,1}, L"If unchecked, files are deleted after being put in a ZIP file", L""},
-    { IDC_RADIO_EXPORT_NO_MATERIALS,        {1,1,0,1,1,1,1,0}, L"No materials are exported", L""},
-    { IDC_RADIO_EXPORT_MTL_COLORS_ONLY,     {1,1,0,2,2,0,1,0}, L"Solid colors are exported, with no textures", L"Solid colors are exported"},
-    { IDC_RADIO_EXPORT_SOLID_TEXTURES,      {1,1,1,0,0,0,1,0}, L"Solid 'noisy' textures are exported", L""},
-    { IDC_RADIO_EXPORT_MOSAIC_TEXTURES,     {1,1,2,0,0,0,1,0}, L"Three large, mosaic textures of all blocks are exported; useful for 3D printing, not great for rendering", L"For USD, one large, mosaic texture of all blocks is exported"},
-    { IDC_RADIO_EXPORT_SEPARATE_TILES,      {1,1,1,0,0,0,0,0}, L"Separate textures are exported for each block face, as needed", L""},
-    { IDC_TILE_DIR,         {1,1,2,0,0,0,1,0}, L"Textures are put in a subdirectory called this (delete the name for no subdirectory, putting the textures in the same directory)", L"In the '*_materials' subdirectory, textures are put in a subdirectory called this (delete the name for no subdirectory, putting the textures in the same directory)"},
-    { IDC_TEXTURE_RGB,      {1,1,1,0,0,0,1,0}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
-    { IDC_TEXTURE_A,        {1,1,1,0,0,0,1,0}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
-    { IDC_TEXTURE_RGBA,     {1,1,1,0,0,0,1,0}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
-    { IDC_SCALE_LIGHTS,     {0,0,1,0,0,0,0,0}, L"The relative brightness of the sun and dome lights", L""},
-    { IDC_SCALE_EMITTERS,   {0,0,1,0,0,0,0,0}, L"The relative brightness of emissive blocks such as torches and lava", L""},
-    { IDC_SEPARATE_TYPES,   {1,1,0,0,0,0,0,0}, L"Each type of block - stone, logs, fences, and so on - are put in a separate group", L""},
-    { IDC_INDIVIDUAL_BLOCKS,{1,1,1,0,0,0,0,0}, L"All faces of every block are output. Useful if you are animating blocks; you may also then want to 'Make groups objects', below.", L""},
-    { IDC_MATERIAL_PER_BLOCK_FAMILY,{1,1,0,0,0,0,0,0}, L"For mosaic texures only: if unchecked, a single material is shared by **all** blocks. Rarely a good idea.", L""},
-    { IDC_SPLIT_BY_BLOCK_TYPE,  {1,1,0,0,0,0,0,0}, L"Checked, every type of block has a separate material. Unchecked, blocks in a 'family' (such as 'planks') share a single material.", L""},
-    { IDC_MAKE_GROUPS_OBJECTS,  {1,1,0,0,0,0,0,0}, L"Checked, there is one object. Unchecked, each OBJ group is a separate object; useful for animation.", L""},
-    { IDC_G3D_MATERIAL,     {1,1,2,0,0,0,0,0}, L"Output extended PBR materials and textures, such as roughness, normals, and emission, as available", L"Use custom 'blocky' shaders for MDL. Uncheck if your textures are high resolution."},
-    { IDC_EXPORT_MDL,       {0,0,1,0,0,0,0,0}, L"Export MDL shaders. Unchecked means export only UsdPreviewSurface materials.", L""},
-    { IDC_MAKE_Z_UP,        {1,1,1,1,1,1,1,1}, L"The Y axis is up by default; check to instead use Z as the up direction", L""},
-    { IDC_SIMPLIFY_MESH,    {1,1,1,0,0,0,0,0}, L"Check to reduce the polygon count, as possible. Downside is that textures are not randomly rotated on grass, etc., to break up pattern repetition.", L""},
-    { IDC_CENTER_MODEL,     {1,1,1,1,1,1,1,1}, L"Checked means model is roughly centered around (0,0,0); unchecked means use the world's coordinates", L""},
-    { IDC_BIOME,            {1,1,1,1,1,1,1,0}, L"The biome at the center of the model is applied to the whole model, likely changing its coloration", L""},
-    { IDC_BLOCKS_AT_BORDERS,{1,1,1,1,1,1,1,0}, L"Unchecked means the bottoms and sides of blocks at the edge of the volume selected are not exported, reducing polygon count", L""},
-    { IDC_TREE_LEAVES_SOLID,{1,1,1,0,0,0,1,0}, L"Checked means use solid, non-transparent textures for leaves, so reducing polygon count", L""},
-    { IDC_RADIO_SCALE_TO_HEIGHT,    {1,1,1,1,1,1,1,0}, L"Normally for 3D printing, specify the height of the model", L""},
-    { IDC_MODEL_HEIGHT,     {1,1,1,1,1,1,1,0}, L"Normally for 3D printing, specify the height of the model", L""},
-    { IDC_RADIO_SCALE_TO_MATERIAL,  {1,1,1,1,1,1,1,0}, L"For 3D printing, absolutely minimize the size of the model for the material", L""},
-    { IDC_RADIO_SCALE_BY_BLOCK, {1,1,1,1,1,1,1,0}, L"For rendering and 3D printing, change the size of a block", L""},
-    { IDC_BLOCK_SIZE,       {1,1,1,1,1,1,1,0}, L"For rendering and 3D printing, change the size of a block", L""},
-    { IDC_RADIO_SCALE_BY_COST,  {1,1,1,1,1,1,1,0}, L"For 3D printing, aim for a (very) approximate cost", L""},
-    { IDC_COST,             {1,1,1,1,1,1,1,0}, L"For 3D printing, aim for a (very) approximate cost", L""},
-    { IDC_FILL_BUBBLES,   {1,1,1,1,1,1,1,0}, L"Any hollow volume is filled with solid material", L""},
-    { IDC_SEAL_ENTRANCES, {1,1,1,1,1,1,1,0}, L"Suboption to fill in the insides of buildings", L""},
-    { IDC_SEAL_SIDE_TUNNELS,  {1,1,1,1,1,1,1,0}, L"Suboption to fill in isolated tunnels", L""},
-    { IDC_CONNECT_PARTS,  {1,1,1,1,1,1,1,0}, L"For 3D printing, connect neighboring blocks if needed", L""},
-    { IDC_CONNECT_CORNER_TIPS,{1,1,1,1,1,1,1,0}, L"Suboption to connect separate objects touching at just a point", L""},
-    { IDC_CONNECT_ALL_EDGES,  {1,1,1,1,1,1,1,0}, L"Suboption to connect all shared edges", L""},
-    { IDC_DELETE_FLOATERS,{1,1,1,1,1,1,1,0}, L"Delete small objects floating in space, unconnected to the main model", L""},
-    { IDC_FLOAT_COUNT,    {1,1,1,1,1,1,1,0}, L"Size of small objects in blocks", L""},
-    { IDC_HOLLOW,         {1,1,1,1,1,1,1,0}, L"For 3D printing, hollow out the bottom of the model to save material", L""},
-    { IDC_HOLLOW_THICKNESS,   {1,1,1,1,1,1,1,0}, L"For 3D printing, how thick to make walls when hollowing", L""},
-    { IDC_SUPER_HOLLOW,   {1,1,1,1,1,1,1,0}, L"Be more aggressive in hollowing out volumes", L""},
-    { IDC_MELT_SNOW,      {1,1,1,1,1,1,1,0}, L"For 3D printing, melt snow blocks (for sealing entrances)", L""},
-    { IDC_EXPORT_ALL,     {1,1,1,1,1,1,1,0}, L"For 3D printing, export more precise versions of partial blocks", L""},
-    { IDC_FATTEN,         {1,1,1,1,1,1,1,0}, L"Suboption to make the partial blocks thicker, to print better", L""},
-    { IDC_COMPOSITE_OVERLAY,{1,1,1,0,0,0,1,0}, L"If checked, vines, ladders, rails, etc. are composited onto the underlying texture, creating a new texture. Mostly needed for 3D printing.", L""},
-    { IDC_SHOW_PARTS,     {1,1,1,1,1,0,1,0}, L"For 3D printing, show separated parts in different colors", L""},
-    { IDC_SHOW_WELDS,     {1,1,1,1,1,0,1,0}, L"For 3D printing, show blocks Mineways adds to connect objects", L""},
+    { IDC_WORLD_MIN_X,      {1,1,1,1,1,1,1,1,1}, L"Western edge of volume exported", L""},
+    { IDC_WORLD_MIN_Y,      {1,1,1,1,1,1,1,1,1}, L"Lower bound of volume exported", L""},
+    { IDC_WORLD_MIN_Z,      {1,1,1,1,1,1,1,1,1}, L"Northern edge of volume exported", L""},
+    { IDC_WORLD_MAX_X,      {1,1,1,1,1,1,1,1,1}, L"Eastern edge of volume exported", L""},
+    { IDC_WORLD_MAX_Y,      {1,1,1,1,1,1,1,1,1}, L"Upper bound of volume exported", L""},
+    { IDC_WORLD_MAX_Z,      {1,1,1,1,1,1,1,1,1}, L"Southern edge of volume exported", L""},
+    { IDC_CREATE_ZIP,       {1,1,1,1,1,1,1,1,1}, L"Put all exported files in a corresponding ZIP file", L""},
+    { IDC_CREATE_FILES,     {1,1,1,1,1,1,1,1,1}, L"If unchecked, files are deleted after being put in a ZIP file", L""},
+    { IDC_RADIO_EXPORT_NO_MATERIALS,        {1,1,0,1,1,1,1,0,1}, L"No materials are exported", L""},
+    { IDC_RADIO_EXPORT_MTL_COLORS_ONLY,     {1,1,0,2,2,0,1,0,1}, L"Solid colors are exported, with no textures", L"Solid colors are exported"},
+    { IDC_RADIO_EXPORT_SOLID_TEXTURES,      {1,1,1,0,0,0,1,0,1}, L"Solid 'noisy' textures are exported", L""},
+    { IDC_RADIO_EXPORT_MOSAIC_TEXTURES,     {1,1,2,0,0,0,1,0,1}, L"Three large, mosaic textures of all blocks are exported; useful for 3D printing, not great for rendering", L"For USD, one large, mosaic texture of all blocks is exported"},
+    { IDC_RADIO_EXPORT_SEPARATE_TILES,      {1,1,1,0,0,0,0,0,1}, L"Separate textures are exported for each block face, as needed", L""},
+    { IDC_TILE_DIR,         {1,1,2,0,0,0,1,0,1}, L"Textures are put in a subdirectory called this (delete the name for no subdirectory, putting the textures in the same directory)", L"In the '*_materials' subdirectory, textures are put in a subdirectory called this (delete the name for no subdirectory, putting the textures in the same directory)"},
+    { IDC_TEXTURE_RGB,      {1,1,1,0,0,0,1,0,1}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
+    { IDC_TEXTURE_A,        {1,1,1,0,0,0,1,0,1}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
+    { IDC_TEXTURE_RGBA,     {1,1,1,0,0,0,1,0,1}, L"If you previously exported textures for this model, you can save time by unchecking these", L""},
+    { IDC_SCALE_LIGHTS,     {0,0,1,0,0,0,0,0,0}, L"The relative brightness of the sun and dome lights", L""},
+    { IDC_SCALE_EMITTERS,   {0,0,1,0,0,0,0,0,0}, L"The relative brightness of emissive blocks such as torches and lava", L""},
+    { IDC_SEPARATE_TYPES,   {1,1,0,0,0,0,0,0,0}, L"Each type of block - stone, logs, fences, and so on - are put in a separate group", L""},
+    { IDC_INDIVIDUAL_BLOCKS,{1,1,1,0,0,0,0,0,0}, L"All faces of every block are output. Useful if you are animating blocks; you may also then want to 'Make groups objects', below.", L""},
+    { IDC_MATERIAL_PER_BLOCK_FAMILY,{1,1,0,0,0,0,0,0,0}, L"For mosaic texures only: if unchecked, a single material is shared by **all** blocks. Rarely a good idea.", L""},
+    { IDC_SPLIT_BY_BLOCK_TYPE,  {1,1,0,0,0,0,0,0,0}, L"Checked, every type of block has a separate material. Unchecked, blocks in a 'family' (such as 'planks') share a single material.", L""},
+    { IDC_MAKE_GROUPS_OBJECTS,  {1,1,0,0,0,0,0,0,0}, L"Checked, there is one object. Unchecked, each OBJ group is a separate object; useful for animation.", L""},
+    { IDC_G3D_MATERIAL,     {1,1,2,0,0,0,0,0,0}, L"Output extended PBR materials and textures, such as roughness, normals, and emission, as available", L"Use custom 'blocky' shaders for MDL. Uncheck if your textures are high resolution."},
+    { IDC_EXPORT_MDL,       {0,0,1,0,0,0,0,0,0}, L"Export MDL shaders. Unchecked means export only UsdPreviewSurface materials.", L""},
+    { IDC_MAKE_Z_UP,        {1,1,1,1,1,1,1,1,0}, L"The Y axis is up by default; check to instead use Z as the up direction", L""},
+    { IDC_SIMPLIFY_MESH,    {1,1,1,0,0,0,0,0,1}, L"Check to reduce the polygon count, as possible. Downside is that textures are not randomly rotated on grass, etc., to break up pattern repetition.", L""},
+    { IDC_CENTER_MODEL,     {1,1,1,1,1,1,1,1,1}, L"Checked means model is roughly centered around (0,0,0); unchecked means use the world's coordinates", L""},
+    { IDC_BIOME,            {1,1,1,1,1,1,1,0,1}, L"The biome at the center of the model is applied to the whole model, likely changing its coloration", L""},
+    { IDC_BLOCKS_AT_BORDERS,{1,1,1,1,1,1,1,0,1}, L"Unchecked means the bottoms and sides of blocks at the edge of the volume selected are not exported, reducing polygon count", L""},
+    { IDC_TREE_LEAVES_SOLID,{1,1,1,0,0,0,1,0,1}, L"Checked means use solid, non-transparent textures for leaves, so reducing polygon count", L""},
+    { IDC_RADIO_SCALE_TO_HEIGHT,    {1,1,1,1,1,1,1,0,1}, L"Normally for 3D printing, specify the height of the model", L""},
+    { IDC_MODEL_HEIGHT,     {1,1,1,1,1,1,1,0,1}, L"Normally for 3D printing, specify the height of the model", L""},
+    { IDC_RADIO_SCALE_TO_MATERIAL,  {1,1,1,1,1,1,1,0,1}, L"For 3D printing, absolutely minimize the size of the model for the material", L""},
+    { IDC_RADIO_SCALE_BY_BLOCK, {1,1,1,1,1,1,1,0,1}, L"For rendering and 3D printing, change the size of a block", L""},
+    { IDC_BLOCK_SIZE,       {1,1,1,1,1,1,1,0,1}, L"For rendering and 3D printing, change the size of a block", L""},
+    { IDC_RADIO_SCALE_BY_COST,  {1,1,1,1,1,1,1,0,1}, L"For 3D printing, aim for a (very) approximate cost", L""},
+    { IDC_COST,             {1,1,1,1,1,1,1,0,1}, L"For 3D printing, aim for a (very) approximate cost", L""},
+    { IDC_FILL_BUBBLES,   {1,1,1,1,1,1,1,0,1}, L"Any hollow volume is filled with solid material", L""},
+    { IDC_SEAL_ENTRANCES, {1,1,1,1,1,1,1,0,1}, L"Suboption to fill in the insides of buildings", L""},
+    { IDC_SEAL_SIDE_TUNNELS,  {1,1,1,1,1,1,1,0,1}, L"Suboption to fill in isolated tunnels", L""},
+    { IDC_CONNECT_PARTS,  {1,1,1,1,1,1,1,0,1}, L"For 3D printing, connect neighboring blocks if needed", L""},
+    { IDC_CONNECT_CORNER_TIPS,{1,1,1,1,1,1,1,0,1}, L"Suboption to connect separate objects touching at just a point", L""},
+    { IDC_CONNECT_ALL_EDGES,  {1,1,1,1,1,1,1,0,1}, L"Suboption to connect all shared edges", L""},
+    { IDC_DELETE_FLOATERS,{1,1,1,1,1,1,1,0,1}, L"Delete small objects floating in space, unconnected to the main model", L""},
+    { IDC_FLOAT_COUNT,    {1,1,1,1,1,1,1,0,1}, L"Size of small objects in blocks", L""},
+    { IDC_HOLLOW,         {1,1,1,1,1,1,1,0,1}, L"For 3D printing, hollow out the bottom of the model to save material", L""},
+    { IDC_HOLLOW_THICKNESS,   {1,1,1,1,1,1,1,0,1}, L"For 3D printing, how thick to make walls when hollowing", L""},
+    { IDC_SUPER_HOLLOW,   {1,1,1,1,1,1,1,0,1}, L"Be more aggressive in hollowing out volumes", L""},
+    { IDC_MELT_SNOW,      {1,1,1,1,1,1,1,0,1}, L"For 3D printing, melt snow blocks (for sealing entrances)", L""},
+    { IDC_EXPORT_ALL,     {1,1,1,1,1,1,1,0,1}, L"For 3D printing, export more precise versions of partial blocks", L""},
+    { IDC_FATTEN,         {1,1,1,1,1,1,1,0,1}, L"Suboption to make the partial blocks thicker, to print better", L""},
+    { IDC_COMPOSITE_OVERLAY,{1,1,1,0,0,0,1,0,1}, L"If checked, vines, ladders, rails, etc. are composited onto the underlying texture, creating a new texture. Mostly needed for 3D printing.", L""},
+    { IDC_SHOW_PARTS,     {1,1,1,1,1,0,1,0,1}, L"For 3D printing, show separated parts in different colors", L""},
+    { IDC_SHOW_WELDS,     {1,1,1,1,1,0,1,0,1}, L"For 3D printing, show blocks Mineways adds to connect objects", L""},
 };
 
 
@@ -299,7 +299,8 @@ INT_PTR CALLBACK ExportPrint(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPar
         }
 
         //CheckDlgButton(hDlg,IDC_MERGE_FLATTOP,epd.chkMergeFlattop);
-        CheckDlgButton(hDlg, IDC_MAKE_Z_UP, epd.chkMakeZUp[epd.fileType]);
+        // glTF is always +Y up
+        CheckDlgButton(hDlg, IDC_MAKE_Z_UP, (epd.fileType == FILE_TYPE_GLTF) ? BST_INDETERMINATE : epd.chkMakeZUp[epd.fileType]);
         // under certain conditions we need to make composite overlay uncheckable, i.e. if 3D printing is on, or if detailed output is off for rendering (or, below, if tiling textures are in use)
         // disallow composites if tile texture is on
         CheckDlgButton(hDlg, IDC_COMPOSITE_OVERLAY, ((epd.flags & EXPT_3DPRINT) || !epd.chkExportAll || !epd.radioExportFullTexture[epd.fileType]) ? BST_INDETERMINATE : epd.chkCompositeOverlay);
@@ -593,7 +594,7 @@ INT_PTR CALLBACK ExportPrint(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPar
             if (epd.flags & EXPT_3DPRINT) {
                 // don't allow tile output for 3d printing except for USD
                 if (epd.fileType == FILE_TYPE_WAVEFRONT_ABS_OBJ || epd.fileType == FILE_TYPE_WAVEFRONT_REL_OBJ || 
-                    epd.fileType == FILE_TYPE_VRML2 || epd.fileType == FILE_TYPE_USD) {
+                    epd.fileType == FILE_TYPE_VRML2 || epd.fileType == FILE_TYPE_USD || epd.fileType == FILE_TYPE_GLTF) {
                     // single texture is only allowed type, since we can't use compositing with separate tiles
                     CheckDlgButton(hDlg, IDC_RADIO_EXPORT_MOSAIC_TEXTURES, 1);
                     CheckDlgButton(hDlg, IDC_RADIO_EXPORT_SEPARATE_TILES, 0);
@@ -1138,6 +1139,20 @@ INT_PTR CALLBACK ExportPrint(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPar
             }
             break;
 
+        case IDC_MAKE_Z_UP:
+            // the indeterminate state is only for when the option is not available (i.e., glTF)
+            if (epd.fileType == FILE_TYPE_GLTF)
+            {
+                CheckDlgButton(hDlg, IDC_MAKE_Z_UP, BST_INDETERMINATE);
+            }
+            else
+            {
+                UINT isIndeterminate = (IsDlgButtonChecked(hDlg, IDC_MAKE_Z_UP) == BST_INDETERMINATE);
+                if (isIndeterminate)
+                    CheckDlgButton(hDlg, IDC_MAKE_Z_UP, BST_UNCHECKED);
+            }
+            break;
+
         case IDC_TREE_LEAVES_SOLID:
             // the indeterminate state is only for when the option is not available (i.e., 3d printing)
             if (epd.flags & EXPT_3DPRINT)
@@ -1328,7 +1343,7 @@ INT_PTR CALLBACK ExportPrint(HWND hDlg, UINT message, WPARAM wParam, LPARAM lPar
             lepd.chkIndividualBlocks[epd.fileType] = (epd.flags & EXPT_3DPRINT) ? 0 : (IsDlgButtonChecked(hDlg, IDC_INDIVIDUAL_BLOCKS) == BST_CHECKED);
 
             //lepd.chkMergeFlattop = IsDlgButtonChecked(hDlg,IDC_MERGE_FLATTOP);
-            lepd.chkMakeZUp[lepd.fileType] = (IsDlgButtonChecked(hDlg, IDC_MAKE_Z_UP) == BST_CHECKED);
+            lepd.chkMakeZUp[lepd.fileType] = (lepd.fileType == FILE_TYPE_GLTF) ? 0 : (IsDlgButtonChecked(hDlg, IDC_MAKE_Z_UP) == BST_CHECKED);
             lepd.chkCenterModel = (IsDlgButtonChecked(hDlg, IDC_CENTER_MODEL) == BST_CHECKED);
             // if 3D printing, or if lesser blocks is off, do composite overlay, where we make a new tile (things break otherwise)
             lepd.chkCompositeOverlay = (epd.flags & EXPT_3DPRINT) ? 1 :
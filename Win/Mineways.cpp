@@ -37,6 +37,7 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #include "XZip.h"
 #include "rwpng.h"
+#include "OutputBuffer.h"
 #include <assert.h>
 #include <ShlObj.h>
 #include <Shlwapi.h>
@@ -176,6 +177,12 @@ static wchar_t gWorldPathCurrent[MAX_PATH_AND_FILE];
 
 // low, inside, high for selection area, fourth value is minimum height found below selection box
 static int gHitsFound[4];
+// chunks in view still to be loaded; the map is redrawn on a timer until all are in
+static int gMapChunksPending = 0;
+#define MAP_LOAD_TIMER_ID       1
+#define MAP_LOAD_TIMER_MSEC     10
+// how long each map draw spends loading chunks, so the interface stays responsive
+#define MAP_LOAD_BUDGET_MSEC    50
 static int gFullLow = 1;
 static int gAdjustingSelection = 0;
 static bool gShowPrintStats = true;
@@ -386,6 +393,8 @@ ATOM				MyRegisterClass(HINSTANCE hInstance);
 BOOL				InitInstance(HINSTANCE, int);
 LRESULT CALLBACK	WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK	About(HWND, UINT, WPARAM, LPARAM);
+static int fileTypeToFilterIndex(int fileType);
+static int filterIndexToFileType(int filterIndex);
 static boolean badFileSuffix(int fileType, TCHAR* filePath);
 static void closeMineways();
 static bool startExecutionLogFile(const LPWSTR* argList, int argCount);
@@ -452,6 +461,8 @@ static int switchToTheEnd(ImportedSet& is);
 static int interpretImportLine(char* line, ImportedSet& is);
 static int interpretScriptLine(char* line, ImportedSet& is);
 static bool findBitToggle(char* line, ImportedSet& is, char* type, unsigned int bitLocation, unsigned int windowID, int* pRetCode);
+static bool findBenchmarkCommand(char* line, ImportedSet& is, char* type, char* countName, int* pCount, int* pRetCode);
+static void showBenchmarkResults(wchar_t* msgString, bool ok);
 static bool testChangeBlockCommand(char* line, ImportedSet& is, int* pRetCode);
 static void cleanStringForLocations(char* cleanString, char* strPtr);
 static char* findBlockTypeAndData(char* line, int* pType, int* pData, unsigned short* pDataBits, wchar_t* error);
@@ -1915,6 +1926,31 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                         );
                         wcscat_s(infoString, 1024, playerString);
                     }
+                    {
+                        // what's saved in the dimension being viewed, and in the selection, if any
+                        const ChunkInventory* inventory = GetChunkInventory(&gWorldGuide, gOptions.worldType);
+                        if (inventory != NULL) {
+                            TCHAR chunkString[1024];
+                            if (inventory->numChunks > 0) {
+                                swprintf_s(chunkString, 1024, L"\n\nChunks saved in this dimension: %d, %.1f MB compressed\nChunk area: X %d to %d, Z %d to %d (blocks X %d to %d, Z %d to %d)",
+                                    inventory->numChunks, (double)inventory->compressedBytes / (1024.0 * 1024.0),
+                                    inventory->minCX, inventory->maxCX, inventory->minCZ, inventory->maxCZ,
+                                    inventory->minCX * 16, inventory->maxCX * 16 + 15, inventory->minCZ * 16, inventory->maxCZ * 16 + 15);
+                            }
+                            else {
+                                swprintf_s(chunkString, 1024, L"\n\nNo chunks saved in this dimension");
+                            }
+                            wcscat_s(infoString, 1024, chunkString);
+                            GetHighlightState(&on, &minx, &miny, &minz, &maxx, &maxy, &maxz, gMinHeight);
+                            if (on) {
+                                long long compressedBytes;
+                                int numChunks = CountSavedChunks(&gWorldGuide, gOptions.worldType, minx >> 4, minz >> 4, maxx >> 4, maxz >> 4, &compressedBytes);
+                                swprintf_s(chunkString, 1024, L"\nChunks saved in selection: %d, %.1f MB compressed",
+                                    numChunks, (double)compressedBytes / (1024.0 * 1024.0));
+                                wcscat_s(infoString, 1024, chunkString);
+                            }
+                        }
+                    }
                     break;
                 case WORLD_SCHEMATIC_TYPE:
                     wsprintf(infoString, L"Schematic name: %s\n\nWidth (X - east/west): %d\nHeight (Y - vertical): %d\nLength (Z - north/south): %d",
@@ -2177,9 +2213,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     ofn.hwndOwner = hWnd;
                     ofn.lpstrFile = gExportPath;
                     ofn.nMaxFile = MAX_PATH_AND_FILE;
-                    ofn.lpstrFilter = gPrintModel ? L"Sculpteo: Wavefront OBJ, absolute (*.obj)\0*.obj\0Wavefront OBJ, relative (*.obj)\0*.obj\0Universal Scene Description (*.usda)\0*.usda\0i.materialise: Binary Materialise Magics STL stereolithography file (*.stl)\0*.stl\0Binary VisCAM STL stereolithography file (*.stl)\0*.stl\0ASCII text STL stereolithography file (*.stl)\0*.stl\0Shapeways: VRML 2.0 (VRML 97) file (*.wrl)\0*.wrl\0" :
-                        L"Wavefront OBJ, absolute (*.obj)\0*.obj\0Wavefront OBJ, relative (*.obj)\0*.obj\0Universal Scene Description (*.usda)\0*.usda\0Binary Materialise Magics STL stereolithography file (*.stl)\0*.stl\0Binary VisCAM STL stereolithography file (*.stl)\0*.stl\0ASCII text STL stereolithography file (*.stl)\0*.stl\0VRML 2.0 (VRML 97) file (*.wrl)\0*.wrl\0";
-                    ofn.nFilterIndex = (gPrintModel ? gExportPrintData.fileType + 1 : gExportViewData.fileType + 1);
+                    ofn.lpstrFilter = gPrintModel ? L"Sculpteo: Wavefront OBJ, absolute (*.obj)\0*.obj\0Wavefront OBJ, relative (*.obj)\0*.obj\0Universal Scene Description (*.usda)\0*.usda\0i.materialise: Binary Materialise Magics STL stereolithography file (*.stl)\0*.stl\0Binary VisCAM STL stereolithography file (*.stl)\0*.stl\0ASCII text STL stereolithography file (*.stl)\0*.stl\0Shapeways: VRML 2.0 (VRML 97) file (*.wrl)\0*.wrl\0glTF 2.0 binary (*.glb)\0*.glb\0" :
+                        L"Wavefront OBJ, absolute (*.obj)\0*.obj\0Wavefront OBJ, relative (*.obj)\0*.obj\0Universal Scene Description (*.usda)\0*.usda\0Binary Materialise Magics STL stereolithography file (*.stl)\0*.stl\0Binary VisCAM STL stereolithography file (*.stl)\0*.stl\0ASCII text STL stereolithography file (*.stl)\0*.stl\0VRML 2.0 (VRML 97) file (*.wrl)\0*.wrl\0glTF 2.0 binary (*.glb)\0*.glb\0";
+                    ofn.nFilterIndex = fileTypeToFilterIndex(gPrintModel ? gExportPrintData.fileType : gExportViewData.fileType);
                     ofn.lpstrFileTitle = NULL;
                     ofn.nMaxFileTitle = 0;
                     wcscpy_s(path, MAX_PATH_AND_FILE, gImportPath);
@@ -2196,11 +2232,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     int fileType;
                     if (gPrintModel)
                     {
-                        fileType = gExportPrintData.fileType = ofn.nFilterIndex - 1;
+                        fileType = gExportPrintData.fileType = filterIndexToFileType(ofn.nFilterIndex);
                     }
                     else
                     {
-                        fileType = gExportViewData.fileType = ofn.nFilterIndex - 1;
+                        fileType = gExportViewData.fileType = filterIndexToFileType(ofn.nFilterIndex);
                     }
 
                     if (saveOK) {
@@ -2501,6 +2537,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         DeleteObject(hb);
     }
     break;
+    case WM_TIMER:
+        if (wParam == MAP_LOAD_TIMER_ID)
+        {
+            // load more of the chunks in view; drawTheMap() sets the timer again if there are more to go
+            KillTimer(hWnd, MAP_LOAD_TIMER_ID);
+            if (gMapChunksPending > 0)
+                drawInvalidateUpdate(hWnd);
+        }
+        break;
     case WM_PAINT:
         hdc = BeginPaint(hWnd, &ps);
         GetClientRect(hWnd, &rect);
@@ -2669,6 +2714,18 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
+// The model export dialog lists the file types in order, except that schematic has its own dialog, so glTF, which
+// comes after schematic, is listed in its place.
+static int fileTypeToFilterIndex(int fileType)
+{
+    return ((fileType == FILE_TYPE_GLTF) ? FILE_TYPE_SCHEMATIC : fileType) + 1;
+}
+
+static int filterIndexToFileType(int filterIndex)
+{
+    return (filterIndex - 1 == FILE_TYPE_SCHEMATIC) ? FILE_TYPE_GLTF : filterIndex - 1;
+}
+
 static boolean badFileSuffix(int fileType, TCHAR *filePath)
 {
     // if the suffix on the file name does not match an expected suffix, give warning
@@ -2717,6 +2774,9 @@ static boolean badFileSuffix(int fileType, TCHAR *filePath)
     case FILE_TYPE_VRML2:
         wcscpy_s(fileString, 10, L"wrl");
         break;
+    case FILE_TYPE_GLTF:
+        wcscpy_s(fileString, 10, L"glb");
+        break;
     case FILE_TYPE_BINARY_MAGICS_STL:
     case FILE_TYPE_BINARY_VISCAM_STL:
     case FILE_TYPE_ASCII_STL:
@@ -2780,6 +2840,7 @@ static void closeMineways()
         gCustomCurrency = NULL;
     }
     Cache_Empty();
+    ClearChunkInventory();
 
     PostQuitMessage(0);
 }
@@ -3478,17 +3539,22 @@ static void drawTheMap()
 {
     if (gLoaded) {
         ClearUnknownBlockNameString();
+        // draw what's loaded, with placeholders for the rest, and come back on a timer to load more
         checkMapDrawErrorCode(
-            DrawMap(&gWorldGuide, gCurX, gCurZ, gCurDepth - gMinHeight, gMaxHeight, bitWidth, bitHeight, gCurScale, map, &gOptions, gHitsFound, updateProgress, gMinecraftVersion, gVersionID)
+            DrawMapProgressive(&gWorldGuide, gCurX, gCurZ, gCurDepth - gMinHeight, gMaxHeight, bitWidth, bitHeight, gCurScale, map, &gOptions, gHitsFound, updateProgress, gMinecraftVersion, gVersionID, MAP_LOAD_BUDGET_MSEC, &gMapChunksPending)
         );
+        if (gMapChunksPending > 0)
+            SetTimer(gWS.hWnd, MAP_LOAD_TIMER_ID, MAP_LOAD_TIMER_MSEC, NULL);
     } else {
+        gMapChunksPending = 0;
         // avoid clearing nothing at all.
         if (bitWidth > 0 && bitHeight > 0)
             memset(map, 0xff, bitWidth * bitHeight * 4);
         else
             return;	// nothing to draw
     }
-    SendMessage(progressBar, PBM_SETPOS, 0, 0);
+    if (gMapChunksPending == 0)
+        SendMessage(progressBar, PBM_SETPOS, 0, 0);
     for (int i = 0; i < bitWidth * bitHeight * 4; i += 4)
     {
         map[i] ^= map[i + 2];
@@ -3553,11 +3619,17 @@ static void testWorldHeight(int& minHeight, int& maxHeight, int mcVersion, int s
 {
     // proceed currently only if version >= 1.17 (1.18 isn't possible yet, but let's future proof it anyway)
     if (mcVersion >= 17) {
+        // A world with a custom height might say so in level.dat, so we don't have to look at any chunks.
+        if (GetLevelHeights(gWorldGuide.world, &minHeight, &maxHeight) == 0) {
+            gWorldGuide.minHeight = minHeight;
+            gWorldGuide.maxHeight = maxHeight;
+            return;
+        }
         // Read where the spawn and player location is and see heights there.
         // I figure the player and spawn locations have been created, hopefully one of them with the mod.
         // The mod appears to do things where the player is, not the spawn.
-        GetChunkHeights(&gWorldGuide, minHeight, maxHeight, mcVersion, spawnX, spawnZ);
-        GetChunkHeights(&gWorldGuide, minHeight, maxHeight, mcVersion, playerX, playerZ);
+        GetChunkHeights(&gWorldGuide, minHeight, maxHeight, spawnX, spawnZ);
+        GetChunkHeights(&gWorldGuide, minHeight, maxHeight, playerX, playerZ);
     }
 }
 
@@ -3565,6 +3637,8 @@ static void testWorldHeight(int& minHeight, int& maxHeight, int mcVersion, int s
 static int loadWorld(HWND hWnd)
 {
     CloseAll();
+    // rescanned below for a level, so a reload picks up newly saved chunks
+    ClearChunkInventory();
     // defaults
     gWorldGuide.minHeight = 0;
     gWorldGuide.maxHeight = 255;
@@ -3630,6 +3704,9 @@ static int loadWorld(HWND hWnd)
         gMinecraftVersion = DATA_VERSION_TO_RELEASE_NUMBER(gVersionID);
         setHeightsFromVersionID();
         testWorldHeight(gMinHeight, gMaxHeight, gMinecraftVersion, gSpawnX, gSpawnZ, gPlayerX, gPlayerZ);
+        // note which chunks exist, so that missing ones are never looked for. If this fails (out of memory),
+        // chunks are simply looked for in the region files, as before.
+        ScanChunkInventory(&gWorldGuide);
         break;
 
     case WORLD_SCHEMATIC_TYPE:
@@ -4280,7 +4357,8 @@ static void copyOverExportPrintData(ExportFileData* pEFD)
         service = 1;
         break;
     case FILE_TYPE_USD:
-        // just ignore, we don't really use USD with print anyway
+    case FILE_TYPE_GLTF:
+        // just ignore, we don't really use USD or glTF with print anyway
         break;
     case FILE_TYPE_VRML2:
         dest[0] = FILE_TYPE_WAVEFRONT_ABS_OBJ;
@@ -5018,6 +5096,22 @@ static int saveObjFile(HWND hWnd, wchar_t* objFileName, int printModel, wchar_t*
             // (in which case this flag isn't turned on anyway).
         }
     }
+    else if (gpEFD->fileType == FILE_TYPE_GLTF)
+    {
+        // a primitive per material, which is by block type for colors and the mosaic, by tile for tiles
+        if (gpEFD->radioExportTileTextures[gpEFD->fileType] == 1)
+        {
+            // Tile export must have these, on top of the mosaic settings made above
+            gOptions.exportFlags |= EXPT_OUTPUT_MATERIALS | EXPT_OUTPUT_TEXTURE_IMAGES | EXPT_OUTPUT_OBJ_MTL_PER_TYPE | EXPT_OUTPUT_SEPARATE_TEXTURE_TILES;
+        }
+        else if ((gOptions.exportFlags & EXPT_OUTPUT_TEXTURE) && (gOptions.exportFlags & EXPT_3DPRINT))
+        {
+            // if printing, as with VRML, one material and texture will do
+            gOptions.exportFlags &= ~EXPT_OUTPUT_OBJ_MTL_PER_TYPE;
+        }
+        // glTF is defined to be +Y up, so never rotate to Z up, even if a script asks for it
+        gpEFD->chkMakeZUp[gpEFD->fileType] = 0;
+    }
     else if (gpEFD->fileType == FILE_TYPE_SCHEMATIC)
     {
         // really, ignore all options for Schematic - set how you want, but they'll all be ignored except rotation around the Y axis.
@@ -5377,7 +5471,7 @@ static const wchar_t* removePath(const wchar_t* src)
     return strPtr;
 }
 
-#define INIT_ALL_FILE_TYPES( a, v0,v1,v2,v3,v4,v5,v6,v7)    \
+#define INIT_ALL_FILE_TYPES( a, v0,v1,v2,v3,v4,v5,v6,v7,v8)    \
     (a)[FILE_TYPE_WAVEFRONT_REL_OBJ] = (v0);    \
     (a)[FILE_TYPE_WAVEFRONT_ABS_OBJ] = (v1);    \
     (a)[FILE_TYPE_USD] = (v2);    \
@@ -5385,7 +5479,8 @@ static const wchar_t* removePath(const wchar_t* src)
     (a)[FILE_TYPE_BINARY_VISCAM_STL] = (v4);    \
     (a)[FILE_TYPE_ASCII_STL] = (v5);    \
     (a)[FILE_TYPE_VRML2] = (v6);	\
-    (a)[FILE_TYPE_SCHEMATIC] = (v7);
+    (a)[FILE_TYPE_SCHEMATIC] = (v7);	\
+    (a)[FILE_TYPE_GLTF] = (v8);
 
 static void initializeExportDialogData()
 {
@@ -5403,22 +5498,22 @@ static void initializePrintExportData(ExportFileData& printData)
     // turn stuff on
     printData.fileType = FILE_TYPE_VRML2;
 
-    INIT_ALL_FILE_TYPES(printData.chkCreateZip,            1, 1, 0, 0, 0, 0, 1, 0);
+    INIT_ALL_FILE_TYPES(printData.chkCreateZip,            1, 1, 0, 0, 0, 0, 1, 0, 0);
     // I used to set the last value to 0, meaning only the zip would be created. The idea
     // was that the naive user would then only have the zip, and so couldn't screw up
     // when uploading the model file. But this setting is a pain if you want to preview
     // the model file, you have to always remember to check the box so you can get the
     // preview files. So, now it's off.
-    INIT_ALL_FILE_TYPES(printData.chkCreateModelFiles,     1, 1, 1, 1, 1, 1, 1, 1);
+    INIT_ALL_FILE_TYPES(printData.chkCreateModelFiles,     1, 1, 1, 1, 1, 1, 1, 1, 1);
 
     // OBJ and VRML have color, depending...
-    // order: Sculpteo OBJ, relative OBJ, USDA, i.materialize STL, VISCAM STL, ASCII STL, Shapeways VRML, (Schematic)
-    INIT_ALL_FILE_TYPES(printData.radioExportNoMaterials,  0, 0, 0, 0, 0, 1, 0, 1);
+    // order: Sculpteo OBJ, relative OBJ, USDA, i.materialize STL, VISCAM STL, ASCII STL, Shapeways VRML, (Schematic), glTF
+    INIT_ALL_FILE_TYPES(printData.radioExportNoMaterials,  0, 0, 0, 0, 0, 1, 0, 1, 0);
     // might as well export color with OBJ and binary STL - nice for previewing
-    INIT_ALL_FILE_TYPES(printData.radioExportMtlColors,    0, 0, 0, 1, 1, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(printData.radioExportSolidTexture, 0, 0, 0, 0, 0, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(printData.radioExportFullTexture,  1, 1, 0, 0, 0, 0, 1, 0); // for 3D printing, nice to be able to load just the large RGB texture
-    INIT_ALL_FILE_TYPES(printData.radioExportTileTextures, 0, 0, 1, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.radioExportMtlColors,    0, 0, 0, 1, 1, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.radioExportSolidTexture, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.radioExportFullTexture,  1, 1, 0, 0, 0, 0, 1, 0, 1); // for 3D printing, nice to be able to load just the large RGB texture
+    INIT_ALL_FILE_TYPES(printData.radioExportTileTextures, 0, 0, 1, 0, 0, 0, 0, 0, 0);
 
     strcpy_s(printData.tileDirString, MAX_PATH, "tex");
 
@@ -5430,7 +5525,7 @@ static void initializePrintExportData(ExportFileData& printData)
     // Shapeways imports VRML files and displays them with Y up, that is, it
     // rotates them itself. Sculpteo imports OBJ, and likes Z is up, so we export with this on.
     // STL uses Z is up, even though i.materialise's previewer shows Y is up.
-    INIT_ALL_FILE_TYPES(printData.chkMakeZUp, 1, 1, 1, 1, 1, 1, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.chkMakeZUp, 1, 1, 1, 1, 1, 1, 0, 0, 0);
     printData.chkCenterModel = 1;
     printData.chkExportAll = 0;
     printData.chkFatten = 0;
@@ -5438,6 +5533,7 @@ static void initializePrintExportData(ExportFileData& printData)
     printData.chkCompositeOverlay = 1;	// never allow 0 for 3D printing, as this would create tiles floating above the surface
     printData.chkBlockFacesAtBorders = 1; // never allow 0 for 3D printing, as this would make the surface non-manifold
     printData.chkDecimate = 0; // never allow 0 for 3D printing, as this would make the surface potentially have T-junctions
+    printData.chkExportInTiles = 0; // rendering only
     printData.chkLeavesSolid = 1; // never allow 0 for 3D printing, as this would make the surface non-manifold 
 
     printData.radioRotate0 = 1;
@@ -5452,6 +5548,7 @@ static void initializePrintExportData(ExportFileData& printData)
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_CUSTOM_MATERIAL].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_CUSTOM_MATERIAL].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,
+        METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall);
     printData.costVal = 25.00f;
 
@@ -5471,20 +5568,20 @@ static void initializePrintExportData(ExportFileData& printData)
 
     // should normally just have one material and group
     printData.chkSeparateTypes = 0;
-    INIT_ALL_FILE_TYPES(printData.chkIndividualBlocks, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.chkIndividualBlocks, 0, 0, 0, 0, 0, 0, 0, 0, 0);
     printData.chkMaterialPerFamily = 0;
     printData.chkSplitByBlockType = 0;
     printData.chkMakeGroupsObjects = 0;
     // shouldn't really matter, now that both versions don't use the diffuse color when texturing
-    INIT_ALL_FILE_TYPES(printData.chkCustomMaterial, 0, 0, 1, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(printData.chkCustomMaterial, 0, 0, 1, 0, 0, 0, 0, 0, 0);
     printData.chkExportMDL = 1;
 
     printData.scaleLightsVal = 30.0f;
     printData.scaleEmittersVal = 1000.0f;
 
     printData.floaterCountVal = 16;
-    INIT_ALL_FILE_TYPES(printData.chkHollow,      1, 1, 1, 0, 0, 0, 1, 0);
-    INIT_ALL_FILE_TYPES(printData.chkSuperHollow, 1, 1, 1, 0, 0, 0, 1, 0);
+    INIT_ALL_FILE_TYPES(printData.chkHollow,      1, 1, 1, 0, 0, 0, 1, 0, 1);
+    INIT_ALL_FILE_TYPES(printData.chkSuperHollow, 1, 1, 1, 0, 0, 0, 1, 0, 1);
     INIT_ALL_FILE_TYPES(printData.hollowThicknessVal,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,
@@ -5493,12 +5590,13 @@ static void initializePrintExportData(ExportFileData& printData)
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_CUSTOM_MATERIAL].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_CUSTOM_MATERIAL].minWall,
         METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,
-        METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall);	// last one is schematic "material"
+        METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall,	// schematic "material"
+        METERS_TO_MM * gMtlCostTable[PRINT_MATERIAL_FULL_COLOR_SANDSTONE].minWall);
 
     // materials selected
-    INIT_ALL_FILE_TYPES(printData.comboPhysicalMaterial, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE);
+    INIT_ALL_FILE_TYPES(printData.comboPhysicalMaterial, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE);
     // defaults: for Sculpteo OBJ, mm (was cm - affects first two values here); for USD, who knows; for i.materialise, mm; for other STL, cm; for Shapeways VRML, mm
-    INIT_ALL_FILE_TYPES(printData.comboModelUnits, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER);
+    INIT_ALL_FILE_TYPES(printData.comboModelUnits, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER);
 
     printData.flags = EXPT_3DPRINT;
 }
@@ -5518,16 +5616,16 @@ static void initializeViewExportData(ExportFileData& viewData)
     viewData.fileType = FILE_TYPE_WAVEFRONT_ABS_OBJ;
 #endif
 
-    // order: Sculpteo OBJ, relative OBJ, USDA, i.materialize STL, VISCAM STL, ASCII STL, Shapeways VRML, (Schematic)
+    // order: Sculpteo OBJ, relative OBJ, USDA, i.materialize STL, VISCAM STL, ASCII STL, Shapeways VRML, (Schematic), glTF
     // don't really need to create a zip for rendering output
-    INIT_ALL_FILE_TYPES(viewData.chkCreateZip,            0, 0, 0, 0, 0, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(viewData.chkCreateModelFiles,     1, 1, 1, 1, 1, 1, 1, 1);
+    INIT_ALL_FILE_TYPES(viewData.chkCreateZip,            0, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkCreateModelFiles,     1, 1, 1, 1, 1, 1, 1, 1, 1);
 
-    INIT_ALL_FILE_TYPES(viewData.radioExportNoMaterials,  0, 0, 0, 0, 0, 1, 0, 1);
-    INIT_ALL_FILE_TYPES(viewData.radioExportMtlColors,    0, 0, 0, 1, 1, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(viewData.radioExportSolidTexture, 0, 0, 0, 0, 0, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(viewData.radioExportFullTexture,  0, 0, 0, 0, 0, 0, 1, 0);  // was 1's for OBJ; now just for VRML, which doesn't have individual texture export code
-    INIT_ALL_FILE_TYPES(viewData.radioExportTileTextures, 1, 1, 1, 0, 0, 0, 0, 0);  // USD uses tile per block, only; really, a better default anyway
+    INIT_ALL_FILE_TYPES(viewData.radioExportNoMaterials,  0, 0, 0, 0, 0, 1, 0, 1, 0);
+    INIT_ALL_FILE_TYPES(viewData.radioExportMtlColors,    0, 0, 0, 1, 1, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.radioExportSolidTexture, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.radioExportFullTexture,  0, 0, 0, 0, 0, 0, 1, 0, 0);  // was 1's for OBJ; now just for VRML, which doesn't have individual texture export code
+    INIT_ALL_FILE_TYPES(viewData.radioExportTileTextures, 1, 1, 1, 0, 0, 0, 0, 0, 1);  // USD uses tile per block, only; really, a better default anyway
 
     strcpy_s(viewData.tileDirString, MAX_PATH, "tex");
 
@@ -5537,7 +5635,7 @@ static void initializeViewExportData(ExportFileData& viewData)
 
     viewData.chkExportAll = 1;
     // for renderers, assume Y is up, which is the norm
-    INIT_ALL_FILE_TYPES(viewData.chkMakeZUp, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkMakeZUp, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 
     viewData.modelHeightVal = 100.0f;    // 100 cm - view doesn't need a minimum, really
     INIT_ALL_FILE_TYPES(viewData.blockSizeVal,
@@ -5548,6 +5646,7 @@ static void initializeViewExportData(ExportFileData& viewData)
         1000.0f,
         1000.0f,
         1000.0f,
+        1000.0f,
         1000.0f);
     viewData.costVal = 25.00f;
 
@@ -5558,18 +5657,19 @@ static void initializeViewExportData(ExportFileData& viewData)
     viewData.chkConnectCornerTips = 0;
     viewData.chkConnectAllEdges = 0;
     viewData.chkDeleteFloaters = 0;
-    INIT_ALL_FILE_TYPES(viewData.chkHollow,      0, 0, 0, 0, 0, 0, 0, 0);
-    INIT_ALL_FILE_TYPES(viewData.chkSuperHollow, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkHollow,      0, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkSuperHollow, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 
     viewData.chkSeparateTypes = 1;
-    INIT_ALL_FILE_TYPES(viewData.chkIndividualBlocks, 0, 0, 0, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkIndividualBlocks, 0, 0, 0, 0, 0, 0, 0, 0, 0);
     viewData.chkMaterialPerFamily = 1;
     viewData.chkSplitByBlockType = 1;
     viewData.chkMakeGroupsObjects = 0;  // keeping the training wheels on for Blender. Setting to 1 can be "surprising".
-    INIT_ALL_FILE_TYPES(viewData.chkCustomMaterial, 1, 1, 1, 0, 0, 0, 0, 0);
+    INIT_ALL_FILE_TYPES(viewData.chkCustomMaterial, 1, 1, 1, 0, 0, 0, 0, 0, 0);
     viewData.chkCompositeOverlay = 0;
     viewData.chkBlockFacesAtBorders = 1;
     viewData.chkDecimate = 0;
+    viewData.chkExportInTiles = 0;
     viewData.chkLeavesSolid = 0;
     viewData.chkExportMDL = 1;
     viewData.scaleLightsVal = 30.0f;
@@ -5577,10 +5677,10 @@ static void initializeViewExportData(ExportFileData& viewData)
 
     viewData.floaterCountVal = 16;
     // mostly irrelevant for viewing, though centimeters can be useful
-    INIT_ALL_FILE_TYPES(viewData.hollowThicknessVal, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f);    // 1 meter
-    INIT_ALL_FILE_TYPES(viewData.comboPhysicalMaterial, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE);
+    INIT_ALL_FILE_TYPES(viewData.hollowThicknessVal, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f);    // 1 meter
+    INIT_ALL_FILE_TYPES(viewData.comboPhysicalMaterial, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_CUSTOM_MATERIAL, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE, PRINT_MATERIAL_FULL_COLOR_SANDSTONE);
     // For USD it was centimeters, but now meters are supported well.
-    INIT_ALL_FILE_TYPES(viewData.comboModelUnits, UNITS_METER, UNITS_METER, UNITS_METER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_METER, UNITS_METER);
+    INIT_ALL_FILE_TYPES(viewData.comboModelUnits, UNITS_METER, UNITS_METER, UNITS_METER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_MILLIMETER, UNITS_METER, UNITS_METER, UNITS_METER);
 
     // TODO someday allow getting rid of floaters, that would be cool.
     //gExportSchematicData.chkDeleteFloaters = 1;
@@ -6565,6 +6665,10 @@ static int interpretImportLine(char* line, ImportedSet& is)
         {
             is.pEFD->fileType = FILE_TYPE_VRML2;
         }
+        else if (strstr(strPtr, "glTF 2.0 binary"))
+        {
+            is.pEFD->fileType = FILE_TYPE_GLTF;
+        }
         else
         {
             if (is.readingModel) {
@@ -7168,6 +7272,19 @@ static int interpretImportLine(char* line, ImportedSet& is)
         return INTERPRETER_FOUND_VALID_EXPORT_LINE;
     }
 
+    strPtr = findLineDataNoCase(line, "Export in tiles:");
+    if (strPtr != NULL) {
+        if (1 != sscanf_s(strPtr, "%s", string1, (unsigned)_countof(string1)))
+        {
+            saveErrorMessage(is, L"could not find boolean value for 'Export in tiles' command."); return INTERPRETER_FOUND_ERROR;
+        }
+        if (!validBoolean(is, string1)) return INTERPRETER_FOUND_ERROR;
+
+        if (is.processData)
+            is.pEFD->chkExportInTiles = interpretBoolean(string1);
+        return INTERPRETER_FOUND_VALID_EXPORT_LINE;
+    }
+
     strPtr = findLineDataNoCase(line, "Double all billboard faces:");
     if (strPtr != NULL) {
         if (1 != sscanf_s(strPtr, "%s", string1, (unsigned)_countof(string1)))
@@ -7907,6 +8024,179 @@ JumpToSpawn:
         return INTERPRETER_FOUND_VALID_LINE | INTERPRETER_REDRAW_SCREEN;
     }
 
+    int benchmarkCount;
+    if (findBenchmarkCommand(line, is, "Benchmark map draw", "passes", &benchmarkCount, &retCode)) {
+        // time the drawing of the map in the selected area, e.g., on the [Block Test World]
+        int passes = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            if (!gLoaded) {
+                saveErrorMessage(is, L"Benchmark map draw command failed, as no world has been loaded.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            GetHighlightState(&on, &minx, &miny, &minz, &maxx, &maxy, &maxz, gMinHeight);
+            if (!on) {
+                saveErrorMessage(is, L"Benchmark map draw command failed, as no area is selected.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            double lutUsec, noLutUsec;
+            int numChunks = BenchmarkMapDraw(&gWorldGuide, minx >> 4, minz >> 4, maxx >> 4, maxz >> 4, gCurDepth - gMinHeight, gMaxHeight, &gOptions, passes, gMinecraftVersion, gVersionID, &lutUsec, &noLutUsec);
+            wchar_t msgString[1024];
+            swprintf_s(msgString, 1024, L"Map draw benchmark: %d chunks, %d passes. Microseconds per chunk: %.1f with the color lookup table, %.1f without.", numChunks, passes, lutUsec, noLutUsec);
+            showBenchmarkResults(msgString, true);
+        }
+        return (retCode == INTERPRETER_FOUND_ERROR) ? retCode : (retCode | INTERPRETER_REDRAW_SCREEN);
+    }
+
+    if (findBenchmarkCommand(line, is, "Benchmark map render", "passes", &benchmarkCount, &retCode)) {
+        // render the selected area, or all of the [Block Test World], at various zooms and map options
+        int passes = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            if (!gLoaded) {
+                saveErrorMessage(is, L"Benchmark map render command failed, as no world has been loaded.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            int bxmin, bzmin, bxmax, bzmax;
+            GetHighlightState(&on, &minx, &miny, &minz, &maxx, &maxy, &maxz, gMinHeight);
+            if (on) {
+                bxmin = minx >> 4;
+                bzmin = minz >> 4;
+                bxmax = maxx >> 4;
+                bzmax = maxz >> 4;
+            }
+            else if (gWorldGuide.type == WORLD_TEST_BLOCK_TYPE) {
+                // the whole test world, so that results can be compared between runs
+                bxmin = 0;
+                bzmin = -3;
+                bxmax = NUM_BLOCKS_DEFINED / 2;
+                bzmax = 8;
+            }
+            else {
+                saveErrorMessage(is, L"Benchmark map render command failed, as no area is selected.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            MapBenchmarkResult results[32];
+            int numResults = BenchmarkMapRender(&gWorldGuide, bxmin, bzmin, bxmax, bzmax, gCurDepth - gMinHeight, gMaxHeight, &gOptions, passes, gMinecraftVersion, gVersionID, results, 32);
+            if (numResults == 0) {
+                saveErrorMessage(is, L"Benchmark map render command failed, as there was not enough memory for the image.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            wchar_t msgString[4096];
+            int len = swprintf_s(msgString, 4096, L"Map render benchmark: chunks %d to %d in X, %d to %d in Z, %d passes.\nzoom, options: chunks/sec, Mpixels/sec, checksum",
+                bxmin, bxmax, bzmin, bzmax, passes);
+            bool allConsistent = true;
+            for (int i = 0; i < numResults; i++) {
+                len += swprintf_s(msgString + len, 4096 - len, L"\n%d, 0x%03x: %.0f, %.1f, %08lx%s", results[i].zoom, results[i].worldType,
+                    results[i].chunksPerSec, results[i].pixelsPerSec / 1000000.0, results[i].checksum, results[i].consistent ? L"" : L" MISMATCH");
+                if (!results[i].consistent)
+                    allConsistent = false;
+            }
+            if (!allConsistent) {
+                len += swprintf_s(msgString + len, 4096 - len, L"\nWarning: renders marked MISMATCH differed between passes or failed.");
+            }
+            showBenchmarkResults(msgString, allConsistent);
+        }
+        return (retCode == INTERPRETER_FOUND_ERROR) ? retCode : (retCode | INTERPRETER_REDRAW_SCREEN);
+    }
+
+    if (findBenchmarkCommand(line, is, "Benchmark map blit", "passes", &benchmarkCount, &retCode)) {
+        // time the copying of chunk renders into map image rows, for zooms 1 through 8
+        int passes = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            double simdMpix[8], scalarMpix[8];
+            BenchmarkMapBlit(8, passes, simdMpix, scalarMpix);
+            wchar_t msgString[1024];
+            int len = swprintf_s(msgString, 1024, L"Map blit benchmark, %d passes. Millions of chunk pixels per second, SSSE3 / scalar:", passes);
+            for (int zoom = 1; zoom <= 8; zoom++) {
+                len += swprintf_s(msgString + len, 1024 - len, L"\nzoom %d: %.0f / %.0f", zoom, simdMpix[zoom - 1], scalarMpix[zoom - 1]);
+            }
+            showBenchmarkResults(msgString, true);
+        }
+        return retCode;
+    }
+
+    if (findBenchmarkCommand(line, is, "Benchmark model write", "lines", &benchmarkCount, &retCode)) {
+        // time writing OBJ-style text lines to a file, a line at a time versus buffered
+        int lines = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            wchar_t tempdir[MAX_PATH_AND_FILE];
+            wchar_t filepath[MAX_PATH_AND_FILE];
+            GetTempPath(MAX_PATH_AND_FILE, tempdir);
+            swprintf_s(filepath, MAX_PATH_AND_FILE, L"%sMinewaysWriteBenchmark", tempdir);
+            double unbufferedMBps, bufferedMBps;
+            bool sameOutput;
+            if (OutBuf_Benchmark(filepath, lines, &unbufferedMBps, &bufferedMBps, &sameOutput)) {
+                saveErrorMessage(is, L"Benchmark model write command failed, as the test files could not be written to the temporary directory.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            wchar_t msgString[1024];
+            swprintf_s(msgString, 1024, L"Model write benchmark, %d lines. Megabytes per second, line by line / buffered: %.1f / %.1f.\nThe files written %s.",
+                lines, unbufferedMBps, bufferedMBps, sameOutput ? L"match" : L"DO NOT match");
+            showBenchmarkResults(msgString, sameOutput);
+        }
+        return retCode;
+    }
+
+    if (findBenchmarkCommand(line, is, "Benchmark USD weld", "faces", &benchmarkCount, &retCode)) {
+        // time finding the unique points, normals and UVs of a USD mesh, by float hash versus on the block lattice
+        int faces = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            double floatHashMsec, latticeMsec;
+            bool sameOutput;
+            if (BenchmarkUSDWeld(faces, &floatHashMsec, &latticeMsec, &sameOutput)) {
+                saveErrorMessage(is, L"Benchmark USD weld command failed, as there was not enough memory for the mesh.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            wchar_t msgString[1024];
+            swprintf_s(msgString, 1024, L"USD weld benchmark, %d faces. Milliseconds, float hash / lattice: %.1f / %.1f.\nThe welded vertices %s.",
+                faces, floatHashMsec, latticeMsec, sameOutput ? L"match" : L"DO NOT match");
+            showBenchmarkResults(msgString, sameOutput);
+        }
+        return retCode;
+    }
+
+    if (findBenchmarkCommand(line, is, "Benchmark export read", "passes", &benchmarkCount, &retCode)) {
+        // read the selected area, or all of the [Block Test World], into the export box with one thread and with several
+        int passes = benchmarkCount;
+        if ((retCode != INTERPRETER_FOUND_ERROR) && is.processData) {
+            if (!gLoaded) {
+                saveErrorMessage(is, L"Benchmark export read command failed, as no world has been loaded.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            GetHighlightState(&on, &minx, &miny, &minz, &maxx, &maxy, &maxz, gMinHeight);
+            if (!on) {
+                if (gWorldGuide.type == WORLD_TEST_BLOCK_TYPE) {
+                    // the whole test world, so that results can be compared between runs
+                    minx = 0;
+                    minz = -3 * 16;
+                    maxx = (NUM_BLOCKS_DEFINED / 2) * 16 + 15;
+                    maxz = 8 * 16 + 15;
+                    miny = gMinHeight;
+                    maxy = gMaxHeight;
+                }
+                else {
+                    saveErrorMessage(is, L"Benchmark export read command failed, as no area is selected.");
+                    return INTERPRETER_FOUND_ERROR;
+                }
+            }
+            double serialMsec, parallelMsec;
+            bool sameOutput;
+            int errCode = BenchmarkExportRead(&gWorldGuide, &gOptions, minx, miny, minz, maxx, maxy, maxz, gMinHeight, gMaxHeight, gVersionID, passes, &serialMsec, &parallelMsec, &sameOutput);
+            if (errCode >= MW_BEGIN_ERRORS) {
+                saveErrorMessage(is, L"Benchmark export read command failed, as there was not enough memory for the box.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            if (errCode >= MW_BEGIN_NOTHING_TO_DO) {
+                saveErrorMessage(is, L"Benchmark export read command failed, as there is nothing in the area to export.");
+                return INTERPRETER_FOUND_ERROR;
+            }
+            wchar_t msgString[1024];
+            swprintf_s(msgString, 1024, L"Export read benchmark: %d to %d in X, %d to %d in Y, %d to %d in Z, %d passes. Milliseconds per pass, one thread / several: %.1f / %.1f.\nThe boxes read in %s.",
+                minx, maxx, miny, maxy, minz, maxz, passes, serialMsec, parallelMsec, sameOutput ? L"match" : L"DO NOT match");
+            showBenchmarkResults(msgString, sameOutput);
+        }
+        return (retCode == INTERPRETER_FOUND_ERROR) ? retCode : (retCode | INTERPRETER_REDRAW_SCREEN);
+    }
+
     if (findBitToggle(line, is, "Show all objects", SHOWALL, IDM_SHOWALLOBJECTS, &retCode))
         return retCode;
     if (findBitToggle(line, is, "Show biomes", BIOMES, IDM_VIEW_SHOWBIOMES, &retCode))
@@ -8421,6 +8711,43 @@ static bool findBitToggle(char* line, ImportedSet& is, char* type, unsigned int
     return false;
 }
 
+// Look for one of the "Benchmark <type>: <count>" commands. If found, returns true, with the count, which must be at
+// least 1; *pRetCode is set to INTERPRETER_FOUND_ERROR if it isn't, else INTERPRETER_FOUND_VALID_LINE.
+static bool findBenchmarkCommand(char* line, ImportedSet& is, char* type, char* countName, int* pCount, int* pRetCode)
+{
+    *pRetCode = INTERPRETER_FOUND_NOTHING_USEFUL;	// until proven otherwise
+    char commandString[1024];
+    strcpy_s(commandString, 1024, type);
+    strcat_s(commandString, 1024, ":");
+    char* strPtr = findLineDataNoCase(line, commandString);
+    if (strPtr != NULL) {
+        wchar_t error[1024];
+        if (1 != sscanf_s(strPtr, "%d", pCount)) {
+            // bad parse - warn and quit
+            wsprintf(error, L"could not read '%S' number of %S.", type, countName);
+            saveErrorMessage(is, error, strPtr);
+            *pRetCode = INTERPRETER_FOUND_ERROR;
+            return true;
+        }
+        if (*pCount < 1) {
+            wsprintf(error, L"number of %S for benchmark must be at least 1.", countName);
+            saveErrorMessage(is, error, strPtr);
+            *pRetCode = INTERPRETER_FOUND_ERROR;
+            return true;
+        }
+        *pRetCode = INTERPRETER_FOUND_VALID_LINE;
+        return true;
+    }
+    // didn't find anything
+    return false;
+}
+
+// Show the results of a benchmark, as a warning if something didn't match up
+static void showBenchmarkResults(wchar_t* msgString, bool ok)
+{
+    FilterMessageBox(NULL, msgString, _T("Informational"), MB_OK | (ok ? MB_ICONINFORMATION : MB_ICONWARNING));
+}
+
 static bool testChangeBlockCommand(char* line, ImportedSet& is, int* pRetCode)
 {
     // types of commands:
@@ -9675,6 +10002,18 @@ static void checkMapDrawErrorCode(int retCode)
 }
 
 
+// map images are rendered and written in bands of chunk rows, each band at most about this size
+#define MAP_BAND_MAX_BYTES (64*1024*1024)
+
+static float gMapBandProgressStart = 0.0f;
+static float gMapBandProgressScale = 1.0f;
+
+// DrawMapToArray reports progress for just the band it's drawing, so scale that to the whole map
+static void updateMapBandProgress(float progress, wchar_t* buf)
+{
+    updateProgress((progress >= 0.0f) ? (gMapBandProgressStart + progress * gMapBandProgressScale) : progress, buf);
+}
+
 static bool saveMapFile(int xmin, int zmin, int xmax, int ymax, int zmax, wchar_t* mapFileName)
 {
     int temp, retCode;
@@ -9694,33 +10033,56 @@ static bool saveMapFile(int xmin, int zmin, int xmax, int ymax, int zmax, wchar_
     int h = zmax - zmin + 1;
     int zoom = (int)(gCurScale + 0.5f);
 
-    // first, can we even make such an image?
-    progimage_info* mapimage;
-    mapimage = new progimage_info();
-    mapimage->width = zoom * w;
-    mapimage->height = zoom * h;
-
-    // resize and clear
-    mapimage->image_data.resize(w * h * 3 * zoom * zoom * sizeof(unsigned char), 0x0);
-    unsigned char* imageDst = &mapimage->image_data[0];
-
-    // turn off highlight for map draw
-    SetHighlightState(0, xmin, gTargetDepth, zmin, xmax, ymax, zmax, gMinHeight, gMaxHeight, HIGHLIGHT_UNDO_IGNORE);
-
-    ClearUnknownBlockNameString();
-    checkMapDrawErrorCode(
-        DrawMapToArray(imageDst, &gWorldGuide, xmin, zmin, ymax - gMinHeight, gMaxHeight, w, h, zoom, &gOptions, gHitsFound, updateProgress, gMinecraftVersion, gVersionID)
-    );
+    // Render in horizontal bands of whole chunk rows and stream each band out to the PNG, so that memory use
+    // depends on the band size and not the image size. Each chunk is drawn independently of the chunks to its
+    // north and south, so the bands join up seamlessly.
+    size_t blockRowBytes = (size_t)w * 3 * zoom * zoom;
+    int bandChunkRows = (int)(MAP_BAND_MAX_BYTES / (16 * blockRowBytes));
+    if (bandChunkRows < 1) {
+        bandChunkRows = 1;
+    }
+    // no need for a band taller than the map itself, which may touch one more chunk row than h/16
+    bandChunkRows = min(bandChunkRows, h / 16 + 2);
 
     // check if map file has ".png" at the end - if not, add it.
     wchar_t mapFileNameSafe[MAX_PATH_AND_FILE];
     EnsureSuffix(mapFileNameSafe, mapFileName, L".png");
 
     // 0 means success. Currently we don't say what goes wrong otherwise.
-    retCode = writepng(mapimage, 3, mapFileNameSafe);
+    pngstream_info mapstream;
+    retCode = writepngStreamOpen(&mapstream, zoom * w, zoom * h, 3, mapFileNameSafe);
+    if (retCode) {
+        return false;
+    }
 
-    writepng_cleanup(mapimage);
-    delete mapimage;
+    // band image, reused for each band
+    std::vector<unsigned char> bandImage;
+    bandImage.resize(bandChunkRows * 16 * blockRowBytes);
+
+    // turn off highlight for map draw
+    SetHighlightState(0, xmin, gTargetDepth, zmin, xmax, ymax, zmax, gMinHeight, gMaxHeight, HIGHLIGHT_UNDO_IGNORE);
+
+    ClearUnknownBlockNameString();
+    int bandzmin = zmin;
+    while (bandzmin <= zmax && retCode == 0) {
+        // band runs to the end of its last chunk row, or to the end of the map
+        int bandzmax = (int)floor((float)bandzmin / 16.0f) * 16 + bandChunkRows * 16 - 1;
+        if (bandzmax > zmax) {
+            bandzmax = zmax;
+        }
+        int bandh = bandzmax - bandzmin + 1;
+
+        gMapBandProgressStart = (float)(bandzmin - zmin) / (float)h;
+        gMapBandProgressScale = (float)bandh / (float)h;
+        memset(&bandImage[0], 0x0, bandh * blockRowBytes);
+        checkMapDrawErrorCode(
+            DrawMapToArray(&bandImage[0], &gWorldGuide, xmin, bandzmin, ymax - gMinHeight, gMaxHeight, w, bandh, zoom, &gOptions, gHitsFound, updateMapBandProgress, gMinecraftVersion, gVersionID)
+        );
+        retCode = writepngStreamRows(&mapstream, &bandImage[0], bandh * zoom);
+
+        bandzmin = bandzmax + 1;
+    }
+    retCode |= writepngStreamClose(&mapstream);
 
     // turn highlight back on, now that we're done
     SetHighlightState(gHighlightOn, xmin, gTargetDepth, zmin, xmax, gCurDepth, zmax, gMinHeight, gMaxHeight, HIGHLIGHT_UNDO_IGNORE);
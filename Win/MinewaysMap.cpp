@@ -35,13 +35,32 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #include "biomes.h"
 #include <assert.h>
 #include <string.h>
+#include <time.h>
+#include <intrin.h>
+#include <tmmintrin.h>
+#include <mutex>
 
 static void clearUndoHighlight();
 static void copyHighlightState(HighlightBox& destBox, HighlightBox& srcBox);
 static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int topy, int mapMaxY, Options* pOpts,
     ProgressCallback callback, float percent, float & pctprogress, int* hitsFound, int mcVersion, int versionID, int& retCode);
+static unsigned char* compositeHighlight(WorldBlock* block, int bx, int bz, int* hitsFound);
+static void findEdgeHeights(WorldBlock* block, int heightAlloc, int mapMaxY, Options* pOpts, short* heights);
+static int findColumnStart(WorldBlock* block, int x, int z, int clippedMaxHeight, unsigned char& seenempty);
+static inline int findVisibleVoxel(WorldBlock* block, int x, int z, int i, unsigned int viewFilterFlags, bool transparentWater, bool showobscured,
+    unsigned char& seenempty, int& sely, unsigned short& type);
+static WorldBlock* loadChunkToCache(WorldGuide* pWorldGuide, int bx, int bz, Options* pOpts, int mcVersion, int versionID, int& retCode);
+static bool loadChunkLight(WorldGuide* pWorldGuide, WorldBlock* block, int bx, int bz, Options* pOpts, int mcVersion, int versionID);
+static void setChunkDirectory(WorldGuide* pWorldGuide, Options* pOpts);
+static void findViewCorner(double cx, double cz, int w, int h, double zoom, int* startxblock, int* startzblock, int* shiftx, int* shifty);
+static int drawMapTiles(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int* hitsFound,
+    ProgressCallback callback, int mcVersion, int versionID, int loadBudgetMsec, int* pendingChunks);
 static void blit(unsigned char* block, unsigned char* bits, int px, int py, double zoom, int w, int h);
-static WorldBlock* determineMaxFilledHeight(WorldBlock* block);
+static void initBlitKernels();
+static void copyRGBAToRGB(unsigned char* dst, const unsigned char* src, int n);
+static void copyRGBAToRGBZoomed(unsigned char* dst, const unsigned char* src, int n, int zoom);
+static WorldBlock* determineMaxFilledHeight(WorldBlock* block, const short* surfaceTop);
+static void determineOccupancy(WorldBlock* block, const short* surfaceTop);
 static int createBlockFromSchematic(WorldGuide* pWorldGuide, int cx, int cz, WorldBlock* block);
 static void initColors();
 static void saveBadChunkLocation(int bx, int bz);
@@ -53,6 +72,27 @@ static unsigned char gEmptyR, gEmptyG, gEmptyB;
 static unsigned char gBlankTile[16 * 16 * 4];
 static unsigned char gBlankHighlitTile[16 * 16 * 4];
 static unsigned char gBlankTransitionTile[16 * 16 * 4];
+static unsigned char gHighlitTile[16 * 16 * 4];
+static unsigned char gPlaceholderTile[16 * 16 * 4];
+
+// use SSSE3 byte shuffles for converting chunk renders to RGB image rows, if the processor has them
+static int gUseSSSE3Blit = 0;
+// widest run of pixels blit() computes source offsets for in advance; 16 * MAXZOOM is 640
+#define BLIT_MAX_SPAN 1024
+
+// Color lookup table, so that draw() doesn't have to run checkSpecialBlockColor() for every voxel.
+// gColorLUTIndex gives, for each type and data value, which row of 16 light levels in gColorLUT to use, plus one.
+// Rows are filled in as each type and data value pair is first drawn, and all are cleared by initColors()
+// when the color scheme changes. Colors depending on the biome are flagged and used only when biomes are off.
+#define COLOR_LUT_MAX_ROWS  4096
+#define COLOR_LUT_UNSET     0x0000
+#define COLOR_LUT_BIOME     0x8000
+#define COLOR_LUT_ROW_MASK  0x7fff
+#define COLOR_LUT_SLOW      0xffff
+static unsigned short gColorLUTIndex[NUM_BLOCKS_DEFINED * 256];
+static unsigned int gColorLUT[COLOR_LUT_MAX_ROWS * 16];
+static int gColorLUTRows = 0;
+static int gUseColorLUT = 1;
 
 static unsigned short gColormap = 0;
 static long long gMapSeed;
@@ -60,18 +100,12 @@ static long long gMapSeed;
 static HighlightBox gBox = { 0,0,0,0,0,0,0 };
 static HighlightBox gPreviousBox = { 0,0,0,0,0,0,0 };
 
-static int gDirtyBoxMinX = INT_MAX;
-static int gDirtyBoxMinZ = INT_MAX;
-static int gDirtyBoxMaxX = INT_MIN;
-static int gDirtyBoxMaxZ = INT_MIN;
-
 // highlight blend factor and color
 static double gHalpha = 0.3;
 static double gHalphaBorder = 0.8;
 static int gHred = 205;
 static int gHgreen = 50;
 static int gHblue = 255;
-static int gHighlightID = 0;
 static bool gUndoAvailable = false;
 
 // was an unknown block read in?
@@ -84,6 +118,10 @@ static int gUnknownBlockID = 7;
 
 static wchar_t gSeparator[3];
 
+// which chunks are saved in the loaded world's overworld, nether, and end, from the region file headers
+static wchar_t gInventoryWorld[MAX_PATH_AND_FILE];
+static ChunkInventory gChunkInventory[3];
+
 // for which chunk was drawn badly (likely the last bad chunk)
 static int gBx = 0;
 static int gBz = 0;
@@ -130,8 +168,8 @@ void SetHighlightState(int on, int minx, int miny, int minz, int maxx, int maxy,
         gBox.maxY != maxy ||
         gBox.maxZ != maxz)
     {
-        // state has changed, so invalidate rendering caches by changing highlight ID
-        gHighlightID++;
+        // state has changed. Chunk renders don't include the highlight, it's drawn over them
+        // each time by compositeHighlight(), so there's nothing to invalidate.
         gBox.highlightUsed = on;
         gBox.minX = minx;
         gBox.minY = miny;
@@ -139,18 +177,6 @@ void SetHighlightState(int on, int minx, int miny, int minz, int maxx, int maxy,
         gBox.maxX = maxx;
         gBox.maxY = maxy;
         gBox.maxZ = maxz;
-        if (on)
-        {
-            // increase dirty rectangle by new bounds
-            if (gDirtyBoxMinX > minx)
-                gDirtyBoxMinX = minx;
-            if (gDirtyBoxMinZ > minz)
-                gDirtyBoxMinZ = minz;
-            if (gDirtyBoxMaxX < maxx)
-                gDirtyBoxMaxX = maxx;
-            if (gDirtyBoxMaxZ < maxz)
-                gDirtyBoxMaxZ = maxz;
-        }
     }
 }
 
@@ -182,21 +208,7 @@ void UndoHighlight()
 {
     // undo if there's something to undo
     if (UndoHighlightExists()) {
-        // state has changed, so invalidate rendering caches by changing highlight ID - forces update of selection on screen
-        gHighlightID++;
-
         copyHighlightState(gBox, gPreviousBox);
-        if (gBox.highlightUsed) {
-            // increase dirty rectangle by new bounds
-            if (gDirtyBoxMinX > gBox.minX)
-                gDirtyBoxMinX = gBox.minX;
-            if (gDirtyBoxMinZ > gBox.minZ)
-                gDirtyBoxMinZ = gBox.minZ;
-            if (gDirtyBoxMaxX < gBox.maxX)
-                gDirtyBoxMaxX = gBox.maxX;
-            if (gDirtyBoxMaxZ < gBox.maxZ)
-                gDirtyBoxMaxZ = gBox.maxZ;
-        }
 
         // we used up the undo:
         gUndoAvailable = false;
@@ -257,6 +269,66 @@ void GetHighlightState(int* on, int* minx, int* miny, int* minz, int* maxx, int*
 //bits = byte array for output
 //opts = bitmasks of render options (see MinewaysMap.h)
 int DrawMap(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int* hitsFound, ProgressCallback callback, int mcVersion, int versionID)
+{
+    // load every chunk needed, however long it takes
+    return drawMapTiles(pWorldGuide, cx, cz, topy, mapMaxY, w, h, zoom, bits, pOpts, hitsFound, callback, mcVersion, versionID, -1, NULL);
+}
+
+// Same as DrawMap, but chunks not yet in the cache are drawn as placeholders, and at most loadBudgetMsec
+// is spent loading them, closest to the center of the view first. pendingChunks returns how many visible
+// chunks are still not loaded; call again (e.g., on a timer) until this is 0. Since each call only looks
+// at what's currently in view, panning away from an area abandons its remaining loads.
+int DrawMapProgressive(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int* hitsFound, ProgressCallback callback, int mcVersion, int versionID, int loadBudgetMsec, int* pendingChunks)
+{
+    assert(loadBudgetMsec >= 0);
+    return drawMapTiles(pWorldGuide, cx, cz, topy, mapMaxY, w, h, zoom, bits, pOpts, hitsFound, callback, mcVersion, versionID, loadBudgetMsec, pendingChunks);
+}
+
+typedef struct ChunkToLoad {
+    int bx, bz;
+    double dist2;
+} ChunkToLoad;
+
+static int compareChunkDistance(const void* elem1, const void* elem2)
+{
+    double d1 = ((const ChunkToLoad*)elem1)->dist2;
+    double d2 = ((const ChunkToLoad*)elem2)->dist2;
+    return (d1 < d2) ? -1 : ((d1 > d2) ? 1 : 0);
+}
+
+// Find the chunk at the upper left corner of the view and how many pixels its corner is off the screen. The map
+// drawing and IDBlock() both use this, so that what's identified is what's drawn at that location.
+static void findViewCorner(double cx, double cz, int w, int h, double zoom, int* startxblock, int* startzblock, int* shiftx, int* shifty)
+{
+    int blockScale = (int)(16 * zoom);
+
+    // cx/cz is the center, so find the upper left corner from that
+    double startx = cx - (double)w / (2 * zoom);
+    double startz = cz - (double)h / (2 * zoom);
+    // TODO: I suspect these want to be floors, not ints; int
+    // rounds towards 0, floor takes -4.5 and goes to -5.
+    *startxblock = (int)(startx / 16);
+    *startzblock = (int)(startz / 16);
+    *shiftx = (int)((startx - *startxblock * 16) * zoom);
+    *shifty = (int)((startz - *startzblock * 16) * zoom);
+
+    if (*shiftx < 0)
+    {
+        // essentially the floor function
+        (*startxblock)--;
+        *shiftx += blockScale;
+    }
+    if (*shifty < 0)
+    {
+        // essentially the floor function
+        (*startzblock)--;
+        *shifty += blockScale;
+    }
+}
+
+// loadBudgetMsec < 0 means load every chunk needed as it's drawn, else see DrawMapProgressive
+static int drawMapTiles(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int* hitsFound,
+    ProgressCallback callback, int mcVersion, int versionID, int loadBudgetMsec, int* pendingChunks)
 {
     /* We're converting between coordinate systems:
     *
@@ -287,32 +359,74 @@ int DrawMap(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY
     int hBlocks = (w + blockScale * 2) / blockScale;
     int vBlocks = (h + blockScale * 2) / blockScale;
 
-    // cx/cz is the center, so find the upper left corner from that
-    double startx = cx - (double)w / (2 * zoom);
-    double startz = cz - (double)h / (2 * zoom);
-    int startxblock = (int)(startx / 16);
-    int startzblock = (int)(startz / 16);
-    int shiftx = (int)((startx - startxblock * 16) * zoom);
-    int shifty = (int)((startz - startzblock * 16) * zoom);
+    int startxblock, startzblock, shiftx, shifty;
+    findViewCorner(cx, cz, w, h, zoom, &startxblock, &startzblock, &shiftx, &shifty);
 
     int sumRetCode = 0;
     int retCode;
 
-    if (shiftx < 0)
+    if (!gColorsInited)
+        initColors();
+
+    bool progressive = (loadBudgetMsec >= 0);
+    if (progressive && (vBlocks + 1) * (hBlocks + 1) > Cache_Max_Entries())
     {
-        // essentially the floor function
-        startxblock--;
-        shiftx += blockScale;
+        // zoomed out so far that the cache can't hold the whole view, so loading
+        // ahead would just evict chunks loaded on earlier calls and we'd never finish.
+        // Instead load and draw each chunk in turn, as DrawMap does.
+        progressive = false;
+        if (pendingChunks)
+            *pendingChunks = 0;
     }
-    if (shifty < 0)
+    if (progressive)
     {
-        // essentially the floor function
-        startzblock--;
-        shifty += blockScale;
-    }
+        // gather up the visible chunks not yet in the cache and load them, nearest the center of the view first
+        void* data;
+        int numMissing = 0;
+        int numVisible = (vBlocks + 1) * (hBlocks + 1);
+        ChunkToLoad* missing = (ChunkToLoad*)malloc(numVisible * sizeof(ChunkToLoad));
+        if (missing == NULL)
+            return -1;
+        for (z = 0; z <= vBlocks; z++)
+        {
+            for (x = 0; x <= hBlocks; x++)
+            {
+                if (!Cache_Find(startxblock + x, startzblock + z, &data))
+                {
+                    missing[numMissing].bx = startxblock + x;
+                    missing[numMissing].bz = startzblock + z;
+                    double dx = (startxblock + x) * 16 + 8 - cx;
+                    double dz = (startzblock + z) * 16 + 8 - cz;
+                    missing[numMissing].dist2 = dx * dx + dz * dz;
+                    numMissing++;
+                }
+            }
+        }
+        qsort(missing, numMissing, sizeof(ChunkToLoad), compareChunkDistance);
 
-    if (!gColorsInited)
-        initColors();
+        clock_t endTime = clock() + (clock_t)((double)loadBudgetMsec * CLOCKS_PER_SEC / 1000.0);
+        int numLoaded = 0;
+        while (numLoaded < numMissing)
+        {
+            loadChunkToCache(pWorldGuide, missing[numLoaded].bx, missing[numLoaded].bz, pOpts, mcVersion, versionID, retCode);
+            numLoaded++;
+            if (retCode < 0) {
+                sumRetCode = retCode;
+            }
+            else if (sumRetCode >= 0)
+            {
+                sumRetCode |= retCode;
+            }
+            if (clock() >= endTime)
+                break;
+        }
+        free(missing);
+
+        if (pendingChunks)
+            *pendingChunks = numMissing - numLoaded;
+        if (callback && numMissing > numLoaded)
+            callback((float)(numVisible - numMissing + numLoaded) / (float)numVisible, NULL);
+    }
 
     float pctprogress = DRAW_PROGRESS_INCREMENT;
     // x increases south, decreases north
@@ -321,6 +435,13 @@ int DrawMap(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY
         // z increases west, decreases east
         for (x = 0, px = -shiftx; x <= hBlocks; x++, px += blockScale)
         {
+            void* data;
+            if (progressive && !Cache_Find(startxblock + x, startzblock + z, &data))
+            {
+                // not loaded yet, to be filled in on a later call
+                blit(gPlaceholderTile, bits, px, py, zoom, w, h);
+                continue;
+            }
             blockbits = draw(pWorldGuide, startxblock + x, startzblock + z, topy, mapMaxY, pOpts, callback, (float)(z * hBlocks + x) / (float)(vBlocks * hBlocks), pctprogress, hitsFound, mcVersion, versionID, retCode);
             if (retCode < 0) {
                 // preserve the error code, which will (mysteriously) be displayed
@@ -334,23 +455,6 @@ int DrawMap(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY
             blit(blockbits, bits, px, py, zoom, w, h);
         }
     }
-    // clear dirty rectangle, if any
-    if (gBox.highlightUsed)
-    {
-        // box is set to current rectangle
-        // TODO: this isn't quite right, as if you select a large rect, scroll it offscreen
-        // then select new and scroll back, you'll see the highlight.
-        gDirtyBoxMinX = gBox.minX;
-        gDirtyBoxMinZ = gBox.minZ;
-        gDirtyBoxMaxX = gBox.maxX;
-        gDirtyBoxMaxZ = gBox.maxZ;
-    }
-    else
-    {
-        // empty
-        gDirtyBoxMinX = gDirtyBoxMinZ = INT_MAX;
-        gDirtyBoxMaxX = gDirtyBoxMaxZ = INT_MIN;
-    }
 
     return sumRetCode;
 }
@@ -462,43 +566,208 @@ int DrawMapToArray(unsigned char* image, WorldGuide* pWorldGuide, int cx, int cz
             assert(iblockxend > 0 && iblockxend <= chunkSize);
 
             // copy over the data
+            int runPixels = iblockxend - iblockxstart;
             for (int iz = iblockzstart; iz < iblockzend; iz++) {
                 unsigned char* curImg = &image[((iz + b2iz) * zoom * w + (iblockxstart + b2ix)) * zoom * 3];
                 unsigned char* curBits = &blockbits[(iz * chunkSize + iblockxstart) * 4];
-                for (int ix = iblockxstart; ix < iblockxend; ix++) {
-                    // make sure in range
-                    //assert(((iz + b2iz) * w + (ix + b2ix)) >= 0 && ((iz + b2iz) * w + (ix + b2ix)) <= w * h);
+                if (zoom == 1) {
+                    copyRGBAToRGB(curImg, curBits, runPixels);
+                }
+                else {
+                    // fill in the first line of this row of pixels, then copy it down to the rest
+                    copyRGBAToRGBZoomed(curImg, curBits, runPixels, zoom);
+                    for (int imgz = 1; imgz < zoom; imgz++) {
+                        memcpy(curImg + imgz * nextLine, curImg, runPixels * zoom * 3);
+                    }
+                }
+            }
+        }
+    }
+    return sumRetCode;
+}
+
+// For performance testing: draw() each chunk in the given range of chunks "passes" times, first using
+// the color lookup table, then without it. The chunks are loaded before timing starts and each pass forces
+// a fresh render, so this measures the map coloring and not the reading of the world. The Block Test World
+// is chunks 0 to NUM_BLOCKS_DEFINED/2 in X, -3 to 8 in Z. Returns the number of chunks drawn per pass,
+// and the average time in microseconds to draw a chunk with and without the lookup table.
+int BenchmarkMapDraw(WorldGuide* pWorldGuide, int bxmin, int bzmin, int bxmax, int bzmax, int topy, int mapMaxY, Options* pOpts, int passes, int mcVersion, int versionID, double* lutUsec, double* noLutUsec)
+{
+    int bx, bz, pass, useLUT, retCode;
+    int hitsFound[4] = { 0, 0, 0, 0 };
+    // high enough that draw() never calls a progress callback
+    float pctprogress = 2.0f;
+    void* data;
+
+    if (!gColorsInited)
+        initColors();
+
+    // load all the chunks
+    for (bz = bzmin; bz <= bzmax; bz++)
+        for (bx = bxmin; bx <= bxmax; bx++)
+            draw(pWorldGuide, bx, bz, topy, mapMaxY, pOpts, NULL, 0.0f, pctprogress, hitsFound, mcVersion, versionID, retCode);
+
+    int numChunks = (bxmax - bxmin + 1) * (bzmax - bzmin + 1);
+    for (useLUT = 1; useLUT >= 0; useLUT--)
+    {
+        gUseColorLUT = useLUT;
+        clock_t start = clock();
+        for (pass = 0; pass < passes; pass++)
+        {
+            for (bz = bzmin; bz <= bzmax; bz++)
+            {
+                for (bx = bxmin; bx <= bxmax; bx++)
+                {
+                    // force a new render
+                    if (Cache_Find(bx, bz, &data) && data != NULL)
+                        ((WorldBlock*)data)->rendery = -1;
+                    draw(pWorldGuide, bx, bz, topy, mapMaxY, pOpts, NULL, 0.0f, pctprogress, hitsFound, mcVersion, versionID, retCode);
+                }
+            }
+        }
+        double usec = 1000000.0 * (double)(clock() - start) / (double)CLOCKS_PER_SEC / (double)(passes * numChunks);
+        if (useLUT)
+            *lutUsec = usec;
+        else
+            *noLutUsec = usec;
+    }
+    gUseColorLUT = 1;
+    return numChunks;
+}
+
+// For performance testing: render the area of chunks bxmin..bxmax, bzmin..bzmax with DrawMapToArray() "passes" times for each
+// combination of zoom 1, 2, 4 and the map options none, CAVEMODE, LIGHTING, BIOMES, DEPTHSHADING, and all four together. Every
+// pass renders the chunks anew. Any selection highlight is turned off, so that the image depends only on the world, the options,
+// and the colors. Each result gives the chunks and image pixels drawn per second, and the CRC-32 of the image, which must be the
+// same for all passes (else "consistent" is 0) and can be compared across builds, e.g., for the [Block Test World] use chunks
+// 0 to NUM_BLOCKS_DEFINED/2 in X, -3 to 8 in Z. Returns the number of results filled in, at most maxResults.
+int BenchmarkMapRender(WorldGuide* pWorldGuide, int bxmin, int bzmin, int bxmax, int bzmax, int topy, int mapMaxY, Options* pOpts, int passes, int mcVersion, int versionID, MapBenchmarkResult* results, int maxResults)
+{
+    static const int zooms[] = { 1, 2, 4 };
+    static const int masks[] = { 0, CAVEMODE, LIGHTING, BIOMES, DEPTHSHADING, CAVEMODE | LIGHTING | BIOMES | DEPTHSHADING };
+    int bx, bz, pass, iz, im, retCode;
+    int numResults = 0;
+    int hitsFound[4] = { 0, 0, 0, 0 };
+    void* data;
+
+    int w = (bxmax - bxmin + 1) * 16;
+    int h = (bzmax - bzmin + 1) * 16;
+    int numChunks = (bxmax - bxmin + 1) * (bzmax - bzmin + 1);
+    unsigned char* image = (unsigned char*)malloc((size_t)w * h * 3 * 4 * 4);
+    if (image == NULL)
+        return 0;
+
+    // keep the nether or end, if shown, but otherwise use only the options tested
+    Options opts = *pOpts;
+    int baseType = pOpts->worldType & (HELL | ENDER);
+    int highlightUsed = gBox.highlightUsed;
+    gBox.highlightUsed = 0;
+
+    for (iz = 0; iz < (int)(sizeof(zooms) / sizeof(zooms[0])); iz++)
+    {
+        int zoom = zooms[iz];
+        size_t imageSize = (size_t)w * h * 3 * zoom * zoom;
+        for (im = 0; im < (int)(sizeof(masks) / sizeof(masks[0])) && numResults < maxResults; im++)
+        {
+            MapBenchmarkResult* result = &results[numResults++];
+            opts.worldType = baseType | masks[im];
+            result->zoom = zoom;
+            result->worldType = opts.worldType;
+            result->consistent = 1;
+
+            // load the chunks, so that reading the world is not timed
+            DrawMapToArray(image, pWorldGuide, bxmin * 16, bzmin * 16, topy, mapMaxY, w, h, zoom, &opts, hitsFound, NULL, mcVersion, versionID);
+
+            clock_t elapsed = 0;
+            for (pass = 0; pass < passes; pass++)
+            {
+                // force a new render of every chunk
+                for (bz = bzmin; bz <= bzmax; bz++)
+                    for (bx = bxmin; bx <= bxmax; bx++)
+                        if (Cache_Find(bx, bz, &data) && data != NULL)
+                            ((WorldBlock*)data)->rendery = -1;
+
+                clock_t start = clock();
+                retCode = DrawMapToArray(image, pWorldGuide, bxmin * 16, bzmin * 16, topy, mapMaxY, w, h, zoom, &opts, hitsFound, NULL, mcVersion, versionID);
+                elapsed += clock() - start;
+
+                unsigned long checksum = crc32(0L, image, (uInt)imageSize);
+                if (pass == 0)
+                    result->checksum = checksum;
+                else if (checksum != result->checksum)
+                    result->consistent = 0;
+                if (retCode < 0)
+                    result->consistent = 0;
+            }
+            double seconds = (double)elapsed / (double)CLOCKS_PER_SEC;
+            if (seconds <= 0.0) {
+                // too fast to measure
+                result->chunksPerSec = result->pixelsPerSec = 0.0;
+            }
+            else {
+                result->chunksPerSec = (double)passes * (double)numChunks / seconds;
+                result->pixelsPerSec = (double)passes * (double)imageSize / 3.0 / seconds;
+            }
+        }
+    }
+
+    gBox.highlightUsed = highlightUsed;
+    free(image);
+    return numResults;
+}
+
+// For performance testing: convert "passes" rows of chunk pixels to RGB image rows for each zoom from 1 to maxZoom,
+// as DrawMapToArray() does, with and without the SSSE3 kernels. Returns the millions of chunk pixels copied per second
+// for each zoom in simdMpix[zoom-1] and scalarMpix[zoom-1]; simdMpix[] is 0 if the processor doesn't support SSSE3.
+void BenchmarkMapBlit(int maxZoom, int passes, double* simdMpix, double* scalarMpix)
+{
+    int zoom, pass, row, useSIMD;
+    // a chunk-wide image of 16 rows, as for a map export 16 blocks (one chunk) wide
+    unsigned char* image = (unsigned char*)malloc(16 * maxZoom * 16 * maxZoom * 3);
+    if (image == NULL)
+        return;
+
+    if (!gColorsInited)
+        initColors();
+    int hasSSSE3 = gUseSSSE3Blit;
+
+    for (zoom = 1; zoom <= maxZoom; zoom++)
+    {
+        int nextLine = 16 * zoom * 3;
+        for (useSIMD = 1; useSIMD >= 0; useSIMD--)
+        {
+            if (useSIMD && !hasSSSE3) {
+                simdMpix[zoom - 1] = 0.0;
+                continue;
+            }
+            gUseSSSE3Blit = useSIMD;
+            clock_t start = clock();
+            for (pass = 0; pass < passes; pass++)
+            {
+                for (row = 0; row < 16; row++)
+                {
+                    unsigned char* curImg = &image[row * zoom * nextLine];
                     if (zoom == 1) {
-                        *curImg++ = *curBits++;
-                        *curImg++ = *curBits++;
-                        *curImg++ = *curBits++;
-                        curBits++;
+                        copyRGBAToRGB(curImg, &gBlankTile[row * 16 * 4], 16);
                     }
                     else {
-                        // loop and fill in image
-                        unsigned char r = *curBits++;
-                        unsigned char g = *curBits++;
-                        unsigned char b = *curBits++;
-                        curBits++;
-                        unsigned char* curImgLine = curImg;
-                        for (int imgz = 0; imgz < zoom; imgz++) {
-                            unsigned char* curImgLoc = curImgLine;
-                            for (int imgx = 0; imgx < zoom; imgx++) {
-                                *curImgLoc++ = r;
-                                *curImgLoc++ = g;
-                                *curImgLoc++ = b;
-                                //assert(curImgLoc - image <= zoom * zoom * w * h * 3);
-                            }
-                            curImgLine += nextLine;
+                        copyRGBAToRGBZoomed(curImg, &gBlankTile[row * 16 * 4], 16, zoom);
+                        for (int imgz = 1; imgz < zoom; imgz++) {
+                            memcpy(curImg + imgz * nextLine, curImg, 16 * zoom * 3);
                         }
-                        // next pixel start location in line
-                        curImg += zoom * 3;
                     }
                 }
             }
+            double seconds = (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+            double mpix = (seconds > 0.0) ? (double)passes * 16.0 * 16.0 / seconds / 1000000.0 : 0.0;
+            if (useSIMD)
+                simdMpix[zoom - 1] = mpix;
+            else
+                scalarMpix[zoom - 1] = mpix;
         }
     }
-    return sumRetCode;
+    gUseSSSE3Blit = hasSSSE3;
+    free(image);
 }
 
 //bx = x coord of pixel
@@ -514,20 +783,13 @@ int DrawMapToArray(unsigned char* image, WorldGuide* pWorldGuide, int cx, int cz
 //biome is biome found
 const char* IDBlock(int bx, int by, double cx, double cz, int w, int h, int yOffset, double zoom, int* ox, int* oy, int* oz, int* type, int* dataVal, int* biome, bool schematic)
 {
-    //WARNING: keep this code in sync with draw()
+    // Nothing is searched for here: draw() saved the height and block shown at each location when it rendered the chunk.
     WorldBlock* block;
     int x, y, z, px, py, xoff, zoff;
     int blockScale = (int)(16 * zoom);
 
-    // cx/cz is the center, so find the upper left corner from that
-    double startx = cx - (double)w / (2 * zoom);
-    double startz = cz - (double)h / (2 * zoom);
-    // TODO: I suspect these want to be floors, not ints; int
-    // rounds towards 0, floor takes -4.5 and goes to -5.
-    int startxblock = (int)(startx / 16);
-    int startzblock = (int)(startz / 16);
-    int shiftx = (int)((startx - startxblock * 16) * zoom);
-    int shifty = (int)((startz - startzblock * 16) * zoom);
+    int startxblock, startzblock, shiftx, shifty;
+    findViewCorner(cx, cz, w, h, zoom, &startxblock, &startzblock, &shiftx, &shifty);
     // someone could be more than 10000 blocks from spawn, so don't assert
     //assert(cz < 10000);
     //assert(cz > -10000);
@@ -535,17 +797,6 @@ const char* IDBlock(int bx, int by, double cx, double cz, int w, int h, int yOff
     // initialize to "not set"
     *dataVal = 0;
 
-    if (shiftx < 0)
-    {
-        startxblock--;
-        shiftx += blockScale;
-    }
-    if (shifty < 0)
-    {
-        startzblock--;
-        shifty += blockScale;
-    }
-
     // Adjust bx and by so they can be negative.
     // Note that things are a bit weird with numbers here.
     // I check if the mouse location is unreasonably high, which means
@@ -575,8 +826,9 @@ const char* IDBlock(int bx, int by, double cx, double cz, int w, int h, int yOff
     (WorldBlock*)Cache_Find(startxblock + x, startzblock + z, &data);
     block = (WorldBlock*)data;
 
-    // this is assumed OK, that we don't need to actually go retrieve the block if empty, as it should be visible and loaded already
-    if (block == NULL || block->blockType == NBT_NO_SECTIONS)
+    // this is assumed OK, that we don't need to actually go retrieve the block if empty, as it should be visible and loaded already;
+    // if it was read in for some other reason and not yet drawn, there's nothing on the screen to identify
+    if (block == NULL || block->blockType == NBT_NO_SECTIONS || block->rendery == -1)
     {
         *oy = EMPTY_HEIGHT;
         *type = BLOCK_UNKNOWN;
@@ -615,19 +867,8 @@ const char* IDBlock(int bx, int by, double cx, double cz, int w, int h, int yOff
         return "(off map)";
     }
 
-    int chunkIndex = xoff + zoff * 16 + y * 256;
-    assert((chunkIndex >> 8) <= block->maxFilledHeight);  // if block is reduced in size, make sure it's in bounds
-    *type = block->grid[chunkIndex];
-    *dataVal = block->data[chunkIndex];
-
-    // 1.13+ fun: move topmost dataVal value to type - note that BLOCK_HEAD and BLOCK_FLOWER_POT are "reserved" and the high-bit version is not used
-    // Here is where the high data bit gets masked off and moved to the type bit.
-    if (block->mcVersion >= 13) {
-        if ((*dataVal & HIGH_BIT) && (*type != BLOCK_HEAD) && (*type != BLOCK_FLOWER_POT)) {
-            *dataVal &= 0x7F;
-            *type |= 0x100;
-        }
-    }
+    *type = block->renderType[xoff + zoff * 16];
+    *dataVal = block->renderData[xoff + zoff * 16];
 
     return RetrieveBlockSubname(*type, *dataVal); //, block), xoff, y, zoff);
 }
@@ -2356,24 +2597,111 @@ static void blit(unsigned char* block, unsigned char* bits, int px, int py,
     if (bh <= 0) return;
     bits += py * w * 4;
     bits += px * 4;
-    for (y = 0; y < bh; y++, bits += w << 2)
-    {
-        if (y < skipy) continue;
-        yofs = ((int)(y / zoom)) << 6;
-        bitofs = 0;
-        if (zoom == 1.0 && skipx == 0 && bw == 16) {
-            memcpy(bits + bitofs, block + yofs, 16 * 4);
+    if (zoom == 1.0 && skipx == 0 && bw == 16) {
+        for (y = skipy, bits += skipy * (w << 2); y < bh; y++, bits += w << 2)
+        {
+            memcpy(bits, block + (y << 6), 16 * 4);
         }
-        else {
-            for (x = 0; x < bw; x++, bitofs += 4)
+    }
+    else if (bw <= BLIT_MAX_SPAN) {
+        // find which texel each column comes from once, instead of dividing for every pixel;
+        // lines that come from the same row of texels as the line above are copied from it
+        int srcofs[BLIT_MAX_SPAN];
+        for (x = skipx; x < bw; x++)
+            srcofs[x] = ((int)(x / zoom)) << 2;
+        int prevyofs = -1;
+        unsigned char* prevbits = NULL;
+        for (y = skipy, bits += skipy * (w << 2); y < bh; y++, bits += w << 2)
+        {
+            yofs = ((int)(y / zoom)) << 6;
+            if (yofs == prevyofs) {
+                memcpy(bits + skipx * 4, prevbits + skipx * 4, (bw - skipx) * 4);
+            }
+            else {
+                unsigned char* src = block + yofs;
+                for (x = skipx, bitofs = skipx * 4; x < bw; x++, bitofs += 4)
+                {
+                    memcpy(bits + bitofs, src + srcofs[x], 4);
+                }
+                prevyofs = yofs;
+                prevbits = bits;
+            }
+        }
+    }
+    else {
+        for (y = 0; y < bh; y++, bits += w << 2)
+        {
+            if (y < skipy) continue;
+            yofs = ((int)(y / zoom)) << 6;
+            for (x = skipx, bitofs = skipx * 4; x < bw; x++, bitofs += 4)
             {
-                if (x < skipx) continue;
                 memcpy(bits + bitofs, block + yofs + (((int)(x / zoom)) << 2), 4);
             }
         }
     }
 }
 
+static void initBlitKernels()
+{
+    // SSSE3 is CPUID function 1, ECX bit 9
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 1);
+    gUseSSSE3Blit = (cpuInfo[2] & (1 << 9)) ? 1 : 0;
+}
+
+// convert n RGBA pixels to RGB
+static void copyRGBAToRGB(unsigned char* dst, const unsigned char* src, int n)
+{
+    if (gUseSSSE3Blit) {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        // 4 pixels at a time; each store writes 4 bytes past those pixels, so stop while there are
+        // still at least 2 pixels left for those bytes to be overwritten by
+        for (; n >= 6; n -= 4, src += 16, dst += 12)
+            _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), shuffle));
+    }
+    for (; n > 0; n--, src += 4)
+    {
+        *dst++ = src[0];
+        *dst++ = src[1];
+        *dst++ = src[2];
+    }
+}
+
+// convert n RGBA pixels to RGB, each pixel repeated zoom times
+static void copyRGBAToRGBZoomed(unsigned char* dst, const unsigned char* src, int n, int zoom)
+{
+    if (gUseSSSE3Blit && zoom == 2) {
+        const __m128i shuffleLo = _mm_setr_epi8(0, 1, 2, 0, 1, 2, 4, 5, 6, 4, 5, 6, 8, 9, 10, 8);
+        const __m128i shuffleHi = _mm_setr_epi8(9, 10, 12, 13, 14, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+        // 4 pixels to 24 bytes at a time; the second store writes 8 bytes past those, which at least
+        // 2 pixels left will overwrite
+        for (; n >= 6; n -= 4, src += 16, dst += 24)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)src);
+            _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(pixels, shuffleLo));
+            _mm_storeu_si128((__m128i*)(dst + 16), _mm_shuffle_epi8(pixels, shuffleHi));
+        }
+    }
+    for (; n > 1; n--, src += 4)
+    {
+        // store all 4 bytes and step by 3; the extra byte is overwritten by the next copy
+        unsigned int pixel;
+        memcpy(&pixel, src, 4);
+        for (int i = 0; i < zoom; i++, dst += 3)
+            memcpy(dst, &pixel, 4);
+    }
+    if (n == 1)
+    {
+        // last pixel, don't write past the end of the run
+        for (int i = 0; i < zoom; i++)
+        {
+            *dst++ = src[0];
+            *dst++ = src[1];
+            *dst++ = src[2];
+        }
+    }
+}
+
 void CloseAll()
 {
     Cache_Empty();
@@ -2409,7 +2737,8 @@ static unsigned int scaleColor(unsigned int color, float scale)
     return (r << 16) | (g << 8) | b;
 }
 
-static unsigned int checkSpecialBlockColor(WorldBlock* block, unsigned int voxel, unsigned short type, int light, char useBiome, char useElevation)
+// pAffectedByBiome, if not NULL, returns whether the color would change if biomes were used
+static unsigned int checkSpecialBlockColor(WorldBlock* block, unsigned int voxel, unsigned short type, int light, char useBiome, char useElevation, int* pAffectedByBiome)
 {
     unsigned int color = 0xFFFFFF;
     unsigned int r, g, b;
@@ -4446,6 +4775,11 @@ static unsigned int checkSpecialBlockColor(WorldBlock* block, unsigned int voxel
         color = gBlockColors[type * 16 + light];
     }
 
+    if (pAffectedByBiome)
+    {
+        *pAffectedByBiome = affectedByBiome;
+    }
+
     // if biome affects color, then look up color and use it
     if (useBiome && affectedByBiome)
     {
@@ -4556,6 +4890,111 @@ static unsigned int checkSpecialBlockColor(WorldBlock* block, unsigned int voxel
     return color;
 }   // endend
 
+// The first time a type and data value pair is seen, fill in its row of 16 light levels in the color lookup table.
+static unsigned short addColorLUTEntry(WorldBlock* block, unsigned int voxel, unsigned short type, unsigned char dataVal)
+{
+    unsigned short entry;
+    // The top half of a double flower may need the data value of the bottom half (pre-1.13), so it's not
+    // purely a function of its own data value. Also, if the table is full, give up on new entries.
+    if ((type == BLOCK_DOUBLE_FLOWER && (dataVal & 0x8)) || (gColorLUTRows >= COLOR_LUT_MAX_ROWS))
+    {
+        entry = COLOR_LUT_SLOW;
+    }
+    else
+    {
+        int affectedByBiome = 0;
+        unsigned int* row = &gColorLUT[gColorLUTRows * 16];
+        for (int light = 0; light < 16; light++)
+        {
+            row[light] = checkSpecialBlockColor(block, voxel, type, light, 0, 0, &affectedByBiome);
+        }
+        gColorLUTRows++;
+        entry = (unsigned short)gColorLUTRows | (affectedByBiome ? COLOR_LUT_BIOME : 0x0);
+    }
+    gColorLUTIndex[type * 256 + dataVal] = entry;
+    return entry;
+}
+
+// Same result as checkSpecialBlockColor(), but using the lookup table whenever the color depends only on type, data value, and light.
+static unsigned int lookupBlockColor(WorldBlock* block, unsigned int voxel, unsigned short type, int light, char useBiome, char useElevation)
+{
+    if (gUseColorLUT)
+    {
+        unsigned char dataVal = block->data[voxel];
+        unsigned short entry = gColorLUTIndex[type * 256 + dataVal];
+        if (entry == COLOR_LUT_UNSET)
+        {
+            entry = addColorLUTEntry(block, voxel, type, dataVal);
+        }
+        if ((entry != COLOR_LUT_SLOW) && !(useBiome && (entry & COLOR_LUT_BIOME)))
+        {
+            return gColorLUT[((entry & COLOR_LUT_ROW_MASK) - 1) * 16 + light];
+        }
+    }
+    return checkSpecialBlockColor(block, voxel, type, light, useBiome, useElevation, NULL);
+}
+
+// load a chunk for the map's world type and add it to the cache, even if empty or bad,
+// so that we don't try to read it again
+static WorldBlock* loadChunkToCache(WorldGuide* pWorldGuide, int bx, int bz, Options* pOpts, int mcVersion, int versionID, int& retCode)
+{
+    setChunkDirectory(pWorldGuide, pOpts);
+
+    //char debugString[256];
+    //sprintf_s(debugString, 256, "DEBUG: loading %d %d\n", bx, bz);
+    //OutputDebugStringA(debugString);
+
+    WorldBlock* block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, (pOpts->worldType & LIGHTING) != 0, retCode, 0);
+
+    if (retCode < 0) {
+        // save bx and bz for error message later
+        saveBadChunkLocation(bx, bz);
+    }
+
+    // always add the block, even if empty, so that we don't have to look it up as
+    // being empty in the future
+    Cache_Add(bx, bz, block);
+    return block;
+}
+
+// the directory the chunks are read from, for the overworld, nether, or end
+static void setChunkDirectory(WorldGuide* pWorldGuide, Options* pOpts)
+{
+    wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
+    wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
+    if (pOpts->worldType & HELL)
+    {
+        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM-1/");
+    }
+    if (pOpts->worldType & ENDER)
+    {
+        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM1/");
+    }
+}
+
+// Light levels are read in only when the map's lighting option is on. If a cached chunk was read without them,
+// read the chunk again and take its light. Returns false if the cache was emptied to make room (out of memory),
+// in which case "block" is gone.
+static bool loadChunkLight(WorldGuide* pWorldGuide, WorldBlock* block, int bx, int bz, Options* pOpts, int mcVersion, int versionID)
+{
+    int retCode;
+    void* data;
+    setChunkDirectory(pWorldGuide, pOpts);
+    WorldBlock* litBlock = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, true, retCode, 0);
+    if (!Cache_Find(bx, bz, &data) || data != block) {
+        block_free(litBlock);
+        return false;
+    }
+    if (litBlock != NULL) {
+        if (litBlock->light != NULL && litBlock->heightAlloc == block->heightAlloc) {
+            block->light = litBlock->light;
+            litBlock->light = NULL;
+        }
+        block_free(litBlock);
+    }
+    return true;
+}
+
 // Draw a block at chunk bx,bz
 // opts is a bitmask representing render options (see MinewaysMap.h)
 // returns 16x16 set of block colors to use to render map.
@@ -4563,7 +5002,7 @@ static unsigned int checkSpecialBlockColor(WorldBlock* block, unsigned int voxel
 static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAlloc, int mapMaxY, Options* pOpts, ProgressCallback callback, float percent, float & pctprogress, int* hitsFound, int mcVersion, int versionID, int& retCode)
 {
     WorldBlock* block, * prevblock;
-    int ofs = 0, prevy, prevSely, blockSolid, saveHeight;
+    int ofs = 0, prevy, prevSely, saveHeight;
     unsigned int voxel;
     //int hasSlime = 0;
     int x, z, i;
@@ -4600,31 +5039,7 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
 
     if (!found)
     {
-        wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
-        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
-        if (pOpts->worldType & HELL)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM-1/");
-        }
-        if (pOpts->worldType & ENDER)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM1/");
-        }
-
-        //char debugString[256];
-        //sprintf_s(debugString, 256, "DEBUG: loading %d %d\n", bx, bz);
-        //OutputDebugStringA(debugString);
-
-        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, retCode);
-
-        if (retCode < 0) {
-            // save bx and bz for error message later
-            saveBadChunkLocation(bx, bz);
-        }
-
-        // always add the block, even if empty, so that we don't have to look it up as
-        // being empty in the future
-        Cache_Add(bx, bz, block);
+        block = loadChunkToCache(pWorldGuide, bx, bz, pOpts, mcVersion, versionID, retCode);
 
         //let's only update the progress bar if we're loading
         if (callback && (percent > pctprogress) ) {
@@ -4685,54 +5100,57 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
 
     // At this point the block is loaded.
 
-    // Is the block partially or fully inside the dirty area?
-    bool isOnOrInside = (bx * 16 + 15 >= gDirtyBoxMinX && bx * 16 <= gDirtyBoxMaxX &&
-        bz * 16 + 15 >= gDirtyBoxMinZ && bz * 16 <= gDirtyBoxMaxZ);
-
     // already rendered?
     if (block->rendery == heightAlloc && block->renderopts == pOpts->worldType && block->colormap == gColormap)
     {
         void* dummy;
         if (block->rendermissing // wait, the last render was incomplete
-            && Cache_Find(bx, bz + block->rendermissing, &dummy) != NULL) {
+            && Cache_Find(bx - 1, bz, &dummy)) {
             ; // we can do a better render now that the missing block is loaded
         }
         else {
-            // Yes, it's been rendered, but now we need to check if the highlight number is OK:
-            // If the area is inside the highlighted region, renderhilitID==gHighlightID.
-            // If the area is outside the hightlighted region, renderhilitID==0.
-            // Else the area should be redrawn.
-            // final check, is highlighting state OK?
-            if (((block->renderhilitID == gHighlightID) && isOnOrInside) ||
-                ((block->renderhilitID == 0) && !isOnOrInside))
-            {
-                // there's no need to re-render, use cached image already generated
-                return block->rendercache;
-            }
-            // else re-render, to clean up previous highlight
+            // there's no need to re-render, use cached image already generated, with any selection drawn on top
+            return compositeHighlight(block, bx, bz, hitsFound);
         }
     }
 
+    // chunks are read in without their light levels unless lighting is on, so get them now if needed
+    if (lighting && block->light == NULL && !loadChunkLight(pWorldGuide, block, bx, bz, pOpts, mcVersion, versionID))
+        return gBlankTile;
+
     block->rendery = heightAlloc;
     block->renderopts = pOpts->worldType;
-    // if the block to be drawn is inside, note the ID, else note it's "clean" of highlighting;
-    // when we come back next time, the code above will note the rendering is OK.
-    block->renderhilitID = isOnOrInside ? gHighlightID : 0;
     block->rendermissing = 0;
     block->colormap = gColormap;
 
     bits = block->rendercache;
 
-    // find the block to the west, so we can use its heightmap for shading - it should be loaded.
-    // If not, whatever, it's offscreen, perhaps, so the shadow's not exactly correct on the left edge.
-    (WorldBlock*)Cache_Find(bx - 1, bz, &data);
-    prevblock = (WorldBlock*)data;
-
-    if (prevblock == NULL || prevblock->blockType == NBT_NO_SECTIONS)
+    // Find the block to the west, so we can use the heights along its east edge for shading. If it's not loaded,
+    // whatever, it's offscreen, perhaps, so the shadow's not exactly correct on the left edge; note this, so that
+    // it's drawn again if it does get loaded. If it hasn't been drawn with these settings yet, find its heights
+    // without drawing it, so that the shading doesn't depend on the order the chunks are drawn in.
+    short westHeights[16];
+    bool useWest = false;
+    if (!Cache_Find(bx - 1, bz, &data))
+    {
         block->rendermissing = 1; //note no loaded block to west
-    else if (prevblock->rendery != heightAlloc || prevblock->renderopts != pOpts->worldType) {
-        block->rendermissing = 1; //note improperly rendered block to west
-        prevblock = NULL; //block was rendered at a different y level, ignore
+    }
+    else
+    {
+        prevblock = (WorldBlock*)data;
+        if (prevblock != NULL && prevblock->blockType != NBT_NO_SECTIONS)
+        {
+            useWest = true;
+            if (prevblock->rendery == heightAlloc && prevblock->renderopts == pOpts->worldType && prevblock->colormap == gColormap)
+            {
+                for (z = 0; z < 16; z++)
+                    westHeights[z] = prevblock->heightmap[15 + z * 16];
+            }
+            else
+            {
+                findEdgeHeights(prevblock, heightAlloc, mapMaxY, pOpts, westHeights);
+            }
+        }
     }
 
     // what height can we (must we, if we reduce the grid storage) start at?
@@ -4746,8 +5164,8 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
     {
         // prevy is the height of the block to the left (west) of the current block, for shadowing.
         // Note it is set to the previous y height for the loop below.
-        if (prevblock != NULL)
-            prevy = prevblock->heightmap[15 + z * 16];
+        if (useWest)
+            prevy = westHeights[z];
         else
             prevy = -1;
 
@@ -4758,7 +5176,6 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
             saveHeight = -1; // the "not found" value.
             bool hitGrid = false;
 
-            voxel = ((clippedMaxHeight * 16 + z) * 16 + x);
             r = gEmptyR;
             g = gEmptyG;
             b = gEmptyB;
@@ -4768,93 +5185,70 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
             // the next solid block is then shown. If it's solid all the way down, the block will be
             // drawn as "empty". Note we truly want to test maxHeight here, not clippedMaxHeight.
             seenempty = (heightAlloc == mapMaxY ? 1 : 0);
+            int startHeight = findColumnStart(block, x, z, clippedMaxHeight, seenempty);
             alpha = 0.0;
-            // go from top down through all voxels, looking for the first one visible.
-            for (i = clippedMaxHeight; i >= 0; i--, voxel -= 16 * 16)
+            // go from top down through all voxels, looking for the first one visible, and blend in each one
+            // drawn until an opaque one is hit.
+            for (i = startHeight; (i = findVisibleVoxel(block, x, z, i, viewFilterFlags, transparentWater, showobscured, seenempty, prevSely, type)) >= 0; i--)
             {
-                type = retrieveType(block, voxel);
-                // if block is air or something very small, or water when transparent water is flagged, note it's empty and continue to next voxel
-                if ((type == BLOCK_AIR) ||
-                    !(gBlockDefinitions[type].flags & viewFilterFlags) ||
-                    (transparentWater && (type == BLOCK_STATIONARY_WATER || type == BLOCK_WATER)))
-                {
-                    seenempty = 1;
-                    continue;
-                }
-
-                // special selection height: we want to be able to select water
+                voxel = ((i * 16 + z) * 16 + x);
                 float currentAlpha = gBlockDefinitions[type].alpha;
-                // water is considered "solid"
-                blockSolid = (currentAlpha != 0.0f); // ((type<NUM_BLOCKS_MAP) || (type ==255)) && 
-                if ((showobscured || seenempty) && blockSolid)
-                    if (prevSely == -1)
-                        prevSely = i;
-
-                // non-flowing water does not count when finding the displayed height, so that we can reveal what is
-                // underneath the water.
-                if (type == BLOCK_STATIONARY_WATER)
-                    seenempty = 1;
-
-                // if showobscured is on, or voxel is air or water (seenempty)
-                // AND the voxel id is valid (in our array of known values)
-                // AND it's not entirely transparent, then process it
-                if ((showobscured || seenempty) && blockSolid)
+                int light = 12;
+                if (lighting)
                 {
-                    int light = 12;
-                    if (lighting)
-                    {
-                        if (i < mapMaxY)
-                        {
-                            light = block->light[voxel / 2];
-                            if (voxel & 1) light >>= 4;
-                            light &= 0xf;
-                        }
-                        else
-                        {
-                            light = 0;
-                        }
-                    }
-                    // if it's the first voxel visible (i.e., there was no block at all to the west), note this depth.
-                    if (prevy == -1)
-                        prevy = i;
-                    else if (prevy < i)   // fully lit on west side of block?
-                        light += 2;
-                    else if (prevy > i)   // in shadow?
-                        light -= 5;
-                    light = clamp(light, 1, 15);
-
-                    // Here is where the color of the block is retrieved.
-                    // First we check if there's a special color for this block,
-                    // such as for wool, terracotta, carpet, etc. If not, then
-                    // we can look the quick lookup value from the table.
-                    color = checkSpecialBlockColor(block, voxel, type, light, useBiome, useElevation);
-
-                    // is this the first block encountered?
-                    if (alpha == 0.0)
+                    if (i < mapMaxY && block->light != NULL)
                     {
-                        // yes; since there's no accumulated alpha, simply substitute the values into place;
-                        // note that semi-transparent values already have their alpha multiplied in.
-                        saveHeight = i;
-                        alpha = currentAlpha;
-                        r = (unsigned char)(color >> 16);
-                        g = (unsigned char)((color >> 8) & 0xff);
-                        b = (unsigned char)(color & 0xff);
+                        light = block->light[voxel / 2];
+                        if (voxel & 1) light >>= 4;
+                        light &= 0xf;
                     }
                     else
                     {
-                        // Else need to blend in this color with the previous.
-                        // This is an "under" operation, putting the new color under the previous
-                        // accumulated alpha
-                        r += (unsigned char)((1.0 - alpha) * (color >> 16));
-                        g += (unsigned char)((1.0 - alpha) * ((color >> 8) & 0xff));
-                        b += (unsigned char)((1.0 - alpha) * (color & 0xff));
-                        alpha += currentAlpha * (1.0 - alpha);
+                        light = 0;
                     }
-                    // if the current block's color is fully opaque, finish.
-                    if (currentAlpha == 1.0f)
-                        break;
                 }
+                // if it's the first voxel visible (i.e., there was no block at all to the west), note this depth.
+                if (prevy == -1)
+                    prevy = i;
+                else if (prevy < i)   // fully lit on west side of block?
+                    light += 2;
+                else if (prevy > i)   // in shadow?
+                    light -= 5;
+                light = clamp(light, 1, 15);
+
+                // Here is where the color of the block is retrieved.
+                // First we check if there's a special color for this block,
+                // such as for wool, terracotta, carpet, etc. If not, then
+                // we can look the quick lookup value from the table.
+                color = lookupBlockColor(block, voxel, type, light, useBiome, useElevation);
+
+                // is this the first block encountered?
+                if (alpha == 0.0)
+                {
+                    // yes; since there's no accumulated alpha, simply substitute the values into place;
+                    // note that semi-transparent values already have their alpha multiplied in.
+                    saveHeight = i;
+                    alpha = currentAlpha;
+                    r = (unsigned char)(color >> 16);
+                    g = (unsigned char)((color >> 8) & 0xff);
+                    b = (unsigned char)(color & 0xff);
+                }
+                else
+                {
+                    // Else need to blend in this color with the previous.
+                    // This is an "under" operation, putting the new color under the previous
+                    // accumulated alpha
+                    r += (unsigned char)((1.0 - alpha) * (color >> 16));
+                    g += (unsigned char)((1.0 - alpha) * ((color >> 8) & 0xff));
+                    b += (unsigned char)((1.0 - alpha) * (color & 0xff));
+                    alpha += currentAlpha * (1.0 - alpha);
+                }
+                // if the current block's color is fully opaque, finish.
+                if (currentAlpha == 1.0f)
+                    break;
             }
+            // where the search ended, for cave mode
+            voxel = ((i * 16 + z) * 16 + x);
 
             // The solid location (or none at all, in which case -1 is set) is saved here.
             // If everything is visible, then the height map will store the highest object found,
@@ -4919,6 +5313,12 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
                     if (type == BLOCK_AIR)
                     {
                         seenempty = 1;
+                        // skip the rest of an all-air section
+                        if (!(block->sectionMask & (1 << (i >> 4))) || (block->sectionUniform & (1 << (i >> 4))))
+                        {
+                            voxel -= (i & 0xf) * 16 * 16;
+                            i &= ~0xf;
+                        }
                         continue;
                     }
                     if (seenempty && gBlockDefinitions[type].alpha != 0.0) // ((type<NUM_BLOCKS_MAP) || (type ==255)) &&
@@ -4928,6 +5328,12 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
                         b = (unsigned char)(b * (prevy - i + 10) / 138);
                         break;
                     }
+                    // skip the rest of a section that's all this same block, e.g., solid stone
+                    if (block->sectionUniform & (1 << (i >> 4)))
+                    {
+                        voxel -= (i & 0xf) * 16 * 16;
+                        i &= ~0xf;
+                    }
                 }
             }
 
@@ -4948,93 +5354,12 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
                 hitGrid = true;
             }
 
-            if (gBox.highlightUsed) {
-                // make selected area slightly red, if at right heightmap range
-                if (bx * 16 + x >= gBox.minX && bx * 16 + x <= gBox.maxX &&
-                    bz * 16 + z >= gBox.minZ && bz * 16 + z <= gBox.maxZ)
-                {
-                    // test and save minimum height found
-                    if (prevSely >= 0 && prevSely < hitsFound[3])
-                    {
-                        // the minimum visible selected height found so far
-                        hitsFound[3] = prevSely;
-                    }
-
-                    // in bounds, is the height good?
-                    // First case is for if we hit nothing, all void, so it's black:
-                    // always highlight that area, just for readability.
-                    if ((prevSely == -1) || (prevSely >= gBox.minY && prevSely <= gBox.maxY))
-                    {
-                        hitsFound[1] = 1;
-                        // blend in highlight color
-                        blend = gHalpha;
-                        // are we on a border? If so, change blend factor
-                        if (prevSely == gBox.minY || prevSely == gBox.maxY ||
-                            bx * 16 + x == gBox.minX || bx * 16 + x == gBox.maxX ||
-                            bz * 16 + z == gBox.minZ || bz * 16 + z == gBox.maxZ)
-                        {
-                            blend = gHalphaBorder;
-                        }
-                        r = (unsigned char)((double)r * (1.0 - blend) + blend * (double)gHred);
-                        g = (unsigned char)((double)g * (1.0 - blend) + blend * (double)gHgreen);
-                        b = (unsigned char)((double)b * (1.0 - blend) + blend * (double)gHblue);
-                    }
-                    else if (prevSely < gBox.minY)
-                    {
-                        hitsFound[0] = 1;
-                        // lower than selection box, so if exactly on border, dim
-                        if (bx * 16 + x == gBox.minX || bx * 16 + x == gBox.maxX ||
-                            bz * 16 + z == gBox.minZ || bz * 16 + z == gBox.maxZ)
-                        {
-                            double dim = 0.5;
-                            r = (unsigned char)((double)r * dim);
-                            g = (unsigned char)((double)g * dim);
-                            b = (unsigned char)((double)b * dim);
-                        }
-                    }
-                    else
-                    {
-                        hitsFound[2] = 1;
-                        // higher than selection box, so if exactly on border, brighten
-                        // - I don't think it's actually possible to hit this condition,
-                        // as the area above the selection box should never be seen (the
-                        // slider sets the maximum), but just in case things change...
-                        if (bx * 16 + x == gBox.minX || bx * 16 + x == gBox.maxX ||
-                            bz * 16 + z == gBox.minZ || bz * 16 + z == gBox.maxZ)
-                        {
-                            double brighten = 0.5;
-                            r = (unsigned char)((double)r * (1.0 - brighten) + brighten);
-                            g = (unsigned char)((double)g * (1.0 - brighten) + brighten);
-                            b = (unsigned char)((double)b * (1.0 - brighten) + brighten);
-                        }
-                    }
-                }
-            }
-
             if (prevy == -1 && !hitGrid) {
                 // empty, so make it background color to start
                 unsigned char* clr = &gBlankTile[(x + z * 16) * 4];
                 r = *clr++;
                 g = *clr++;
                 b = *clr; // ++ if you add alpha
-                // highlight the block if in selected area, as otherwise it looks like it's missing with schematics.
-                // Make selected area slightly red
-                if (gBox.highlightUsed &&
-                    bx * 16 + x >= gBox.minX && bx * 16 + x <= gBox.maxX &&
-                    bz * 16 + z >= gBox.minZ && bz * 16 + z <= gBox.maxZ)
-                {
-                    // blend in highlight color
-                    blend = gHalpha;
-                    // are we on a border? If so, change blend factor
-                    if (bx * 16 + x == gBox.minX || bx * 16 + x == gBox.maxX ||
-                        bz * 16 + z == gBox.minZ || bz * 16 + z == gBox.maxZ)
-                    {
-                        blend = gHalphaBorder;
-                    }
-                    r = (unsigned char)((double)r * (1.0 - blend) + blend * (double)gHred);
-                    g = (unsigned char)((double)g * (1.0 - blend) + blend * (double)gHgreen);
-                    b = (unsigned char)((double)b * (1.0 - blend) + blend * (double)gHblue);
-                }
             }
 
             // to make the map look like a heightfield instead
@@ -5053,13 +5378,231 @@ static unsigned char* draw(WorldGuide* pWorldGuide, int bx, int bz, int heightAl
             // heightmap determines what value is displayed on status and for shadowing. If "show all" is on,
             // save any semi-visible thing, else save the first solid thing (or possibly nothing == -1).
             block->heightmap[x + z * 16] = (prevy < 0) ? EMPTY_HEIGHT : (short)prevy;
+            // and save what's there, for IDBlock()
+            if (prevy >= 0)
+            {
+                voxel = (prevy * 16 + z) * 16 + x;
+                type = retrieveType(block, voxel);
+                block->renderType[x + z * 16] = (unsigned short)type;
+                // 1.13+ fun: the high data bit, if moved to the type, is masked off
+                block->renderData[x + z * 16] = (type & 0x100) ? (block->data[voxel] & 0x7F) : block->data[voxel];
+            }
+            // the selection highlight is tinted by this height, the first solid visible block (or -1 if none)
+            block->selectHeight[x + z * 16] = (short)prevSely;
+        }
+    }
+    return compositeHighlight(block, bx, bz, hitsFound);
+}
+
+// Find the heights draw() would save in the heightmap along the east edge of a chunk, without working out any colors.
+static void findEdgeHeights(WorldBlock* block, int heightAlloc, int mapMaxY, Options* pOpts, short* heights)
+{
+    int x = 15;
+    bool showobscured = !(pOpts->worldType & HIDEOBSCURED);
+    bool transparentWater = !!(pOpts->worldType & TRANSPARENT_WATER);
+    bool showAll = !!(pOpts->worldType & SHOWALL);
+    unsigned int viewFilterFlags = BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF | BLF_MIDDLER | BLF_BILLBOARD | BLF_PANE | BLF_FLATTEN |   // what's visible
+        (showAll ? (BLF_FLATTEN_SMALL | BLF_SMALL_MIDDLER | BLF_SMALL_BILLBOARD) : 0x0);
+
+    int clippedMaxHeight = heightAlloc;
+    if (block->maxFilledHeight < clippedMaxHeight && block->maxFilledHeight > EMPTY_MAX_HEIGHT) {
+        clippedMaxHeight = block->maxFilledHeight;
+    }
+    for (int z = 0; z < 16; z++)
+    {
+        int i;
+        int saveHeight = -1;
+        int sely = -1;
+        unsigned short type;
+        unsigned char seenempty = (heightAlloc == mapMaxY ? 1 : 0);
+        int startHeight = findColumnStart(block, x, z, clippedMaxHeight, seenempty);
+        for (i = startHeight; (i = findVisibleVoxel(block, x, z, i, viewFilterFlags, transparentWater, showobscured, seenempty, sely, type)) >= 0; i--)
+        {
+            // the first block drawn is the one saved for "show all"; the search ends at the first opaque block
+            if (saveHeight < 0)
+                saveHeight = i;
+            if (gBlockDefinitions[type].alpha == 1.0f)
+                break;
+        }
+        int height = showAll ? saveHeight : i;
+        heights[z] = (height < 0) ? EMPTY_HEIGHT : (short)height;
+    }
+}
+
+// Where the search down a column for what's drawn starts: the highest non-air voxel in the column, if that's below
+// clippedMaxHeight. Everything skipped over is air, so seenempty is then set.
+static int findColumnStart(WorldBlock* block, int x, int z, int clippedMaxHeight, unsigned char& seenempty)
+{
+    int startHeight = clippedMaxHeight;
+    if (block->columnTop[z * 16 + x] < startHeight)
+    {
+        startHeight = block->columnTop[z * 16 + x];
+        seenempty = 1;
+    }
+    return startHeight;
+}
+
+// The search down a column for what's drawn on the map, used by draw() and findEdgeHeights(). Starting at height i,
+// return the height of the next voxel drawn, and its type, or a negative height if there is none. Air, blocks the view filters leave
+// out, and water when it's transparent are passed over and count as empty space; unless showing obscured blocks, a
+// block is drawn only if there's empty space, or non-flowing water, above it. sely gets the highest block drawn
+// that can be selected, if not already set. This is the inner loop of drawing the map, hence inline.
+static inline int findVisibleVoxel(WorldBlock* block, int x, int z, int i, unsigned int viewFilterFlags, bool transparentWater, bool showobscured,
+    unsigned char& seenempty, int& sely, unsigned short& type)
+{
+    // work on copies, so that they can stay in registers
+    unsigned char empty = seenempty;
+    unsigned short voxelType = type;
+    unsigned int voxel = ((i * 16 + z) * 16 + x);
+    for (; i >= 0; i--, voxel -= 16 * 16)
+    {
+        voxelType = retrieveType(block, voxel);
+        // if block is air or something very small, or water when transparent water is flagged, note it's empty and continue to next voxel
+        if ((voxelType == BLOCK_AIR) ||
+            !(gBlockDefinitions[voxelType].flags & viewFilterFlags) ||
+            (transparentWater && (voxelType == BLOCK_STATIONARY_WATER || voxelType == BLOCK_WATER)))
+        {
+            empty = 1;
+            // if the rest of this section is all air, or all this same block, go to the top of the section below
+            if (!(block->sectionMask & (1 << (i >> 4))) || (block->sectionUniform & (1 << (i >> 4))))
+            {
+                voxel -= (i & 0xf) * 16 * 16;
+                i &= ~0xf;
+            }
+            continue;
+        }
+
+        // special selection height: we want to be able to select water, which is considered "solid"
+        bool blockSolid = (gBlockDefinitions[voxelType].alpha != 0.0f);
+        if ((showobscured || empty) && blockSolid)
+            if (sely == -1)
+                sely = i;
+
+        // non-flowing water does not count when finding the displayed height, so that we can reveal what is
+        // underneath the water.
+        if (voxelType == BLOCK_STATIONARY_WATER)
+            empty = 1;
+
+        // if showobscured is on, or voxel is air or water (seenempty)
+        // AND it's not entirely transparent, then it's drawn
+        if ((showobscured || empty) && blockSolid)
+            break;
+
+        if (block->sectionUniform & (1 << (i >> 4)))
+        {
+            // the rest of this section is this same block, which won't be drawn either, so go to the section below
+            voxel -= (i & 0xf) * 16 * 16;
+            i &= ~0xf;
+        }
+    }
+    seenempty = empty;
+    type = voxelType;
+    return i;
+}
+
+static void blendHighlight(unsigned char* pixel, double blend)
+{
+    pixel[0] = (unsigned char)((double)pixel[0] * (1.0 - blend) + blend * (double)gHred);
+    pixel[1] = (unsigned char)((double)pixel[1] * (1.0 - blend) + blend * (double)gHgreen);
+    pixel[2] = (unsigned char)((double)pixel[2] * (1.0 - blend) + blend * (double)gHblue);
+}
+
+// The selection highlight is drawn over a chunk's render each time the chunk is displayed, so that changing the
+// selection doesn't force the chunk to be rendered again. Returns the chunk's rendercache if it's outside
+// the selection, else a highlit copy in gHighlitTile, which is good until the next call.
+// The tint goes over the finished pixel, i.e., after lighting, depth shading, relief and the map grid, which is
+// where draw() always applied it, so the highlit map looks just as it did when the tint was part of the render.
+// hitsFound notes whether visible blocks in the selected area are below, in, and above the selection's heights.
+static unsigned char* compositeHighlight(WorldBlock* block, int bx, int bz, int* hitsFound)
+{
+    int x, z;
+    double blend;
+
+    if (!gBox.highlightUsed ||
+        (bx * 16 + 15 < gBox.minX) || (bx * 16 > gBox.maxX) ||
+        (bz * 16 + 15 < gBox.minZ) || (bz * 16 > gBox.maxZ))
+        return block->rendercache;
+
+    bool mapGrid = !!(block->renderopts & MAP_GRID);
+    memcpy(gHighlitTile, block->rendercache, 16 * 16 * 4);
+    // z increases south, decreases north
+    for (z = 0; z < 16; z++)
+    {
+        if (bz * 16 + z < gBox.minZ || bz * 16 + z > gBox.maxZ)
+            continue;
+        // x increases west, decreases east
+        for (x = 0; x < 16; x++)
+        {
+            if (bx * 16 + x < gBox.minX || bx * 16 + x > gBox.maxX)
+                continue;
+
+            unsigned char* pixel = &gHighlitTile[(x + z * 16) * 4];
+            int prevSely = block->selectHeight[x + z * 16];
+            bool onBorder = (bx * 16 + x == gBox.minX || bx * 16 + x == gBox.maxX ||
+                bz * 16 + z == gBox.minZ || bz * 16 + z == gBox.maxZ);
+            // nothing visible, and no grid line, means the background color was put here
+            bool background = (block->heightmap[x + z * 16] == EMPTY_HEIGHT) && !(mapGrid && (x == 0 || z == 0));
+
+            // test and save minimum height found
+            if (prevSely >= 0 && prevSely < hitsFound[3])
+            {
+                // the minimum visible selected height found so far
+                hitsFound[3] = prevSely;
+            }
+
+            // in bounds, is the height good?
+            // First case is for if we hit nothing, all void, so it's black:
+            // always highlight that area, just for readability.
+            if ((prevSely == -1) || (prevSely >= gBox.minY && prevSely <= gBox.maxY))
+            {
+                hitsFound[1] = 1;
+                if (!background)
+                {
+                    // blend in highlight color; are we on a border? If so, change blend factor
+                    blend = (onBorder || prevSely == gBox.minY || prevSely == gBox.maxY) ? gHalphaBorder : gHalpha;
+                    blendHighlight(pixel, blend);
+                }
+            }
+            else if (prevSely < gBox.minY)
+            {
+                hitsFound[0] = 1;
+                // lower than selection box, so if exactly on border, dim
+                if (onBorder && !background)
+                {
+                    double dim = 0.5;
+                    pixel[0] = (unsigned char)((double)pixel[0] * dim);
+                    pixel[1] = (unsigned char)((double)pixel[1] * dim);
+                    pixel[2] = (unsigned char)((double)pixel[2] * dim);
+                }
+            }
+            else
+            {
+                hitsFound[2] = 1;
+                // higher than selection box, so if exactly on border, brighten
+                // - I don't think it's actually possible to hit this condition,
+                // as the area above the selection box should never be seen (the
+                // slider sets the maximum), but just in case things change...
+                if (onBorder && !background)
+                {
+                    double brighten = 0.5;
+                    pixel[0] = (unsigned char)((double)pixel[0] * (1.0 - brighten) + brighten);
+                    pixel[1] = (unsigned char)((double)pixel[1] * (1.0 - brighten) + brighten);
+                    pixel[2] = (unsigned char)((double)pixel[2] * (1.0 - brighten) + brighten);
+                }
+            }
+
+            // highlight the background if in selected area, as otherwise it looks like it's missing with schematics.
+            if (background)
+            {
+                blendHighlight(pixel, onBorder ? gHalphaBorder : gHalpha);
+            }
         }
     }
-    return bits;
+    return gHighlitTile;
 }
 
 // if it fails, that's OK, it just does nothing
-void GetChunkHeights(WorldGuide* pWorldGuide, int& minHeight, int& maxHeight, int mcVersion, int mx, int mz)
+void GetChunkHeights(WorldGuide* pWorldGuide, int& minHeight, int& maxHeight, int mx, int mz)
 {
     wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
     wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
@@ -5077,7 +5620,7 @@ void GetChunkHeights(WorldGuide* pWorldGuide, int& minHeight, int& maxHeight, in
     int cz = mz / 16;
 
     // ignore failure - means nothing happened
-    (void)regionTestHeights(pWorldGuide->directory, minHeight, maxHeight, mcVersion, cx, cz);
+    (void)regionTestHeights(pWorldGuide->directory, minHeight, maxHeight, cx, cz);
 
     // Unfortunately, the 1.17 regionTestHeights doesn't work so great. It will detect the minHeight just fine (normally), but not the maxHeight, necessarily.
     // So, we assume that, if the minHeight got kicked down to below -64, assume a data pack is in use and set maxHeight to 511.
@@ -7270,8 +7813,96 @@ void testNumeral(WorldBlock* block, int type, int y, int digitPlace, int outType
     }
 }
 
+// the gChunkInventory index for the overworld, nether, or end
+static int inventoryIndex(int worldType)
+{
+    return (worldType & HELL) ? 1 : ((worldType & ENDER) ? 2 : 0);
+}
+
+// Find which chunks are saved in each dimension of the world, by reading the 8KB header of every region file.
+// Returns the total number of chunks found, or -1 if out of memory.
+int ScanChunkInventory(WorldGuide* pWorldGuide)
+{
+    ClearChunkInventory();
+    if (pWorldGuide->type != WORLD_LEVEL_TYPE)
+        return 0;
+
+    // same directories as setChunkDirectory() uses
+    static const wchar_t* dimensionDirectory[3] = { L"", L"DIM-1/", L"DIM1/" };
+    wchar_t directories[3][MAX_PATH_AND_FILE];
+    wchar_t* directoryList[3];
+    for (int i = 0; i < 3; i++) {
+        swprintf_s(directories[i], MAX_PATH_AND_FILE, L"%s%s%s", pWorldGuide->world, gSeparator, dimensionDirectory[i]);
+        directoryList[i] = directories[i];
+    }
+    int numChunks = regionScanInventory(directoryList, gChunkInventory, 3);
+    if (numChunks < 0) {
+        ClearChunkInventory();
+        return -1;
+    }
+    wcscpy_s(gInventoryWorld, MAX_PATH_AND_FILE, pWorldGuide->world);
+    return numChunks;
+}
+
+void ClearChunkInventory()
+{
+    for (int i = 0; i < 3; i++) {
+        regionFreeInventory(&gChunkInventory[i]);
+    }
+    gInventoryWorld[0] = (wchar_t)0;
+}
+
+// The chunks saved in the dimension shown by these map options, or NULL if the world hasn't been scanned.
+const ChunkInventory* GetChunkInventory(WorldGuide* pWorldGuide, int worldType)
+{
+    if (pWorldGuide->type != WORLD_LEVEL_TYPE || gInventoryWorld[0] == (wchar_t)0 || wcscmp(gInventoryWorld, pWorldGuide->world) != 0)
+        return NULL;
+    return &gChunkInventory[inventoryIndex(worldType)];
+}
+
+// Count the saved chunks in an area, and their total compressed size - a rough guide to how much work
+// exporting the area is. Returns -1 if the world hasn't been scanned.
+int CountSavedChunks(WorldGuide* pWorldGuide, int worldType, int bxmin, int bzmin, int bxmax, int bzmax, long long* compressedBytes)
+{
+    const ChunkInventory* inventory = GetChunkInventory(pWorldGuide, worldType);
+    *compressedBytes = 0;
+    if (inventory == NULL)
+        return -1;
+    int numChunks = 0;
+    for (int r = 0; r < inventory->numRegions; r++) {
+        const RegionInventory* region = &inventory->regions[r];
+        if (region->rx < (bxmin >> 5) || region->rx > (bxmax >> 5) || region->rz < (bzmin >> 5) || region->rz > (bzmax >> 5))
+            continue;
+        for (int i = 0; i < 32 * 32; i++) {
+            int bx = region->rx * 32 + (i & 31);
+            int bz = region->rz * 32 + (i >> 5);
+            if ((region->present[i >> 5] & (1u << (i & 31))) && bx >= bxmin && bx <= bxmax && bz >= bzmin && bz <= bzmax) {
+                numChunks++;
+                *compressedBytes += 4096 * (long long)region->sectors[i];
+            }
+        }
+    }
+    return numChunks;
+}
+
+// the inventory for the dimension LoadBlock() is reading from, going by the directory name
+static ChunkInventory* directoryInventory(WorldGuide* pWorldGuide)
+{
+    size_t worldLength = wcslen(gInventoryWorld);
+    if (gInventoryWorld[0] == (wchar_t)0 || wcsncmp(gInventoryWorld, pWorldGuide->directory, worldLength) != 0)
+        return NULL;
+    const wchar_t* dimension = pWorldGuide->directory + worldLength;
+    if (wcsstr(dimension, L"DIM-1") != NULL)
+        return &gChunkInventory[1];
+    if (wcsstr(dimension, L"DIM1") != NULL)
+        return &gChunkInventory[2];
+    return &gChunkInventory[0];
+}
+
 // return NULL if no block loaded.
-WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, int versionID, int& retCode)
+// withLight says to also read in the block light levels, needed only for drawing the map with lighting
+// bufferSet is which set of buffers to read the chunk with, 0 for the main thread, else one per thread reading chunks
+WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, int versionID, bool withLight, int& retCode, int bufferSet)
 {
     // return negative value on error, 1 on read OK, 2 on read and it's empty, and higher bits than 1 or 2 are warnings
     retCode = 0;
@@ -7287,12 +7918,23 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
         }
     }
 
+    // don't look in the region file for a chunk its header says isn't there
+    if (pWorldGuide->type == WORLD_LEVEL_TYPE) {
+        ChunkInventory* inventory = directoryInventory(pWorldGuide);
+        if (inventory != NULL && !regionChunkPresent(inventory, pWorldGuide->directory, cx, cz)) {
+            return NULL;
+        }
+    }
+
     // WorldBlock* block = block_alloc(MAX_ARRAY_HEIGHT(versionID, mcVersion));
     WorldBlock* block = block_alloc(pWorldGuide->minHeight, pWorldGuide->maxHeight);
 
-    // out of memory? If so, clear cache and cross fingers
+    // out of memory? If so, clear cache and cross fingers.
+    // Export reads in chunks with several threads at once, which do not otherwise touch the cache, so this is locked.
     if (block == NULL)
     {
+        static std::mutex emptyCacheMutex;
+        std::lock_guard<std::mutex> lock(emptyCacheMutex);
         Cache_Empty();
         //block = block_alloc(MAX_ARRAY_HEIGHT(versionID, mcVersion));
         block = block_alloc(pWorldGuide->minHeight, pWorldGuide->maxHeight);
@@ -7301,8 +7943,12 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
             return NULL;
         }
     }
+    // if there's no memory for light, go without
+    if (withLight)
+        block_alloc_light(block);
     // always set
     block->rendery = -1; // force redraw
+    block->lowestSurface[0] = block->lowestSurface[1] = -1;
     block->mcVersion = mcVersion;
     block->versionID = versionID;
     // this version of 1.17 beta went to a height of 384;
@@ -7328,8 +7974,8 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
         memset(block->grid, 0, 16 * 16 * block->maxHeight);
         memset(block->data, 0, 16 * 16 * block->maxHeight);
         memset(block->biome, 1, 16 * 16);
-        memset(block->light, 0xff, 16 * 16 * block->maxHeight/2);
-        block->renderhilitID = 0;
+        if (block->light)
+            memset(block->light, 0xff, 16 * 16 * block->maxHeight/2);
 
         if (type >= 0 && type < NUM_BLOCKS_DEFINED && cz >= 0 && cz < 8)
         {
@@ -7354,7 +8000,7 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
                 testBlock(block, type + 1, blockHeight, cz * 2);
                 testBlock(block, type + 1, blockHeight, cz * 2 + 1);
             }
-            return determineMaxFilledHeight(block);
+            return determineMaxFilledHeight(block, NULL);
         }
         // tick marks
         else if (type >= 0 && type < NUM_BLOCKS_DEFINED && (cz == -1 || cz == 8))
@@ -7382,7 +8028,7 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
                     }
                 }
             }
-            return determineMaxFilledHeight(block);
+            return determineMaxFilledHeight(block, NULL);
         }
         // numbers (yes, I'm insane)
         else if (type >= 0 && type < NUM_BLOCKS_DEFINED && (cz <= -2 && cz >= -3))
@@ -7417,7 +8063,7 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
                 testNumeral(block, type + 1, blockHeight, -cz * 2 - 3, letterType);
                 testNumeral(block, type + 1, blockHeight, -cz * 2 - 1 - 3, letterType);
             }
-            return determineMaxFilledHeight(block);
+            return determineMaxFilledHeight(block, NULL);
         }
         else
         {
@@ -7426,6 +8072,10 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
         }
     }
     else {
+        // the chunk's own record of the top of each column, if it has one
+        short surfaceTop[16 * 16];
+        bool surfaceFound = false;
+
         // it's a real world or schematic or no world is loaded
         if (pWorldGuide->type == WORLD_LEVEL_TYPE) {
             // absolute insanely high maximum, just in case - 384 is fine here, just to be safe, since it's temporary storage
@@ -7434,7 +8084,7 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
 
             // Given coordinates, check if the file for that location exists, data for the chunk exists, and populate the block.
             // Return 
-            retCode = regionGetBlocks(pWorldGuide->directory, cx, cz, block->grid, block->data, block->light, block->biome, blockEntities, &block->numEntities, block->mcVersion, block->minHeight, block->maxHeight, block->maxFilledSectionHeight, gUnknownBlockName, gUnknownBlockID);
+            retCode = regionGetBlocks(pWorldGuide->directory, cx, cz, block->grid, block->data, block->light, block->biome, blockEntities, &block->numEntities, block->mcVersion, block->minHeight, block->maxHeight, block->maxFilledSectionHeight, gUnknownBlockName, gUnknownBlockID, surfaceTop, surfaceFound, bufferSet);
             assert(block->numEntities <= 384);  // if higher, the allocation above needs to change!
 
             if (retCode == ERROR_INFLATE) {
@@ -7473,7 +8123,7 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
         if (block->blockType == NBT_VALID_BLOCK) {
             int i;
             // TODO someday: we could actually free the block, but the logic's a bit tricky. Leaving it be, since it works.
-            determineMaxFilledHeight(block);
+            determineMaxFilledHeight(block, surfaceFound ? surfaceTop : NULL);
 
             // look for unknown blocks and recover
             unsigned char* pBlockID = block->grid;
@@ -7502,7 +8152,8 @@ WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int cx, int cz, int mcVersion, in
     return NULL;
 }
 
-static WorldBlock* determineMaxFilledHeight(WorldBlock* block)
+// surfaceTop, if not NULL, is the top of each column, as stored in the chunk's heightmap
+static WorldBlock* determineMaxFilledHeight(WorldBlock* block, const short* surfaceTop)
 {
     int i;
     bool searchMaxHeight = true;
@@ -7525,6 +8176,8 @@ static WorldBlock* determineMaxFilledHeight(WorldBlock* block)
         //return NULL;
     }
 
+    determineOccupancy(block, surfaceTop);
+
     // and, realloc, if set to minimize memory
     block_realloc(block);
 
@@ -7532,6 +8185,137 @@ static WorldBlock* determineMaxFilledHeight(WorldBlock* block)
 
 }
 
+// Find the highest level that is not air in each column, which 16-level sections have anything in them,
+// and which are all one block, so that draw() and export can skip through these sections in one go.
+// "Not air" here matches what retrieveType() returns.
+// If the chunk's heightmap is given, each column is searched starting at its top where the sections show it's
+// not out of date, rather than searching all the columns level by level from the top of the chunk.
+static void determineOccupancy(WorldBlock* block, const short* surfaceTop)
+{
+    int i, y;
+    int columnsFound = 0;
+    bool useHighBit = (block->mcVersion >= 13);
+
+    // Only sections that are entirely at or below maxFilledHeight are tested, since the rest may not be allocated.
+    // Comparing each array with itself shifted by one finds whether every byte is the same, and quits at the
+    // first difference, which for a typical mixed section comes right away.
+    block->sectionUniform = 0x0;
+    for (int section = 0; section * 16 + 15 <= block->maxFilledHeight; section++)
+    {
+        unsigned char* pBlockID = block->grid + section * 16 * 16 * 16;
+        unsigned char* pData = block->data + section * 16 * 16 * 16;
+        if ((memcmp(pBlockID, pBlockID + 1, 16 * 16 * 16 - 1) == 0) && (memcmp(pData, pData + 1, 16 * 16 * 16 - 1) == 0))
+            block->sectionUniform |= 1 << section;
+    }
+
+    block->sectionMask = 0x0;
+    if (surfaceTop != NULL)
+    {
+        // The heightmap can be out of date, e.g., if the chunk was changed by a program that doesn't update it, so
+        // which sections have anything in them is found from the sections themselves, and the heightmap is only a hint.
+        int topSection = -1;
+        for (int section = block->maxFilledHeight >> 4; section >= 0; section--)
+        {
+            if (block->sectionUniform & (1 << section))
+            {
+                // all one block, so just look at the first one
+                i = section * 16 * 16 * 16;
+                if (block->grid[i] || (useHighBit && (block->data[i] & 0x80)))
+                    block->sectionMask |= 1 << section;
+                continue;
+            }
+            int top = (section * 16 + 15 < block->maxFilledHeight) ? section * 16 + 15 : block->maxFilledHeight;
+            for (i = section * 16 * 16 * 16; i < (top + 1) * 16 * 16; i++)
+            {
+                if (block->grid[i] || (useHighBit && (block->data[i] & 0x80)))
+                {
+                    block->sectionMask |= 1 << section;
+                    break;
+                }
+            }
+        }
+        for (int section = block->maxFilledHeight >> 4; section >= 0; section--)
+        {
+            if (block->sectionMask & (1 << section))
+            {
+                topSection = section;
+                break;
+            }
+        }
+
+        // A column's heightmap top is used only if no section above the one it's in has anything in it; else
+        // the heightmap may have missed blocks added above, so the column is searched from the top. Blocks may also
+        // have been added above it in its own section, so the search starts at the top of that section. Either way,
+        // the heightmap counts some blocks as not air that we treat as air, e.g., light blocks, so look down from there.
+        int searchTop = (topSection * 16 + 15 < block->maxFilledHeight) ? topSection * 16 + 15 : block->maxFilledHeight;
+        for (i = 0; i < 16 * 16; i++)
+        {
+            y = surfaceTop[i];
+            if ((y < 0) || ((y >> 4) < topSection))
+                y = searchTop;
+            else
+                y = ((y | 0xf) < block->maxFilledHeight) ? (y | 0xf) : block->maxFilledHeight;
+            for (; y >= 0; y--)
+            {
+                int voxel = y * 16 * 16 + i;
+                if (block->grid[voxel] || (useHighBit && (block->data[voxel] & 0x80)))
+                    break;
+            }
+            block->columnTop[i] = (short)y;
+        }
+        return;
+    }
+    for (i = 0; i < 16 * 16; i++)
+        block->columnTop[i] = -1;
+
+    for (y = block->maxFilledHeight; y >= 0; y--)
+    {
+        unsigned char* pBlockID = block->grid + y * 16 * 16;
+        unsigned char* pData = block->data + y * 16 * 16;
+        unsigned int sectionBit = 1 << (y >> 4);
+        if (block->sectionUniform & sectionBit)
+        {
+            // at the top of a section that's all one block: if it's not air, it's the top of any column not yet found
+            if (pBlockID[0] || (useHighBit && (pData[0] & 0x80)))
+            {
+                block->sectionMask |= sectionBit;
+                for (i = 0; i < 16 * 16; i++)
+                {
+                    if (block->columnTop[i] < 0)
+                    {
+                        block->columnTop[i] = (short)y;
+                        columnsFound++;
+                    }
+                }
+            }
+            y &= ~0xf;
+            continue;
+        }
+        for (i = 0; i < 16 * 16; i++)
+        {
+            if (pBlockID[i] || (useHighBit && (pData[i] & 0x80)))
+            {
+                block->sectionMask |= sectionBit;
+                if (block->columnTop[i] < 0)
+                {
+                    block->columnTop[i] = (short)y;
+                    columnsFound++;
+                }
+                else if (columnsFound == 16 * 16)
+                {
+                    // all columns have their tops, so all that's left is to know whether this section is filled: it is
+                    break;
+                }
+            }
+        }
+        // once all columns are found and this section is known to be filled, go to the top of the section below
+        if ((columnsFound == 16 * 16) && (block->sectionMask & sectionBit))
+        {
+            y &= ~0xf;
+        }
+    }
+}
+
 // cx and cz are the chunk location - multiply by 16 to get the starting world location
 // return 1 if real data is found, 0 if all empty
 int createBlockFromSchematic(WorldGuide* pWorldGuide, int cx, int cz, WorldBlock* block)
@@ -7547,7 +8331,8 @@ int createBlockFromSchematic(WorldGuide* pWorldGuide, int cx, int cz, WorldBlock
     // no biome, so that's easy
     memset(block->biome, 0, 16 * 16);
     // no light, so that's also easy
-    memset(block->light, 0, 16 * 16 * block->heightAlloc/2);
+    if (block->light)
+        memset(block->light, 0, 16 * 16 * block->heightAlloc/2);
 
     // clear the rest, so we fill these in as found
     memset(block->grid, 0, 16 * 16 * block->heightAlloc);
@@ -7680,6 +8465,28 @@ int GetFileVersionId(const wchar_t* world, int* versionId)
     return retcode;
 }
 
+// 0 succeed, 1+ windows file open fail, -1 or less is some other read error from nbt, including
+// that level.dat doesn't give the overworld's heights, which is usual
+int GetLevelHeights(const wchar_t* world, int* minHeight, int* maxHeight)
+{
+    bfFile bf;
+    wchar_t filename[300];
+    wcsncpy_s(filename, 300, world, wcslen(world) + 1);
+    wcscat_s(filename, 300, gSeparator);
+    wcscat_s(filename, 300, L"level.dat");
+    int err = 0;
+    bf = newNBT(filename, &err);
+    if (bf.gz == 0x0) return err;
+    int minY, height;
+    int retcode = nbtGetLevelHeights(&bf, &minY, &height);
+    nbtClose(&bf);
+    if (retcode == 0) {
+        *minHeight = minY;
+        *maxHeight = minY + height - 1;
+    }
+    return retcode;
+}
+
 /* currently not used
 // 0 succeed, 1+ windows file open fail, -1 or less is some other read error from nbt
 int GetFileVersionName(const wchar_t* world, char* versionName, int stringLength)
@@ -7788,6 +8595,12 @@ void SetMapPremultipliedColors(int start)
     }
 }
 
+// Changes whenever the colors or alphas of the blocks change
+unsigned short GetMapColormap()
+{
+    return gColormap;
+}
+
 //Sets the colors used.
 //palette should be in RGBA format
 // done from the color scheme, as possible
@@ -7815,6 +8628,10 @@ void SetMapPalette(unsigned int* palette, int num)
 static void initColors()
 {
     gColorsInited = 1;
+    initBlitKernels();
+    // start the color lookup table over
+    memset(gColorLUTIndex, 0, sizeof(gColorLUTIndex));
+    gColorLUTRows = 0;
     for (unsigned int i = 0; i < NUM_BLOCKS_DEFINED; i++)
     {
         unsigned int color = gBlockDefinitions[i].pcolor;
@@ -7862,6 +8679,13 @@ static void initColors()
             gBlankHighlitTile[off + 1] = (unsigned char)((double)gBlankTile[off + 1] * (1.0 - gHalpha) + gHalpha * (double)gHgreen);
             gBlankHighlitTile[off + 2] = (unsigned char)((double)gBlankTile[off + 2] * (1.0 - gHalpha) + gHalpha * (double)gHblue);
             gBlankHighlitTile[off + 3] = (unsigned char)255;
+
+            // chunk not loaded yet, for progressive drawing: lighter, with diagonal stripes
+            tone = (((rx + ry) / 4) % 2) ? 180 : 170;
+            gPlaceholderTile[off] = (unsigned char)tone;
+            gPlaceholderTile[off + 1] = (unsigned char)tone;
+            gPlaceholderTile[off + 2] = (unsigned char)tone;
+            gPlaceholderTile[off + 3] = (unsigned char)255;
         }
     }
 }
@@ -91,6 +91,16 @@ typedef struct HighlightBox {
     int maxZ;
 } HighlightBox;
 
+// one zoom and set of map options timed by BenchmarkMapRender
+typedef struct MapBenchmarkResult {
+    int zoom;
+    int worldType;
+    double chunksPerSec;
+    double pixelsPerSec;
+    unsigned long checksum;
+    int consistent;
+} MapBenchmarkResult;
+
 // push values
 #define HIGHLIGHT_UNDO_IGNORE   0
 #define HIGHLIGHT_UNDO_PUSH     1
@@ -104,11 +114,20 @@ void SetHighlightState(int on, int minx, int miny, int minz, int maxx, int maxy,
 void GetHighlightState(int* on, int* minx, int* miny, int* minz, int* maxx, int* maxy, int* maxz, int mapMinHeight);
 int DrawMapToArray(unsigned char* image, WorldGuide* pWorldGuide, int cx, int cz, int topy, int mapMaxY, int w, int h, int zoom, Options* pOpts, int* hitsFound, ProgressCallback callback, int mcVersion, int versionID);
 int DrawMap(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int hitsFound[3], ProgressCallback callback, int mcVersion, int versionID);
+int DrawMapProgressive(WorldGuide* pWorldGuide, double cx, double cz, int topy, int mapMaxY, int w, int h, double zoom, unsigned char* bits, Options* pOpts, int hitsFound[3], ProgressCallback callback, int mcVersion, int versionID, int loadBudgetMsec, int* pendingChunks);
+int BenchmarkMapDraw(WorldGuide* pWorldGuide, int bxmin, int bzmin, int bxmax, int bzmax, int topy, int mapMaxY, Options* pOpts, int passes, int mcVersion, int versionID, double* lutUsec, double* noLutUsec);
+void BenchmarkMapBlit(int maxZoom, int passes, double* simdMpix, double* scalarMpix);
+int BenchmarkMapRender(WorldGuide* pWorldGuide, int bxmin, int bzmin, int bxmax, int bzmax, int topy, int mapMaxY, Options* pOpts, int passes, int mcVersion, int versionID, MapBenchmarkResult* results, int maxResults);
 const char* IDBlock(int bx, int by, double cx, double cz, int w, int h, int yOffset, double zoom, int* ox, int* oy, int* oz, int* type, int* dataVal, int* biome, bool schematic);
 const char* RetrieveBlockSubname(int type, int dataVal); //, WorldBlock* block = NULL, int xoff = 0, int y = 0, int zoff = 0);
 void CloseAll();
-WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int bx, int bz, int mcVersion, int versionID, int& retCode);
-void GetChunkHeights(WorldGuide* pWorldGuide, int& minHeight, int& maxHeight, int mcVersion, int mx, int mz);
+WorldBlock* LoadBlock(WorldGuide* pWorldGuide, int bx, int bz, int mcVersion, int versionID, bool withLight, int& retCode, int bufferSet);
+void GetChunkHeights(WorldGuide* pWorldGuide, int& minHeight, int& maxHeight, int mx, int mz);
+int ScanChunkInventory(WorldGuide* pWorldGuide);
+void ClearChunkInventory();
+const struct ChunkInventory* GetChunkInventory(WorldGuide* pWorldGuide, int worldType);
+int CountSavedChunks(WorldGuide* pWorldGuide, int worldType, int bxmin, int bzmin, int bxmax, int bzmax, long long* compressedBytes);
+unsigned short GetMapColormap();
 void ClearBlockReadCheck();
 int UnknownBlockRead();
 void CheckUnknownBlock(int check);
@@ -116,6 +135,7 @@ int NeedToCheckUnknownBlock();
 int GetSpawn(const wchar_t* world, int* x, int* y, int* z);
 int GetFileVersion(const wchar_t* world, int* version, wchar_t* fileOpened, rsize_t size);
 int GetFileVersionId(const wchar_t* world, int* versionId);
+int GetLevelHeights(const wchar_t* world, int* minHeight, int* maxHeight);
 // currently not used: int GetFileVersionName(const wchar_t* world, char* versionName, int stringLength);
 int GetLevelName(const wchar_t* world, char* levelName, int stringLength);
 int GetPlayer(const wchar_t* world, int* px, int* py, int* pz);
@@ -34,12 +34,19 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #include "rwpng.h"
 #include "vector.h"
 #include "mdlFiles.h"
+#include "OutputBuffer.h"
 #include <assert.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 #include <time.h>
+#include <stdarg.h>
+#include <emmintrin.h>
 
 #include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
 
 // Set to a tiny number to have front and back faces of billboards be separated a bit.
 // TODO: currently works only for those billboards made by using the various multitile calls,
@@ -78,13 +85,65 @@ DWORD br;
 // if we see this value, it's probably bad
 #define UNINITIALIZED_INT	-98789
 
-typedef struct BoxCell {
-    int group;	// for 3D printing, what connected group a block is part of
-    unsigned short type;
-    unsigned short origType;
-    unsigned char flatFlags;	// pointer to which origType to use for face output, for "merged" snow, redstone, etc. in cell above
-    unsigned char data;     // extra data for block (wool color, etc.); note that four top bits are not used
-} BoxCell;
+// The export box, each value kept in an array of its own, indexed by BOX_INDEX, so that a cell takes 6 bytes instead
+// of 12, and loops that look only at types, such as the neighbor tests with gFaceOffset, read only the types.
+typedef struct BoxData {
+    int* group;	// for 3D printing, what connected group a block is part of; NULL unless groups are needed
+    unsigned short* type;
+    unsigned short* origType;
+    unsigned char* flatFlags;	// pointer to which origType to use for face output, for "merged" snow, redstone, etc. in cell above
+    unsigned char* data;     // extra data for block (wool color, etc.); note that four top bits are not used
+} BoxData;
+
+// What populateBox() learns about a chunk while it's read in
+typedef struct ChunkSummary {
+    int bx;
+    int bz;
+    int topY;   // world Y of the highest level with anything in it, or INT_MIN if the chunk is empty or missing
+} ChunkSummary;
+
+// chunks are read in and saved off for export this many at a time, by a set of threads
+#define EXPORT_BATCH_SIZE 256
+// fewer chunks than this are not worth starting threads for
+#define EXPORT_MIN_PARALLEL 4
+// one set of chunk reading buffers per thread, see regionGetBlocks()
+#define EXPORT_MAX_THREADS REGION_BUFFER_SETS
+
+// How sortFaces() orders the faces, the same as the comparison function named
+#define FACE_SORT_BY_FACE_ID        0   // faceIdCompare()
+#define FACE_SORT_BY_TILE_ID        1   // tileIdCompare()
+#define FACE_SORT_BY_USD_TILE_ID    2   // tileUSDIdCompare()
+// fewer faces than this are sorted by a single thread
+#define FACE_SORT_MIN_PARALLEL 65536
+
+// The faces of the full blocks are made by a set of threads, each doing a slab of the box, a range of X rows, with its
+// own vertices and faces. The slabs are then merged into the model in order, so the results are the same as if made
+// by a single thread. This is what made each face, for adding its UVs when merging.
+typedef struct FaceSource {
+    int boxIndex;
+    unsigned char faceDirection;
+    unsigned char dataVal;
+    bool firstFace;
+    bool fluidHeights;  // the top of the face is at the fluid's height
+} FaceSource;
+
+typedef struct FaceSlab {
+    int minX, maxX;     // rows done, in box coordinates
+    int* lastPlane;     // vertex indices for the plane of vertices just past maxX; NULL if the slab is the last one
+    Point* vertices;
+    int* vertexGridIndex;   // location of each vertex in the vertex grid, or -1 if not in the grid
+    int vertexCount;
+    int vertexListSize;
+    FaceRecord** faceList;
+    FaceSource* faceSource;
+    int faceCount;
+    int faceSize;
+    FaceRecordPool* faceRecordPool;
+    int retCode;
+} FaceSlab;
+
+// the most slabs the box is split into for making faces
+#define FACE_MAX_SLABS (2 * EXPORT_MAX_THREADS)
 
 typedef struct BoxGroup
 {
@@ -94,7 +153,7 @@ typedef struct BoxGroup
     IBox bounds;	// the box that this group occupies. Not valid if population is 0 (merged)
 } BoxGroup;
 
-static BoxCell* gBoxData = NULL;
+static BoxData gBoxData = { NULL, NULL, NULL, NULL, NULL };
 static unsigned char* gBiomeArray = NULL;
 static IPoint gBoxSize;
 static int gBoxSizeYZ = UNINITIALIZED_INT;
@@ -110,6 +169,12 @@ static Point gFilledBoxSize;    // in centimeters
 static IBox gSolidWorldBox;  // area of solid box in world coordinates
 static IPoint gWorld2BoxOffset;
 
+// When exporting in tiles, the tile being exported, in box coordinates. The box also holds the cells just past the tile's
+// sides, so that neighbors are known, but what these output is thrown away: it's output with the neighboring tile.
+static IBox gTileBox;
+// how many chunks wide each tile is, in X and Z
+#define EXPORT_TILE_CHUNKS 8
+
 Model gModel;
 
 typedef struct FillAlpha {
@@ -179,6 +244,9 @@ static int gMinHeight = 0;
 
 static int gBadBlocksInModel = 0;
 
+// if set, runChunkJobs() does all the jobs on this thread, for checking that the threads give the same results
+static bool gExportSerial = false;
+
 // If set, the current faces being output will (probably) be transformed later.
 // This is important to know for merging faces: if faces are to later be rotated, etc.,
 // then their geometric coordinates cannot be used for seeing if the face should be removed
@@ -381,9 +449,9 @@ static int gFaceDirectionVector[6][3] =
 };
 
 // I wish file writing was faster. Don't know why it seems so slow. TODO. Relevant? https://stackoverflow.com/questions/64795981/how-to-make-fs-writefile-faster-for-an-image
-#define WERROR_MODEL(x) if(x) { assert(0); PortaClose(gModelFile); return MW_CANNOT_WRITE_TO_FILE; }
-#define WERROR_FH(x) if(x) { assert(0); PortaClose(fh); return MW_CANNOT_WRITE_TO_FILE; }
-#define WERROR_SPECIFY(x,FHANDLE) if(x) { assert(0); PortaClose(FHANDLE); return MW_CANNOT_WRITE_TO_FILE; }
+#define WERROR_MODEL(x) if(x) { assert(0); OutBuf_Close(gModelFile); return MW_CANNOT_WRITE_TO_FILE; }
+#define WERROR_FH(x) if(x) { assert(0); OutBuf_Close(fh); return MW_CANNOT_WRITE_TO_FILE; }
+#define WERROR_SPECIFY(x,FHANDLE) if(x) { assert(0); OutBuf_Close(FHANDLE); return MW_CANNOT_WRITE_TO_FILE; }
 
 
 // feed world coordinate in to get box index: in our coordinate system, X is dominant, Z is next, Y is weakest.
@@ -475,7 +543,7 @@ ProgressValues gProgress;
 
 // objects that are waterlogged should be considered fully in water, as if the block was in water
 #define IS_WATERLOGGED(tval,bi) ((gBlockDefinitions[tval].flags & BLF_WATERLOG) || \
-								((gBlockDefinitions[tval].flags & BLF_MAYWATERLOG) && !(gBlockDefinitions[tval].flags & BLF_LAME_WATERLOG) && (gBoxData[bi].data & WATERLOGGED_BIT)))
+								((gBlockDefinitions[tval].flags & BLF_MAYWATERLOG) && !(gBlockDefinitions[tval].flags & BLF_LAME_WATERLOG) && (gBoxData.data[bi] & WATERLOGGED_BIT)))
 
 #define IS_FLUID(tval,bi)	(((tval) >= BLOCK_WATER && (tval) <= BLOCK_STATIONARY_LAVA) || IS_WATERLOGGED(tval,bi))
 #define IS_NOT_FLUID(tval,bi)	(!IS_FLUID(tval,bi))
@@ -552,6 +620,17 @@ typedef struct TouchRecord {
 // Now part of the system, but left in here to show what's related to welding.
 //#define WELD_USD_VERTICES
 //#ifdef WELD_USD_VERTICES
+// Values are welded with an open addressing hash table of unique value IDs. Minecraft geometry is made on a 1/16 block
+// lattice, and normals and tile UVs nearly all land on it too, so a value with all its components on the lattice is keyed
+// by its packed lattice coordinates, which match exactly. Anything else, e.g., rotated geometry or a sloped normal, is
+// keyed by a hash of its bits, with WELD_OFF_LATTICE set, and its floats are compared.
+#define WELD_LATTICE_SCALE 16.0f
+// lattice coordinates are stored in 21 bits each, so must be less than this in magnitude
+#define WELD_LATTICE_LIMIT 1048576
+#define WELD_OFF_LATTICE 0x8000000000000000ULL
+#define WELD_TABLE_LOCATION(key, mask) (weldMix(key) & (mask))
+
+// The way values used to be welded, now used just by BenchmarkUSDWeld()
 typedef struct VertexHash
 {
     int id; // the index ID this vertex has; matching vertices will use this ID
@@ -570,10 +649,11 @@ typedef struct OutDataArrays
     int* indices;   // indices to vertices
 //#ifdef WELD_USD_VERTICES
     int* indicesWelded; // indices to vertices, removing duplicates; size of this is different than the vhashes, it's the list of indices
-    int weldedHashSize;    // the number or hashes and locations allocated for hashing
+    int weldedHashSize;    // the most unique vertices, normals, or st's there can be in any mesh
     int vertCountWelded;  // number of vertices needed, in list below, i.e., unique vertices; list size is vertCount
-    VertexHash** vhashLocation; // pointers to hashes for the vertex locations - indexed by hash location computed
-    VertexHash* vhashPool; // pool of hashes for the vertices/normals/st's. vertCountWelded gives the next one we can "allocate"
+    int* weldTable;   // hash table of unique value IDs, -1 if empty; a power of two in size
+    unsigned int weldTableSize;
+    unsigned long long* weldKeys;   // the key of each unique value, by ID
     Point** welded; // list of pointers to unique vertices, normals, or st's, dependeing
 //#endif
     int facesize; // size of array
@@ -602,13 +682,24 @@ static void convertCharPathUnderlined(char* worldNameUnderlined, char* worldChar
 
 static void initializeWorldData(IBox* worldBox, int xmin, int ymin, int zmin, int xmax, int ymax, int zmax);
 static int initializeModelData();
+static int initializeOutputTexture();
+static bool canExportInTiles(int fileType, ChangeBlockCommand* pCBC, IBox* worldBox);
 
 static int readTerrainPNG(const wchar_t* curDir, progimage_info* pII, wchar_t* terrainFileName, int category, int exportFileType);
 static void invertImage(progimage_info* dst);
 
 static int populateBox(WorldGuide* pWorldGuide, ChangeBlockCommand* pCBC, IBox* box);
-static void findChunkBounds(WorldGuide* pWorldGuide, int bx, int bz, IBox* worldBox, int mcVersion, int versionID);
-static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* box, int mcVersion, int versionID);
+static bool boxNeedsGroups();
+static bool allocBoxData(int size, bool groups);
+static void freeBoxData();
+static void setExportDirectory(WorldGuide* pWorldGuide);
+static WorldBlock* findExportChunk(WorldGuide* pWorldGuide, int bx, int bz, int mcVersion, int versionID);
+static void readChunkBatch(WorldGuide* pWorldGuide, ChunkSummary** batch, int count, IBox* worldBox, IBox* readWorldBox);
+static void useChunkForExport(WorldBlock* block, ChunkSummary* pCS, IBox* worldBox, IBox* readWorldBox, IBox* solidBox);
+static void findChunkBounds(WorldBlock* block, int bx, int bz, IBox* worldBox, IBox* solidBox);
+static void extractChunk(WorldBlock* block, int bx, int bz, IBox* readWorldBox);
+static bool tightenBox(IPoint oldBoxSize, IPoint oldWorld2BoxOffset, IBox* edgeWorldBox);
+static void clearBoxCells(int boxIndex, int count);
 static bool willChangeBlockCommandModifyAir(ChangeBlockCommand* pCBC);
 static void modifySides(int editMode);
 static void modifySlab(int by, int editMode);
@@ -619,6 +710,7 @@ static bool applyChangeBlockCommand(ChangeBlockCommand* pCBC);
 static bool isWorldVolumeEmpty();
 static void computeRedstoneConnectivity(int boxIndex);
 static int computeFlatFlags(int boxIndex);
+static int saveCellBillboardOrGeometry(int boxIndex, int type);
 static int firstFaceModifier(int isFirst, int faceIndex);
 static void wobbleObjectLocation(int boxIndex, float& shiftX, float& shiftZ);
 static void randomRotation(int boxIndex, int& angle);
@@ -710,12 +802,20 @@ static int tileIdDeleteAndCompare(void* context, const void* str1, const void* s
 static int tileUSDIdDeleteAndCompare(void* context, const void* str1, const void* str2);
 #endif
 static int faceIdCompare(void* context, const void* str1, const void* str2);
+static void sortFaces(FaceRecord** faceList, int faceCount, int sortType);
+static void getFaceSortFields(FaceRecord* face, int sortType, int fields[4]);
 static int chunkUSDCompare(void* context, const void* str1, const void* str2);
 static int instanceUSDCompare(void* context, const void* str1, const void* str2);
 
-static int getDimensionsAndCount(Point dimensions);
+static int getDimensionsAndCount(Point dimensions, IBox* filledBounds);
 static void rotateLocation(Point pt);
-static int checkAndCreateFaces(int boxIndex, IPoint loc);
+static int createFacesInSlabs(IBox* faceBox);
+static int mergeFaceSlabs(FaceSlab* slabs, int numSlabs);
+static int* vertexGridEntry(FaceSlab* pSlab, int vertexIndex);
+static int addFaceVertex(FaceSlab* pSlab, int gridIndex, float x, float y, float z, int* pIndex);
+static FaceRecord* allocSlabFaceRecord(FaceSlab* pSlab);
+static int addSlabFace(FaceSlab* pSlab, FaceRecord* face, int boxIndex, int faceDirection, int dataVal, int fluidHeights, int firstFace);
+static int checkAndCreateFaces(FaceSlab* pSlab, int boxIndex, IPoint loc);
 static int checkMakeFace(int type, int neighborType, int view3D, int testPartial, int faceDirection, int boxIndex, int neighborBoxIndex, int fluidFullBlock);
 static int neighborMayCoverFace(int neighborType, int view3D, int testPartial, int faceDirection, int neighborBoxIndex);
 static int lesserBlockCoversWholeFace(int faceDirection, int neighborBoxIndex, int view3D);
@@ -724,9 +824,10 @@ static int cornerHeights(int boxIndex, float heights[4]);
 static float computeUpperCornerHeight(int boxIndex, int x, int z);
 static float getFluidHeightPercent(int dataVal);
 static int sameFluid(int fluidBI, int typeBI);
-static int saveSpecialVertices(int boxIndex, int faceDirection, IPoint loc, float heights[4], int heightIndices[4]);
-static int saveVertices(int boxIndex, int faceDirection, IPoint loc);
-static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int heightIndex[4], int firstFace);
+static int saveSpecialVertices(FaceSlab* pSlab, int boxIndex, int faceDirection, IPoint loc, float heights[4], int heightIndices[4]);
+static int saveVertices(FaceSlab* pSlab, int boxIndex, int faceDirection, IPoint loc);
+static int saveFaceLoop(FaceSlab* pSlab, int boxIndex, int faceDirection, float heights[4], int heightIndex[4], int firstFace);
+static void saveFaceUVs(FaceRecord* face, int boxIndex, int faceDirection, int dataVal, float heights[4]);
 static int getMaterialUsingGroup(int groupID);
 static void randomlyRotateTopAndBottomFace(int faceDirection, int boxIndex, int* localIndices, bool halfOnly = false, bool allFaces = false);
 static void randomlyRotate180AndReflect(int faceDirection, int boxIndex, int* localIndices);
@@ -743,6 +844,7 @@ static void saveRectangleTextureUVs(int swatchLoc, int type, float minu, float m
 static int saveTextureUV(int swatchLoc, int type, float u, float v);
 
 static void freeModel(Model* pModel);
+static void freeModelGeometry(Model* pModel);
 
 static int findMatchingNormal(FaceRecord* pFace, Vector normal, Vector* normalList, int normalListCount);
 static int addNormalToList(Vector normal, Vector* normalList, int* normalListCount, int normalListSize);
@@ -755,7 +857,14 @@ static int mosaicUVtoSeparateUV();
 static int writeAsciiSTLBox(WorldGuide* pWorldGuide, IBox* box, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
 static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* box, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
 static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
+static int writeOBJBoxInTiles(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
+static int beginOBJFile(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
+static int writeOBJGeometry(int firstNormal, int firstUV);
+static int endOBJFile(int retCode);
+static bool isOBJMaterialListed(int type, int dataVal, bool subtypeMaterial);
 static int writeOBJTextureUV(float u, float v, int addComment, int swatchLoc);
+static int formatOBJTextureUV(char* dst, size_t size, float u, float v, int addComment, int swatchLoc);
+static int formatOBJFace(char* dst, size_t size, FaceRecord* pFace, int absoluteIndices);
 static int writeOBJMtlFile();
 static int writeOBJFullMtlDescription(char* mtlName, int type, int dataVal, char* textureRGB, char* textureRGBA, char* textureAlpha, char* textureRoot, int swatchLoc);
 
@@ -763,6 +872,14 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* box, IBox* tightenedWorl
 static int writeVRMLAttributeShapeSplit(int type, int dataVal, char* mtlName, char* textureOutputString);
 static int writeVRMLTextureUV(float u, float v, int addComment, int swatchLoc);
 
+static int writeGLBBox(WorldGuide* pWorldGuide, IBox* box, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
+static int getGLBMaterialKey(FaceRecord* pFace, int materialMode);
+static int getGLBFaceCorners(FaceRecord* pFace, int corner[6]);
+static void getGLBTextureUV(FaceRecord* pFace, int corner, float uv[2]);
+static void appendGLBJson(std::string& json, const char* format, ...);
+static void appendGLBJsonString(std::string& json, const char* str);
+static void appendGLBJsonURI(std::string& json, const char* uri);
+
 static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* box, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
 static bool findNextChunk(int startInstance, int& endInstance, char* chunkLocation);
 static void nameFromHash(int hash, char* instanceNameString);
@@ -777,9 +894,15 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
 static void removeDuplicateVertices(Box& box);
 static void removeDuplicateNormals();
 static void removeDuplicateTextureSTs();
+static void weldOutData(float* data, int components, bool checkLast, Box* pBox);
+static unsigned long long weldKey(float* value, int components);
+static bool weldKeyMatches(unsigned long long key, int id, float* value, int components);
+static unsigned int weldMix(unsigned long long key);
+static void weldOutDataByFloatHash(float* data, int components, VertexHash** vhashLocation, VertexHash* vhashPool);
 static unsigned int hashVertex(Point* point);
 static unsigned int hashTextureST(Point2* point);
 static boolean allocOutHashData();
+static boolean allocWeldTable(int weldedCount);
 static boolean allocOutData(int vertsize, int facesize);
 static void freeOutAndHashData();
 static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t* mtlLibraryFile, bool singleTerrainFile, char *slashDefaultPrim);
@@ -814,7 +937,11 @@ static void formCategoryFileName(char* catFile, int category, char* textureRGB);
 
 static int writeLines(HANDLE file, char** textLines, int lines);
 
-static int writeStatistics(HANDLE fh, int (*printFunc)(char*), WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBoxconst, const wchar_t* curDir, const wchar_t* terrainFileName, const wchar_t* schemeSelected, ChangeBlockCommand* pCBC);
+// which parts of the statistics writeStatistics() writes out
+#define STATS_SETTINGS  0x1     // the settings used for the export, which importing the file restores
+#define STATS_COUNTS    0x2     // what depends on the whole model: its non-empty bounds, block and face counts, dimensions and cost
+#define STATS_ALL       (STATS_SETTINGS | STATS_COUNTS)
+static int writeStatistics(HANDLE fh, int (*printFunc)(char*), WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBoxconst, const wchar_t* curDir, const wchar_t* terrainFileName, const wchar_t* schemeSelected, ChangeBlockCommand* pCBC, int parts = STATS_ALL);
 
 static float computeMaterialCost(int printMaterialType, float blockEdgeSize, int numBlocks, int numMinorBlocks);
 static int finalModelChecks();
@@ -872,7 +999,10 @@ static void prettifyNumber(int i, wchar_t* wstring);
 static void myseedrand(long seed);
 static double myrand();
 
-static int analyzeChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int bz, int minx, int miny, int minz, int maxx, int maxy, int maxz, int mapMinHeight, int mapMaxHeight, bool ignoreTransparent, int mcVersion, int versionID);
+static WorldBlock* findAnalysisChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int bz, int mcVersion, int versionID);
+static bool lowestSurfaceKnown(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int minz, int maxx, int maxy, int maxz, bool ignoreTransparent, int& heightFound);
+static bool wholeChunkAnalyzed(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int minz, int maxx, int maxy, int maxz);
+static int analyzeChunk(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int miny, int minz, int maxx, int maxy, int maxz, int mapMinHeight, int mapMaxHeight, bool ignoreTransparent);
 
 static int decimateMesh();
 static bool faceCanTile(int faceId);
@@ -917,9 +1047,9 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
 {
     // * Read the texture for the materials.
     // * populateBox:
-    //  ** Read through the chunks once, only the data within the box specified. Keep track of the "solid box", the bounds where objects actually exist.
-    //  ** Allocate and clear the "air box", which includes the solid box plus a 1 cell border for ease of neighbor testing.
-    //  ** Read through the chunks again, this time increasing the solid box by 1 in X and Z for rendering if not boxing off, and 1 in Y for all.
+    //  ** Read through the chunks once, copying the box specified, plus a 1 cell border, into a box. Keep track of the "solid box", the bounds where objects actually exist.
+    //  ** Tighten the box to the "air box", which includes the solid box plus a 1 cell border for ease of neighbor testing.
+    //  ** Only the solid box, increased by 1 in X and Z for rendering if not boxing off, and 1 in Y for all, is kept from what was read.
     // * Create output texture image data array.
     // * filterBox: output all minor geometry objects that are not full blocks. Billboards, small geometry, and snow and wires are flattened onto the face below. The "type" of these is all set to be empty immediately after they're processed, so origType is used if we want to find if anything was in the cell.
     //  ** Fill, connect, hollow, melt: various operations to add or subtract blocks, mostly needed for 3D printing.
@@ -1021,7 +1151,7 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
     gModel.groupCountSize = groupCountSize;
     gModel.groupCountArray = groupCountArray;
 
-    gBoxData = NULL;
+    memset(&gBoxData, 0, sizeof(BoxData));
     gBiomeArray = NULL;
 
     gMinorBlockCount = 0;
@@ -1212,6 +1342,27 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
     initializeWorldData(&worldBox, xmin, ymin, zmin, xmax, ymax, zmax);
     tightenedWorldBox = worldBox;
 
+    gModel.exportInTiles = canExportInTiles(fileType, pCBC, &worldBox);
+    if (gModel.exportInTiles)
+    {
+        // The selection is read in, processed and written out a tile at a time, so all of it is never in memory at once.
+        // The texture doesn't depend on the blocks found, as biomes aren't used when tiling, so it's made first.
+        retCode |= initializeOutputTexture();
+        if (retCode >= MW_BEGIN_ERRORS)
+        {
+            goto Exit;
+        }
+
+        // for OBJ, we may use more than one texture
+        needDifferentTextures = 1;
+        retCode |= writeOBJBoxInTiles(pWorldGuide, &worldBox, &tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+        if (retCode >= MW_BEGIN_ERRORS || retCode >= MW_BEGIN_NOTHING_TO_DO)
+        {
+            goto Exit;
+        }
+        goto WriteTextures;
+    }
+
     // Note that tightenedWorldBox will come back with the "solid" bounds, of where data was actually found.
     // Mostly "of interest", not particularly useful - we used to output it, but that's a bit confusing when importing.
     retCode |= populateBox(pWorldGuide, pCBC, &tightenedWorldBox);
@@ -1221,58 +1372,13 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
         goto Exit;
     }
 
-    // prepare to write texture, if needed
-    if (gModel.exportTexture)
-    {
-        // Make it twice as large if we're outputting image textures, too- we need the space.
-        // We're just setting up here, giving something to write UVs against; even per-tile texture
-        // output uses this. We export the texture at the end.
-        if (gModel.options->exportFlags & EXPT_OUTPUT_TEXTURE_IMAGES_OR_TILES)
-        {
-            // use true textures - for 3D printing or if swatches are needed, we need to make output image larger to accomodate composite swatches.
-            // for 1.16 and earlier: gModel.textureResolution = ((gModel.print3D || gModel.options->pEFD->chkCompositeOverlay) ? 4 : 2) * gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
-            gModel.textureResolution = 4 * gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
-            gModel.terrainWidth = gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
-        }
-        else
-        {
-            // Use "noisy" colors, fixed 512 x 512 - we could actually make this texture quite small
-            // Note this used to be 256 x 256, but that's only 14*14 = 196 materials, and we're now
-            // at 198 or so...
-            gModel.textureResolution = 1024;    // was 512 for 1.16
-            // This number determines number of swatches per row. Make it 256, even though there's
-            // no incoming image. This then ensures there's room for enough solid color images.
-            gModel.terrainWidth = 256;    // really, no image, but act like there is
-        }
-        // there are always 16 tiles wide in terrainExt.png, so we divide by this.
-        gModel.tileSize = gModel.terrainWidth / 16;
-        gModel.resScale = 16.0f / (float)gModel.tileSize;
-        gModel.swatchSize = 2 + gModel.tileSize;
-        gModel.invTextureResolution = 1.0f / (float)gModel.textureResolution;
-        gModel.swatchesPerRow = (int)(gModel.textureResolution / gModel.swatchSize);
-        gModel.textureUVPerSwatch = (float)gModel.swatchSize / (float)gModel.textureResolution; // e.g. 18 / 256
-        gModel.textureUVPerTile = (float)gModel.tileSize / (float)gModel.textureResolution; // e.g. 16 / 256
-        gModel.swatchListSize = gModel.swatchesPerRow * gModel.swatchesPerRow;
-
-        if (EXPORT_TEXTURE) {
-            retCode |= createBaseMaterialTexture();
-        }
-    }
-
-    // were there errors?
+    retCode |= initializeOutputTexture();
     if (retCode >= MW_BEGIN_ERRORS)
     {
         // texture out of memory or some other read error.
         goto Exit;
     }
 
-    // check if resolution is massively high; warn once
-    static bool warnOnSize = true;
-    if (warnOnSize && gModel.textureResolution >= 16384 && !gModel.exportTiles) {
-        warnOnSize = false;
-        retCode |= MW_TEXTURE_RESOLUTION_HIGH;
-    }
-
     UPDATE_PROGRESS(gProgress.start.readBlocks + 0.45f * gProgress.absolute.readBlocks);
     retCode |= initializeModelData();
     if (retCode >= MW_BEGIN_ERRORS)
@@ -1352,6 +1458,9 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
     case FILE_TYPE_VRML2:
         retCode |= writeVRML2Box(pWorldGuide, &worldBox, &tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
         break;
+    case FILE_TYPE_GLTF:
+        retCode |= writeGLBBox(pWorldGuide, &worldBox, &tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+        break;
         //case FILE_TYPE_SETTINGS:
             //retCode |= writeSettings( pWorldGuide, &worldBox, &tightenedWorldBox );
             //break;
@@ -1366,6 +1475,7 @@ int SaveVolume(wchar_t* saveFileName, int fileType, Options* options, WorldGuide
     if (retCode >= MW_BEGIN_ERRORS)
         goto Exit;
 
+WriteTextures:
     retCode |= finalModelChecks();
 
     if (retCode >= MW_BEGIN_ERRORS)
@@ -1389,14 +1499,16 @@ Exit:
     UPDATE_STATUS(gProgress.start.zip, L"Cleanup");
     freeModel(&gModel);
 
-    if (gBoxData)
-        free(gBoxData);
-    gBoxData = NULL;
+    freeBoxData();
 
     if (gBiomeArray)
         free(gBiomeArray);
     gBiomeArray = NULL;
 
+    // the threads' buffers for reading chunks are freed once the last chunk is read, see populateBox(); this is
+    // in case a tiled export stopped before its last tile
+    regionFreeBuffers();
+
     if (gBadBlocksInModel)
         // if ( UnknownBlockRead() && gBadBlocksInModel )
     {
@@ -1421,6 +1533,89 @@ Exit:
     return retCode;
 }
 
+// Set up the output texture, giving something to write UVs against, and fill in the base materials.
+static int initializeOutputTexture()
+{
+    int retCode = MW_NO_ERROR;
+
+    // prepare to write texture, if needed
+    if (gModel.exportTexture)
+    {
+        // Make it twice as large if we're outputting image textures, too- we need the space.
+        // We're just setting up here, giving something to write UVs against; even per-tile texture
+        // output uses this. We export the texture at the end.
+        if (gModel.options->exportFlags & EXPT_OUTPUT_TEXTURE_IMAGES_OR_TILES)
+        {
+            // use true textures - for 3D printing or if swatches are needed, we need to make output image larger to accomodate composite swatches.
+            // for 1.16 and earlier: gModel.textureResolution = ((gModel.print3D || gModel.options->pEFD->chkCompositeOverlay) ? 4 : 2) * gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
+            gModel.textureResolution = 4 * gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
+            gModel.terrainWidth = gModel.pInputTerrainImage[CATEGORY_RGBA]->width;
+        }
+        else
+        {
+            // Use "noisy" colors, fixed 512 x 512 - we could actually make this texture quite small
+            // Note this used to be 256 x 256, but that's only 14*14 = 196 materials, and we're now
+            // at 198 or so...
+            gModel.textureResolution = 1024;    // was 512 for 1.16
+            // This number determines number of swatches per row. Make it 256, even though there's
+            // no incoming image. This then ensures there's room for enough solid color images.
+            gModel.terrainWidth = 256;    // really, no image, but act like there is
+        }
+        // there are always 16 tiles wide in terrainExt.png, so we divide by this.
+        gModel.tileSize = gModel.terrainWidth / 16;
+        gModel.resScale = 16.0f / (float)gModel.tileSize;
+        gModel.swatchSize = 2 + gModel.tileSize;
+        gModel.invTextureResolution = 1.0f / (float)gModel.textureResolution;
+        gModel.swatchesPerRow = (int)(gModel.textureResolution / gModel.swatchSize);
+        gModel.textureUVPerSwatch = (float)gModel.swatchSize / (float)gModel.textureResolution; // e.g. 18 / 256
+        gModel.textureUVPerTile = (float)gModel.tileSize / (float)gModel.textureResolution; // e.g. 16 / 256
+        gModel.swatchListSize = gModel.swatchesPerRow * gModel.swatchesPerRow;
+
+        if (EXPORT_TEXTURE) {
+            retCode |= createBaseMaterialTexture();
+            if (retCode >= MW_BEGIN_ERRORS)
+                return retCode;
+        }
+    }
+
+    // check if resolution is massively high; warn once
+    static bool warnOnSize = true;
+    if (warnOnSize && gModel.textureResolution >= 16384 && !gModel.exportTiles) {
+        warnOnSize = false;
+        retCode |= MW_TEXTURE_RESOLUTION_HIGH;
+    }
+
+    return retCode;
+}
+
+// Can this export be done a tile at a time? Only when rendering to OBJ, and when nothing done to the blocks or the model
+// needs the whole selection at once. Tiling is also not needed if the selection fits in a single tile.
+static bool canExportInTiles(int fileType, ChangeBlockCommand* pCBC, IBox* worldBox)
+{
+    if (!gModel.options->pEFD->chkExportInTiles ||
+        ((fileType != FILE_TYPE_WAVEFRONT_REL_OBJ) && (fileType != FILE_TYPE_WAVEFRONT_ABS_OBJ)) ||
+        gModel.print3D ||
+        // filling, hollowing, melting and the like look at groups of blocks of any size
+        boxNeedsGroups() ||
+        // simplification merges faces across the whole model
+        gModel.options->pEFD->chkDecimate ||
+        // the other scalings depend on the size of the whole model
+        !gModel.options->pEFD->radioScaleByBlock ||
+        // individual blocks are numbered through the whole model
+        (gModel.options->exportFlags & (EXPT_INDIVIDUAL_BLOCKS | EXPT_OUTPUT_EACH_BLOCK_A_GROUP)) ||
+        // the biome at the center of the selection is used, unless one is given
+        ((gModel.options->exportFlags & EXPT_BIOME) && (gUserSelectedBiome < 0)) ||
+        // change block commands are checked against the whole selection
+        (pCBC != NULL))
+    {
+        return false;
+    }
+
+    int tileWidth = 16 * EXPORT_TILE_CHUNKS;
+    return ((int)floor((float)worldBox->min[X] / (float)tileWidth) != (int)floor((float)worldBox->max[X] / (float)tileWidth)) ||
+        ((int)floor((float)worldBox->min[Z] / (float)tileWidth) != (int)floor((float)worldBox->max[Z] / (float)tileWidth));
+}
+
 static void determineProgressValues(int fileType, int xdim, int zdim)
 {
     // defaults for a 200x200 export and a 16x16 tile size
@@ -1449,6 +1644,11 @@ static void determineProgressValues(int fileType, int xdim, int zdim)
         gProgress.relative.output = 15600;
         gProgress.relative.texture = 350;
         break;
+    case FILE_TYPE_GLTF:
+        // binary, so much less to format than OBJ
+        gProgress.relative.output = 2500;
+        gProgress.relative.texture = 350;
+        break;
     case FILE_TYPE_SCHEMATIC:
         // very fast
         gProgress.relative.readTextures = 0;
@@ -2165,9 +2365,9 @@ static int initializeModelData()
             {
                 for (faceDirection = 0; faceDirection < 6; faceDirection++)
                 {
-                    if (gBoxData[boxIndex].type > BLOCK_AIR)
+                    if (gBoxData.type[boxIndex] > BLOCK_AIR)
                     {
-                        if (gBoxData[boxIndex + gFaceOffset[faceDirection]].type == BLOCK_AIR)
+                        if (gBoxData.type[boxIndex + gFaceOffset[faceDirection]] == BLOCK_AIR)
                             gModel.faceSize++;
                     }
                 }
@@ -2179,9 +2379,13 @@ static int initializeModelData()
     gModel.faceSize = (int)(gModel.faceSize * 1.4 + 1);
     gModel.faceList = (FaceRecord**)malloc(gModel.faceSize * sizeof(FaceRecord*));
 
-    memset(gModel.uvSwatches, 0, NUM_MAX_SWATCHES * sizeof(UVList));
-    gModel.uvIndexListSize = 200;	// 50 blocks' worth of UVs, often enough
-    gModel.uvIndexList = (UVOutput*)malloc(gModel.uvIndexListSize * sizeof(UVOutput));
+    // when exporting in tiles, the UVs are kept from tile to tile, so are set up just for the first one
+    if (gModel.uvIndexList == NULL)
+    {
+        memset(gModel.uvSwatches, 0, NUM_MAX_SWATCHES * sizeof(UVList));
+        gModel.uvIndexListSize = 200;	// 50 blocks' worth of UVs, often enough
+        gModel.uvIndexList = (UVOutput*)malloc(gModel.uvIndexListSize * sizeof(UVOutput));
+    }
     if ((gModel.faceList == NULL) || (gModel.uvIndexList == NULL))
     {
         return MW_WORLD_EXPORT_TOO_LARGE;
@@ -2396,12 +2600,48 @@ static void invertImage(progimage_info* dst)
 }
 
 
+// Call job(i, t) for each i from 0 to count-1, spread over a set of threads. t is which thread, from 0 to
+// EXPORT_MAX_THREADS-1, so that each can keep its own results. This thread helps, too.
+template <typename Func>
+static void runChunkJobs(int count, Func job)
+{
+    int numThreads = (gExportSerial || (count < EXPORT_MIN_PARALLEL)) ? 1 : (int)std::thread::hardware_concurrency();
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > EXPORT_MAX_THREADS)
+        numThreads = EXPORT_MAX_THREADS;
+    std::atomic<int> nextJob(0);
+    auto worker = [&](int t) {
+        int i;
+        while ((i = nextJob++) < count) {
+            job(i, t);
+        }
+    };
+    std::thread* threads = (numThreads > 1) ? new std::thread[numThreads - 1] : NULL;
+    for (int t = 1; t < numThreads; t++) {
+        threads[t - 1] = std::thread(worker, t);
+    }
+    worker(0);
+    for (int t = 1; t < numThreads; t++) {
+        threads[t - 1].join();
+    }
+    delete[] threads;
+}
+
 static int populateBox(WorldGuide* pWorldGuide, ChangeBlockCommand* pCBC, IBox* worldBox)
 {
     int startxblock, startzblock;
     int endxblock, endzblock;
     int blockX, blockZ;
+    int readstartxblock, readstartzblock;
+    int readendxblock, readendzblock;
     IBox originalWorldBox = *worldBox;
+    IBox readWorldBox;
+    IBox edgeWorldBox;
+    IPoint readBoxSize;
+    IPoint readWorld2BoxOffset;
+    int retCode = MW_NO_ERROR;
+    int numJobs;
 
     // grab the data block needed, with a border of "air", 0, around the set
     startxblock = (int)floor((float)worldBox->min[X] / 16.0f);
@@ -2413,67 +2653,104 @@ static int populateBox(WorldGuide* pWorldGuide, ChangeBlockCommand* pCBC, IBox*
     VecScalar(gSolidWorldBox.min, =, INT_MAX);
     VecScalar(gSolidWorldBox.max, =, INT_MIN);
 
-    // We now extract twice: first time is just to get bounds of solid stuff we'll actually output.
-    // Results of this first pass are put in gSolidWorldBox.
-    for (blockX = startxblock; blockX <= endxblock; blockX++)
-    {
-        //UPDATE_PROGRESS( 0.1f*(blockX-startxblock+1)/(endxblock-startxblock+1) );
-        // z increases west, decreases east
-        for (blockZ = startzblock; blockZ <= endzblock; blockZ++)
-        {
-            // this method sets gSolidWorldBox
-            findChunkBounds(pWorldGuide, blockX, blockZ, worldBox, gMcVersion, gMinecraftWorldVersion);
-
-            // done with reading chunk for export, so free memory
-            if (gModel.options->moreExportMemory)
-            {
-                ClearCache();
-            }
-        }
-    }
-
-    if (willChangeBlockCommandModifyAir(pCBC)) {
-        // have a command list - have to reset solid world bounds if we find the person is actually
-        // building in the air space, turning air into something solid.
-        // TODO: someday we might want to make the solid world bound limited.
-        gSolidWorldBox = *worldBox;
-    }
-    else if (gSolidWorldBox.min[Y] > gSolidWorldBox.max[Y]) {
-        // quick out test, nothing to do: there is nothing in the box
-        return MW_NO_BLOCKS_FOUND;
+    // Each chunk is read in just once. While it's in hand, the bounds of the solid stuff we'll actually output are
+    // found and put in gSolidWorldBox, and everything the box could need from the chunk is copied into a box made to
+    // hold the whole volume. That's the volume plus a border of one block, as the blocks just outside the solid stuff
+    // may be needed, see below. Once the bounds are known, the box is tightened to them, see tightenBox().
+    // Chunks are done a batch at a time, so that they can be read in and looked at by a set of threads.
+    readWorldBox = originalWorldBox;
+    readWorldBox.min[X]--;
+    readWorldBox.max[X]++;
+    readWorldBox.min[Z]--;
+    readWorldBox.max[Z]++;
+    if (readWorldBox.min[Y] > gMinHeight)
+    {
+        readWorldBox.min[Y]--;
+    }
+    if (readWorldBox.max[Y] < gMaxHeight)
+    {
+        readWorldBox.max[Y]++;
+    }
+    readstartxblock = (int)floor((float)readWorldBox.min[X] / 16.0f);
+    readstartzblock = (int)floor((float)readWorldBox.min[Z] / 16.0f);
+    readendxblock = (int)floor((float)readWorldBox.max[X] / 16.0f);
+    readendzblock = (int)floor((float)readWorldBox.max[Z] / 16.0f);
+
+    int numChunksX = endxblock - startxblock + 3;
+    int numChunksZ = endzblock - startzblock + 3;
+    ChunkSummary* chunks = (ChunkSummary*)calloc(numChunksX * numChunksZ, sizeof(ChunkSummary));
+    // the chunks to do next
+    ChunkSummary** jobs = (ChunkSummary**)malloc(numChunksX * numChunksZ * sizeof(ChunkSummary*));
+    if ((chunks == NULL) || (jobs == NULL))
+    {
+        free(chunks);
+        free(jobs);
+        return MW_WORLD_EXPORT_TOO_LARGE;
     }
+    // index of a chunk in the list, which includes a ring of chunks around those in the volume
+#define CHUNK_SUMMARY_INDEX(bx,bz)  (((bx) - startxblock + 1) * numChunksZ + (bz) - startzblock + 1)
 
-    // have to reinitialize to get right globals for gSolidWorldBox.
-    initializeWorldData(worldBox, gSolidWorldBox.min[X], gSolidWorldBox.min[Y], gSolidWorldBox.min[Z], gSolidWorldBox.max[X], gSolidWorldBox.max[Y], gSolidWorldBox.max[Z]);
+    // the box for the whole volume; its border of one block holds the rest of readWorldBox
+    initializeWorldData(worldBox, originalWorldBox.min[X], originalWorldBox.min[Y], originalWorldBox.min[Z], originalWorldBox.max[X], originalWorldBox.max[Y], originalWorldBox.max[Z]);
+    Vec2Op(readBoxSize, =, gBoxSize);
+    Vec2Op(readWorld2BoxOffset, =, gWorld2BoxOffset);
 
-    gBoxData = (BoxCell*)calloc(gBoxSizeXYZ, sizeof(BoxCell));
-    if (gBoxData == NULL)
+    // set all values to "air", 0, etc. Groups, if needed, are allocated once the box is tightened.
+    if (!allocBoxData(gBoxSizeXYZ, false))
     {
-        return MW_WORLD_EXPORT_TOO_LARGE;
+        retCode = MW_WORLD_EXPORT_TOO_LARGE;
+        goto Exit;
     }
 
-    // set all values to "air", 0, etc.
-    //memset(gBoxData, 0x0, gBoxSizeXYZ * sizeof(BoxCell));
-
     if (gModel.options->exportFlags & EXPT_BIOME)
     {
         gBiomeArray = (unsigned char*)calloc(gBoxSize[X] * gBoxSize[Z], sizeof(unsigned char));
         if (gBiomeArray == NULL)
         {
-            return MW_WORLD_EXPORT_TOO_LARGE;
+            retCode = MW_WORLD_EXPORT_TOO_LARGE;
+            goto Exit;
         }
 
         // set all biome values to "plains"
         //memset(gBiomeArray, 0x1, gBoxSize[X] * gBoxSize[Z] * sizeof(unsigned char));
     }
 
-    // Now actually copy the relevant data over to the newly-allocated box data grid.
-    // x increases east, decreases west.
+    numJobs = 0;
+    for (blockX = readstartxblock; blockX <= readendxblock; blockX++)
+    {
+        //UPDATE_PROGRESS( 0.1f*(blockX-readstartxblock+1)/(readendxblock-readstartxblock+1) );
+        // z increases west, decreases east
+        for (blockZ = readstartzblock; blockZ <= readendzblock; blockZ++)
+        {
+            ChunkSummary* pCS = &chunks[CHUNK_SUMMARY_INDEX(blockX, blockZ)];
+            pCS->bx = blockX;
+            pCS->bz = blockZ;
+            jobs[numJobs++] = pCS;
+            if ((numJobs == EXPORT_BATCH_SIZE) || ((blockX == readendxblock) && (blockZ == readendzblock)))
+            {
+                // this method sets gSolidWorldBox
+                readChunkBatch(pWorldGuide, jobs, numJobs, &originalWorldBox, &readWorldBox);
+                numJobs = 0;
+            }
+        }
+    }
+
+    if (willChangeBlockCommandModifyAir(pCBC)) {
+        // have a command list - have to reset solid world bounds if we find the person is actually
+        // building in the air space, turning air into something solid.
+        // TODO: someday we might want to make the solid world bound limited.
+        gSolidWorldBox = originalWorldBox;
+    }
+    else if (gSolidWorldBox.min[Y] > gSolidWorldBox.max[Y]) {
+        // quick out test, nothing to do: there is nothing in the box
+        retCode = MW_NO_BLOCKS_FOUND;
+        goto Exit;
+    }
 
     // Expand out by 1
     // for what we read from the data files. Later on we will set these border blocks so that
     // only the original type is set, with the regular type being air.
-    IBox edgeWorldBox = *worldBox;
+    edgeWorldBox = gSolidWorldBox;
     //if (!gModel.options->pEFD->chkBlockFacesAtBorders)
     //if (!gModel.print3D)
     {
@@ -2515,26 +2792,30 @@ static int populateBox(WorldGuide* pWorldGuide, ChangeBlockCommand* pCBC, IBox*
     }
     // Later in this method we clear all these blocks, leaving only the original type, if we do generate faces at the borders.
 
-    int edgestartxblock = (int)floor((float)edgeWorldBox.min[X] / 16.0f);
-    int edgestartzblock = (int)floor((float)edgeWorldBox.min[Z] / 16.0f);
-    int edgeendxblock = (int)floor((float)edgeWorldBox.max[X] / 16.0f);
-    int edgeendzblock = (int)floor((float)edgeWorldBox.max[Z] / 16.0f);
+    // have to reinitialize to get right globals for gSolidWorldBox, then move what's in edgeWorldBox to where it goes
+    initializeWorldData(worldBox, gSolidWorldBox.min[X], gSolidWorldBox.min[Y], gSolidWorldBox.min[Z], gSolidWorldBox.max[X], gSolidWorldBox.max[Y], gSolidWorldBox.max[Z]);
+    if (!tightenBox(readBoxSize, readWorld2BoxOffset, &edgeWorldBox))
+    {
+        retCode = MW_WORLD_EXPORT_TOO_LARGE;
+        goto Exit;
+    }
 
-    for (blockX = edgestartxblock; blockX <= edgeendxblock; blockX++)
+    // a chunk gives its biome only if it has something at or above the bottom of edgeWorldBox
+    if (gBiomeArray)
     {
-        //UPDATE_PROGRESS( 0.1f*(blockX-edgestartxblock+1)/(edgeendxblock-edgestartxblock+1) );
-        // z increases south, decreases north
-        for (blockZ = edgestartzblock; blockZ <= edgeendzblock; blockZ++)
+        for (int x = edgeWorldBox.min[X]; x <= edgeWorldBox.max[X]; x++)
         {
-            extractChunk(pWorldGuide, blockX, blockZ, &edgeWorldBox, gMcVersion, gMinecraftWorldVersion);
-
-            // done with reading chunk for export, so free memory
-            if (gModel.options->moreExportMemory)
+            for (int z = edgeWorldBox.min[Z]; z <= edgeWorldBox.max[Z]; z++)
             {
-                ClearCache();
+                ChunkSummary* pCS = &chunks[CHUNK_SUMMARY_INDEX(x >> 4, z >> 4)];
+                if (pCS->topY < edgeWorldBox.min[Y])
+                {
+                    gBiomeArray[(x + gWorld2BoxOffset[X]) * gBoxSize[Z] + z + gWorld2BoxOffset[Z]] = 0;
+                }
             }
         }
     }
+#undef CHUNK_SUMMARY_INDEX
 
     // convert to solid relative box (0 through boxSize-1)
     Vec3Op(gSolidBox.min, =, gSolidWorldBox.min, +, gWorld2BoxOffset);
@@ -2553,23 +2834,39 @@ static int populateBox(WorldGuide* pWorldGuide, ChangeBlockCommand* pCBC, IBox*
         modifySlab(gAirBox.max[Y], EDIT_MODE_CLEAR_TYPE);
     }
 
-    return MW_NO_ERROR;
-}
-
-// test relevant part of a given chunk to find its size
-static void findChunkBounds(WorldGuide* pWorldGuide, int bx, int bz, IBox* worldBox, int mcVersion, int versionID)
-{
-    int chunkX, chunkZ;
+Exit:
+    free(chunks);
+    free(jobs);
 
-    int loopXmin, loopZmin;
-    int loopXmax, loopZmax;
-    int x, y, z;
+    // done reading chunks, so the threads' buffers for reading them can go; a tiled export keeps them until its
+    // last tile is read in, see writeOBJBoxInTiles()
+    if (!gModel.exportInTiles)
+    {
+        regionFreeBuffers();
+    }
 
-    int chunkIndex, boxIndex;
-    int blockID;
+    return retCode;
+}
 
-    //unsigned char dataVal;
+// set the directory that LoadBlock() reads chunks from
+static void setExportDirectory(WorldGuide* pWorldGuide)
+{
+    wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
+    wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
+    if (gModel.options->worldType & HELL)
+    {
+        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM-1");
+    }
+    if (gModel.options->worldType & ENDER)
+    {
+        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM1");
+    }
+    wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
+}
 
+// Find the chunk, reading it in if it's not in the cache. Returns NULL if there is no chunk.
+static WorldBlock* findExportChunk(WorldGuide* pWorldGuide, int bx, int bz, int mcVersion, int versionID)
+{
     WorldBlock* block;
     void* data;
     bool found = (WorldBlock*)Cache_Find(bx, bz, &data);
@@ -2577,43 +2874,144 @@ static void findChunkBounds(WorldGuide* pWorldGuide, int bx, int bz, IBox* world
 
     if (!found)
     {
-        wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
-        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
-        if (gModel.options->worldType & HELL)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM-1");
-        }
-        if (gModel.options->worldType & ENDER)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM1");
-        }
-        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
-
-        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, gBlockRetCode);
+        setExportDirectory(pWorldGuide);
+        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, false, gBlockRetCode, 0);
         Cache_Add(bx, bz, block);
     }
+    return block;
+}
 
-    if ((block == NULL) || (block->blockType == NBT_NO_SECTIONS)) //blank tile, nothing to do
-        return;
+// Read in the chunks in the batch. Add their solid blocks inside worldBox to gSolidWorldBox, note how high each one's
+// contents go, and copy the parts of them inside readWorldBox to the box data grid.
+static void readChunkBatch(WorldGuide* pWorldGuide, ChunkSummary** batch, int count, IBox* worldBox, IBox* readWorldBox)
+{
+    int i, t;
+    WorldBlock* blocks[EXPORT_BATCH_SIZE];
+    int toRead[EXPORT_BATCH_SIZE];
+    int numToRead = 0;
+    int missing[EXPORT_BATCH_SIZE];
+    int numMissing = 0;
+    IBox threadSolidBox[EXPORT_MAX_THREADS];
+    void* data;
 
-    // set version for later use by textures, etc.
+    // set version for later use by textures, etc., from the chunks in the volume itself, not the ring around it.
     // yes, this gets set multiple times - so be it.
-    gModel.mcVersion = block->mcVersion;
+    auto setVersion = [&](WorldBlock* block, ChunkSummary* pCS) {
+        if ((block != NULL) && (block->blockType != NBT_NO_SECTIONS) &&
+            (pCS->bx >= (worldBox->min[X] >> 4)) && (pCS->bx <= (worldBox->max[X] >> 4)) &&
+            (pCS->bz >= (worldBox->min[Z] >> 4)) && (pCS->bz <= (worldBox->max[Z] >> 4)))
+        {
+            gModel.mcVersion = block->mcVersion;
+        }
+    };
 
-    // loop through area of box that overlaps with this chunk
-    chunkX = bx * 16;
-    chunkZ = bz * 16;
+    assert(count <= EXPORT_BATCH_SIZE);
+    for (i = 0; i < count; i++)
+    {
+        if (!Cache_Find(batch[i]->bx, batch[i]->bz, &data))
+        {
+            toRead[numToRead++] = i;
+        }
+    }
 
-    loopXmin = max(worldBox->min[X], chunkX);
-    loopZmin = max(worldBox->min[Z], chunkZ);
+    // Chunks not in the cache are read in by a set of threads, each with its own set of buffers to read with. Only
+    // adding them to the cache has to wait until they're all read in.
+    setExportDirectory(pWorldGuide);
+    runChunkJobs(numToRead, [&](int job, int jobThread) {
+        int blockRetCode;
+        blocks[job] = LoadBlock(pWorldGuide, batch[toRead[job]]->bx, batch[toRead[job]]->bz, gMcVersion, gMinecraftWorldVersion, false, blockRetCode, jobThread);
+    });
+    for (i = 0; i < numToRead; i++)
+    {
+        Cache_Add(batch[toRead[i]]->bx, batch[toRead[i]]->bz, blocks[i]);
+    }
 
-    loopXmax = min(worldBox->max[X], chunkX + 15);
-    loopZmax = min(worldBox->max[Z], chunkZ + 15);
+    // A chunk found in the cache earlier can be its oldest entry, and so get bumped out by one just added, so the
+    // chunks are all looked up again. Any that have gone missing are done one by one, after the rest.
+    for (i = 0; i < count; i++)
+    {
+        if (Cache_Find(batch[i]->bx, batch[i]->bz, &data))
+        {
+            blocks[i] = (WorldBlock*)data;
+            setVersion(blocks[i], batch[i]);
+        }
+        else
+        {
+            blocks[i] = NULL;
+            missing[numMissing++] = i;
+        }
+    }
 
-    int miny = worldBox->min[Y];
-    if (miny > block->maxFilledHeight + gMinHeight) {
-        // done! The box doesn't overlap this chunk
-        return;
+    // Each thread keeps its own bounds, combined at the end. Each chunk fills its own columns of the box. Nothing
+    // touches the cache from here on.
+    for (t = 0; t < EXPORT_MAX_THREADS; t++)
+    {
+        VecScalar(threadSolidBox[t].min, =, INT_MAX);
+        VecScalar(threadSolidBox[t].max, =, INT_MIN);
+    }
+    runChunkJobs(count, [&](int job, int jobThread) {
+        useChunkForExport(blocks[job], batch[job], worldBox, readWorldBox, &threadSolidBox[jobThread]);
+    });
+    for (t = 0; t < EXPORT_MAX_THREADS; t++)
+    {
+        addBoundsToBounds(threadSolidBox[t], &gSolidWorldBox);
+    }
+
+    for (i = 0; i < numMissing; i++)
+    {
+        WorldBlock* block = findExportChunk(pWorldGuide, batch[missing[i]]->bx, batch[missing[i]]->bz, gMcVersion, gMinecraftWorldVersion);
+        setVersion(block, batch[missing[i]]);
+        useChunkForExport(block, batch[missing[i]], worldBox, readWorldBox, &gSolidWorldBox);
+    }
+
+    // done with reading chunks for export, so free memory
+    if (gModel.options->moreExportMemory)
+    {
+        ClearCache();
+    }
+}
+
+// Add the chunk's solid blocks inside worldBox to solidBox, note how high the chunk's contents go, and copy the part of
+// the chunk inside readWorldBox to the box data grid. Called by several threads at once, each with a different chunk.
+static void useChunkForExport(WorldBlock* block, ChunkSummary* pCS, IBox* worldBox, IBox* readWorldBox, IBox* solidBox)
+{
+    bool empty = (block == NULL) || (block->blockType == NBT_NO_SECTIONS);
+    pCS->topY = empty ? INT_MIN : block->maxFilledHeight + gMinHeight;
+    if (!empty)
+    {
+        findChunkBounds(block, pCS->bx, pCS->bz, worldBox, solidBox);
+        extractChunk(block, pCS->bx, pCS->bz, readWorldBox);
+    }
+}
+
+// test relevant part of a given chunk to find its size, adding it to solidBox
+static void findChunkBounds(WorldBlock* block, int bx, int bz, IBox* worldBox, IBox* solidBox)
+{
+    int chunkX, chunkZ;
+
+    int loopXmin, loopZmin;
+    int loopXmax, loopZmax;
+    int x, y, z;
+
+    int chunkIndex, boxIndex;
+    int blockID;
+
+    //unsigned char dataVal;
+
+    // loop through area of box that overlaps with this chunk
+    chunkX = bx * 16;
+    chunkZ = bz * 16;
+
+    loopXmin = max(worldBox->min[X], chunkX);
+    loopZmin = max(worldBox->min[Z], chunkZ);
+
+    loopXmax = min(worldBox->max[X], chunkX + 15);
+    loopZmax = min(worldBox->max[Z], chunkZ + 15);
+
+    int miny = worldBox->min[Y];
+    if (miny > block->maxFilledHeight + gMinHeight) {
+        // done! The box doesn't overlap this chunk
+        return;
     }
     int maxy = worldBox->max[Y];
     if (maxy > block->maxFilledHeight + gMinHeight) {
@@ -2623,9 +3021,28 @@ static void findChunkBounds(WorldGuide* pWorldGuide, int bx, int bz, IBox* world
 
     for (x = loopXmin; x <= loopXmax; x++) {
         for (z = loopZmin; z <= loopZmax; z++) {
+            // everything above the top of the column is air
+            int columnMaxy = block->columnTop[(z - chunkZ) * 16 + (x - chunkX)] + gMinHeight;
+            if (columnMaxy > maxy) {
+                columnMaxy = maxy;
+            }
             boxIndex = WORLD_TO_BOX_INDEX(x, miny, z);
             chunkIndex = CHUNK_INDEX(bx, bz, x, miny, z);
-            for (y = miny; y <= maxy; y++, boxIndex++) {
+            for (y = miny; y <= columnMaxy; y++, boxIndex++) {
+                // At the bottom of a section (or of the box), see if the section is all air or all one block. If so,
+                // only its first voxel needs a look, and at most its top and bottom levels need to go in the bounds.
+                int level = chunkIndex >> 8;
+                int sectionBit = 1 << (level >> 4);
+                int sectionLevels = 0;
+                if ((y == miny) || ((level & 0xf) == 0)) {
+                    if (!(block->sectionMask & sectionBit) || (block->sectionUniform & sectionBit)) {
+                        sectionLevels = 16 - (level & 0xf);
+                        if (y + sectionLevels - 1 > columnMaxy) {
+                            sectionLevels = columnMaxy - y + 1;
+                        }
+                    }
+                }
+
                 // fold in the high bit to get the type
                 // 1.13 fun: if the highest bit of the data value is 1, this is a 1.13+ block of some sort,
                 // so "move" that bit from data to the type. Ignore head data, which comes in with the high bit set.
@@ -2655,16 +3072,28 @@ static void findChunkBounds(WorldGuide* pWorldGuide, int bx, int bz, IBox* world
                         (gBlockDefinitions[blockID].alpha > 0.0)) {
                         IPoint loc;
                         Vec3Scalar(loc, =, x, y, z);
-                        addBounds(loc, &gSolidWorldBox);
+                        addBounds(loc, solidBox);
+                        if (sectionLevels > 1) {
+                            loc[Y] = y + sectionLevels - 1;
+                            addBounds(loc, solidBox);
+                        }
                     }
                 }
+
+                if (sectionLevels > 1) {
+                    // the rest of the section is the same, so go to the top of it
+                    y += sectionLevels - 1;
+                    boxIndex += sectionLevels - 1;
+                    chunkIndex += (sectionLevels - 1) * 256;
+                }
             }
         }
     }
 }
 
-// copy relevant part of a given chunk to the box data grid
-static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorldBox, int mcVersion, int versionID)
+// Copy the part of the chunk that's inside readWorldBox to the box data grid, which is already cleared to zero.
+// Called by several threads at once, each with a different chunk.
+static void extractChunk(WorldBlock* block, int bx, int bz, IBox* readWorldBox)
 {
     int chunkX, chunkZ;
 
@@ -2678,67 +3107,56 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
     //IPoint loc;
     //unsigned char dataVal;
 
-    WorldBlock* block;
-    void* data;
-    bool found = (WorldBlock*)Cache_Find(bx, bz, &data);
-    block = (WorldBlock*)data;
-
-    if (!found)
-    {
-        wcsncpy_s(pWorldGuide->directory, MAX_PATH_AND_FILE, pWorldGuide->world, MAX_PATH_AND_FILE - 1);
-        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"/");
-        if (gModel.options->worldType & HELL)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM-1");
-        }
-        if (gModel.options->worldType & ENDER)
-        {
-            wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, L"DIM1");
-        }
-        wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
-
-        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, gBlockRetCode);
-        Cache_Add(bx, bz, block);
-    }
-
-    if ((block == NULL) || (block->blockType == NBT_NO_SECTIONS)) //blank tile, nothing to do
-        return;
-
     // loop through area of box that overlaps with this chunk
     chunkX = bx * 16;
     chunkZ = bz * 16;
 
-    loopXmin = max(edgeWorldBox->min[X], chunkX);
-    loopZmin = max(edgeWorldBox->min[Z], chunkZ);
+    loopXmin = max(readWorldBox->min[X], chunkX);
+    loopZmin = max(readWorldBox->min[Z], chunkZ);
 
-    loopXmax = min(edgeWorldBox->max[X], chunkX + 15);
-    loopZmax = min(edgeWorldBox->max[Z], chunkZ + 15);
+    loopXmax = min(readWorldBox->max[X], chunkX + 15);
+    loopZmax = min(readWorldBox->max[Z], chunkZ + 15);
 
     int useBiomes = (gModel.options->exportFlags & EXPT_BIOME);
 
-    int miny = edgeWorldBox->min[Y];
+    int miny = readWorldBox->min[Y];
     if (miny > block->maxFilledHeight + gMinHeight) {
-        // done! The box doesn't overlap this chunk
+        // done! The box doesn't overlap this chunk's contents
         return;
     }
-    int maxy = edgeWorldBox->max[Y];
+    int maxy = readWorldBox->max[Y];
     if (maxy > block->maxFilledHeight + gMinHeight) {
-        // don't search empty (and possibly unallocated) space
+        // don't copy empty (and possibly unallocated) space
         maxy = block->maxFilledHeight + gMinHeight;
     }
 
     for (x = loopXmin; x <= loopXmax; x++) {
         for (z = loopZmin; z <= loopZmax; z++) {
-            boxIndex = WORLD_TO_BOX_INDEX(x, miny, z);
-            chunkIndex = CHUNK_INDEX(bx, bz, x, miny, z);
             if (useBiomes)
             {
-                // X and Z location index is stored in the low-order bits; mask off Y location
                 int biomeIdx = (x + gWorld2BoxOffset[X]) * gBoxSize[Z] + z + gWorld2BoxOffset[Z];
-                gBiomeArray[biomeIdx] = block->biome[chunkIndex & 0xff];
+                gBiomeArray[biomeIdx] = block->biome[(z - chunkZ) * 16 + x - chunkX];
             }
 
+            boxIndex = WORLD_TO_BOX_INDEX(x, miny, z);
+            chunkIndex = CHUNK_INDEX(bx, bz, x, miny, z);
+
             for (y = miny; y <= maxy; y++, boxIndex++) {
+                // The box starts out all zeroes, so at the bottom of a section (or of the box), skip over the
+                // section if it's all air with a data value of 0.
+                int level = chunkIndex >> 8;
+                if (((y == miny) || ((level & 0xf) == 0)) && (block->sectionUniform & (1 << (level >> 4))) &&
+                    (block->grid[chunkIndex] == BLOCK_AIR) && (block->data[chunkIndex] == 0)) {
+                    int sectionLevels = 16 - (level & 0xf);
+                    if (y + sectionLevels - 1 > maxy) {
+                        sectionLevels = maxy - y + 1;
+                    }
+                    y += sectionLevels - 1;
+                    boxIndex += sectionLevels - 1;
+                    chunkIndex += sectionLevels * 256;
+                    continue;
+                }
+
                 // Get the extra values (orientation, type) for the blocks
                 assert((chunkIndex >> 8) <= block->maxFilledHeight);  // if block is reduced in size, make sure it's in bounds
                 unsigned char dataVal = block->data[chunkIndex];
@@ -2747,16 +3165,16 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                 if (gIs13orNewer && (dataVal & HIGH_BIT) && (block->grid[chunkIndex] != BLOCK_HEAD) && (block->grid[chunkIndex] != BLOCK_FLOWER_POT)) {
                     // if you hit this, something has gone odd with the dataVal, which shouldn't happen. See nbt.cpp where it says "make sure upper bits are not set - they should not be!"
                     assert(block->grid[chunkIndex] < NUM_BLOCKS_DEFINED - 256);
-                    gBoxData[boxIndex].data = dataVal & 0x7F;
+                    gBoxData.data[boxIndex] = dataVal & 0x7F;
                     // high bit turns into +256
-                    blockID = gBoxData[boxIndex].origType =
-                        gBoxData[boxIndex].type = block->grid[chunkIndex] | 0x100;
+                    blockID = gBoxData.origType[boxIndex] =
+                        gBoxData.type[boxIndex] = (unsigned short)(block->grid[chunkIndex] | 0x100);
                 }
                 else {
                     // normal case - just transfer the data
-                    gBoxData[boxIndex].data = dataVal;
-                    blockID = gBoxData[boxIndex].origType =
-                        gBoxData[boxIndex].type = block->grid[chunkIndex];
+                    gBoxData.data[boxIndex] = dataVal;
+                    blockID = gBoxData.origType[boxIndex] =
+                        gBoxData.type[boxIndex] = block->grid[chunkIndex];
                 }
 
                 // tile entities needed if using old data format
@@ -2775,7 +3193,7 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                                     if (pBE->type == blockID || ((pBE->type == BLOCK_STANDING_BANNER) && (blockID == BLOCK_WALL_BANNER))) {
                                         // found it, data gets stored differently for heads and flowers
                                         if (blockID == BLOCK_FLOWER_POT) {
-                                            gBoxData[boxIndex].data = pBE->data;
+                                            gBoxData.data[boxIndex] = pBE->data;
                                         }
                                         else if (blockID == BLOCK_HEAD) {
                                             // BLOCK_HEAD
@@ -2786,18 +3204,18 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                                             // bit 7 - is bottom four bits 3210 the rotation on floor? If off, put on wall.
                                             // bits 654 - the head. Hopefully Minecraft won't add more than 8 heads...
                                             // bits 3210 - depends on bit 7; rotation if on floor, or on which wall (2-5)
-                                            if (gBoxData[boxIndex].data > 1) {
+                                            if (gBoxData.data[boxIndex] > 1) {
                                                 // head is on the wall, so rotation is ignored; just store the head in the high 4 bits
                                                 assert((pBE->data & 0x80) == 0x0);	// topmost bit better not be used...
                                                 // use wall rotation value 2-5 in lower 4 bits, put head type in next top 3 bits.
-                                                gBoxData[boxIndex].data |= pBE->data & 0x70;
+                                                gBoxData.data[boxIndex] |= pBE->data & 0x70;
                                             }
                                             else {
                                                 // head is on the floor, use the rotation angle too.
-                                                assert(gBoxData[boxIndex].data == 1);
+                                                assert(gBoxData.data[boxIndex] == 1);
                                                 // flag very highest bit: this means the lower data field is the rotation angle, 0-16, like sign posts.
                                                 // use head data and rotation data, and flag topmost bit to note it's this way
-                                                gBoxData[boxIndex].data = pBE->data | 0x80;
+                                                gBoxData.data[boxIndex] = pBE->data | 0x80;
                                             }
                                         }
                                         else if ((blockID == BLOCK_STANDING_BANNER) || (blockID == BLOCK_WALL_BANNER)) {
@@ -2809,10 +3227,10 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                                                 //{ 0, 177,           0, "white_wall_banner", FACING_PROP },
                                                 //{ 0,  38,    HIGH_BIT, "orange_wall_banner", FACING_PROP },
                                                 if (blockID == BLOCK_STANDING_BANNER) {
-                                                    gBoxData[boxIndex].type = (23 | 0x100) + 14 - pBE->data;
+                                                    gBoxData.type[boxIndex] = (unsigned short)((23 | 0x100) + 14 - pBE->data);
                                                 }
                                                 else {
-                                                    gBoxData[boxIndex].type = (38 | 0x100) + 14 - pBE->data;
+                                                    gBoxData.type[boxIndex] = (unsigned short)((38 | 0x100) + 14 - pBE->data);
                                                 }
                                             }
                                         }
@@ -2828,14 +3246,7 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                             //assert(i < block->numEntities);
                         }
                     }
-                    // for 1.12 and earlier, shove bottom half flower ID number into top half, too
-                    else if ((blockID == BLOCK_DOUBLE_FLOWER) && (gBoxData[boxIndex].data & 0x8)) {
-                        // The top part of the flower doesn't always have the lower bits that identifies it. Copy these over from the block below, if available.
-                        // This could screw up schematic export. TODO
-                        if (y > miny) {
-                            gBoxData[boxIndex].data = 0x8 | gBoxData[boxIndex - 1].data;
-                        }
-                    }
+                    // the top half of a double flower gets its type from the bottom half, see tightenBox()
                 }
 
                 // For Anvil, Y goes up by 256 (in 1.1 and earlier, it was just ++)
@@ -2849,14 +3260,240 @@ static void extractChunk(WorldGuide* pWorldGuide, int bx, int bz, IBox* edgeWorl
                 //{
                 //Vec3Scalar( loc, =, x,y,z );
                 //addBounds(loc,&gSolidWorldBox);
+            }
+        }
+    }
+}
+
+// The box was read in for the whole volume, with the size and offset given. Move the part of it inside edgeWorldBox
+// to where it goes in the box now set up by initializeWorldData(), clear the rest, and shrink the arrays to fit. This
+// is done in place: the new box is no larger in any direction and starts no earlier, so a cell never moves to a later
+// index, and going through the new box in order never writes over a cell still to be moved. Counts the unknown blocks
+// and fixes up double flowers along the way. Returns false if out of memory.
+static bool tightenBox(IPoint oldBoxSize, IPoint oldWorld2BoxOffset, IBox* edgeWorldBox)
+{
+    int x, z, boxIndex, oldIndex;
+    int ylo = edgeWorldBox->min[Y] + gWorld2BoxOffset[Y];
+    int yhi = edgeWorldBox->max[Y] + gWorld2BoxOffset[Y];
+    int runLength = yhi - ylo + 1;
+
+    for (x = 0; x < gBoxSize[X]; x++)
+    {
+        int worldX = x - gWorld2BoxOffset[X];
+        for (z = 0; z < gBoxSize[Z]; z++)
+        {
+            int worldZ = z - gWorld2BoxOffset[Z];
+            boxIndex = BOX_INDEX(x, 0, z);
+            int biomeIndex = x * gBoxSize[Z] + z;
+            if ((worldX < edgeWorldBox->min[X]) || (worldX > edgeWorldBox->max[X]) ||
+                (worldZ < edgeWorldBox->min[Z]) || (worldZ > edgeWorldBox->max[Z]))
+            {
+                clearBoxCells(boxIndex, gBoxSize[Y]);
+                if (gBiomeArray)
+                {
+                    gBiomeArray[biomeIndex] = 0;
+                }
+                continue;
+            }
 
-                if (blockID == BLOCK_UNKNOWN)
+            oldIndex = (worldX + oldWorld2BoxOffset[X]) * oldBoxSize[Y] * oldBoxSize[Z] +
+                (worldZ + oldWorld2BoxOffset[Z]) * oldBoxSize[Y] + edgeWorldBox->min[Y] + oldWorld2BoxOffset[Y];
+            assert(oldIndex >= boxIndex + ylo);
+            clearBoxCells(boxIndex, ylo);
+            memmove(&gBoxData.type[boxIndex + ylo], &gBoxData.type[oldIndex], runLength * sizeof(unsigned short));
+            memmove(&gBoxData.origType[boxIndex + ylo], &gBoxData.origType[oldIndex], runLength * sizeof(unsigned short));
+            memmove(&gBoxData.data[boxIndex + ylo], &gBoxData.data[oldIndex], runLength * sizeof(unsigned char));
+            clearBoxCells(boxIndex + yhi + 1, gBoxSize[Y] - yhi - 1);
+            if (gBiomeArray)
+            {
+                gBiomeArray[biomeIndex] = gBiomeArray[(worldX + oldWorld2BoxOffset[X]) * oldBoxSize[Z] + worldZ + oldWorld2BoxOffset[Z]];
+            }
+
+            for (boxIndex += ylo; boxIndex <= BOX_INDEX(x, yhi, z); boxIndex++)
+            {
+                if (gBoxData.origType[boxIndex] == BLOCK_UNKNOWN)
                 {
                     gBadBlocksInModel++;
                 }
+                // for 1.12 and earlier, shove bottom half flower ID number into top half, too
+                else if (!gIs13orNewer && (gBoxData.origType[boxIndex] == BLOCK_DOUBLE_FLOWER) && (gBoxData.data[boxIndex] & 0x8)) {
+                    // The top part of the flower doesn't always have the lower bits that identifies it. Copy these over from the block below, if available.
+                    // This could screw up schematic export. TODO
+                    if (boxIndex > BOX_INDEX(x, ylo, z)) {
+                        gBoxData.data[boxIndex] = 0x8 | gBoxData.data[boxIndex - 1];
+                    }
+                }
             }
         }
     }
+
+    // the flat flags are still all zero, so only need to be shrunk
+    unsigned short* type = (unsigned short*)realloc(gBoxData.type, gBoxSizeXYZ * sizeof(unsigned short));
+    unsigned short* origType = (unsigned short*)realloc(gBoxData.origType, gBoxSizeXYZ * sizeof(unsigned short));
+    unsigned char* flatFlags = (unsigned char*)realloc(gBoxData.flatFlags, gBoxSizeXYZ * sizeof(unsigned char));
+    unsigned char* data = (unsigned char*)realloc(gBoxData.data, gBoxSizeXYZ * sizeof(unsigned char));
+    // shrinking can't fail, but if it does the original block is still good
+    if (type) gBoxData.type = type;
+    if (origType) gBoxData.origType = origType;
+    if (flatFlags) gBoxData.flatFlags = flatFlags;
+    if (data) gBoxData.data = data;
+    if (gBiomeArray)
+    {
+        unsigned char* biome = (unsigned char*)realloc(gBiomeArray, gBoxSize[X] * gBoxSize[Z] * sizeof(unsigned char));
+        if (biome) gBiomeArray = biome;
+    }
+
+    if (boxNeedsGroups())
+    {
+        gBoxData.group = (int*)calloc(gBoxSizeXYZ, sizeof(int));
+        if (gBoxData.group == NULL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// set the types, original types and data values of a run of cells to air, 0
+static void clearBoxCells(int boxIndex, int count)
+{
+    memset(&gBoxData.type[boxIndex], 0, count * sizeof(unsigned short));
+    memset(&gBoxData.origType[boxIndex], 0, count * sizeof(unsigned short));
+    memset(&gBoxData.data[boxIndex], 0, count * sizeof(unsigned char));
+}
+
+// For performance testing: read the volume into the export box as populateBox() does, passes times with one thread and
+// then passes times with a set of threads, clearing the cache first each time so every chunk is read in again. The
+// milliseconds per pass for each are returned; sameOutput is set if every pass gave the same box, original types, data
+// values, biomes and solid bounds as the first. Returns an MW_ code, e.g. MW_NO_BLOCKS_FOUND if the volume is empty.
+int BenchmarkExportRead(WorldGuide* pWorldGuide, Options* pOptions, int xmin, int ymin, int zmin, int xmax, int ymax, int zmax, int mapMinHeight, int mapMaxHeight,
+    int worldVersion, int passes, double* serialMsec, double* parallelMsec, bool* sameOutput)
+{
+    Options options = *pOptions;
+    ExportFileData efd;
+    BoxData firstBox;
+    unsigned char* firstBiome = NULL;
+    IBox firstSolidWorldBox;
+    IPoint firstBoxSize;
+    int firstBadBlocks = 0;
+    int retCode = MW_NO_ERROR;
+    int pass;
+
+    *serialMsec = *parallelMsec = 0.0;
+    *sameOutput = true;
+    memset(&firstBox, 0, sizeof(BoxData));
+
+    gMinecraftWorldVersion = worldVersion;
+    gMcVersion = DATA_VERSION_TO_RELEASE_NUMBER(worldVersion);
+    gIs13orNewer = (gMcVersion >= 13);
+    gMinHeight = mapMinHeight;
+    gMaxHeight = mapMaxHeight;
+
+    // read everything a rendering export would, with biomes, and nothing more
+    memset(&efd, 0, sizeof(ExportFileData));
+    options.pEFD = &efd;
+    options.exportFlags = EXPT_BIOME;
+    options.saveFilterFlags = BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF | BLF_MIDDLER | BLF_BILLBOARD | BLF_PANE | BLF_FLATTEN | BLF_FLATTEN_SMALL;
+    memset(&gModel, 0, sizeof(Model));
+    gModel.options = &options;
+
+    for (pass = 0; pass < 2 * passes; pass++)
+    {
+        IBox worldBox;
+        Vec3Scalar(worldBox.min, =, xmin, clamp(ymin, mapMinHeight, mapMaxHeight), zmin);
+        Vec3Scalar(worldBox.max, =, xmax, clamp(ymax, mapMinHeight, mapMaxHeight), zmax);
+        gBadBlocksInModel = 0;
+        gExportSerial = (pass < passes);
+        ClearCache();
+
+        clock_t start = clock();
+        retCode = populateBox(pWorldGuide, NULL, &worldBox);
+        double msec = 1000.0 * (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+        if (retCode >= MW_BEGIN_NOTHING_TO_DO)
+        {
+            goto Exit;
+        }
+        *(gExportSerial ? serialMsec : parallelMsec) += msec / (double)passes;
+
+        if (pass == 0)
+        {
+            // keep the first box to compare the rest to
+            firstBox = gBoxData;
+            firstBiome = gBiomeArray;
+            memset(&gBoxData, 0, sizeof(BoxData));
+            gBiomeArray = NULL;
+            firstSolidWorldBox = gSolidWorldBox;
+            Vec2Op(firstBoxSize, =, gBoxSize);
+            firstBadBlocks = gBadBlocksInModel;
+        }
+        else if (memcmp(firstBoxSize, gBoxSize, sizeof(IPoint)) || memcmp(&firstSolidWorldBox, &gSolidWorldBox, sizeof(IBox)) ||
+            (firstBadBlocks != gBadBlocksInModel) ||
+            memcmp(firstBox.type, gBoxData.type, gBoxSizeXYZ * sizeof(unsigned short)) ||
+            memcmp(firstBox.origType, gBoxData.origType, gBoxSizeXYZ * sizeof(unsigned short)) ||
+            memcmp(firstBox.data, gBoxData.data, gBoxSizeXYZ * sizeof(unsigned char)) ||
+            memcmp(firstBiome, gBiomeArray, gBoxSize[X] * gBoxSize[Z] * sizeof(unsigned char)))
+        {
+            *sameOutput = false;
+        }
+        freeBoxData();
+        free(gBiomeArray);
+        gBiomeArray = NULL;
+    }
+
+Exit:
+    gExportSerial = false;
+    freeBoxData();
+    if (gBiomeArray)
+    {
+        free(gBiomeArray);
+        gBiomeArray = NULL;
+    }
+    gBoxData = firstBox;
+    freeBoxData();
+    free(firstBiome);
+    memset(&gModel, 0, sizeof(Model));
+    return retCode;
+}
+
+// Are connected groups of blocks going to be found, or used, for this export? Only then is there a group for each cell.
+static bool boxNeedsGroups()
+{
+    return gModel.print3D ||
+        (gModel.options->exportFlags & (EXPT_FILL_BUBBLES | EXPT_CONNECT_PARTS | EXPT_DELETE_FLOATING_OBJECTS | EXPT_DEBUG_SHOW_GROUPS | EXPT_HOLLOW_BOTTOM)) ||
+        gModel.options->pEFD->chkMeltSnow;
+}
+
+// Allocate the export box, all cleared to air. Each array is allocated separately, as a few smaller pieces of memory
+// are easier to find than one large one. Returns false if out of memory, with nothing left allocated.
+static bool allocBoxData(int size, bool groups)
+{
+    gBoxData.type = (unsigned short*)calloc(size, sizeof(unsigned short));
+    gBoxData.origType = (unsigned short*)calloc(size, sizeof(unsigned short));
+    gBoxData.flatFlags = (unsigned char*)calloc(size, sizeof(unsigned char));
+    gBoxData.data = (unsigned char*)calloc(size, sizeof(unsigned char));
+    gBoxData.group = groups ? (int*)calloc(size, sizeof(int)) : NULL;
+    if ((gBoxData.type == NULL) || (gBoxData.origType == NULL) || (gBoxData.flatFlags == NULL) || (gBoxData.data == NULL) ||
+        (groups && (gBoxData.group == NULL)))
+    {
+        freeBoxData();
+        return false;
+    }
+    return true;
+}
+
+static void freeBoxData()
+{
+    if (gBoxData.group)
+        free(gBoxData.group);
+    if (gBoxData.type)
+        free(gBoxData.type);
+    if (gBoxData.origType)
+        free(gBoxData.origType);
+    if (gBoxData.flatFlags)
+        free(gBoxData.flatFlags);
+    if (gBoxData.data)
+        free(gBoxData.data);
+    memset(&gBoxData, 0, sizeof(BoxData));
 }
 
 static bool willChangeBlockCommandModifyAir(ChangeBlockCommand* pCBC)
@@ -2927,20 +3564,20 @@ static void editBlock(int x, int y, int z, int editMode)
     switch (editMode)
     {
     case EDIT_MODE_CLEAR_TYPE:
-        gBoxData[boxIndex].type = BLOCK_AIR;
+        gBoxData.type[boxIndex] = BLOCK_AIR;
         // don't clear data field, since origType is still intact
         break;
     case EDIT_MODE_CLEAR_ALL:
-        gBoxData[boxIndex].type = gBoxData[boxIndex].origType = BLOCK_AIR;
-        gBoxData[boxIndex].data = 0x0f;
+        gBoxData.type[boxIndex] = gBoxData.origType[boxIndex] = BLOCK_AIR;
+        gBoxData.data[boxIndex] = 0x0f;
         break;
     case EDIT_MODE_CLEAR_TYPE_AND_ENTRANCES:
         // if type is an entrance, clear it fully: done so seed propagation along borders happens properly
-        if (gBlockDefinitions[gBoxData[boxIndex].origType].flags & BLF_ENTRANCE)
+        if (gBlockDefinitions[gBoxData.origType[boxIndex]].flags & BLF_ENTRANCE)
         {
-            gBoxData[boxIndex].origType = BLOCK_AIR;
+            gBoxData.origType[boxIndex] = BLOCK_AIR;
         }
-        gBoxData[boxIndex].type = BLOCK_AIR;
+        gBoxData.type[boxIndex] = BLOCK_AIR;
         // don't clear data field, since origType may still be intact
         break;
     default:
@@ -2972,16 +3609,16 @@ static int filterBox(ChangeBlockCommand* pCBC)
             for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
             {
                 // sorry, air is never allowed to turn solid
-                if (gBoxData[boxIndex].type != BLOCK_AIR)
+                if (gBoxData.type[boxIndex] != BLOCK_AIR)
                 {
-                    int flags = gBlockDefinitions[gBoxData[boxIndex].type].flags;
+                    int flags = gBlockDefinitions[gBoxData.type[boxIndex]].flags;
 
                     // check if it's something to be filtered out: not in the output list or alpha is 0
                     if (!(flags & gModel.options->saveFilterFlags) ||
-                        gBlockDefinitions[gBoxData[boxIndex].type].alpha <= 0.0) {
+                        gBlockDefinitions[gBoxData.type[boxIndex]].alpha <= 0.0) {
                         // things that should not be saved should be gone, gone, gone, no trace left
-                        gBoxData[boxIndex].type = gBoxData[boxIndex].origType = BLOCK_AIR;
-                        gBoxData[boxIndex].data = 0x0;
+                        gBoxData.type[boxIndex] = gBoxData.origType[boxIndex] = BLOCK_AIR;
+                        gBoxData.data[boxIndex] = 0x0;
                     }
                 }
             }
@@ -3043,7 +3680,7 @@ static int filterBox(ChangeBlockCommand* pCBC)
                     boxIndex = BOX_INDEX(x, gSolidBox.min[Y], z);
                     for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
                     {
-                        if (gBoxData[boxIndex].type == BLOCK_REDSTONE_WIRE)
+                        if (gBoxData.type[boxIndex] == BLOCK_REDSTONE_WIRE)
                             computeRedstoneConnectivity(boxIndex);
                     }
                 }
@@ -3059,7 +3696,7 @@ static int filterBox(ChangeBlockCommand* pCBC)
                 for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
                 {
                     // sorry, air is never allowed to turn solid
-                    type = gBoxData[boxIndex].type;
+                    type = gBoxData.type[boxIndex];
                     if (type != BLOCK_AIR)
                     {
                         if (type >= NUM_BLOCKS_DEFINED) {
@@ -3069,11 +3706,11 @@ static int filterBox(ChangeBlockCommand* pCBC)
                             // But it's flakey - seems more like uninitialized or corrupted memory. Ugh.
 //#ifdef _DEBUG
 //                            type = BLOCK_BEDROCK;
-//                            gBoxData[boxIndex].type = BLOCK_BEDROCK;
+//                            gBoxData.type[boxIndex] = BLOCK_BEDROCK;
 //#else
-                            type = gBoxData[boxIndex].type = (unsigned short)(GetUnknownBlockID() & 0xff);
+                            type = gBoxData.type[boxIndex] = (unsigned short)(GetUnknownBlockID() & 0xff);
 
-                            gBoxData[boxIndex].data = 0x0;
+                            gBoxData.data[boxIndex] = 0x0;
                             gBadBlocksInModel = true;
                         }
                         int flags = gBlockDefinitions[type].flags;
@@ -3089,21 +3726,21 @@ static int filterBox(ChangeBlockCommand* pCBC)
                             {
                                 // tricksy code: if the return value > 1, then it's an error
                                 // and should be treated as such.
-                                retVal = saveBillboardOrGeometry(boxIndex, type);
+                                retVal = saveCellBillboardOrGeometry(boxIndex, type);
                                 if (retVal == 1)
                                 {
                                     // this block is then cleared out, since it's been processed.
                                     if (IS_WATERLOGGED(type, boxIndex)) {
                                         // clears to water if waterlogged, e.g., seagrass.
-                                        gBoxData[boxIndex].type = BLOCK_STATIONARY_WATER;
-                                        gBoxData[boxIndex].data = 8;
+                                        gBoxData.type[boxIndex] = BLOCK_STATIONARY_WATER;
+                                        gBoxData.data[boxIndex] = 8;
                                     }
                                     else {
-                                        gBoxData[boxIndex].type = BLOCK_AIR;
+                                        gBoxData.type[boxIndex] = BLOCK_AIR;
                                     }
                                     // do NOT do this, as we use the data later to check if geometry
                                     // covers a voxel face, etc., e.g. stairs in particular:
-                                    // NO NO NO gBoxData[boxIndex].data = 0x0;
+                                    // NO NO NO gBoxData.data[boxIndex] = 0x0;
                                     blockProcessed = 1;
                                 }
                                 else if (retVal >= MW_BEGIN_ERRORS)
@@ -3120,20 +3757,20 @@ static int filterBox(ChangeBlockCommand* pCBC)
                             // or to its neighbor, or both (depends on dataval),
                             // instead of rendering a block for it.
 
-                            // was: gBoxData[boxIndex-1].flatFlags = type;
+                            // was: gBoxData.flatFlags[boxIndex-1] = type;
                             // if object was indeed flattened, set it to air
                             if (computeFlatFlags(boxIndex))
                             {
                                 if (IS_WATERLOGGED(type, boxIndex)) {
                                     // clears to water if waterlogged, e.g., seagrass
-                                    gBoxData[boxIndex].type = BLOCK_STATIONARY_WATER;
-                                    gBoxData[boxIndex].data = 8; // level of water set to full
+                                    gBoxData.type[boxIndex] = BLOCK_STATIONARY_WATER;
+                                    gBoxData.data[boxIndex] = 8; // level of water set to full
                                 }
                                 else {
-                                    gBoxData[boxIndex].type = BLOCK_AIR;
+                                    gBoxData.type[boxIndex] = BLOCK_AIR;
                                 }
                                 // don't do this: we may use origType and data at some point:
-                                // NO NO NO: gBoxData[boxIndex].data = 0x0;
+                                // NO NO NO: gBoxData.data[boxIndex] = 0x0;
                             }
                             else
                             {
@@ -3165,7 +3802,7 @@ static int filterBox(ChangeBlockCommand* pCBC)
                     for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
                     {
                         // sorry, air is never allowed to turn solid
-                        type = gBoxData[boxIndex].type;
+                        type = gBoxData.type[boxIndex];
                         if (type != BLOCK_AIR)
                         {
                             int flags = gBlockDefinitions[type].flags;
@@ -3177,21 +3814,21 @@ static int filterBox(ChangeBlockCommand* pCBC)
                             // so that floaters are not deleted? Probably... but we don't try to test.
                             if (flags & outputFlags)
                             {
-                                retVal = saveBillboardOrGeometry(boxIndex, type);
+                                retVal = saveCellBillboardOrGeometry(boxIndex, type);
                                 if (retVal == 1)
                                 {
                                     // this block is then cleared out, since it's been processed.
                                     if (IS_WATERLOGGED(type, boxIndex)) {
                                         // clears to water if waterlogged, e.g., seagrass
-                                        gBoxData[boxIndex].type = BLOCK_STATIONARY_WATER;
-                                        gBoxData[boxIndex].data = 8;
+                                        gBoxData.type[boxIndex] = BLOCK_STATIONARY_WATER;
+                                        gBoxData.data[boxIndex] = 8;
                                     }
                                     else {
-                                        gBoxData[boxIndex].type = BLOCK_AIR;
+                                        gBoxData.type[boxIndex] = BLOCK_AIR;
                                     }
                                     // do NOT do this, as we use the data later to check if geometry
                                     // covers a voxel face, etc., e.g. stairs in particular:
-                                    // NO NO NO gBoxData[boxIndex].data = 0x0;
+                                    // NO NO NO gBoxData.data[boxIndex] = 0x0;
                                     foundBlock = 1;
                                 }
                                 else if (retVal >= MW_BEGIN_ERRORS)
@@ -3477,21 +4114,21 @@ static bool applyChangeBlockCommand(ChangeBlockCommand* pCBC)
                 bool modify = false;
                 if (pCBC->useFromArray) {
                     // apply array: see if bit for type is flagged
-                    if (pCBC->fromDataBitsArray[gBoxData[boxIndex].type] & (1 << gBoxData[boxIndex].data))
+                    if (pCBC->fromDataBitsArray[gBoxData.type[boxIndex]] & (1 << gBoxData.data[boxIndex]))
                         modify = true;
                 }
                 else {
                     // apply range and bits
-                    int fromType = gBoxData[boxIndex].type;
-                    if ((pCBC->simpleFromDataBits & (1 << gBoxData[boxIndex].data)) &&
+                    int fromType = gBoxData.type[boxIndex];
+                    if ((pCBC->simpleFromDataBits & (1 << gBoxData.data[boxIndex])) &&
                         (pCBC->simpleFromTypeBegin <= fromType) &&
                         (pCBC->simpleFromTypeEnd >= fromType)) {
                         modify = true;
                     }
                 }
                 if (modify) {
-                    gBoxData[boxIndex].type = gBoxData[boxIndex].origType = toType;
-                    gBoxData[boxIndex].data = toData;
+                    gBoxData.type[boxIndex] = gBoxData.origType[boxIndex] = toType;
+                    gBoxData.data[boxIndex] = toData;
                 }
             }
         }
@@ -3511,7 +4148,7 @@ static bool isWorldVolumeEmpty()
             boxIndex = BOX_INDEX(x, y, gSolidBox.min[Z]);
             for (z = gSolidBox.min[Z]; z <= gSolidBox.max[Z]; z++, boxIndex += gBoxSize[Y])
             {
-                if (gBoxData[boxIndex].type != BLOCK_AIR) {
+                if (gBoxData.type[boxIndex] != BLOCK_AIR) {
                     gSolidBox.max[Y] = y;
                     return false;
                 }
@@ -3525,7 +4162,7 @@ static bool isWorldVolumeEmpty()
     //		boxIndex = BOX_INDEX(x, gSolidBox.min[Y], z);
     //		for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
     //		{
-    //			if (gBoxData[boxIndex].type != BLOCK_AIR)
+    //			if (gBoxData.type[boxIndex] != BLOCK_AIR)
     //				return false;
     //		}
     //	}
@@ -3537,7 +4174,7 @@ static bool isWorldVolumeEmpty()
 static void computeRedstoneConnectivity(int boxIndex)
 {
     //BLOCK_REDSTONE_WIRE:
-    gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+    gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
     // look to see whether there is wire neighboring and above: if so, run this wire
     // up the sides of the blocks
 
@@ -3551,8 +4188,8 @@ static void computeRedstoneConnectivity(int boxIndex)
     //
     // Version test here isn't quite right, but basically 1.16 20w21a is the time
     //if (gMinecraftWorldVersion >= 2532) {
-    //    isCross = (gBoxData[boxIndex].data == BIT_16);
-    //    gBoxData[boxIndex].data &= ~BIT_16;
+    //    isCross = (gBoxData.data[boxIndex] == BIT_16);
+    //    gBoxData.data[boxIndex] &= ~BIT_16;
     //}
 
     // first, is the block above the redstone wire not a whole block, or is a whole block and is glass on the outside or a piston?
@@ -3562,61 +4199,61 @@ static void computeRedstoneConnectivity(int boxIndex)
     // These two will normally connect. However, if just above the redstone on the ground is a full block that is not glass/glowstone/piston/observer/etc.,
     // it will chop the redstone on the ground from connecting with the neighboring redstone a level up. Whew.
     // See the "full-block solids" section here https://minecraft.wiki/w/Opacity#Types_of_transparent_blocks for which blocks should be listed below
-    if (!(gBlockDefinitions[gBoxData[boxIndex + 1].origType].flags & BLF_WHOLE) ||
-        //(gBoxData[boxIndex + 1].origType == BLOCK_PISTON) || - not needed; not a whole block
-        (gBoxData[boxIndex + 1].origType == BLOCK_GLASS) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_GLOWSTONE && (gBoxData[boxIndex + 1].data & 0xf) == 0x0) ||   // shroomlight blocks *do* cut off redstone wires
+    if (!(gBlockDefinitions[gBoxData.origType[boxIndex + 1]].flags & BLF_WHOLE) ||
+        //(gBoxData.origType[boxIndex + 1] == BLOCK_PISTON) || - not needed; not a whole block
+        (gBoxData.origType[boxIndex + 1] == BLOCK_GLASS) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_GLOWSTONE && (gBoxData.data[boxIndex + 1] & 0xf) == 0x0) ||   // shroomlight blocks *do* cut off redstone wires
          // "Target" used to conduct in 20w16a, now it does not - testing here is easier than moving the TNT elsewhere
-        (gBoxData[boxIndex + 1].origType == BLOCK_TNT && !(gBoxData[boxIndex + 1].data & 0x1)) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_REDSTONE_BLOCK) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_SEA_LANTERN) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_BEACON) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_ICE) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_FROSTED_ICE) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_OBSERVER) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_LEAVES) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_AD_LEAVES) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_MANGROVE_LEAVES) ||
-        (gBoxData[boxIndex + 1].origType == BLOCK_STAINED_GLASS))
+        (gBoxData.origType[boxIndex + 1] == BLOCK_TNT && !(gBoxData.data[boxIndex + 1] & 0x1)) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_REDSTONE_BLOCK) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_SEA_LANTERN) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_BEACON) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_ICE) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_FROSTED_ICE) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_OBSERVER) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_LEAVES) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_AD_LEAVES) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_MANGROVE_LEAVES) ||
+        (gBoxData.origType[boxIndex + 1] == BLOCK_STAINED_GLASS))
     {
         // first hurdle passed - now check each in turn: is block above wire. If so,
         // then these will connect. Note we must check again origType, as wires get culled out
         // as we go through the blocks.
-        if (gBoxData[boxIndex + 1 + gBoxSizeYZ].origType == BLOCK_REDSTONE_WIRE)
+        if (gBoxData.origType[boxIndex + 1 + gBoxSizeYZ] == BLOCK_REDSTONE_WIRE)
         {
             // (upside down) stairs do not have redstone put on their sides.
-            if (!(gBlockDefinitions[gBoxData[boxIndex + gBoxSizeYZ].type].flags & (BLF_STAIRS | BLF_HALF))) {
-                gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            if (!(gBlockDefinitions[gBoxData.type[boxIndex + gBoxSizeYZ]].flags & (BLF_STAIRS | BLF_HALF))) {
+                gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             }
-            gBoxData[boxIndex + 1 + gBoxSizeYZ].data |= (FLAT_FACE_LO_X << 4);
-            gBoxData[boxIndex].data |= (FLAT_FACE_HI_X << 4);
+            gBoxData.data[boxIndex + 1 + gBoxSizeYZ] |= (FLAT_FACE_LO_X << 4);
+            gBoxData.data[boxIndex] |= (FLAT_FACE_HI_X << 4);
         }
-        if (gBoxData[boxIndex + 1 - gBoxSizeYZ].origType == BLOCK_REDSTONE_WIRE)
+        if (gBoxData.origType[boxIndex + 1 - gBoxSizeYZ] == BLOCK_REDSTONE_WIRE)
         {
             // (upside down) stairs do not have redstone put on their sides.
-            if (!(gBlockDefinitions[gBoxData[boxIndex - gBoxSizeYZ].type].flags & (BLF_STAIRS | BLF_HALF))) {
-                gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            if (!(gBlockDefinitions[gBoxData.type[boxIndex - gBoxSizeYZ]].flags & (BLF_STAIRS | BLF_HALF))) {
+                gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             }
-            gBoxData[boxIndex + 1 - gBoxSizeYZ].data |= (FLAT_FACE_HI_X << 4);
-            gBoxData[boxIndex].data |= (FLAT_FACE_LO_X << 4);
+            gBoxData.data[boxIndex + 1 - gBoxSizeYZ] |= (FLAT_FACE_HI_X << 4);
+            gBoxData.data[boxIndex] |= (FLAT_FACE_LO_X << 4);
         }
-        if (gBoxData[boxIndex + 1 + gBoxSize[Y]].origType == BLOCK_REDSTONE_WIRE)
+        if (gBoxData.origType[boxIndex + 1 + gBoxSize[Y]] == BLOCK_REDSTONE_WIRE)
         {
             // (upside down) stairs do not have redstone put on their sides.
-            if (!(gBlockDefinitions[gBoxData[boxIndex + gBoxSize[Y]].type].flags & (BLF_STAIRS | BLF_HALF))) {
-                gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            if (!(gBlockDefinitions[gBoxData.type[boxIndex + gBoxSize[Y]]].flags & (BLF_STAIRS | BLF_HALF))) {
+                gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             }
-            gBoxData[boxIndex + 1 + gBoxSize[Y]].data |= (FLAT_FACE_LO_Z << 4);
-            gBoxData[boxIndex].data |= (FLAT_FACE_HI_Z << 4);
+            gBoxData.data[boxIndex + 1 + gBoxSize[Y]] |= (FLAT_FACE_LO_Z << 4);
+            gBoxData.data[boxIndex] |= (FLAT_FACE_HI_Z << 4);
         }
-        if (gBoxData[boxIndex + 1 - gBoxSize[Y]].origType == BLOCK_REDSTONE_WIRE)
+        if (gBoxData.origType[boxIndex + 1 - gBoxSize[Y]] == BLOCK_REDSTONE_WIRE)
         {
             // (upside down) stairs do not have redstone put on their sides.
-            if (!(gBlockDefinitions[gBoxData[boxIndex - gBoxSize[Y]].type].flags & (BLF_STAIRS | BLF_HALF))) {
-                gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            if (!(gBlockDefinitions[gBoxData.type[boxIndex - gBoxSize[Y]]].flags & (BLF_STAIRS | BLF_HALF))) {
+                gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             }
-            gBoxData[boxIndex + 1 - gBoxSize[Y]].data |= (FLAT_FACE_HI_Z << 4);
-            gBoxData[boxIndex].data |= (FLAT_FACE_LO_Z << 4);
+            gBoxData.data[boxIndex + 1 - gBoxSize[Y]] |= (FLAT_FACE_HI_Z << 4);
+            gBoxData.data[boxIndex] |= (FLAT_FACE_LO_Z << 4);
         }
     }
     // finally, check the +X and +Z neighbors on this level: if wire, connect them.
@@ -3626,48 +4263,48 @@ static void computeRedstoneConnectivity(int boxIndex)
     // Test *all* things that redstone connects to. This could become a table, for speed.
     // What this means: given a block, it will have BLF_CONNECTS_REDSTONE for it if, when you put the block
     // down and put redstone dust next to it, the dust forms a single straight line into the block, instead of a cross.
-    if ((gBlockDefinitions[gBoxData[boxIndex + gBoxSizeYZ].origType].flags & BLF_CONNECTS_REDSTONE) ||
+    if ((gBlockDefinitions[gBoxData.origType[boxIndex + gBoxSizeYZ]].flags & BLF_CONNECTS_REDSTONE) ||
         // repeaters attach only at their ends, so test the direction they're at
-        (gBoxData[boxIndex + gBoxSizeYZ].origType == BLOCK_REDSTONE_REPEATER_OFF && (gBoxData[boxIndex + gBoxSizeYZ].data & 0x1)) ||
-        (gBoxData[boxIndex + gBoxSizeYZ].origType == BLOCK_REDSTONE_REPEATER_ON && (gBoxData[boxIndex + gBoxSizeYZ].data & 0x1))
+        (gBoxData.origType[boxIndex + gBoxSizeYZ] == BLOCK_REDSTONE_REPEATER_OFF && (gBoxData.data[boxIndex + gBoxSizeYZ] & 0x1)) ||
+        (gBoxData.origType[boxIndex + gBoxSizeYZ] == BLOCK_REDSTONE_REPEATER_ON && (gBoxData.data[boxIndex + gBoxSizeYZ] & 0x1))
         )
     {
-        if (gBoxData[boxIndex + gBoxSizeYZ].origType == BLOCK_REDSTONE_WIRE)
-            gBoxData[boxIndex + gBoxSizeYZ].data |= (FLAT_FACE_LO_X << 4);
-        gBoxData[boxIndex].data |= (FLAT_FACE_HI_X << 4);
+        if (gBoxData.origType[boxIndex + gBoxSizeYZ] == BLOCK_REDSTONE_WIRE)
+            gBoxData.data[boxIndex + gBoxSizeYZ] |= (FLAT_FACE_LO_X << 4);
+        gBoxData.data[boxIndex] |= (FLAT_FACE_HI_X << 4);
     }
-    if ((gBlockDefinitions[gBoxData[boxIndex + gBoxSize[Y]].origType].flags & BLF_CONNECTS_REDSTONE) ||
+    if ((gBlockDefinitions[gBoxData.origType[boxIndex + gBoxSize[Y]]].flags & BLF_CONNECTS_REDSTONE) ||
         // repeaters attach only at their ends, so test the direction they're at
-        (gBoxData[boxIndex + gBoxSize[Y]].origType == BLOCK_REDSTONE_REPEATER_OFF && !(gBoxData[boxIndex + gBoxSize[Y]].data & 0x1)) ||
-        (gBoxData[boxIndex + gBoxSize[Y]].origType == BLOCK_REDSTONE_REPEATER_ON && !(gBoxData[boxIndex + gBoxSize[Y]].data & 0x1))
+        (gBoxData.origType[boxIndex + gBoxSize[Y]] == BLOCK_REDSTONE_REPEATER_OFF && !(gBoxData.data[boxIndex + gBoxSize[Y]] & 0x1)) ||
+        (gBoxData.origType[boxIndex + gBoxSize[Y]] == BLOCK_REDSTONE_REPEATER_ON && !(gBoxData.data[boxIndex + gBoxSize[Y]] & 0x1))
         )
     {
-        if (gBoxData[boxIndex + gBoxSize[Y]].origType == BLOCK_REDSTONE_WIRE)
-            gBoxData[boxIndex + gBoxSize[Y]].data |= (FLAT_FACE_LO_Z << 4);
-        gBoxData[boxIndex].data |= (FLAT_FACE_HI_Z << 4);
+        if (gBoxData.origType[boxIndex + gBoxSize[Y]] == BLOCK_REDSTONE_WIRE)
+            gBoxData.data[boxIndex + gBoxSize[Y]] |= (FLAT_FACE_LO_Z << 4);
+        gBoxData.data[boxIndex] |= (FLAT_FACE_HI_Z << 4);
     }
     // catch redstone torches at the -X and -Z faces
-    if ((gBlockDefinitions[gBoxData[boxIndex - gBoxSizeYZ].origType].flags & BLF_CONNECTS_REDSTONE) ||
+    if ((gBlockDefinitions[gBoxData.origType[boxIndex - gBoxSizeYZ]].flags & BLF_CONNECTS_REDSTONE) ||
         // repeaters attach only at their ends, so test the direction they're at
-        (gBoxData[boxIndex - gBoxSizeYZ].origType == BLOCK_REDSTONE_REPEATER_OFF && (gBoxData[boxIndex - gBoxSizeYZ].data & 0x1)) ||
-        (gBoxData[boxIndex - gBoxSizeYZ].origType == BLOCK_REDSTONE_REPEATER_ON && (gBoxData[boxIndex - gBoxSizeYZ].data & 0x1))
+        (gBoxData.origType[boxIndex - gBoxSizeYZ] == BLOCK_REDSTONE_REPEATER_OFF && (gBoxData.data[boxIndex - gBoxSizeYZ] & 0x1)) ||
+        (gBoxData.origType[boxIndex - gBoxSizeYZ] == BLOCK_REDSTONE_REPEATER_ON && (gBoxData.data[boxIndex - gBoxSizeYZ] & 0x1))
         )
     {
-        gBoxData[boxIndex].data |= (FLAT_FACE_LO_X << 4);
+        gBoxData.data[boxIndex] |= (FLAT_FACE_LO_X << 4);
     }
-    if ((gBlockDefinitions[gBoxData[boxIndex - gBoxSize[Y]].origType].flags & BLF_CONNECTS_REDSTONE) ||
+    if ((gBlockDefinitions[gBoxData.origType[boxIndex - gBoxSize[Y]]].flags & BLF_CONNECTS_REDSTONE) ||
         // repeaters attach only at their ends, so test the direction they're at
-        (gBoxData[boxIndex - gBoxSize[Y]].origType == BLOCK_REDSTONE_REPEATER_OFF && !(gBoxData[boxIndex - gBoxSize[Y]].data & 0x1)) ||
-        (gBoxData[boxIndex - gBoxSize[Y]].origType == BLOCK_REDSTONE_REPEATER_ON && !(gBoxData[boxIndex - gBoxSize[Y]].data & 0x1))
+        (gBoxData.origType[boxIndex - gBoxSize[Y]] == BLOCK_REDSTONE_REPEATER_OFF && !(gBoxData.data[boxIndex - gBoxSize[Y]] & 0x1)) ||
+        (gBoxData.origType[boxIndex - gBoxSize[Y]] == BLOCK_REDSTONE_REPEATER_ON && !(gBoxData.data[boxIndex - gBoxSize[Y]] & 0x1))
         )
     {
-        gBoxData[boxIndex].data |= (FLAT_FACE_LO_Z << 4);
+        gBoxData.data[boxIndex] |= (FLAT_FACE_LO_Z << 4);
     }
 
     // finally finally, if ONLY waterlogged bit is set, which means there are no other connections, unset it and make this one a cross.
     // this is a 1.16 20w21a addition, see https://minecraft.wiki/w/Java_Edition_20w21a
-    //if (isCross && (gBoxData[boxIndex].data & ((FLAT_FACE_HI_X | FLAT_FACE_HI_Z | FLAT_FACE_LO_X | FLAT_FACE_LO_Z) << 4)) == 0x0) {
-    //    gBoxData[boxIndex].data |= (FLAT_FACE_HI_X|FLAT_FACE_HI_Z|FLAT_FACE_LO_X|FLAT_FACE_LO_Z) << 4;
+    //if (isCross && (gBoxData.data[boxIndex] & ((FLAT_FACE_HI_X | FLAT_FACE_HI_Z | FLAT_FACE_LO_X | FLAT_FACE_LO_Z) << 4)) == 0x0) {
+    //    gBoxData.data[boxIndex] |= (FLAT_FACE_HI_X|FLAT_FACE_HI_Z|FLAT_FACE_LO_X|FLAT_FACE_LO_Z) << 4;
     //}
 }
 
@@ -3676,7 +4313,7 @@ static int computeFlatFlags(int boxIndex)
 {
     // for this box's contents, mark the neighbor(s) that should receive
     // its flatness
-    switch (gBoxData[boxIndex].type)
+    switch (gBoxData.type[boxIndex])
     {
         // the block below this one, if solid, gets marked
     case BLOCK_STONE_PRESSURE_PLATE:						// computeFlatFlags
@@ -3734,22 +4371,22 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_PINK_PETALS:
     case BLOCK_TORCHFLOWER_CROP:
         //case BLOCK_CHAIN:   // questionable: should a chain (offset to the edge!) really be flattened onto the neighbor below?
-        gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+        gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
         break;
 
     case BLOCK_MANGROVE_PROPAGULE:
         //case BLOCK_CHAIN:   // questionable: should a chain (offset to the edge!) really be flattened onto the neighbor below?
         // If mangrove propagule is hanging, just ignore it (can't really used textures, and hard to see, anyway)
-        if ((gBoxData[boxIndex].data & 0x7) == 0x0)
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+        if ((gBoxData.data[boxIndex] & 0x7) == 0x0)
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
         break;
 
         // easy ones: flattops
     case BLOCK_RAIL:						// computeFlatFlags
-        if (gBoxData[boxIndex].data >= 6)
+        if (gBoxData.data[boxIndex] >= 6)
         {
             // curved rail bit, it's always just flat
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             break;
         }
         // NOTE: if curve test failed, needed only for basic rails, continue on through tilted track tests
@@ -3759,47 +4396,47 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_ACTIVATOR_RAIL:
         // only pay attention to sloped rails, as these mark sides;
         // remove top bit, as that's whether it's powered
-        switch (gBoxData[boxIndex].data & 0x7)
+        switch (gBoxData.data[boxIndex] & 0x7)
         {
         case 2: // east, +X
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 3:
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         case 4:
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 5:
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         default:
             // don't do anything, this rail is not sloped; continue on down to mark top face
             break;
         }
-        gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+        gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
         break;
 
     case BLOCK_TORCH:						// computeFlatFlags
     case BLOCK_REDSTONE_TORCH_OFF:
     case BLOCK_REDSTONE_TORCH_ON:
     case BLOCK_SOUL_TORCH:
-        switch (gBoxData[boxIndex].data)
+        switch (gBoxData.data[boxIndex])
         {
         case 1: // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         case 2:
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 3:
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 4:
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 5:
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             break;
         default:
             // don't do anything, this torch is not touching a side
@@ -3826,19 +4463,19 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_GREEN_WALL_BANNER:
     case BLOCK_RED_WALL_BANNER:
     case BLOCK_BLACK_WALL_BANNER:
-        switch (gBoxData[boxIndex].data & 0x7)
+        switch (gBoxData.data[boxIndex] & 0x7)
         {
         case 2: // north, -Z
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 3: // south, +Z
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 4: // west, -X
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 5: // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         default:
             assert(0);
@@ -3847,28 +4484,28 @@ static int computeFlatFlags(int boxIndex)
         break;
 
     case BLOCK_LEVER:						// computeFlatFlags
-        switch (gBoxData[boxIndex].data & 0x7)
+        switch (gBoxData.data[boxIndex] & 0x7)
         {
         case 1: // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         case 2:
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 3:
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 4:
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 5:
         case 6:
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             break;
             // added in 1.3:
         case 7:	// pointing south
         case 0:	// pointing east
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
             break;
         default:
             assert(0);
@@ -3888,25 +4525,25 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_MANGROVE_BUTTON:
     case BLOCK_CHERRY_BUTTON:
     case BLOCK_BAMBOO_BUTTON:
-        switch (gBoxData[boxIndex].data & 0x7)
+        switch (gBoxData.data[boxIndex] & 0x7)
         {
         case 0: // at top of block, +Y
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
             break;
         case 5: // at bottom of block, -Y
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             break;
         case 4: // north, -Z
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 3: // south, +Z
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 2: // west, -X
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 1: // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         default:
             assert(0);
@@ -3917,19 +4554,19 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_TRIPWIRE_HOOK:						// computeFlatFlags
         // 0x4 means "tripwire connected"
         // 0x8 means "tripwire tripped"
-        switch (gBoxData[boxIndex].data & 0x3)
+        switch (gBoxData.data[boxIndex] & 0x3)
         {
         case 0: // south, +Z
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 1: // west, -X
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 2: // north, -Z
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 3: // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         default:
             assert(0);
@@ -3949,22 +4586,22 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_MANGROVE_TRAPDOOR:
     case BLOCK_CHERRY_TRAPDOOR:
     case BLOCK_BAMBOO_TRAPDOOR:
-        if (gBoxData[boxIndex].data & 0x4)
+        if (gBoxData.data[boxIndex] & 0x4)
         {
             // trapdoor is open, so is against a wall
-            switch (gBoxData[boxIndex].data & 0x3)
+            switch (gBoxData.data[boxIndex] & 0x3)
             {
             case 0: // north, -Z
-                gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+                gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
                 break;
             case 1: // south, +Z
-                gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+                gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
                 break;
             case 2: // west, -X
-                gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+                gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
                 break;
             case 3: // east, +X
-                gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+                gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
                 break;
             default:
                 assert(0);
@@ -3975,7 +4612,7 @@ static int computeFlatFlags(int boxIndex)
         {
             // Not open, so connected to floor (if any!) or "roof". Very special case:
             // attached to roof?
-            if (gBoxData[boxIndex].data & 0x8)
+            if (gBoxData.data[boxIndex] & 0x8)
             {
                 // Roof: don't need to do anything, should show up as full block.'
                 return 0;
@@ -3985,19 +4622,19 @@ static int computeFlatFlags(int boxIndex)
                 // On floor
                 // if there's nothing below trapdoor, block below is set to trapdoor, if
                 // Y is not too low
-                if (gBoxData[boxIndex - 1].origType == BLOCK_AIR)
+                if (gBoxData.origType[boxIndex - 1] == BLOCK_AIR)
                 {
                     IPoint loc;
                     boxIndexToLoc(loc, boxIndex);
                     if (loc[Y] > gSolidBox.min[Y])
                     {
-                        gBoxData[boxIndex - 1].origType = gBoxData[boxIndex].type;
+                        gBoxData.origType[boxIndex - 1] = gBoxData.type[boxIndex];
                     }
                 }
                 else
                 {
                     // mark the solid box, as usual
-                    gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+                    gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
                 }
             }
         }
@@ -4006,20 +4643,20 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_VINES:						// computeFlatFlags
         // first, if this block was not originally a vine, then forget it - this block was generated
         // by a vine spreading to its neighbor - see below.
-        if (gBoxData[boxIndex].origType != BLOCK_VINES)
+        if (gBoxData.origType[boxIndex] != BLOCK_VINES)
         {
             return 0;
         }
         // the rules: vines can cover up to four sides, or if no bits set, top of overhanging block.
         // The overhanging block stops side faces from appearing, essentially.
         // If billboarding is on and we're not printing, then we've already exported everything else of the vine, so remove it.
-        if ((gBoxData[boxIndex].data == 0) || (gBoxData[boxIndex].data == BIT_16) || (gExportBillboards && !gModel.print3D))
+        if ((gBoxData.data[boxIndex] == 0) || (gBoxData.data[boxIndex] == BIT_16) || (gExportBillboards && !gModel.print3D))
         {
             // top face, flatten to bottom of block above, if the neighbor exists. If it doesn't,
             // something odd is going on (this shouldn't happen).
-            if (gBoxData[boxIndex + 1].origType != BLOCK_AIR)
+            if (gBoxData.origType[boxIndex + 1] != BLOCK_AIR)
             {
-                gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+                gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
             }
             else
             {
@@ -4033,11 +4670,11 @@ static int computeFlatFlags(int boxIndex)
         else
         {
             // if a block is above a vine, there's always a below
-            if (gBoxData[boxIndex + 1].origType != BLOCK_AIR)
+            if (gBoxData.origType[boxIndex + 1] != BLOCK_AIR)
             {
-                gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+                gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
             }
-            if (gBoxData[boxIndex].data & 0x1)
+            if (gBoxData.data[boxIndex] & 0x1)
             {
                 // south face (+Z)
                 // is there a neighbor large enough to composite a vine onto?
@@ -4046,73 +4683,73 @@ static int computeFlatFlags(int boxIndex)
                 // TODO shift the "air vines" inwards, as shown in the "else" statement. However, this code here is not
                 // really the place to do it - vines could extend past the border, and if "seal tunnels" etc. is done things go
                 // very wrong.
-                if (gBlockDefinitions[gBoxData[boxIndex + gBoxSize[Y]].type].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
-                    !TYPE_IS_LEAF(gBoxData[boxIndex + gBoxSize[Y]].type))
+                if (gBlockDefinitions[gBoxData.type[boxIndex + gBoxSize[Y]]].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
+                    !TYPE_IS_LEAF(gBoxData.type[boxIndex + gBoxSize[Y]]))
                 {
                     // neighbor's a whole block, so shove the vine onto it
-                    gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+                    gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
                 }
                 else
                 {
                     // force the block to become a vine - could be weird if there was something else here.
                     // This is not quite legal, first of all because we might set a location to solid that's outside the border
-                    //gBoxData[boxIndex+gBoxSize[Y]].type = BLOCK_VINES;
-                    //gBoxData[boxIndex+gBoxSize[Y]].data = 0x0;
+                    //gBoxData.type[boxIndex+gBoxSize[Y]] = BLOCK_VINES;
+                    //gBoxData.data[boxIndex+gBoxSize[Y]] = 0x0;
                     return 0;
                 }
             }
-            if (gBoxData[boxIndex].data & 0x2)
+            if (gBoxData.data[boxIndex] & 0x2)
             {
                 // west face (-X)
                 // is there a neighbor?
-                if (gBlockDefinitions[gBoxData[boxIndex - gBoxSizeYZ].type].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
-                    !TYPE_IS_LEAF(gBoxData[boxIndex - gBoxSizeYZ].type))
+                if (gBlockDefinitions[gBoxData.type[boxIndex - gBoxSizeYZ]].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
+                    !TYPE_IS_LEAF(gBoxData.type[boxIndex - gBoxSizeYZ]))
                 {
                     // neighbor's a whole block, so shove the vine onto it
-                    gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+                    gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
                 }
                 else
                 {
                     // force the block to become a vine - could be weird if there was something else here.
-                    //gBoxData[boxIndex-gBoxSizeYZ].type = BLOCK_VINES;
-                    //gBoxData[boxIndex-gBoxSizeYZ].data = 0x0;
+                    //gBoxData.type[boxIndex-gBoxSizeYZ] = BLOCK_VINES;
+                    //gBoxData.data[boxIndex-gBoxSizeYZ] = 0x0;
                     return 0;
                 }
             }
-            if (gBoxData[boxIndex].data & 0x4)
+            if (gBoxData.data[boxIndex] & 0x4)
             {
                 // north face (-Z)
                 // is there a neighbor?
-                if (gBlockDefinitions[gBoxData[boxIndex - gBoxSize[Y]].type].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
-                    !TYPE_IS_LEAF(gBoxData[boxIndex - gBoxSize[Y]].type))
+                if (gBlockDefinitions[gBoxData.type[boxIndex - gBoxSize[Y]]].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
+                    !TYPE_IS_LEAF(gBoxData.type[boxIndex - gBoxSize[Y]]))
                 {
                     // neighbor's a real-live whole block, so shove the vine onto it
-                    gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+                    gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
                 }
                 else
                 {
                     // TODO for rendering export, we really want vines to always be offset billboards, I believe
                     // force the block to become a vine - could be weird if there was something else here.
-                    //gBoxData[boxIndex-gBoxSize[Y]].type = BLOCK_VINES;
-                    //gBoxData[boxIndex-gBoxSize[Y]].data = 0x0;
+                    //gBoxData.type[boxIndex-gBoxSize[Y]] = BLOCK_VINES;
+                    //gBoxData.data[boxIndex-gBoxSize[Y]] = 0x0;
                     return 0;
                 }
             }
-            if (gBoxData[boxIndex].data & 0x8)
+            if (gBoxData.data[boxIndex] & 0x8)
             {
                 // east face (+X)
                 // is there a neighbor?
-                if (gBlockDefinitions[gBoxData[boxIndex + gBoxSizeYZ].type].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
-                    !TYPE_IS_LEAF(gBoxData[boxIndex + gBoxSizeYZ].type))
+                if (gBlockDefinitions[gBoxData.type[boxIndex + gBoxSizeYZ]].flags & (BLF_WHOLE | BLF_ALMOST_WHOLE | BLF_STAIRS | BLF_HALF) &&
+                    !TYPE_IS_LEAF(gBoxData.type[boxIndex + gBoxSizeYZ]))
                 {
                     // neighbor's a whole block, so shove the vine onto it
-                    gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+                    gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
                 }
                 else
                 {
                     // force the block to become a vine - could be weird if there was something else here.
-                    //gBoxData[boxIndex+gBoxSizeYZ].type = BLOCK_VINES;
-                    //gBoxData[boxIndex+gBoxSizeYZ].data = 0x0;
+                    //gBoxData.type[boxIndex+gBoxSizeYZ] = BLOCK_VINES;
+                    //gBoxData.data[boxIndex+gBoxSizeYZ] = 0x0;
                     return 0;
                 }
             }
@@ -4120,25 +4757,25 @@ static int computeFlatFlags(int boxIndex)
         break;
 
     case BLOCK_AMETHYST_BUD:
-        switch ((gBoxData[boxIndex].data & 0x1c) >> 2)
+        switch ((gBoxData.data[boxIndex] & 0x1c) >> 2)
         {
         case 0: // pointing down
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
             break;
         case 1: // pointing up
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             break;
         case 2: // pointing north
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
             break;
         case 3: // pointing south
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
             break;
         case 4: // pointing west
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
             break;
         case 5: // pointing east
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
             break;
         default:
             assert(0);
@@ -4149,29 +4786,29 @@ static int computeFlatFlags(int boxIndex)
     case BLOCK_GLOW_LICHEN:
     case BLOCK_SCULK_VEIN:
         // (south ? 1 : 0) | (west ? 2 : 0) | (north ? 4 : 0) | (east ? 8 : 0) | (down ? BIT_16 : 0) | (up ? BIT_32 : 0);
-        if (gBoxData[boxIndex].data & 0x01) {
+        if (gBoxData.data[boxIndex] & 0x01) {
             // south, +Z
-            gBoxData[boxIndex - gBoxSize[Y]].flatFlags |= FLAT_FACE_HI_Z;
+            gBoxData.flatFlags[boxIndex - gBoxSize[Y]] |= FLAT_FACE_HI_Z;
         }
-        if (gBoxData[boxIndex].data & 0x02) {
+        if (gBoxData.data[boxIndex] & 0x02) {
             // west, -X
-            gBoxData[boxIndex + gBoxSizeYZ].flatFlags |= FLAT_FACE_LO_X;
+            gBoxData.flatFlags[boxIndex + gBoxSizeYZ] |= FLAT_FACE_LO_X;
         }
-        if (gBoxData[boxIndex].data & 0x04) {
+        if (gBoxData.data[boxIndex] & 0x04) {
             // north, -Z
-            gBoxData[boxIndex + gBoxSize[Y]].flatFlags |= FLAT_FACE_LO_Z;
+            gBoxData.flatFlags[boxIndex + gBoxSize[Y]] |= FLAT_FACE_LO_Z;
         }
-        if (gBoxData[boxIndex].data & 0x08) {
+        if (gBoxData.data[boxIndex] & 0x08) {
             // east, +X
-            gBoxData[boxIndex - gBoxSizeYZ].flatFlags |= FLAT_FACE_HI_X;
+            gBoxData.flatFlags[boxIndex - gBoxSizeYZ] |= FLAT_FACE_HI_X;
         }
-        if (gBoxData[boxIndex].data & 0x10) {
+        if (gBoxData.data[boxIndex] & 0x10) {
             // (hanging) down
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
         }
-        if (gBoxData[boxIndex].data & 0x20) {
+        if (gBoxData.data[boxIndex] & 0x20) {
             // up
-            gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
         }
         break;
 
@@ -4180,28 +4817,28 @@ static int computeFlatFlags(int boxIndex)
         break;
 
     case BLOCK_WEEPING_VINES:						// computeFlatFlags
-        if ((gBoxData[boxIndex].data & 0xf) == 0x1) {
+        if ((gBoxData.data[boxIndex] & 0xf) == 0x1) {
             // twisting vines go up
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_ABOVE;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_ABOVE;
         }
         else {
             // other vines, roots, etc. hang
-            gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+            gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
         }
         break;
 
     case BLOCK_SPORE_BLOSSOM:						// computeFlatFlags
-        gBoxData[boxIndex + 1].flatFlags |= FLAT_FACE_BELOW;
+        gBoxData.flatFlags[boxIndex + 1] |= FLAT_FACE_BELOW;
         break;
 
     case BLOCK_PITCHER_CROP:						// computeFlatFlags
         // flatten only if age is 0
         {
-            int age = (gBoxData[boxIndex].data & 0x7);
+            int age = (gBoxData.data[boxIndex] & 0x7);
 
             // if age > 1, there's a flower. Get the swatch to use, then output it
             if (age == 0) {
-                gBoxData[boxIndex - 1].flatFlags |= FLAT_FACE_ABOVE;
+                gBoxData.flatFlags[boxIndex - 1] |= FLAT_FACE_ABOVE;
             }
             else {
                 return 0;
@@ -4210,7 +4847,7 @@ static int computeFlatFlags(int boxIndex)
         break;
 
     default:
-        // something needs to be added to the cases above! The gBoxData[boxIndex].type is not in the switch list
+        // something needs to be added to the cases above! The gBoxData.type[boxIndex] is not in the switch list
         assert(0);
         return 0;
 
@@ -4528,7 +5165,7 @@ static bool fenceNeighbor(int type, int boxIndex, int blockSide)
         return false;
     }
     int neighborIndex = boxIndex + gFaceOffset[blockSide];
-    int neighborType = gBoxData[neighborIndex].origType;
+    int neighborType = gBoxData.origType[neighborIndex];
     // is neighbor of same type? Easy out
     if (type == neighborType)
         return true;
@@ -4541,7 +5178,7 @@ static bool fenceNeighbor(int type, int boxIndex, int blockSide)
     if (gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) {
         // fence gate only connects if it is oriented properly
         int bitSet = ((blockSide == DIRECTION_BLOCK_SIDE_LO_Z) || (blockSide == DIRECTION_BLOCK_SIDE_HI_Z)) ? 0x1 : 0x0;
-        if ((gBoxData[neighborIndex].data & 0x1) == bitSet)
+        if ((gBoxData.data[neighborIndex] & 0x1) == bitSet)
             return true;
     }
 
@@ -4553,6 +5190,36 @@ static bool fenceNeighbor(int type, int boxIndex, int blockSide)
     return false;
 }
 
+// Output a billboard or true geometry for a cell. When exporting in tiles, the cells around the tile are processed
+// too, as what's done to them can affect the tile's blocks, but anything they output is marked as deleted.
+// Returns the same as saveBillboardOrGeometry().
+static int saveCellBillboardOrGeometry(int boxIndex, int type)
+{
+    int x = boxIndex / gBoxSizeYZ;
+    int z = (boxIndex % gBoxSizeYZ) / gBoxSize[Y];
+    if (!gModel.exportInTiles ||
+        ((x >= gTileBox.min[X]) && (x <= gTileBox.max[X]) && (z >= gTileBox.min[Z]) && (z <= gTileBox.max[Z])))
+    {
+        return saveBillboardOrGeometry(boxIndex, type);
+    }
+
+    int faceCount = gModel.faceCount;
+    int billboardCount = gModel.billboardCount;
+    IBox billboardBounds = gModel.billboardBounds;
+    int minorBlockCount = gMinorBlockCount;
+
+    int retVal = saveBillboardOrGeometry(boxIndex, type);
+
+    for (int i = faceCount; i < gModel.faceCount; i++)
+    {
+        gModel.faceList[i]->normalIndex = HAS_BEEN_MERGED_SO_IGNORE_IT;
+    }
+    gModel.billboardCount = billboardCount;
+    gModel.billboardBounds = billboardBounds;
+    gMinorBlockCount = minorBlockCount;
+    return retVal;
+}
+
 // return 1 if block processed as a billboard or true geometry
 static int saveBillboardOrGeometry(int boxIndex, int type)
 {
@@ -4580,7 +5247,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
     float shiftX, shiftZ;  // cppcheck-suppress 398
     float x, z;
 
-    dataVal = gBoxData[boxIndex].data;
+    dataVal = gBoxData.data[boxIndex];
 
     // Add to minor count if this object has some heft. This is approximate, but better than nothing.
     // This count can be slightly off if we return 0, meaning the block wasn't a billboard or geometry after all
@@ -4874,18 +5541,18 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             }
             else {
                 matchType = (type == BLOCK_PUMPKIN_STEM) ? BLOCK_PUMPKIN : BLOCK_MELON;
-                if (gBoxData[boxIndex - gBoxSizeYZ].origType == matchType) {
+                if (gBoxData.origType[boxIndex - gBoxSizeYZ] == matchType) {
                     // to west
                     angle = 0;
                 }
-                else if (gBoxData[boxIndex + gBoxSizeYZ].origType == matchType) {
+                else if (gBoxData.origType[boxIndex + gBoxSizeYZ] == matchType) {
                     // east
                     angle = 180;
                 }
-                else if (gBoxData[boxIndex - gBoxSize[Y]].origType == matchType) {
+                else if (gBoxData.origType[boxIndex - gBoxSize[Y]] == matchType) {
                     angle = 90;
                 }
-                else if (gBoxData[boxIndex + gBoxSize[Y]].origType == matchType) {
+                else if (gBoxData.origType[boxIndex + gBoxSize[Y]] == matchType) {
                     angle = 270;
                 }
                 else
@@ -4989,7 +5656,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             }
 
             // it's sloping, so check if object below it is not air
-            typeBelow = gBoxData[boxIndex - 1].origType;
+            typeBelow = gBoxData.origType[boxIndex - 1];
             if (typeBelow == BLOCK_AIR)
             {
                 // air below, which means this rail's at the bottom level, descending.
@@ -5017,11 +5684,11 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                     assert(0);
                 }
                 boxIndexBelow = boxIndex + gFaceOffset[transNeighbor];
-                typeBelow = gBoxData[boxIndex + gFaceOffset[transNeighbor]].origType;
+                typeBelow = gBoxData.origType[boxIndex + gFaceOffset[transNeighbor]];
                 // make sure the block to the side is something valid for a rail to be on
                 if (gBlockDefinitions[typeBelow].flags & BLF_WHOLE)
                 {
-                    dataValBelow = gBoxData[boxIndexBelow].data;
+                    dataValBelow = gBoxData.data[boxIndexBelow];
                 }
                 else
                 {
@@ -5035,7 +5702,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             else
             {
                 boxIndexBelow = boxIndex - 1;
-                dataValBelow = gBoxData[boxIndexBelow].data;
+                dataValBelow = gBoxData.data[boxIndexBelow];
             }
 
             // brute force the four cases: always draw bottom of block as the thing, use top of block for decal,
@@ -5279,7 +5946,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         // brace here, so that we can declare local variables
         {
             // if there's *anything* above the wall, put the post, at least temporarily
-            if (gBoxData[boxIndex + 1].origType != 0)
+            if (gBoxData.origType[boxIndex + 1] != 0)
             {
                 hasPost = 1;
                 if (gMcVersion >= 16) {
@@ -5290,13 +5957,13 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                     // So we leave hasPost == 1.
                     // Most partial blocks above will create a post but not cover things
 
-                    neighborType = gBoxData[boxIndex + 1].origType;
+                    neighborType = gBoxData.origType[boxIndex + 1];
                     // Some things actually have no effect.
                     // If the block above is a slab or stairs that's "above" (upside down), it doesn't affect the wall at all;
                     // pointed dripstone doesn't, either. Nor does a hopper pointing any way but down.
-                    if (((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && (gBoxData[boxIndex + 1].data & 0x4)) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_HALF) && (gBoxData[boxIndex + 1].data & 0x8)) ||
-                        ((neighborType == BLOCK_HOPPER) && (gBoxData[boxIndex + 1].data & 0x7)) ||  // pointing down is 0, other directions are values > 0
+                    if (((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && (gBoxData.data[boxIndex + 1] & 0x4)) ||
+                        ((gBlockDefinitions[neighborType].flags & BLF_HALF) && (gBoxData.data[boxIndex + 1] & 0x8)) ||
+                        ((neighborType == BLOCK_HOPPER) && (gBoxData.data[boxIndex + 1] & 0x7)) ||  // pointing down is 0, other directions are values > 0
                         (neighborType >= BLOCK_WATER && neighborType <= BLOCK_STATIONARY_LAVA) ||
                         (neighborType == BLOCK_POINTED_DRIPSTONE)
                         ) {
@@ -5325,7 +5992,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                         (neighborType == BLOCK_BAMBOO_PRESSURE_PLATE) ||
                         (neighborType == BLOCK_STANDING_BANNER) ||
                         (neighborType >= BLOCK_ORANGE_BANNER && neighborType <= BLOCK_BLACK_BANNER) ||
-                        ((neighborType == BLOCK_HOPPER) && !(gBoxData[boxIndex + 1].data & 0x7)) ||  // pointing down is 0, which makes a post but no cover
+                        ((neighborType == BLOCK_HOPPER) && !(gBoxData.data[boxIndex + 1] & 0x7)) ||  // pointing down is 0, which makes a post but no cover
                         (neighborType == BLOCK_LADDER) ||
                         (neighborType == BLOCK_VINES) ||
                         (neighborType == BLOCK_CHAIN) ||
@@ -5360,35 +6027,35 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             float xHighWall = 0.0f;
             float zLowWall = 0.0f;
             float zHighWall = 0.0f;
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
             if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                 (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].data & 0x3)) == 0) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].data & 0x1)) == 0))
+                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] & 0x3)) == 0) ||
+                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] & 0x1)) == 0))
             {
                 xLowWall = 1 + covered;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
             if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                 (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].data & 0x3)) == 1) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].data & 0x1)) == 0))
+                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] & 0x3)) == 1) ||
+                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] & 0x1)) == 0))
             {
                 xHighWall = 1 + covered;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
             if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                 (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].data & 0x3)) == 2) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].data & 0x1)) == 1))
+                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] & 0x3)) == 2) ||
+                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] & 0x1)) == 1))
             {
                 zLowWall = 1 + covered;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
             if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                 (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].data & 0x3)) == 3) ||
-                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].data & 0x1)) == 1))
+                ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] & 0x3)) == 3) ||
+                ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] & 0x1)) == 1))
             {
                 zHighWall = 1 + covered;
             }
@@ -5397,17 +6064,17 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             // Rules: iron/panes/walls/fences and fence gates directly above
             if (!covered) {
                 bool upper_matches = true;
-                neighborType = gBoxData[boxIndex + 1].origType; // above
+                neighborType = gBoxData.origType[boxIndex + 1]; // above
 
                 // OK, is it a wall above?
                 if (neighborType == BLOCK_COBBLESTONE_WALL) {
                     // yes, so check all connections (similar to earlier code) to see how these walls *above* are connected.
                     // If they connect exactly the same, then there's no post.
-                    neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X] + 1].origType;
+                    neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X] + 1];
                     if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                         (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].data & 0x3)) == 0) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].data & 0x1)) == 0))
+                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] & 0x3)) == 0) ||
+                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] & 0x1)) == 0))
                     {
                         if (xLowWall) {
                             xLowWall += 1.0f;   // now covered after all
@@ -5422,11 +6089,11 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                         }
                     }
 
-                    neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X] + 1].origType;
+                    neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X] + 1];
                     if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                         (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].data & 0x3)) == 1) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].data & 0x1)) == 0))
+                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] & 0x3)) == 1) ||
+                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] & 0x1)) == 0))
                     {
                         if (xHighWall) {
                             xHighWall += 1.0f;   // now covered after all
@@ -5440,11 +6107,11 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                             upper_matches = false;
                         }
                     }
-                    neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z] + 1].origType;
+                    neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z] + 1];
                     if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                         (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].data & 0x3)) == 2) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].data & 0x1)) == 1))
+                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] & 0x3)) == 2) ||
+                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] & 0x1)) == 1))
                     {
                         if (zLowWall) {
                             zLowWall += 1.0f;   // now covered after all
@@ -5458,11 +6125,11 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                             upper_matches = false;
                         }
                     }
-                    neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z] + 1].origType;
+                    neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z] + 1];
                     if ((neighborType == BLOCK_COBBLESTONE_WALL) || (gBlockDefinitions[neighborType].flags & BLF_FENCE_NEIGHBOR) ||
                         (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].data & 0x3)) == 3) ||
-                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].data & 0x1)) == 1))
+                        ((gBlockDefinitions[neighborType].flags & BLF_STAIRS) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] & 0x3)) == 3) ||
+                        ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && ((gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] & 0x1)) == 1))
                     {
                         if (zHighWall) {
                             zHighWall += 1.0f;   // now covered after all
@@ -5480,7 +6147,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 else if ((neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || (neighborType == BLOCK_IRON_BARS)) {
                     if (gIs13orNewer && neighborType != BLOCK_STAINED_GLASS_PANE) {
                         // easy and dependable - neighbors marked by bits 0-3
-                        dataVal = gBoxData[boxIndex + 1].data;
+                        dataVal = gBoxData.data[boxIndex + 1];
                         if (dataVal & 0x2)
                         {
                             if (xLowWall) {
@@ -5541,7 +6208,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                     else {
                         // which neighboring blocks have something that attaches to a glass pane? Things that attach:
                         // whole blocks, glass panes, iron bars, walls
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
                         if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                             (neighborType == BLOCK_COBBLESTONE_WALL) ||
                             (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -5559,7 +6226,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                             }
                         }
 
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X] + 1].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X] + 1];
                         if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                             (neighborType == BLOCK_COBBLESTONE_WALL) ||
                             (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -5576,7 +6243,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                                 upper_matches = false;
                             }
                         }
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z] + 1].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z] + 1];
                         if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                             (neighborType == BLOCK_COBBLESTONE_WALL) ||
                             (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -5593,7 +6260,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                                 upper_matches = false;
                             }
                         }
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z] + 1].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z] + 1];
                         if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                             (neighborType == BLOCK_COBBLESTONE_WALL) ||
                             (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -5671,9 +6338,9 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                         }
                     }
                 }
-                else if ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && !(gBoxData[boxIndex + 1].data & 0x4)) {
+                else if ((gBlockDefinitions[neighborType].flags & BLF_FENCE_GATE) && !(gBoxData.data[boxIndex + 1] & 0x4)) {
                     // if fence gate is overhead and not open (weirdly, when the gate closes, the wall below is covered), it covers EW or NS, odd or even
-                    if (gBoxData[boxIndex + 1].data & 0x1) {
+                    if (gBoxData.data[boxIndex + 1] & 0x1) {
                         if (zLowWall) {
                             zLowWall += 1.0f;   // now covered after all
                         }
@@ -5751,28 +6418,28 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             if (xLowWall > 0.0f) {
                 // this wall connects to the neighboring block, so output the wall piece
                 // if the neighbor is transparent, or a different type, or individual blocks are made, we'll output the face facing the neighbor (important if we connect to a fence, for example)
-                neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+                neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
                 transNeighbor = (gBlockDefinitions[neighborType].flags & BLF_TRANSPARENT) || individualBlocks || (type != neighborType) || (xLowWall == 2.0f);
                 saveBoxTileGeometry(boxIndex, type, dataVal, swatchLoc, firstFace, (gModel.print3D ? 0x0 : DIR_HI_X_BIT) | (transNeighbor ? 0x0 : DIR_LO_X_BIT), 0, 8 - hasPost * 4, 0, 12 + xLowWall * 2, 5, 11);
                 firstFace = 0;
             }
             if (xHighWall > 0.0f) {
                 // this wall connects to the neighboring block, so output the wall piece
-                neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+                neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
                 transNeighbor = (gBlockDefinitions[neighborType].flags & BLF_TRANSPARENT) || individualBlocks || (type != neighborType) || (xHighWall == 2.0f);
                 saveBoxTileGeometry(boxIndex, type, dataVal, swatchLoc, firstFace, (gModel.print3D ? 0x0 : DIR_LO_X_BIT) | (transNeighbor ? 0x0 : DIR_HI_X_BIT), 8 + hasPost * 4, 16, 0, 12 + xHighWall * 2, 5, 11);
                 firstFace = 0;
             }
             if (zLowWall > 0.0f) {
                 // this wall connects to the neighboring block, so output the wall piece
-                neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+                neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
                 transNeighbor = (gBlockDefinitions[neighborType].flags & BLF_TRANSPARENT) || individualBlocks || (type != neighborType) || (zLowWall == 2.0f);
                 saveBoxTileGeometry(boxIndex, type, dataVal, swatchLoc, firstFace, (gModel.print3D ? 0x0 : DIR_HI_Z_BIT) | (transNeighbor ? 0x0 : DIR_LO_Z_BIT), 5, 11, 0, 12 + zLowWall * 2, 0, 8 - hasPost * 4);
                 firstFace = 0;
             }
             if (zHighWall > 0.0f) {
                 // this wall connects to the neighboring block, so output the wall piece
-                neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+                neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
                 transNeighbor = (gBlockDefinitions[neighborType].flags & BLF_TRANSPARENT) || individualBlocks || (type != neighborType) || (zHighWall == 2.0f);
                 saveBoxTileGeometry(boxIndex, type, dataVal, swatchLoc, firstFace, (gModel.print3D ? 0x0 : DIR_LO_Z_BIT) | (transNeighbor ? 0x0 : DIR_HI_Z_BIT), 5, 11, 0, 12 + zHighWall * 2, 8 + hasPost * 4, 16);
                 firstFace = 0;	// not necessary, but for safety in case new code is added below  // cppcheck-suppress 563
@@ -5790,7 +6457,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & BIT_32) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_TOP]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_TOP]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType)) ? 16.0f : 13.0f;
         //tricky: when extended, cap it only if 3D printing and the neighbor is NOT the same type; i.e. we want caps when it's a flower or end stone.
@@ -5803,7 +6470,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & BIT_16) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_BOTTOM]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_BOTTOM]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType) || (BLOCK_END_STONE == neighborType)) ? 0.0f : 3.0f;
         saveBoxGeometry(boxIndex, type, dataVal, 0, (((!gModel.print3D && (newHeight == 0)) || (type == neighborType)) ? DIR_BOTTOM_BIT : 0x0) | DIR_TOP_BIT, 4, 12, newHeight, 4, 4, 12);
@@ -5832,7 +6499,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & 0x2) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType)) ? 0.0f : 3.0f;
         // four cases:
@@ -5861,7 +6528,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & 0x8) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType)) ? 16.0f : 13.0f;
         if (newHeight == 13.0f) {
@@ -5885,7 +6552,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & 0x4) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType)) ? 0.0f : 3.0f;
         // four cases:
@@ -5914,7 +6581,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             neighborType = (dataVal & 0x1) ? type : 0;
         }
         else {
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
         }
         newHeight = ((type == neighborType) || (BLOCK_CHORUS_FLOWER == neighborType)) ? 16.0f : 13.0f;
         if (newHeight == 13.0f) {
@@ -5952,7 +6619,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
     case BLOCK_BAMBOO_PRESSURE_PLATE:
         // if printing and the location below the plate is empty, then don't make plate (it'll be too thin)
         if (gModel.print3D &&
-            (gBoxData[boxIndex - 1].origType == BLOCK_AIR))
+            (gBoxData.origType[boxIndex - 1] == BLOCK_AIR))
         {
             gMinorBlockCount--;
             return 0;
@@ -5972,7 +6639,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
     case BLOCK_CARPET:						// saveBillboardOrGeometry
         // if printing and the location below the carpet is empty, then don't make carpet (it'll be too thin)
         if (gModel.print3D &&
-            (gBoxData[boxIndex - 1].origType == BLOCK_AIR))
+            (gBoxData.origType[boxIndex - 1] == BLOCK_AIR))
         {
             gMinorBlockCount--;
             return 0;
@@ -6158,10 +6825,10 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                     if (northSouth) {
                         // Goes north-south.
                         // Check north neighbor.
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
                         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS) {
                             // northern neighbor is stairs
-                            neighborData = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].data;
+                            neighborData = gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
                             if (neighborData == dataVal) {
                                 // the data values match - but, do the stair masks match?
                                 if (getStairMask(boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z], neighborData) == origStepMask) {
@@ -6171,10 +6838,10 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                             }
                         }
                         // Check south neighbor.
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
                         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS) {
                             // southern neighbor is stairs
-                            neighborData = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].data;
+                            neighborData = gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
                             if (neighborData == dataVal) {
                                 // the data values match - but, do the stair masks match?
                                 if (getStairMask(boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z], neighborData) == origStepMask) {
@@ -6187,10 +6854,10 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                     else {
                         // Goes east-west
                         // Check west neighbor.
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
                         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS) {
                             // western neighbor is stairs
-                            neighborData = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].data;
+                            neighborData = gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
                             if (neighborData == dataVal) {
                                 // the data values match - but, do the stair masks match?
                                 if (getStairMask(boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X], neighborData) == origStepMask) {
@@ -6200,10 +6867,10 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                             }
                         }
                         // Check east neighbor.
-                        neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+                        neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
                         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS) {
                             // eastern neighbor is stairs
-                            neighborData = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].data;
+                            neighborData = gBoxData.data[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
                             if (neighborData == dataVal) {
                                 // the data values match - but, do the stair masks match?
                                 if (getStairMask(boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X], neighborData) == origStepMask) {
@@ -6843,7 +7510,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         //{
         //	// if printing, and door is down, check if there's air below.
         //	// if so, don't print it! Too thin.
-        //	if ( gBoxData[boxIndex-1].type == BLOCK_AIR)
+        //	if ( gBoxData.type[boxIndex-1] == BLOCK_AIR)
         //		return 0;
         //}
         gUsingTransform = 1;
@@ -7127,13 +7794,13 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             // get bottom dataVal - if bottom of door is cut off, this will be 0 and door will be wrong
             // (who cares, it's half a door)
             topDataVal = dataVal;
-            bottomDataVal = gBoxData[boxIndex - 1].data;
+            bottomDataVal = gBoxData.data[boxIndex - 1];
         }
         else
         {
             // bottom of door - switch to that for sides
             swatchLoc = bottomSwatchLoc;
-            topDataVal = gBoxData[boxIndex + 1].data;
+            topDataVal = gBoxData.data[boxIndex + 1];
             bottomDataVal = dataVal;
         }
 
@@ -7212,7 +7879,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         // This should only happen if the snow is at the lowest level, which means that the object below would
         // not exist. In this case, we check "type" and not "origType", as origType may well exist due to reading it in.
         if (gModel.print3D &&
-            ((gBoxData[boxIndex - 1].origType == BLOCK_AIR) || (gBoxData[boxIndex - 1].type == BLOCK_AIR)))
+            ((gBoxData.origType[boxIndex - 1] == BLOCK_AIR) || (gBoxData.type[boxIndex - 1] == BLOCK_AIR)))
         {
             gMinorBlockCount--;
             return 0;
@@ -7288,7 +7955,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         if (gModel.print3D)
         {
             // if we're print, and there is something above this farmland, don't shift the farmland down (it would just make a gap)
-            if (gBoxData[boxIndex + 1].origType != BLOCK_AIR)
+            if (gBoxData.origType[boxIndex + 1] != BLOCK_AIR)
             {
                 gMinorBlockCount--;
                 return 0;
@@ -7418,11 +8085,11 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 if (dataVal & 0x1)
                 {
                     // open west/east
-                    shiftGate = (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType == BLOCK_COBBLESTONE_WALL) || (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType == BLOCK_COBBLESTONE_WALL);
+                    shiftGate = (gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] == BLOCK_COBBLESTONE_WALL) || (gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] == BLOCK_COBBLESTONE_WALL);
                 }
                 else {
                     // open north/south
-                    shiftGate = (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType == BLOCK_COBBLESTONE_WALL) || (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType == BLOCK_COBBLESTONE_WALL);
+                    shiftGate = (gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] == BLOCK_COBBLESTONE_WALL) || (gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] == BLOCK_COBBLESTONE_WALL);
                 }
             }
             if (shiftGate)
@@ -8067,9 +8734,9 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         individualBlocks = (gModel.options->exportFlags & EXPT_INDIVIDUAL_BLOCKS);
 
         faceMask = 0x0;
-        if ((gBoxData[boxIndex + 1].origType == BLOCK_CACTUS) && !individualBlocks)
+        if ((gBoxData.origType[boxIndex + 1] == BLOCK_CACTUS) && !individualBlocks)
             faceMask |= DIR_TOP_BIT;
-        if ((gBoxData[boxIndex - 1].origType == BLOCK_CACTUS) && !individualBlocks)
+        if ((gBoxData.origType[boxIndex - 1] == BLOCK_CACTUS) && !individualBlocks)
             faceMask |= DIR_BOTTOM_BIT;
         // remember that this gives the top of the block:
         swatchLoc = SWATCH_INDEX(gBlockDefinitions[type].txrX, gBlockDefinitions[type].txrY);
@@ -8139,12 +8806,12 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 // in the world, but you can't see or interact with the chests.
             case 2: // facing north
                 // is neighbor to west also a chest?
-                if (gBoxData[boxIndex - gBoxSizeYZ].origType == type)
+                if (gBoxData.origType[boxIndex - gBoxSizeYZ] == type)
                 {
                     chestType = 1;
                     neighborIndex = -gBoxSizeYZ;
                 }
-                else if (gBoxData[boxIndex + gBoxSizeYZ].origType == type)
+                else if (gBoxData.origType[boxIndex + gBoxSizeYZ] == type)
                 {
                     chestType = 2;
                     neighborIndex = gBoxSizeYZ;
@@ -8153,13 +8820,13 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 break;
             case 3: // facing south
                 // is neighbor to east also a chest?
-                if (gBoxData[boxIndex + gBoxSizeYZ].origType == type)
+                if (gBoxData.origType[boxIndex + gBoxSizeYZ] == type)
                 {
                     chestType = 1;
                     neighborIndex = gBoxSizeYZ;
                 }
                 // else, is neighbor to west also a chest?
-                else if (gBoxData[boxIndex - gBoxSizeYZ].origType == type)
+                else if (gBoxData.origType[boxIndex - gBoxSizeYZ] == type)
                 {
                     chestType = 2;
                     neighborIndex = -gBoxSizeYZ;
@@ -8167,12 +8834,12 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 angle = 0;
                 break;
             case 4: // facing west
-                if (gBoxData[boxIndex - gBoxSize[Y]].origType == type)
+                if (gBoxData.origType[boxIndex - gBoxSize[Y]] == type)
                 {
                     chestType = 2;
                     neighborIndex = -gBoxSize[Y];
                 }
-                else if (gBoxData[boxIndex + gBoxSize[Y]].origType == type)
+                else if (gBoxData.origType[boxIndex + gBoxSize[Y]] == type)
                 {
                     chestType = 1;
                     neighborIndex = gBoxSize[Y];
@@ -8180,12 +8847,12 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 angle = 90;
                 break;
             case 5: // facing east
-                if (gBoxData[boxIndex + gBoxSize[Y]].origType == type)
+                if (gBoxData.origType[boxIndex + gBoxSize[Y]] == type)
                 {
                     chestType = 2;
                     neighborIndex = gBoxSize[Y];
                 }
-                else if (gBoxData[boxIndex - gBoxSize[Y]].origType == type)
+                else if (gBoxData.origType[boxIndex - gBoxSize[Y]] == type)
                 {
                     chestType = 1;
                     neighborIndex = -gBoxSize[Y];
@@ -8250,7 +8917,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             swatchLocSet[DIRECTION_BLOCK_SIDE_HI_Z] = SWATCH_INDEX(9, 2);	// front
             // Check if neighboring half of chest is actually there, and we're showing border faces.
             // If half of check is outside of the export area (type != origType, basically type == AIR), then faceMask here should be 0x0
-            if (gModel.options->pEFD->chkBlockFacesAtBorders && (gBoxData[boxIndex + neighborIndex].type == 0)) {
+            if (gModel.options->pEFD->chkBlockFacesAtBorders && (gBoxData.type[boxIndex + neighborIndex] == 0)) {
                 faceMask = 0x0;
             }
             else {
@@ -8265,7 +8932,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             swatchLocSet[DIRECTION_BLOCK_SIDE_HI_Z] = SWATCH_INDEX(10, 2);	// front
             // Check if neighboring half of chest is actually there, and we're showing border faces.
             // If half of check is outside of the export area (type != origType, basically type == AIR), then faceMask here should be 0x0
-            if (gModel.options->pEFD->chkBlockFacesAtBorders && (gBoxData[boxIndex + neighborIndex].type == 0)) {
+            if (gModel.options->pEFD->chkBlockFacesAtBorders && (gBoxData.type[boxIndex + neighborIndex] == 0)) {
                 faceMask = 0x0;
             }
             else {
@@ -8668,7 +9335,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         default:
             assert(0);
         }
-        neighborType = gBoxData[boxIndex + gFaceOffset[dir]].origType;
+        neighborType = gBoxData.origType[boxIndex + gFaceOffset[dir]];
         assert((neighborType == BLOCK_PISTON_HEAD) || (neighborType == BLOCK_AIR));
 
         totalVertexCount = gModel.vertexCount;
@@ -8751,7 +9418,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             assert(0);
         }
         // look at neighboring piston block to know what kind of piston head we are.
-        neighborType = gBoxData[boxIndex + gFaceOffset[dir]].origType;
+        neighborType = gBoxData.origType[boxIndex + gFaceOffset[dir]];
         assert((neighborType == BLOCK_PISTON) || (neighborType == BLOCK_STICKY_PISTON) || (neighborType == BLOCK_AIR));
 
         totalVertexCount = gModel.vertexCount;
@@ -9033,7 +9700,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         else {
             // which neighboring blocks have something that attaches to a glass pane? Things that attach:
             // whole blocks, glass panes, iron bars, walls
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
             if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                 (neighborType == BLOCK_COBBLESTONE_WALL) ||
                 (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -9042,7 +9709,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 filled |= 0x1;
                 faceMask |= DIR_LO_Z_BIT;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
             if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                 (neighborType == BLOCK_COBBLESTONE_WALL) ||
                 (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -9051,7 +9718,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 filled |= 0x2;
                 faceMask |= DIR_HI_X_BIT;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
             if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                 (neighborType == BLOCK_COBBLESTONE_WALL) ||
                 (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -9060,7 +9727,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
                 filled |= 0x4;
                 faceMask |= DIR_HI_Z_BIT;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
             if ((neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) ||
                 (neighborType == BLOCK_COBBLESTONE_WALL) ||
                 (gBlockDefinitions[neighborType].flags & BLF_WHOLE))
@@ -9072,7 +9739,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         }
 
         // in 1.9 addition of posts made glass and bars merge differently
-        //neighborType = gBoxData[boxIndex+gFaceOffset[DIRECTION_BLOCK_BOTTOM]].origType;
+        //neighborType = gBoxData.origType[boxIndex+gFaceOffset[DIRECTION_BLOCK_BOTTOM]];
         //if ( (neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || 
         //    (gBlockDefinitions[neighborType].flags & BLF_WHOLE) )
         //{
@@ -9081,7 +9748,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         //    tbFaceMask |= DIR_BOTTOM_BIT;
         //}
 
-        //neighborType = gBoxData[boxIndex+gFaceOffset[DIRECTION_BLOCK_TOP]].origType;
+        //neighborType = gBoxData.origType[boxIndex+gFaceOffset[DIRECTION_BLOCK_TOP]];
         //if ( (neighborType == BLOCK_IRON_BARS) || (neighborType == BLOCK_GLASS_PANE) || (neighborType == BLOCK_STAINED_GLASS_PANE) || 
         //    (gBlockDefinitions[neighborType].flags & BLF_WHOLE) )
         //{
@@ -10554,19 +11221,19 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
             // north/south?
             int ns = 0;
             int ew = 0;
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]];
             if ((neighborType == BLOCK_NETHER_PORTAL) || (neighborType == BLOCK_OBSIDIAN)) {
                 ew += (neighborType == BLOCK_NETHER_PORTAL) ? 10 : 1;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]];
             if ((neighborType == BLOCK_NETHER_PORTAL) || (neighborType == BLOCK_OBSIDIAN)) {
                 ew += (neighborType == BLOCK_NETHER_PORTAL) ? 10 : 1;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]];
             if ((neighborType == BLOCK_NETHER_PORTAL) || (neighborType == BLOCK_OBSIDIAN)) {
                 ns += (neighborType == BLOCK_NETHER_PORTAL) ? 10 : 1;
             }
-            neighborType = gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].origType;
+            neighborType = gBoxData.origType[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]];
             if ((neighborType == BLOCK_NETHER_PORTAL) || (neighborType == BLOCK_OBSIDIAN)) {
                 ns += (neighborType == BLOCK_NETHER_PORTAL) ? 10 : 1;
             }
@@ -11014,7 +11681,7 @@ static int saveBillboardOrGeometry(int boxIndex, int type)
         saveBoxMultitileGeometry(boxIndex, type, dataVal, swatchLoc+3, swatchLoc, swatchLoc+4, 1, 0x0, 0x0, 1, 15, 0, 16, 1, 15);
 
         // the top of the decorated pot goes into the cube above. If that cube is solid and opaque OR 3d printing is in use, don't make the pot top, since it will be hidden.
-        if (!(gBlockDefinitions[gBoxData[boxIndex + 1].type].flags & BLF_WHOLE) || (!gModel.print3D && (gBlockDefinitions[gBoxData[boxIndex + 1].type].flags & (BLF_TRANSPARENT | BLF_CUTOUTS | BLF_LEAF_PART)))) {
+        if (!(gBlockDefinitions[gBoxData.type[boxIndex + 1]].flags & BLF_WHOLE) || (!gModel.print3D && (gBlockDefinitions[gBoxData.type[boxIndex + 1]].flags & (BLF_TRANSPARENT | BLF_CUTOUTS | BLF_LEAF_PART)))) {
             // output the top, since it's visible
             gUsingTransform = 1;
             totalVertexCount = gModel.vertexCount;
@@ -11886,12 +12553,12 @@ static unsigned int getStairMask(int boxIndex, int dataVal)
             return 0x0;
         }
         //int neighborIndex = boxIndex + gFaceOffset[stairs[stepDir].backDir];
-        int neighborType = gBoxData[neighborIndex].origType;
+        int neighborType = gBoxData.origType[neighborIndex];
         bool subtractedBlock = false;
         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS)
         {
             // get the data value and check it
-            neighborDataVal = gBoxData[neighborIndex].data;
+            neighborDataVal = gBoxData.data[neighborIndex];
 
             // first, are slabs on same level?
             if ((neighborDataVal & 0x4) == stepLevel)
@@ -11910,12 +12577,12 @@ static unsigned int getStairMask(int boxIndex, int dataVal)
                         return 0x0;
                     }
                     assert(neighborIndex != boxIndex);
-                    neighborType = gBoxData[neighborIndex].origType;
+                    neighborType = gBoxData.origType[neighborIndex];
                     // is there a stairs to the key side of us?
                     if (gBlockDefinitions[neighborType].flags & BLF_STAIRS)
                     {
                         // get the data value and check it
-                        neighborDataVal = gBoxData[neighborIndex].data;
+                        neighborDataVal = gBoxData.data[neighborIndex];
 
                         // first, are slabs on same level?
                         if ((neighborDataVal & 0x4) == stepLevel)
@@ -11949,12 +12616,12 @@ static unsigned int getStairMask(int boxIndex, int dataVal)
             if (badNeighborTest(neighborIndex, boxIndex, (stairs[stepDir].backDir + 3) % 6)) {
                 return 0x0;
             }
-            neighborType = gBoxData[neighborIndex].origType;
+            neighborType = gBoxData.origType[neighborIndex];
             // is there a stairs in front of us?
             if (gBlockDefinitions[neighborType].flags & BLF_STAIRS)
             {
                 // get the data value and check it
-                neighborDataVal = gBoxData[neighborIndex].data;
+                neighborDataVal = gBoxData.data[neighborIndex];
 
                 // first, are slabs on same level?
                 if ((neighborDataVal & 0x4) == stepLevel)
@@ -11973,12 +12640,12 @@ static unsigned int getStairMask(int boxIndex, int dataVal)
                         }
                         //neighborIndex = boxIndex + gFaceOffset[(stairs[stepDir].sideDir[(neighborDataVal & 0x3)] + 3) % 6];
                         assert(neighborIndex != boxIndex);
-                        neighborType = gBoxData[neighborIndex].origType;
+                        neighborType = gBoxData.origType[neighborIndex];
                         // is there a stairs to the key side of us?
                         if (gBlockDefinitions[neighborType].flags & BLF_STAIRS)
                         {
                             // get the data value and check it
-                            neighborDataVal = gBoxData[neighborIndex].data;
+                            neighborDataVal = gBoxData.data[neighborIndex];
 
                             // first, are slabs on same level?
                             if ((neighborDataVal & 0x4) == stepLevel)
@@ -12585,42 +13252,42 @@ static int saveBoxAlltileGeometry(int boxIndex, int type, int dataVal, int swatc
 
                 // check flattening flags
                 int special = 0;
-                if (gBoxData[boxIndex].flatFlags)
+                if (gBoxData.flatFlags[boxIndex])
                 {
                     switch (faceDirection)
                     {
                     case DIRECTION_BLOCK_TOP:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_ABOVE)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_ABOVE)
                         {
                             special = 1;
                         }
                         break;
                     case DIRECTION_BLOCK_BOTTOM:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_BELOW)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_BELOW)
                         {
                             special = 1;
                         }
                         break;
                     case DIRECTION_BLOCK_SIDE_LO_X:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_LO_X)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_LO_X)
                         {
                             special = 1;
                         }
                         break;
                     case DIRECTION_BLOCK_SIDE_HI_X:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_HI_X)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_HI_X)
                         {
                             special = 1;
                         }
                         break;
                     case DIRECTION_BLOCK_SIDE_LO_Z:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_LO_Z)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_LO_Z)
                         {
                             special = 1;
                         }
                         break;
                     case DIRECTION_BLOCK_SIDE_HI_Z:
-                        if (gBoxData[boxIndex].flatFlags & FLAT_FACE_HI_Z)
+                        if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_HI_Z)
                         {
                             special = 1;
                         }
@@ -12636,9 +13303,9 @@ static int saveBoxAlltileGeometry(int boxIndex, int type, int dataVal, int swatc
                     if ((minu == 0.0f) && (minv == 0.0f) && (maxu == 1.0f) && (maxv == 1.0f))
                     {
                         // a bit wasteful: vertices are set separately here in the grid
-                        retCode |= saveVertices(boxIndex, faceDirection, anchor);
+                        retCode |= saveVertices(NULL, boxIndex, faceDirection, anchor);
                         if (retCode >= MW_BEGIN_ERRORS) return retCode;
-                        saveFaceLoop(boxIndex, faceDirection, NULL, NULL, markFirstFace);
+                        saveFaceLoop(NULL, boxIndex, faceDirection, NULL, NULL, markFirstFace);
 
                         // face output, so don't need to mark first face
                         markFirstFace = 0;
@@ -12759,7 +13426,7 @@ static int lesserNeighborCoversRectangle(int faceDirection, int boxIndex, float
     // If we are maintaining borders, we need to ignore neighbors above and below that are in air space.
     neighborBoxIndex = boxIndex + gFaceOffset[faceDirection];
     // in this case we use the actual type (not origType), since we're checking coverage
-    neighborType = gBoxData[neighborBoxIndex].type;
+    neighborType = gBoxData.type[neighborBoxIndex];
     // super-quick out: is neighbor air? Common enough case, let's test for it.
     if (neighborType == BLOCK_AIR)
         return 0;
@@ -12785,7 +13452,7 @@ static int lesserNeighborCoversRectangle(int faceDirection, int boxIndex, float
 
     // check for easy case: if neighbor is a full block, neighbor covers all, so return 1
     // (or, for printing, return 1 if the block being covered *exactly* matches)
-    type = gBoxData[boxIndex].type;
+    type = gBoxData.type[boxIndex];
     if (gBlockDefinitions[neighborType].flags & BLF_WHOLE)
     {
         // special cases for viewing (rendering), having to do with semitransparency or cutouts
@@ -12919,11 +13586,11 @@ static int getFaceRect(int faceDirection, int boxIndex, int view3D, float faceRe
         (faceDirection != DIRECTION_BLOCK_TOP))
     {
         // we have partial blocks possible. Check if neighbor's original type exists at all
-        int origType = gBoxData[boxIndex].origType;
+        int origType = gBoxData.origType[boxIndex];
         // not air?
         if (origType > BLOCK_AIR)
         {
-            int dataVal = gBoxData[boxIndex].data;
+            int dataVal = gBoxData.data[boxIndex];
             float setBottom = 0;
             // The idea here is that setTop is set by the various minor blocks below
             float setTop = 0;
@@ -13220,7 +13887,7 @@ static int saveBoxFaceUVs(int type, int dataVal, int faceDirection, int markFirs
 // 3) for each face, set the loop, the vertex indices, the normal indices (really, just face direction), and the texture indices
 static int saveBillboardFaces(int boxIndex, int type, int billboardType)
 {
-    return saveBillboardFacesExtraData(boxIndex, type, billboardType, gBoxData[boxIndex].data, 1, false);
+    return saveBillboardFacesExtraData(boxIndex, type, billboardType, gBoxData.data[boxIndex], 1, false);
 }
 
 static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType, int dataVal, int firstFace, bool dontWobbleOverride /*= false*/)
@@ -13451,10 +14118,10 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
             // fully mature, change height to 10 if the proper fruit is next door
             matchType = (type == BLOCK_PUMPKIN_STEM) ? BLOCK_PUMPKIN : BLOCK_MELON;
             if ((dataVal & 0x8) ||  // the new way - if there's an attachment, https://minecraft.wiki/w/Pumpkin_Seeds#Metadata
-                (gBoxData[boxIndex - gBoxSizeYZ].origType == matchType) ||
-                (gBoxData[boxIndex + gBoxSizeYZ].origType == matchType) ||
-                (gBoxData[boxIndex - gBoxSize[Y]].origType == matchType) ||
-                (gBoxData[boxIndex + gBoxSize[Y]].origType == matchType)) {
+                (gBoxData.origType[boxIndex - gBoxSizeYZ] == matchType) ||
+                (gBoxData.origType[boxIndex + gBoxSizeYZ] == matchType) ||
+                (gBoxData.origType[boxIndex - gBoxSize[Y]] == matchType) ||
+                (gBoxData.origType[boxIndex + gBoxSize[Y]] == matchType)) {
                 height = -9.0 / 16.0f;
             }
         }
@@ -13537,7 +14204,7 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
         else {
             // full check: is dataVal == 0 (means only a vine above) or is there a solid block above?
             // Note that the solid block must actually exist, vs. "origType"
-            if ((dataVal == 0) || (dataVal == BIT_16) || (gBlockDefinitions[gBoxData[boxIndex + 1].type].flags & BLF_WHOLE)) {
+            if ((dataVal == 0) || (dataVal == BIT_16) || (gBlockDefinitions[gBoxData.type[boxIndex + 1]].flags & BLF_WHOLE)) {
                 vineUnderBlock = true;
             }
         }
@@ -13668,10 +14335,10 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
                 // row 19 (#18) has these
                 // old code, before we shoved the dataVal from the bottom half (if available) into the top half (around line 2812), in extractChunk.
                 // But, should work the same, so don't mess with it.
-                swatchLoc = SWATCH_INDEX(gBoxData[boxIndex - 1].data * 2 + 3, 18);
+                swatchLoc = SWATCH_INDEX(gBoxData.data[boxIndex - 1] * 2 + 3, 18);
                 // for material differentiation set the dataVal to the bottom half
-                origDataVal = gBoxData[boxIndex - 1].data;
-                if (gBoxData[boxIndex - 1].data == 0)
+                origDataVal = gBoxData.data[boxIndex - 1];
+                if (gBoxData.data[boxIndex - 1] == 0)
                 {
                     foundSunflowerTop = 1;
                 }
@@ -13690,7 +14357,7 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
             // top half of plant
             swatchLoc = SWATCH_INDEX(15, 33);
             // for material differentiation set the dataVal to the bottom half
-            origDataVal = gBoxData[boxIndex - 1].data;
+            origDataVal = gBoxData.data[boxIndex - 1];
         }
         //else
         //{
@@ -13705,7 +14372,7 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
             // use short half of plant - twisting vines?
             swatchLoc = (dataVal & 0x1) ? swatchLoc + 15 : swatchLoc - 1;
             // for material differentiation set the dataVal to the bottom half
-            origDataVal = gBoxData[boxIndex - 1].data;
+            origDataVal = gBoxData.data[boxIndex - 1];
         }
         else {
             // full plant; is it twisting vines or hanging roots instead?
@@ -13791,9 +14458,9 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
             // get neighbor's flatFlags in that direction.
             int neighborBoxIndex = boxIndex + gFaceOffset[faceDirection];
             // is the corresponding flag set to point at the redstone?
-            if (gBoxData[neighborBoxIndex].flatFlags & gFlagPointsTo[faceDirection]) {
+            if (gBoxData.flatFlags[neighborBoxIndex] & gFlagPointsTo[faceDirection]) {
                 // yes it is - clear flat flag, and output redstone
-                gBoxData[neighborBoxIndex].flatFlags &= ~gFlagPointsTo[faceDirection];
+                gBoxData.flatFlags[neighborBoxIndex] &= ~gFlagPointsTo[faceDirection];
 
                 // direction of neighbor
                 switch (faceDirection)
@@ -14740,7 +15407,7 @@ static int saveBillboardFacesExtraData(int boxIndex, int type, int billboardType
 
     // special case:
     // for vines, return 0 (flatten to face) if there is a block above it
-    if (CHECK_COMPOSITE_OVERLAY && (billboardType == BB_SIDE) && (gBlockDefinitions[gBoxData[boxIndex + 1].type].flags & BLF_WHOLE))
+    if (CHECK_COMPOSITE_OVERLAY && (billboardType == BB_SIDE) && (gBlockDefinitions[gBoxData.type[boxIndex + 1]].flags & BLF_WHOLE))
     {
         return 0;
     }
@@ -14852,7 +15519,7 @@ static int findGroups()
             for (loc[Y] = gAirBox.max[Y]; loc[Y] >= gAirBox.min[Y]; loc[Y]--, boxIndex--)
             {
                 // check if the object has no group
-                if (gBoxData[boxIndex].group == NO_GROUP_SET)
+                if (gBoxData.group[boxIndex] == NO_GROUP_SET)
                 {
                     gGroupCount++;
                     retCode |= checkGroupListSize();
@@ -14866,9 +15533,9 @@ static int findGroups()
                     // the solid air group will need to have its bounds fixed at the end if tunnel sealing is going on
                     Vec2Op(pGroup->bounds.min, =, loc);
                     Vec2Op(pGroup->bounds.max, =, loc);
-                    pGroup->solid = (gBoxData[boxIndex].type > BLOCK_AIR);
+                    pGroup->solid = (gBoxData.type[boxIndex] > BLOCK_AIR);
 
-                    gBoxData[boxIndex].group = gGroupCount;
+                    gBoxData.group[boxIndex] = gGroupCount;
                     if (pGroup->solid)
                         gSolidGroups++;
                     else
@@ -14927,10 +15594,10 @@ static void addVolumeToGroup(int groupID, int minx, int miny, int minz, int maxx
             // Note that we start at the top and work down, as we want to ensure that outside air is the top group.
             for (loc[Y] = miny; loc[Y] <= maxy; loc[Y]++, boxIndex++)
             {
-                assert(gBoxData[boxIndex].group == NO_GROUP_SET);
+                assert(gBoxData.group[boxIndex] == NO_GROUP_SET);
 
                 pGroup->population++;   // the solid air group might already exist with a population
-                gBoxData[boxIndex].group = groupID;
+                gBoxData.group[boxIndex] = groupID;
             }
         }
     }
@@ -14967,10 +15634,10 @@ static void propagateSeed(IPoint point, BoxGroup* pGroup, IPoint** pSeedStack, i
     if ( (gModel.options->exportFlags & EXPT_SEAL_ENTRANCES) && !pGroup->solid)
     {
         boxIndex = BOX_INDEXV(point);
-        if ((gBlockDefinitions[gBoxData[boxIndex].origType].flags & BLF_ENTRANCE) && notAirEdge(point))
+        if ((gBlockDefinitions[gBoxData.origType[boxIndex]].flags & BLF_ENTRANCE) && notAirEdge(point))
             // In this way, you can use things like snow blocks set to display an alpha of 0 to seal off entrances,
             // and the hole will be visible at the end.  TODO: document - removed, too obscure!!!
-            //if ( gBoxData[boxIndex].origType > BLOCK_AIR )
+            //if ( gBoxData.origType[boxIndex] > BLOCK_AIR )
         {
             // This air block was actually something (like a ladder) that got culled out early on. Use it to seal the entrance.
             // Old code: This air block is actually an entrance, so don't propagate it further.
@@ -14988,24 +15655,24 @@ static void propagateSeed(IPoint point, BoxGroup* pGroup, IPoint** pSeedStack, i
         {
             newBoxIndex = BOX_INDEXV(newPt);
             // is neighbor not in a group, and the same sort of thing as our seed (solid or not)?
-            if (gBoxData[newBoxIndex].group == NO_GROUP_SET) {
+            if (gBoxData.group[newBoxIndex] == NO_GROUP_SET) {
                 if (gModel.print3D) {
                     // For 3D printing, only check fully-filled cells (which is all that are left at this point).
                     // Test: is this a solid block (survivded billboard export) and a solid group, or an air block and an air group?
-                    if ((gBoxData[newBoxIndex].type > BLOCK_AIR) != pGroup->solid) {
+                    if ((gBoxData.type[newBoxIndex] > BLOCK_AIR) != pGroup->solid) {
                         continue;
                     }
                 }
                 else {
                     // For rendering:
                     // Is this a non-air block of any type, including billboards, and is not an "air edge" block?
-                    if (((gBoxData[newBoxIndex].origType > BLOCK_AIR) && notAirEdge(newPt)) != pGroup->solid) {
+                    if (((gBoxData.origType[newBoxIndex] > BLOCK_AIR) && notAirEdge(newPt)) != pGroup->solid) {
                         continue;
                     }
                 }
 
                 // note the block is a part of this group now
-                gBoxData[newBoxIndex].group = pGroup->groupID;
+                gBoxData.group[newBoxIndex] = pGroup->groupID;
                 // update the group's population, and check if this one touches a side.
                 pGroup->population++;
                 addBounds(newPt, &pGroup->bounds);
@@ -15112,25 +15779,25 @@ static void coatSurfaces()
             for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
             {
                 // air?
-                if (gBoxData[boxIndex].type == BLOCK_AIR)
+                if (gBoxData.type[boxIndex] == BLOCK_AIR)
                 {
                     // Are the two neighbors on each side solid? Could be a door or window.
                     static int rule = 2;
                     switch (rule) {
                     default:
                     case 1:
-                        if (((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].type > BLOCK_AIR)) ||
-                            ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].type > BLOCK_AIR)))
-                            gBoxData[boxIndex].type = BLOCK_FAKE;
+                        if (((gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] > BLOCK_AIR)) ||
+                            ((gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] > BLOCK_AIR)))
+                            gBoxData.type[boxIndex] = BLOCK_FAKE;
                         break;
 
                         // We could also test if the two in the other direction *are* air. This will not plug holes in the roof, though, so let's not.
                     case 2:
-                        if (((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].type > BLOCK_AIR) &&
-                            (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].type == BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].type == BLOCK_AIR)) ||
-                            ((gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]].type == BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]].type == BLOCK_AIR) &&
-                            (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]].type > BLOCK_AIR)))
-                            gBoxData[boxIndex].type = BLOCK_FAKE;
+                        if (((gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] > BLOCK_AIR) &&
+                            (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] == BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] == BLOCK_AIR)) ||
+                            ((gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_X]] == BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_X]] == BLOCK_AIR) &&
+                            (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_LO_Z]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[DIRECTION_BLOCK_SIDE_HI_Z]] > BLOCK_AIR)))
+                            gBoxData.type[boxIndex] = BLOCK_FAKE;
                         break;
 
                         // Are the two neighbors on each side solid, or solid on both ends with one air block in between? Could be a door or window.
@@ -15142,8 +15809,8 @@ static void coatSurfaces()
                             if (x - xlo >= gSolidBox.min[X] - 1) {
                                 for (int xhi = 1; xhi < 3 && !madeFake; xhi++) {
                                     if (x + xhi <= gSolidBox.max[X] + 1 && xlo + xhi < 4) {
-                                        if ((gBoxData[boxIndex + gFaceOffset[xlo * DIRECTION_BLOCK_SIDE_LO_X]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[xhi * DIRECTION_BLOCK_SIDE_HI_X]].type > BLOCK_AIR)) {
-                                            gBoxData[boxIndex].type = BLOCK_FAKE;
+                                        if ((gBoxData.type[boxIndex + gFaceOffset[xlo * DIRECTION_BLOCK_SIDE_LO_X]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[xhi * DIRECTION_BLOCK_SIDE_HI_X]] > BLOCK_AIR)) {
+                                            gBoxData.type[boxIndex] = BLOCK_FAKE;
                                             madeFake = true;
                                         }
                                     }
@@ -15155,8 +15822,8 @@ static void coatSurfaces()
                                 if (z - zlo >= gSolidBox.min[Z] - 1) {
                                     for (int zhi = 1; zhi < 3 && !madeFake; zhi++) {
                                         if (z + zhi <= gSolidBox.max[Z] + 1 && zlo + zhi < 4) {
-                                            if ((gBoxData[boxIndex + gFaceOffset[zlo * DIRECTION_BLOCK_SIDE_LO_Z]].type > BLOCK_AIR) && (gBoxData[boxIndex + gFaceOffset[zhi * DIRECTION_BLOCK_SIDE_HI_Z]].type > BLOCK_AIR)) {
-                                                gBoxData[boxIndex].type = BLOCK_FAKE;
+                                            if ((gBoxData.type[boxIndex + gFaceOffset[zlo * DIRECTION_BLOCK_SIDE_LO_Z]] > BLOCK_AIR) && (gBoxData.type[boxIndex + gFaceOffset[zhi * DIRECTION_BLOCK_SIDE_HI_Z]] > BLOCK_AIR)) {
+                                                gBoxData.type[boxIndex] = BLOCK_FAKE;
                                                 madeFake = true;
                                             }
                                         }
@@ -15186,11 +15853,11 @@ static void removeCoatingAndGroups()
             boxIndex = BOX_INDEX(x, gAirBox.min[Y], z);
             for (y = gAirBox.min[Y]; y <= gAirBox.max[Y]; y++, boxIndex++)
             {
-                gBoxData[boxIndex].group = 0;
+                gBoxData.group[boxIndex] = 0;
                 // turn fake blocks back to air
-                if (gBoxData[boxIndex].type == BLOCK_FAKE)
+                if (gBoxData.type[boxIndex] == BLOCK_FAKE)
                 {
-                    gBoxData[boxIndex].type = BLOCK_AIR;
+                    gBoxData.type[boxIndex] = BLOCK_AIR;
                 }
             }
         }
@@ -15342,7 +16009,7 @@ static void findNeighboringGroups(IBox* bounds, int groupID, int* neighborGroups
             boxIndex = BOX_INDEX(x, bounds->min[Y], z);
             for (y = bounds->min[Y]; y <= bounds->max[Y]; y++, boxIndex++)
             {
-                if (gBoxData[boxIndex].group == groupID)
+                if (gBoxData.group[boxIndex] == groupID)
                 {
                     // mark the neighbors
                     for (faceDirection = 0; faceDirection < 6; faceDirection++)
@@ -15351,7 +16018,7 @@ static void findNeighboringGroups(IBox* bounds, int groupID, int* neighborGroups
                         // and set this as a group that touches the group specified. Simply set them
                         // all, again and again, brute force.
                         // Note that we don't have to check if a neighbor block location is valid! They're all inside air.
-                        neighborGroups[gBoxData[boxIndex + gFaceOffset[faceDirection]].group] = 1;
+                        neighborGroups[gBoxData.group[boxIndex + gFaceOffset[faceDirection]]] = 1;
                     }
                 }
             }
@@ -15387,7 +16054,7 @@ static void findNeighboringGroups(IBox* bounds, int groupID, int* neighborGroups
 //            for ( loc[Y] = gSolidBox.min[Y]; loc[Y] <= gSolidBox.max[Y]; loc[Y]++, boxIndex++ )
 //            {
 //				// get the group of the block
-//				groupIndex = gBoxData[boxIndex].group;
+//				groupIndex = gBoxData.group[boxIndex];
 //				assert(groupIndex >= SURROUND_AIR_GROUP );
 //				if ( groupIndex > SURROUND_AIR_GROUP )
 //				{
@@ -15425,10 +16092,10 @@ static void fillGroups(IBox* bounds, int masterGroupID, bool solid, int fillType
             for (y = bounds->min[Y]; y <= bounds->max[Y]; y++, boxIndex++)
             {
                 // is this group one that should get filled by the master group?
-                if (targetGroupIDs[gBoxData[boxIndex].group] > 0)
+                if (targetGroupIDs[gBoxData.group[boxIndex]] > 0)
                 {
                     // found one to fill, transfer it to master group
-                    pGroup = &gGroupList[gBoxData[boxIndex].group];
+                    pGroup = &gGroupList[gBoxData.group[boxIndex]];
                     if (pGroup->solid != solid)
                     {
                         // target and master differ in solidity
@@ -15447,12 +16114,12 @@ static void fillGroups(IBox* bounds, int masterGroupID, bool solid, int fillType
                             {
                                 int index = boxIndex + gFaceOffset[i];
                                 // leaf found?
-                                if (gBlockDefinitions[gBoxData[index].type].flags & BLF_LEAF_PART)
+                                if (gBlockDefinitions[gBoxData.type[index]].flags & BLF_LEAF_PART)
                                 {
                                     leafFound = 1;
-                                    leafData = gBoxData[index].data;
+                                    leafData = gBoxData.data[index];
                                 }
-                                else if (!(gBlockDefinitions[gBoxData[index].type].flags & BLF_TREE_PART) && gBoxData[index].type != BLOCK_AIR)
+                                else if (!(gBlockDefinitions[gBoxData.type[index]].flags & BLF_TREE_PART) && gBoxData.type[index] != BLOCK_AIR)
                                 {
                                     // not a leaf, log, or air, so we won't fill it in.
                                     woodSearch = 0;
@@ -15461,27 +16128,27 @@ static void fillGroups(IBox* bounds, int masterGroupID, bool solid, int fillType
                             if (woodSearch && leafFound)
                             {
                                 // leaf fill
-                                gBoxData[boxIndex].type = BLOCK_LEAVES;
-                                gBoxData[boxIndex].data = leafData;
+                                gBoxData.type[boxIndex] = BLOCK_LEAVES;
+                                gBoxData.data[boxIndex] = leafData;
                             }
                             else
                             {
                                 // normal fill
-                                gBoxData[boxIndex].type = (unsigned char)fillType;
-                                gBoxData[boxIndex].data = 0x0;
+                                gBoxData.type[boxIndex] = (unsigned char)fillType;
+                                gBoxData.data[boxIndex] = 0x0;
                             }
                         }
                         else
                         {
-                            gBoxData[boxIndex].type = (unsigned char)fillType;
-                            gBoxData[boxIndex].data = 0x0;
+                            gBoxData.type[boxIndex] = (unsigned char)fillType;
+                            gBoxData.data[boxIndex] = 0x0;
                         }
                         // no real reason to clear data field, and we may
                         // in fact want to check it later with origType:
-                        // NO NO NO: gBoxData[boxIndex].data = 0x0;
+                        // NO NO NO: gBoxData.data[boxIndex] = 0x0;
                     }
                     // transfer to master group
-                    gBoxData[boxIndex].group = masterGroupID;
+                    gBoxData.group[boxIndex] = masterGroupID;
 
                     // note that this will make this group's bounds invalid,
                     // but since the group is going away, it doesn't matter
@@ -15551,10 +16218,10 @@ static int connectCornerTips()
                 boxIndex = BOX_INDEX(x, y, z);
 
                 // check if it's solid - if so, we'll check if the spot below is air
-                if (gBoxData[boxIndex].type > BLOCK_AIR)
+                if (gBoxData.type[boxIndex] > BLOCK_AIR)
                 {
                     // quick out: if -Y cell is air, then continue checking, else we're done!
-                    if (gBoxData[boxIndex - 1].type == BLOCK_AIR)
+                    if (gBoxData.type[boxIndex - 1] == BLOCK_AIR)
                     {
                         int hasCorner = checkForCorner(boxIndex, -1, -1);
                         if (!hasCorner)
@@ -15570,10 +16237,10 @@ static int connectCornerTips()
                             // add cell to group above
                             IPoint loc;
                             int airBoxIndex = boxIndex - 1;
-                            assert(gBoxData[airBoxIndex].type == BLOCK_AIR);
+                            assert(gBoxData.type[airBoxIndex] == BLOCK_AIR);
                             if (gModel.options->exportFlags & EXPT_DEBUG_SHOW_WELDS)
                             {
-                                gBoxData[airBoxIndex].type = DEBUG_CORNER_TOUCH_TYPE;
+                                gBoxData.type[airBoxIndex] = DEBUG_CORNER_TOUCH_TYPE;
                             }
                             else
                             {
@@ -15583,19 +16250,19 @@ static int connectCornerTips()
                                 // and the original block was already output as true connector geometry.
                                 // Basically, we're crossing fingers that the original block can connect
                                 // the blocks together. TODO...?
-                                gBoxData[airBoxIndex].type = gBoxData[boxIndex].type;
-                                gBoxData[airBoxIndex].data = gBoxData[boxIndex].data;
+                                gBoxData.type[airBoxIndex] = gBoxData.type[boxIndex];
+                                gBoxData.data[airBoxIndex] = gBoxData.data[boxIndex];
                             }
                             gStats.blocksCornertipWelded++;
 
                             // we don't know which item on the group list is the air block's
                             // group, so can't easily subtract one from its population. But, we
                             // don't really care about the air group populations, ever.
-                            gBoxData[airBoxIndex].group = gBoxData[boxIndex].group;
-                            assert(gGroupList[gBoxData[boxIndex].group].solid);
-                            gGroupList[gBoxData[boxIndex].group].population++;
+                            gBoxData.group[airBoxIndex] = gBoxData.group[boxIndex];
+                            assert(gGroupList[gBoxData.group[boxIndex]].solid);
+                            gGroupList[gBoxData.group[boxIndex]].population++;
                             Vec3Scalar(loc, =, x, y - 1, z);
-                            addBounds(loc, &gGroupList[gBoxData[boxIndex].group].bounds);
+                            addBounds(loc, &gGroupList[gBoxData.group[boxIndex]].bounds);
 
                             filledTip = 1;
                         }
@@ -15615,8 +16282,8 @@ static int checkForCorner(int boxIndex, int offx, int offz)
     // If so, check if the groups do not match (meaning they are disconnected parts, like
     // a balloon string).
     // If so, continue search, as these two could get joined.
-    if ((gBoxData[tipCornerIndex].type != BLOCK_AIR) &&
-        (gBoxData[tipCornerIndex].group != gBoxData[boxIndex].group))
+    if ((gBoxData.type[tipCornerIndex] != BLOCK_AIR) &&
+        (gBoxData.group[tipCornerIndex] != gBoxData.group[boxIndex]))
     {
         // solid, so now check 2x2x2 to see if there are just two filled cells (which must be the original
         // and the diagonal ones).
@@ -15629,7 +16296,7 @@ static int checkForCorner(int boxIndex, int offx, int offz)
             int y = ((i % 4) >= 2);
             int z = i % 2;
 
-            if (gBoxData[boxIndex + x * offx * gBoxSizeYZ - y + z * offz * gBoxSize[Y]].type != BLOCK_AIR)
+            if (gBoxData.type[boxIndex + x * offx * gBoxSizeYZ - y + z * offz * gBoxSize[Y]] != BLOCK_AIR)
                 // one of the six is not air - return
                 return 0;
         }
@@ -15687,7 +16354,7 @@ static int fixTouchingEdges()
             {
                 // check if it's solid - if so, add to average center computations,
                 // and then see if there are any edges that touch
-                if (gBoxData[boxIndex].type > BLOCK_AIR)
+                if (gBoxData.type[boxIndex] > BLOCK_AIR)
                 {
                     // TODO: this just averages all solid blocks purely by position.
                     // Some other weighting from center of air space might be better?
@@ -15702,7 +16369,7 @@ static int fixTouchingEdges()
                     // we will never examine cells for solidity that have already been touched.
 
                     // quick out: if +X cell is air, +X face edges are processed, else all can be ignored
-                    if (gBoxData[boxIndex + gBoxSizeYZ].type == BLOCK_AIR)
+                    if (gBoxData.type[boxIndex + gBoxSizeYZ] == BLOCK_AIR)
                     {
                         checkForTouchingEdge(boxIndex, 1, -1, 0);
                         checkForTouchingEdge(boxIndex, 1, 0, -1);
@@ -15710,7 +16377,7 @@ static int fixTouchingEdges()
                         checkForTouchingEdge(boxIndex, 1, 0, 1);
                     }
                     // quick out, if +Z cell is air, the two +Z face edges are processed, else all can be ignored
-                    if (gBoxData[boxIndex + gBoxSize[Y]].type == BLOCK_AIR)
+                    if (gBoxData.type[boxIndex + gBoxSize[Y]] == BLOCK_AIR)
                     {
                         checkForTouchingEdge(boxIndex, 0, -1, 1);
                         checkForTouchingEdge(boxIndex, 0, 1, 1);
@@ -15762,7 +16429,7 @@ static int fixTouchingEdges()
                     touchList[touchCount].obscurity = gTouchGrid[boxIndex].obscurity;
                     touchList[touchCount].count = gTouchGrid[boxIndex].count;
                     touchList[touchCount].boxIndex = boxIndex;
-                    assert(gBoxData[boxIndex].type == BLOCK_AIR);
+                    assert(gBoxData.type[boxIndex] == BLOCK_AIR);
 
                     Vec3Scalar(floc, = (float), x, y, z);
                     touchList[touchCount].distance = computeHidingDistance(floc, avgLoc, norm);
@@ -15820,12 +16487,12 @@ static int fixTouchingEdges()
             for (i = 0; i < 6; i++)
             {
                 int index = boxIndex + gFaceOffset[i];
-                foundBlock = (gBoxData[index].type > BLOCK_AIR);
+                foundBlock = (gBoxData.type[index] > BLOCK_AIR);
                 if (foundBlock)
                 {
                     int j;
                     int foundGroup = 0;
-                    int groupID = gBoxData[index].group;
+                    int groupID = gBoxData.group[index];
                     if (boxMtlIndex < 0)
                         // store away the index of the first material found
                         boxMtlIndex = index;
@@ -15864,10 +16531,10 @@ static int fixTouchingEdges()
 
             // tada! The actual work: the air block is now filled
             // if weld debugging is going on, we should make these some special color - what?
-            assert(gBoxData[boxIndex].type == BLOCK_AIR);
+            assert(gBoxData.type[boxIndex] == BLOCK_AIR);
             if (gModel.options->exportFlags & EXPT_DEBUG_SHOW_WELDS)
             {
-                gBoxData[boxIndex].type = DEBUG_EDGE_TOUCH_TYPE;
+                gBoxData.type[boxIndex] = DEBUG_EDGE_TOUCH_TYPE;
             }
             else
             {
@@ -15875,15 +16542,15 @@ static int fixTouchingEdges()
                 // and the original block was already output as true connector geometry.
                 // Basically, we're crossing fingers that the original block can connect
                 // the blocks together. TODO...?
-                gBoxData[boxIndex].type = gBoxData[boxMtlIndex].type;
-                gBoxData[boxIndex].data = gBoxData[boxMtlIndex].data;
+                gBoxData.type[boxIndex] = gBoxData.type[boxMtlIndex];
+                gBoxData.data[boxIndex] = gBoxData.data[boxMtlIndex];
             }
             gStats.blocksManifoldWelded++;
 
             // we don't know which item on the group list is the air block's
             // group, so can't easily subtract one from its population. But, we
             // don't really care about the air group populations, ever.
-            gBoxData[boxIndex].group = masterGroupID;
+            gBoxData.group[boxIndex] = masterGroupID;
             gGroupList[masterGroupID].population++;
             boxIndexToLoc(loc, boxIndex);
             addBounds(loc, &gGroupList[masterGroupID].bounds);
@@ -15956,7 +16623,7 @@ static int touchRecordCompare(void* context, const void* str1, const void* str2)
     // Blocks that had something in them originally (e.g. rails, redstone, or other things that got flattened)
     // are more significant than blocks of air, so the air should get covered up first so the rails aren't covered.
     // if the blocks are both air, or were both solid, then we need a different thing to test on.
-    if ((gBoxData[t1->boxIndex].origType == BLOCK_AIR) == (gBoxData[t2->boxIndex].origType == BLOCK_AIR))
+    if ((gBoxData.origType[t1->boxIndex] == BLOCK_AIR) == (gBoxData.origType[t2->boxIndex] == BLOCK_AIR))
     {
         // both elements are air or both are not air
         // elements that are in more of a crevice (more faces covered by solid neighbors) get filled first
@@ -15973,7 +16640,7 @@ static int touchRecordCompare(void* context, const void* str1, const void* str2)
         else return ((t1->obscurity > t2->obscurity) ? -1 : 1);
     }
     // one element is air, so favor filling it first
-    else return ((gBoxData[t1->boxIndex].origType < gBoxData[t2->boxIndex].origType) ? -1 : 1);
+    else return ((gBoxData.origType[t1->boxIndex] < gBoxData.origType[t2->boxIndex]) ? -1 : 1);
 }
 
 
@@ -15981,12 +16648,12 @@ static void checkForTouchingEdge(int boxIndex, int offx, int offy, int offz)
 {
     // we assume the location itself is solid. Check if diagonal is solid
     int otherSolidIndex = boxIndex + offx * gBoxSizeYZ + offy + offz * gBoxSize[Y];
-    if (gBoxData[otherSolidIndex].type > BLOCK_AIR)
+    if (gBoxData.type[otherSolidIndex] > BLOCK_AIR)
     {
         // so far so good, both are solid, so we have two diagonally-opposite blocks;
         // do we want to connect all diagonals (usually a bad option), or do the groups differ?
         if ((gModel.options->exportFlags & EXPT_CONNECT_ALL_EDGES) ||
-            (gBoxData[boxIndex].group != gBoxData[otherSolidIndex].group))
+            (gBoxData.group[boxIndex] != gBoxData.group[otherSolidIndex]))
         {
             // groups differ (or all edges should be connected)
             int n1index = UNINITIALIZED_INT;
@@ -16001,7 +16668,7 @@ static void checkForTouchingEdge(int boxIndex, int offx, int offy, int offz)
                 // So just use the other two offsets to check if the other direction is air.
 
                 // so begins the brute force. There's probably some clever way to do this...
-                if (gBoxData[boxIndex + offy + offz * gBoxSize[Y]].type == BLOCK_AIR)
+                if (gBoxData.type[boxIndex + offy + offz * gBoxSize[Y]] == BLOCK_AIR)
                 {
                     // manifold found! So, mark the two air blocks, +X and y/z offset, and put the proper
                     // TOUCH_ flags in the touch grid.
@@ -16042,7 +16709,7 @@ static void checkForTouchingEdge(int boxIndex, int offx, int offy, int offz)
             {
                 // we're on the +Z face, just need to test the Y offset for AIR
                 assert(offz == 1);
-                if (gBoxData[boxIndex + offy].type == BLOCK_AIR)
+                if (gBoxData.type[boxIndex + offy] == BLOCK_AIR)
                 {
                     foundPair = 1;
                     assert(offx == 0);
@@ -16170,7 +16837,7 @@ static int computeObscurity(int boxIndex)
             // now check the stretch of cells in the given direction
             for (i = 0, cellIndex = start; i < cellsToLoop && !hit; i++, cellIndex += incr)
             {
-                if (gBoxData[cellIndex].type > BLOCK_AIR)
+                if (gBoxData.type[cellIndex] > BLOCK_AIR)
                     hit = 1;
             }
             obscurity += hit;
@@ -16388,15 +17055,15 @@ static void deleteFloatingGroups()
                         for (y = pGroup->bounds.min[Y]; deleteGroup && y <= pGroup->bounds.max[Y]; y++, boxIndex++)
                         {
                             // is this group one that should get filled by the master group?
-                            if (gBoxData[boxIndex].group == i)
+                            if (gBoxData.group[boxIndex] == i)
                             {
                                 // group matches: is it a tree part? Or is it a glass bubble that is
                                 // is surrounded by tree bits? (this can happen, some trees grow funny)
-                                if ((gBlockDefinitions[gBoxData[boxIndex].type].flags & BLF_TREE_PART) ||
-                                    (gBoxData[boxIndex].origType == BLOCK_AIR) || (gBoxData[boxIndex].origType == BLOCK_VINES))
+                                if ((gBlockDefinitions[gBoxData.type[boxIndex]].flags & BLF_TREE_PART) ||
+                                    (gBoxData.origType[boxIndex] == BLOCK_AIR) || (gBoxData.origType[boxIndex] == BLOCK_VINES))
                                 {
                                     // tree part, mark which parts
-                                    treeParts |= gBlockDefinitions[gBoxData[boxIndex].type].flags;
+                                    treeParts |= gBlockDefinitions[gBoxData.type[boxIndex]].flags;
                                 }
                                 else
                                 {
@@ -16446,7 +17113,7 @@ static int determineScaleAndHollowAndMelt()
 {
     // get these for statistics and for autoscaling.
     // If returns 0, nothing in box. Abort output.
-    gModel.blockCount = getDimensionsAndCount(gFilledBoxSize);
+    gModel.blockCount = getDimensionsAndCount(gFilledBoxSize, NULL);
     if (gModel.blockCount + gModel.billboardCount == 0)
     {
         // there really should be something in the box
@@ -16558,7 +17225,7 @@ static float computeMachineVolume()
                     for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
                     {
                         // The melting option melts away snow built as supports or whatever
-                        if (gBoxData[boxIndex].origType != BLOCK_AIR)
+                        if (gBoxData.origType[boxIndex] != BLOCK_AIR)
                         {
                             if (y < minSolid)
                             {
@@ -16681,25 +17348,25 @@ static void hollowBottomOfModel()
                     {
                         survived = 0;
                         // brute force the 3x3 above and 3x3 in the middle layer: all solid?
-                        if (gBoxData[boxIndex - 1].type == BLOCK_AIR &&    // if block below is air
-                            gBoxData[boxIndex].type != BLOCK_AIR &&    // if block is solid
-                            gBoxData[boxIndex + 1].type != BLOCK_AIR &&   // +Y
-                            gBoxData[boxIndex - gBoxSizeYZ].type != BLOCK_AIR &&  // -X
-                            gBoxData[boxIndex + gBoxSizeYZ].type != BLOCK_AIR &&  // +X
-                            gBoxData[boxIndex - gBoxSize[Y]].type != BLOCK_AIR &&  // -Z
-                            gBoxData[boxIndex + gBoxSize[Y]].type != BLOCK_AIR &&  // +Z
-                            gBoxData[boxIndex - gBoxSizeYZ - gBoxSize[Y]].type != BLOCK_AIR &&  // -X-Z
-                            gBoxData[boxIndex + gBoxSizeYZ - gBoxSize[Y]].type != BLOCK_AIR &&  // +X-Z
-                            gBoxData[boxIndex - gBoxSizeYZ + gBoxSize[Y]].type != BLOCK_AIR &&  // -X+Z
-                            gBoxData[boxIndex + gBoxSizeYZ + gBoxSize[Y]].type != BLOCK_AIR &&  // +X+Z
-                            gBoxData[boxIndex - gBoxSizeYZ + 1].type != BLOCK_AIR &&  // -X+Y
-                            gBoxData[boxIndex + gBoxSizeYZ + 1].type != BLOCK_AIR &&  // +X+Y
-                            gBoxData[boxIndex - gBoxSize[Y] + 1].type != BLOCK_AIR &&  // -Z+Y
-                            gBoxData[boxIndex + gBoxSize[Y] + 1].type != BLOCK_AIR &&  // +Z+Y
-                            gBoxData[boxIndex - gBoxSizeYZ - gBoxSize[Y] + 1].type != BLOCK_AIR &&  // -X-Z+Y
-                            gBoxData[boxIndex + gBoxSizeYZ - gBoxSize[Y] + 1].type != BLOCK_AIR &&  // +X-Z+Y
-                            gBoxData[boxIndex - gBoxSizeYZ + gBoxSize[Y] + 1].type != BLOCK_AIR &&  // -X+Z+Y
-                            gBoxData[boxIndex + gBoxSizeYZ + gBoxSize[Y] + 1].type != BLOCK_AIR)  // +X+Z+Y
+                        if (gBoxData.type[boxIndex - 1] == BLOCK_AIR &&    // if block below is air
+                            gBoxData.type[boxIndex] != BLOCK_AIR &&    // if block is solid
+                            gBoxData.type[boxIndex + 1] != BLOCK_AIR &&   // +Y
+                            gBoxData.type[boxIndex - gBoxSizeYZ] != BLOCK_AIR &&  // -X
+                            gBoxData.type[boxIndex + gBoxSizeYZ] != BLOCK_AIR &&  // +X
+                            gBoxData.type[boxIndex - gBoxSize[Y]] != BLOCK_AIR &&  // -Z
+                            gBoxData.type[boxIndex + gBoxSize[Y]] != BLOCK_AIR &&  // +Z
+                            gBoxData.type[boxIndex - gBoxSizeYZ - gBoxSize[Y]] != BLOCK_AIR &&  // -X-Z
+                            gBoxData.type[boxIndex + gBoxSizeYZ - gBoxSize[Y]] != BLOCK_AIR &&  // +X-Z
+                            gBoxData.type[boxIndex - gBoxSizeYZ + gBoxSize[Y]] != BLOCK_AIR &&  // -X+Z
+                            gBoxData.type[boxIndex + gBoxSizeYZ + gBoxSize[Y]] != BLOCK_AIR &&  // +X+Z
+                            gBoxData.type[boxIndex - gBoxSizeYZ + 1] != BLOCK_AIR &&  // -X+Y
+                            gBoxData.type[boxIndex + gBoxSizeYZ + 1] != BLOCK_AIR &&  // +X+Y
+                            gBoxData.type[boxIndex - gBoxSize[Y] + 1] != BLOCK_AIR &&  // -Z+Y
+                            gBoxData.type[boxIndex + gBoxSize[Y] + 1] != BLOCK_AIR &&  // +Z+Y
+                            gBoxData.type[boxIndex - gBoxSizeYZ - gBoxSize[Y] + 1] != BLOCK_AIR &&  // -X-Z+Y
+                            gBoxData.type[boxIndex + gBoxSizeYZ - gBoxSize[Y] + 1] != BLOCK_AIR &&  // +X-Z+Y
+                            gBoxData.type[boxIndex - gBoxSizeYZ + gBoxSize[Y] + 1] != BLOCK_AIR &&  // -X+Z+Y
+                            gBoxData.type[boxIndex + gBoxSizeYZ + gBoxSize[Y] + 1] != BLOCK_AIR)  // +X+Z+Y
                         {
                             survived = 1;
                             // OK, this one can be deleted. Now check extra width, if any
@@ -16719,7 +17386,7 @@ static void hollowBottomOfModel()
                                         {
                                             neighborIndex = BOX_INDEXV(loc);
                                             // is neighbor not in a group, and the same sort of thing as our seed (solid or not)?
-                                            if (gBoxData[neighborIndex].type == BLOCK_AIR)
+                                            if (gBoxData.type[neighborIndex] == BLOCK_AIR)
                                             {
                                                 survived = 0;
                                             }
@@ -16747,8 +17414,8 @@ static void hollowBottomOfModel()
                         // do this to only solid objects. This is done until we hit air.
                         // TODO: when we hit air we could continue, not sure that helps...
                         if (!hollowDone[x * gBoxSize[Z] + z])
-                            if (gBoxData[boxIndex].type > BLOCK_AIR)
-                                gBoxData[boxIndex].group = HOLLOW_AIR_GROUP;
+                            if (gBoxData.type[boxIndex] > BLOCK_AIR)
+                                gBoxData.group[boxIndex] = HOLLOW_AIR_GROUP;
                             else
                                 // stop making a post if we hit air. This OK? TODO
                                 hollowDone[x * gBoxSize[Z] + z] = (unsigned char)y;
@@ -16767,11 +17434,11 @@ static void hollowBottomOfModel()
                 // note at this point we're not messing with populations, since hollow is the very last operation.
                 // If this changes, need to decrement and add to populations here, and we'd need to get the new bounds
                 // for any groups that lost anything (and gained anything), etc.
-                gBoxData[listToChange[listCount]].type = BLOCK_AIR;
+                gBoxData.type[listToChange[listCount]] = BLOCK_AIR;
                 // must track block count now, as it's been computed
                 gModel.blockCount--;
                 // special use of group 0 - for hollow
-                gBoxData[listToChange[listCount]].group = HOLLOW_AIR_GROUP;
+                gBoxData.group[listToChange[listCount]] = HOLLOW_AIR_GROUP;
                 gStats.blocksHollowed++;
             }
         }
@@ -16849,7 +17516,7 @@ static void hollowSeed(int x, int y, int z, IPoint** pSeedList, int* seedSize, i
     int boxIndex = BOX_INDEX(x, y, z);
 
     // first, is it already empty? or marked as part of hollow (as the posts are)?
-    if (gBoxData[boxIndex].type != BLOCK_AIR && gBoxData[boxIndex].group != HOLLOW_AIR_GROUP)
+    if (gBoxData.type[boxIndex] != BLOCK_AIR && gBoxData.group[boxIndex] != HOLLOW_AIR_GROUP)
     {
         // OK, it can be tested and could spawn more seeds
         int neighborBoxIndex, dir;
@@ -16865,8 +17532,8 @@ static void hollowSeed(int x, int y, int z, IPoint** pSeedList, int* seedSize, i
                 neighborBoxIndex = BOX_INDEX(loc[X], y - 1, loc[Z]);
                 for (loc[Y] = y - 1; ok && loc[Y] <= y + 1; loc[Y]++, neighborBoxIndex++)
                 {
-                    if (gBoxData[neighborBoxIndex].type == BLOCK_AIR &&
-                        gBoxData[neighborBoxIndex].group != HOLLOW_AIR_GROUP)
+                    if (gBoxData.type[neighborBoxIndex] == BLOCK_AIR &&
+                        gBoxData.group[neighborBoxIndex] != HOLLOW_AIR_GROUP)
                     {
                         // outside air found, so can't grow that direction
                         ok = 0;
@@ -16895,8 +17562,8 @@ static void hollowSeed(int x, int y, int z, IPoint** pSeedList, int* seedSize, i
                 {
                     neighborBoxIndex = BOX_INDEXV(loc);
                     // is neighbor not in a group, and the same sort of thing as our seed (solid or not)?
-                    if (gBoxData[neighborBoxIndex].type == BLOCK_AIR &&
-                        gBoxData[neighborBoxIndex].group != HOLLOW_AIR_GROUP)
+                    if (gBoxData.type[neighborBoxIndex] == BLOCK_AIR &&
+                        gBoxData.group[neighborBoxIndex] != HOLLOW_AIR_GROUP)
                     {
                         ok = 0;
                     }
@@ -16924,8 +17591,8 @@ static void hollowSeed(int x, int y, int z, IPoint** pSeedList, int* seedSize, i
 
             seedList = *pSeedList;
 
-            gBoxData[boxIndex].type = BLOCK_AIR;
-            gBoxData[boxIndex].group = HOLLOW_AIR_GROUP;
+            gBoxData.type[boxIndex] = BLOCK_AIR;
+            gBoxData.group[boxIndex] = HOLLOW_AIR_GROUP;
             gStats.blocksSuperHollowed++;
             // must track block count now, as it's been computed
             gModel.blockCount--;
@@ -16953,14 +17620,14 @@ static void meltSnow()
             for (y = gSolidBox.min[Y]; y <= gSolidBox.max[Y]; y++, boxIndex++)
             {
                 // The melting option melts away snow built as supports or whatever
-                if (gBoxData[boxIndex].type == BLOCK_SNOW_BLOCK)
+                if (gBoxData.type[boxIndex] == BLOCK_SNOW_BLOCK)
                 {
                     // melting time
-                    gBoxData[boxIndex].type = BLOCK_AIR;
+                    gBoxData.type[boxIndex] = BLOCK_AIR;
                     // We don't know if it's true that this is the right air group, but who cares,
                     // it's the last operation before exporting the model itself. Still, give it some
                     // group, just in case...
-                    gBoxData[boxIndex].group = SURROUND_AIR_GROUP;
+                    gBoxData.group[boxIndex] = SURROUND_AIR_GROUP;
                     gStats.blocksHollowed++;
                 }
             }
@@ -17069,49 +17736,63 @@ static int generateBlockDataAndStatistics(IBox* tightWorldBox, IBox* worldBox)
 
     // get the normals into their proper orientations.
     // We need only 6 when only blocks are exported.
-    gModel.normalListCount = gExportBillboards ? NUM_NORMALS_STORED : 6;
-    for (i = 0; i < gModel.normalListCount; i++)
+    // When exporting in tiles, this is done for the first tile; the normals are then kept, along with any added later.
+    if (gModel.normalListCount == 0)
     {
-        rotateLocation(normals[i]);
-        Vec2Op(gModel.normals[i], =, normals[i]);
+        gModel.normalListCount = gExportBillboards ? NUM_NORMALS_STORED : 6;
+        for (i = 0; i < gModel.normalListCount; i++)
+        {
+            rotateLocation(normals[i]);
+            Vec2Op(gModel.normals[i], =, normals[i]);
+        }
     }
 
     //UPDATE_PROGRESS(gProgress.start.makeFaces + gProgress.absolute.makeFaces * 0.90f);
 
     // At this point all partial blocks have been output, and their type set to BLOCK_AIR. Now output the fully solid blocks.
     // Go through blocks and see which is solid; output these solid blocks.
+    // When exporting in tiles, only the tile's own blocks are output.
+    IBox faceBox = gSolidBox;
+    if (gModel.exportInTiles)
+    {
+        faceBox.min[X] = max(faceBox.min[X], gTileBox.min[X]);
+        faceBox.max[X] = min(faceBox.max[X], gTileBox.max[X]);
+        faceBox.min[Z] = max(faceBox.min[Z], gTileBox.min[Z]);
+        faceBox.max[Z] = min(faceBox.max[Z], gTileBox.max[Z]);
+    }
     IPoint origin = { 0,0,0 };
-    for (loc[X] = gSolidBox.min[X]; loc[X] <= gSolidBox.max[X]; loc[X]++)
+    // instances are all made at the origin, so share the vertex grid there and are made one at a time
+    for (loc[X] = faceBox.min[X]; gModel.instancing && loc[X] <= faceBox.max[X]; loc[X]++)
     {
         // update on each row of X
         //UPDATE_PROGRESS(pgFaceStart + pgFaceOffset * ((float)(loc[X] - gSolidBox.min[X] + 1) / (float)(gSolidBox.max[X] - gSolidBox.min[X] + 1)));
-        for (loc[Z] = gSolidBox.min[Z]; loc[Z] <= gSolidBox.max[Z]; loc[Z]++)
+        for (loc[Z] = faceBox.min[Z]; loc[Z] <= faceBox.max[Z]; loc[Z]++)
         {
             boxIndex = BOX_INDEX(loc[X], gSolidBox.min[Y], loc[Z]);
             for (loc[Y] = gSolidBox.min[Y]; loc[Y] <= gSolidBox.max[Y]; loc[Y]++, boxIndex++)
             {
                 // if it's not air (everything too small has been turned into air)
                 // then output it
-                if (gBoxData[boxIndex].type > BLOCK_AIR)
+                if (gBoxData.type[boxIndex] > BLOCK_AIR)
                 {
                     // block is solid, may need to output some faces.
-                    if (gModel.instancing) {
+                    {
                         // is block already output?
                         int instanceID;
                         // is there an instance already for this type and data value? If so, set the instanceID to it.
-                        if (!findInstance(gBoxData[boxIndex].type, gBoxData[boxIndex].data, instanceID)) {
+                        if (!findInstance(gBoxData.type[boxIndex], gBoxData.data[boxIndex], instanceID)) {
                             // prepare for new instance - gModel.instanceCount is incremented later when the instance is actually created
                             instanceID = gModel.instanceCount;
                             int faceID = gModel.faceCount;
                             // make the instance at the origin, storing it in the regular database the usual way.
-                            retCode |= checkAndCreateFaces(boxIndex, origin);
+                            retCode |= checkAndCreateFaces(NULL, boxIndex, origin);
                             if (retCode >= MW_BEGIN_ERRORS)
                                 return retCode;
 
                             // create a new instance of this block type, storing away the first face ID.
                             // adjust the scale and location (center at origin) of the instance.
                             // this method will test the increment gModel.instanceCount.
-                            createInstance(gBoxData[boxIndex].type, gBoxData[boxIndex].data, faceID);
+                            createInstance(gBoxData.type[boxIndex], gBoxData.data[boxIndex], faceID);
                         }
                         // Whatever the case, store the instance location, which is the stored gModel.faceCount,
                         // which points at the next set of faces
@@ -17125,17 +17806,26 @@ static int generateBlockDataAndStatistics(IBox* tightWorldBox, IBox* worldBox)
                         // save instance location and ID to a long list. ID points to the created instance, which has the faceID
                         saveInstanceLocation(anchorPt, instanceID);
                     }
-                    else {
-                        // the normal thing: create the faces as needed
-                        retCode |= checkAndCreateFaces(boxIndex, loc);
-                    }
                 }
             }
         }
     }
+    if (!gModel.instancing)
+    {
+        // the normal thing: create the faces as needed
+        retCode |= createFacesInSlabs(&faceBox);
+        if (retCode >= MW_BEGIN_ERRORS)
+            return retCode;
+    }
 
     UPDATE_PROGRESS(gProgress.start.makeFaces + gProgress.absolute.makeFaces * 0.75f);
 
+    if (gModel.exportInTiles)
+    {
+        // get rid of what the cells around the tile output
+        removeUnusedFacesAndVertices();
+    }
+
     // If we are grouping by material (e.g., STL does not need this), and we are not outputting per block, then we need to sort by material
     if ((gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MTL_PER_TYPE) && !(gModel.options->exportFlags & EXPT_OUTPUT_EACH_BLOCK_A_GROUP))
     {
@@ -17144,17 +17834,17 @@ static int generateBlockDataAndStatistics(IBox* tightWorldBox, IBox* worldBox)
             // for USD, group by actual tile, as we don't care about groups so much
             UPDATE_STATUS(-999.0f, L"Sort by tile IDs");
             if (gModel.options->pEFD->fileType == FILE_TYPE_USD) {
-                qsort_s(gModel.faceList, gModel.faceCount, sizeof(FaceRecord*), tileUSDIdCompare, NULL);
+                sortFaces(gModel.faceList, gModel.faceCount, FACE_SORT_BY_USD_TILE_ID);
             }
             else {
                 // group by tile type; minimizes material changes
-                qsort_s(gModel.faceList, gModel.faceCount, sizeof(FaceRecord*), tileIdCompare, NULL);
+                sortFaces(gModel.faceList, gModel.faceCount, FACE_SORT_BY_TILE_ID);
             }
         }
         else {
             // don't bother with swatchLoc sorting
             UPDATE_STATUS(-999.0f, L"Sort by face IDs");
-            qsort_s(gModel.faceList, gModel.faceCount, sizeof(FaceRecord*), faceIdCompare, NULL);
+            sortFaces(gModel.faceList, gModel.faceCount, FACE_SORT_BY_FACE_ID);
         }
     }
     // else we are exporting by block, so no sorting is done.
@@ -17231,7 +17921,7 @@ static void removeUnusedFacesAndVertices()
             newi++;
         }
     }
-    assert(gModel.simplifyFaceSavings == gModel.faceCount - newi);
+    assert(gModel.exportInTiles || (gModel.simplifyFaceSavings == gModel.faceCount - newi));
     gModel.faceCount = newi;
 
     // shift to remove vertices, and note new index for given vertex, so we can renumber
@@ -17543,6 +18233,174 @@ static int faceIdCompare(void* context, const void* str1, const void* str2)
     else return ((f1->materialType < f2->materialType) ? -1 : 1);
 }
 
+// Sort the faces in the same order as the comparison function for sortType, but much faster: the fields compared
+// are packed into a 64-bit key for each face, and the keys are radix sorted, a byte at a time, by a set of threads.
+// If the fields don't fit in 64 bits, or there's no memory for the keys, qsort_s() is used instead.
+static void sortFaces(FaceRecord** faceList, int faceCount, int sortType)
+{
+    int numBlocks = (faceCount < FACE_SORT_MIN_PARALLEL) ? 1 : EXPORT_MAX_THREADS;
+    int blockMin[EXPORT_MAX_THREADS][4];
+    int blockMax[EXPORT_MAX_THREADS][4];
+    int fieldMin[4];
+    int fieldShift[4];
+    int totalBits = 0;
+    int i, b;
+    int blockCount[EXPORT_MAX_THREADS][256];
+    unsigned long long* keyBlock = NULL;
+    unsigned long long* keys;
+    unsigned long long* keysOut;
+    FaceRecord** facesIn = faceList;
+    FaceRecord** facesOut = NULL;
+    FaceRecord** facesTemp = NULL;
+
+    if (faceCount < 2)
+        return;
+
+    // find the range of each field, so that only the bits needed are used
+    runChunkJobs(numBlocks, [&](int job, int) {
+        int start = (int)((long long)faceCount * job / numBlocks);
+        int end = (int)((long long)faceCount * (job + 1) / numBlocks);
+        int fields[4];
+        for (int f = 0; f < 4; f++) {
+            blockMin[job][f] = INT_MAX;
+            blockMax[job][f] = INT_MIN;
+        }
+        for (int j = start; j < end; j++) {
+            getFaceSortFields(faceList[j], sortType, fields);
+            for (int f = 0; f < 4; f++) {
+                blockMin[job][f] = min(blockMin[job][f], fields[f]);
+                blockMax[job][f] = max(blockMax[job][f], fields[f]);
+            }
+        }
+        });
+    // the last field is the least significant, so is packed into the lowest bits
+    for (i = 3; i >= 0; i--)
+    {
+        int fieldMax = INT_MIN;
+        unsigned long long range;
+        fieldMin[i] = INT_MAX;
+        for (b = 0; b < numBlocks; b++)
+        {
+            fieldMin[i] = min(fieldMin[i], blockMin[b][i]);
+            fieldMax = max(fieldMax, blockMax[b][i]);
+        }
+        range = (unsigned long long)((long long)fieldMax - (long long)fieldMin[i]);
+        // a field that's always the same adds nothing
+        fieldShift[i] = range ? totalBits : 0;
+        while (range)
+        {
+            totalBits++;
+            range >>= 1;
+        }
+    }
+
+    if (totalBits <= 64)
+    {
+        keyBlock = (unsigned long long*)malloc(2 * (size_t)faceCount * sizeof(unsigned long long));
+        facesTemp = (FaceRecord**)malloc((size_t)faceCount * sizeof(FaceRecord*));
+    }
+    if ((keyBlock == NULL) || (facesTemp == NULL))
+    {
+        free(keyBlock);
+        free(facesTemp);
+        qsort_s(faceList, faceCount, sizeof(FaceRecord*),
+            (sortType == FACE_SORT_BY_USD_TILE_ID) ? tileUSDIdCompare : ((sortType == FACE_SORT_BY_TILE_ID) ? tileIdCompare : faceIdCompare), NULL);
+        return;
+    }
+    keys = keyBlock;
+    keysOut = keyBlock + faceCount;
+    facesOut = facesTemp;
+
+    runChunkJobs(numBlocks, [&](int job, int) {
+        int start = (int)((long long)faceCount * job / numBlocks);
+        int end = (int)((long long)faceCount * (job + 1) / numBlocks);
+        int fields[4];
+        for (int j = start; j < end; j++) {
+            unsigned long long key = 0;
+            getFaceSortFields(faceList[j], sortType, fields);
+            for (int f = 0; f < 4; f++) {
+                key |= (unsigned long long)((long long)fields[f] - (long long)fieldMin[f]) << fieldShift[f];
+            }
+            keys[j] = key;
+        }
+        });
+
+    // least significant byte first; each pass keeps the order of the one before for equal bytes
+    for (int shift = 0; shift < totalBits; shift += 8)
+    {
+        int skip = 0;
+        int offset = 0;
+        runChunkJobs(numBlocks, [&](int job, int) {
+            int start = (int)((long long)faceCount * job / numBlocks);
+            int end = (int)((long long)faceCount * (job + 1) / numBlocks);
+            memset(blockCount[job], 0, sizeof(blockCount[job]));
+            for (int j = start; j < end; j++) {
+                blockCount[job][(keys[j] >> shift) & 0xff]++;
+            }
+            });
+        // where each block's faces with each byte value go: by value, then by block, to keep the order
+        for (int digit = 0; digit < 256; digit++)
+        {
+            int digitStart = offset;
+            for (b = 0; b < numBlocks; b++)
+            {
+                int count = blockCount[b][digit];
+                blockCount[b][digit] = offset;
+                offset += count;
+            }
+            // every face, over all the blocks, has this byte value
+            if (offset - digitStart == faceCount)
+                skip = 1;
+        }
+        // all the same in this byte, so nothing to do
+        if (skip)
+            continue;
+        runChunkJobs(numBlocks, [&](int job, int) {
+            int start = (int)((long long)faceCount * job / numBlocks);
+            int end = (int)((long long)faceCount * (job + 1) / numBlocks);
+            for (int j = start; j < end; j++) {
+                int dest = blockCount[job][(keys[j] >> shift) & 0xff]++;
+                keysOut[dest] = keys[j];
+                facesOut[dest] = facesIn[j];
+            }
+            });
+        std::swap(keys, keysOut);
+        std::swap(facesIn, facesOut);
+    }
+
+    if (facesIn != faceList)
+    {
+        memcpy(faceList, facesIn, (size_t)faceCount * sizeof(FaceRecord*));
+    }
+    free(keyBlock);
+    free(facesTemp);
+}
+
+// The fields compared for each sort type, most significant first
+static void getFaceSortFields(FaceRecord* face, int sortType, int fields[4])
+{
+    switch (sortType)
+    {
+    case FACE_SORT_BY_USD_TILE_ID:
+        fields[0] = gModel.uvIndexList[face->uvIndex[0]].swatchLoc;
+        fields[1] = face->materialType;
+        fields[2] = face->materialDataVal;
+        break;
+    case FACE_SORT_BY_TILE_ID:
+        fields[0] = face->materialType;
+        fields[1] = face->materialDataVal;
+        fields[2] = gModel.uvIndexList[face->uvIndex[0]].swatchLoc;
+        break;
+    default:
+        assert(sortType == FACE_SORT_BY_FACE_ID);
+        fields[0] = face->materialType;
+        fields[1] = face->materialDataVal;
+        fields[2] = 0;
+        break;
+    }
+    fields[3] = face->faceIndex;
+}
+
 // sort by instance hash
 static int instanceUSDCompare(void* context, const void* str1, const void* str2)
 {
@@ -17558,7 +18416,9 @@ static int instanceUSDCompare(void* context, const void* str1, const void* str2)
 
 // return 0 if nothing solid in box
 // Note that the dimensions are returned in floats, for later use for statistics
-static int getDimensionsAndCount(Point dimensions)
+// Returns the number of blocks, and sets the dimensions of the box they and any billboards fill. If filledBounds is
+// given, it's set to this box, in box coordinates. When exporting in tiles, only the tile's own blocks are counted.
+static int getDimensionsAndCount(Point dimensions, IBox* filledBounds)
 {
     IPoint loc;
     int boxIndex;
@@ -17567,6 +18427,15 @@ static int getDimensionsAndCount(Point dimensions)
     VecScalar(bounds.min, =, INT_MAX);
     VecScalar(bounds.max, =, INT_MIN);
 
+    IBox searchBox = gAirBox;
+    if (gModel.exportInTiles)
+    {
+        searchBox.min[X] = max(searchBox.min[X], gTileBox.min[X]);
+        searchBox.max[X] = min(searchBox.max[X], gTileBox.max[X]);
+        searchBox.min[Z] = max(searchBox.min[Z], gTileBox.min[Z]);
+        searchBox.max[Z] = min(searchBox.max[Z], gTileBox.max[Z]);
+    }
+
     // do full grid here, in case supports or other stuff gets added at the end
     //for ( loc[X] = 0; loc[X] < gBoxSize[X]; loc[X]++ )
     //{
@@ -17577,15 +18446,15 @@ static int getDimensionsAndCount(Point dimensions)
 
     // search air block, in case something got added around fringe, or some subtraction
     // pulled box in.
-    for (loc[X] = gAirBox.min[X]; loc[X] <= gAirBox.max[X]; loc[X]++)
+    for (loc[X] = searchBox.min[X]; loc[X] <= searchBox.max[X]; loc[X]++)
     {
-        for (loc[Z] = gAirBox.min[Z]; loc[Z] <= gAirBox.max[Z]; loc[Z]++)
+        for (loc[Z] = searchBox.min[Z]; loc[Z] <= searchBox.max[Z]; loc[Z]++)
         {
-            boxIndex = BOX_INDEX(loc[X], gAirBox.min[Y], loc[Z]);
-            for (loc[Y] = gAirBox.min[Y]; loc[Y] <= gAirBox.max[Y]; loc[Y]++, boxIndex++)
+            boxIndex = BOX_INDEX(loc[X], searchBox.min[Y], loc[Z]);
+            for (loc[Y] = searchBox.min[Y]; loc[Y] <= searchBox.max[Y]; loc[Y]++, boxIndex++)
             {
                 // if it's not air, then it's valid - update bounds
-                if (gBoxData[boxIndex].type > BLOCK_AIR)
+                if (gBoxData.type[boxIndex] > BLOCK_AIR)
                 {
                     // block is solid, may need to output some faces.
                     addBounds(loc, &bounds);
@@ -17601,6 +18470,9 @@ static int getDimensionsAndCount(Point dimensions)
         addBoundsToBounds(gModel.billboardBounds, &bounds);
     }
 
+    if (filledBounds != NULL)
+        *filledBounds = bounds;
+
     // anything in the box?
     if (bounds.min[X] > bounds.max[X])
         return 0;
@@ -17648,28 +18520,311 @@ static void rotateLocation(Point pt)
     }
 }
 
-// check if a solid block is next to something that causes a face to be created
-static int checkAndCreateFaces(int boxIndex, IPoint loc)
+// Make the faces of the full blocks in the face box. Each slab of X rows is done by a thread, then all are merged
+// into the model in order.
+static int createFacesInSlabs(IBox* faceBox)
 {
-    int faceDirection;
-    int neighborType;
-    int type = gBoxData[boxIndex].type;
-    int computeHeights = 1;
-    int isFullBlock = 0;	// to make compiler happy
-    float heights[4];
-    int heightIndices[4];
-    int testPartial = gModel.options->pEFD->chkExportAll;
+    int numRows = faceBox->max[X] - faceBox->min[X] + 1;
+    int numSlabs, i;
+    FaceSlab slabs[FACE_MAX_SLABS];
+    IPoint loc;
     int retCode = MW_NO_ERROR;
 
-    // only solid blocks should be passed in here.
-    assert(type != BLOCK_AIR);
-
-    for (faceDirection = 0; faceDirection < 6; faceDirection++)
+    if (numRows < EXPORT_MIN_PARALLEL)
     {
-        int neighborBoxIndex = boxIndex + gFaceOffset[faceDirection];
-        neighborType = gBoxData[neighborBoxIndex].type;
-
-        // Could be added someday:
+        // not worth splitting up, so put the faces right into the model
+        for (loc[X] = faceBox->min[X]; loc[X] <= faceBox->max[X]; loc[X]++)
+        {
+            for (loc[Z] = faceBox->min[Z]; loc[Z] <= faceBox->max[Z]; loc[Z]++)
+            {
+                int boxIndex = BOX_INDEX(loc[X], gSolidBox.min[Y], loc[Z]);
+                for (loc[Y] = gSolidBox.min[Y]; loc[Y] <= gSolidBox.max[Y]; loc[Y]++, boxIndex++)
+                {
+                    if (gBoxData.type[boxIndex] > BLOCK_AIR)
+                    {
+                        retCode |= checkAndCreateFaces(NULL, boxIndex, loc);
+                        if (retCode >= MW_BEGIN_ERRORS)
+                            return retCode;
+                    }
+                }
+            }
+        }
+        return retCode;
+    }
+
+    numSlabs = min(numRows, FACE_MAX_SLABS);
+    memset(slabs, 0, numSlabs * sizeof(FaceSlab));
+    for (i = 0; i < numSlabs; i++)
+    {
+        slabs[i].minX = faceBox->min[X] + (int)((long long)numRows * i / numSlabs);
+        slabs[i].maxX = faceBox->min[X] + (int)((long long)numRows * (i + 1) / numSlabs) - 1;
+        // the vertices past the end of the slab are also the first ones of the next slab, so are kept separately
+        if (i < numSlabs - 1)
+        {
+            slabs[i].lastPlane = (int*)malloc(gBoxSizeYZ * sizeof(int));
+            if (slabs[i].lastPlane == NULL)
+            {
+                retCode = MW_WORLD_EXPORT_TOO_LARGE;
+                goto Exit;
+            }
+            memset(slabs[i].lastPlane, 0xff, gBoxSizeYZ * sizeof(int));    // NO_INDEX_SET
+        }
+    }
+
+    runChunkJobs(numSlabs, [&](int job, int) {
+        FaceSlab* pSlab = &slabs[job];
+        IPoint slabLoc;
+        for (slabLoc[X] = pSlab->minX; slabLoc[X] <= pSlab->maxX; slabLoc[X]++)
+        {
+            for (slabLoc[Z] = faceBox->min[Z]; slabLoc[Z] <= faceBox->max[Z]; slabLoc[Z]++)
+            {
+                int boxIndex = BOX_INDEX(slabLoc[X], gSolidBox.min[Y], slabLoc[Z]);
+                for (slabLoc[Y] = gSolidBox.min[Y]; slabLoc[Y] <= gSolidBox.max[Y]; slabLoc[Y]++, boxIndex++)
+                {
+                    if (gBoxData.type[boxIndex] > BLOCK_AIR)
+                    {
+                        pSlab->retCode |= checkAndCreateFaces(pSlab, boxIndex, slabLoc);
+                        if (pSlab->retCode >= MW_BEGIN_ERRORS)
+                            return;
+                    }
+                }
+            }
+        }
+        });
+
+    retCode = mergeFaceSlabs(slabs, numSlabs);
+
+Exit:
+    for (i = 0; i < numSlabs; i++)
+    {
+        FaceRecordPool* pPool = slabs[i].faceRecordPool;
+        // the pools are handed over to the model when merged
+        while (pPool)
+        {
+            FaceRecordPool* pPrev = pPool->pPrev;
+            free(pPool);
+            pPool = pPrev;
+        }
+        free(slabs[i].lastPlane);
+        free(slabs[i].vertices);
+        free(slabs[i].vertexGridIndex);
+        free(slabs[i].faceList);
+        free(slabs[i].faceSource);
+    }
+    return retCode;
+}
+
+// Add the vertices and faces of the slabs to the model, in order, giving the faces their UVs.
+static int mergeFaceSlabs(FaceSlab* slabs, int numSlabs)
+{
+    int* prevMap = NULL;
+    int* vertexMap = NULL;
+    int i, v, f, j;
+    int retCode = MW_NO_ERROR;
+
+    for (i = 0; i < numSlabs; i++)
+    {
+        retCode |= slabs[i].retCode;
+    }
+    if (retCode >= MW_BEGIN_ERRORS)
+        return retCode;
+
+    for (i = 0; i < numSlabs; i++)
+    {
+        FaceSlab* pSlab = &slabs[i];
+        int firstPlane = pSlab->minX * gBoxSizeYZ;
+
+        // where each vertex of the slab goes in the model. A vertex shared with the previous slab is already there.
+        vertexMap = (int*)malloc((pSlab->vertexCount + 1) * sizeof(int));
+        if (vertexMap == NULL)
+        {
+            retCode |= MW_WORLD_EXPORT_TOO_LARGE;
+            goto Exit;
+        }
+        for (v = 0; v < pSlab->vertexCount; v++)
+        {
+            int gridIndex = pSlab->vertexGridIndex[v];
+            if ((i > 0) && (gridIndex >= firstPlane) && (gridIndex < firstPlane + gBoxSizeYZ) &&
+                (slabs[i - 1].lastPlane[gridIndex - firstPlane] != NO_INDEX_SET))
+            {
+                vertexMap[v] = prevMap[slabs[i - 1].lastPlane[gridIndex - firstPlane]];
+            }
+            else
+            {
+                retCode |= checkVertexListSize();
+                if (retCode >= MW_BEGIN_ERRORS) goto Exit;
+
+                vertexMap[v] = gModel.vertexCount;
+                Vec2Op(gModel.vertices[gModel.vertexCount], =, pSlab->vertices[v]);
+                gModel.vertexCount++;
+            }
+            // the vertex grid gives the model's vertex, as if all was done in a single pass
+            if (gridIndex >= 0)
+                gModel.vertexIndices[gridIndex] = vertexMap[v];
+        }
+
+        for (f = 0; f < pSlab->faceCount; f++)
+        {
+            FaceRecord* face = pSlab->faceList[f];
+            FaceSource* pSource = &pSlab->faceSource[f];
+            for (j = 0; j < 4; j++)
+            {
+                face->vertexIndex[j] = vertexMap[face->vertexIndex[j]];
+            }
+            face->faceIndex = firstFaceModifier(pSource->firstFace, gModel.faceCount);
+            if (gModel.exportTexture)
+            {
+                float heights[4];
+                if (pSource->fluidHeights)
+                    cornerHeights(pSource->boxIndex, heights);
+                saveFaceUVs(face, pSource->boxIndex, pSource->faceDirection, pSource->dataVal, pSource->fluidHeights ? heights : NULL);
+            }
+
+            retCode |= checkFaceListSize();
+            if (retCode >= MW_BEGIN_ERRORS) goto Exit;
+
+            gModel.faceList[gModel.faceCount++] = face;
+        }
+
+        // hand the face records over to the model, under its current pool, which is still being filled
+        if (pSlab->faceRecordPool)
+        {
+            FaceRecordPool* pTail = pSlab->faceRecordPool;
+            while (pTail->pPrev)
+                pTail = pTail->pPrev;
+            pTail->pPrev = gModel.faceRecordPool->pPrev;
+            gModel.faceRecordPool->pPrev = pSlab->faceRecordPool;
+            pSlab->faceRecordPool = NULL;
+        }
+
+        free(prevMap);
+        prevMap = vertexMap;
+        vertexMap = NULL;
+    }
+
+Exit:
+    free(prevMap);
+    free(vertexMap);
+    return retCode;
+}
+
+// Where the index for this location in the vertex grid is kept.
+static int* vertexGridEntry(FaceSlab* pSlab, int vertexIndex)
+{
+    if (pSlab && pSlab->lastPlane && (vertexIndex >= (pSlab->maxX + 1) * gBoxSizeYZ))
+    {
+        return &pSlab->lastPlane[vertexIndex - (pSlab->maxX + 1) * gBoxSizeYZ];
+    }
+    return &gModel.vertexIndices[vertexIndex];
+}
+
+// Add a vertex to the slab or, if none, to the model, and set *pIndex to it. gridIndex is its location in the vertex
+// grid, or -1 if it's not there.
+static int addFaceVertex(FaceSlab* pSlab, int gridIndex, float x, float y, float z, int* pIndex)
+{
+    float* pt;
+    if (pSlab)
+    {
+        if (pSlab->vertexCount == pSlab->vertexListSize)
+        {
+            int newSize = (int)(pSlab->vertexListSize * 1.4 + 1024);
+            Point* vertices = (Point*)realloc(pSlab->vertices, newSize * sizeof(Point));
+            int* vertexGridIndex = vertices ? (int*)realloc(pSlab->vertexGridIndex, newSize * sizeof(int)) : NULL;
+            if (vertices)
+                pSlab->vertices = vertices;
+            if (vertexGridIndex == NULL)
+            {
+                return MW_WORLD_EXPORT_TOO_LARGE;
+            }
+            pSlab->vertexGridIndex = vertexGridIndex;
+            pSlab->vertexListSize = newSize;
+        }
+        pSlab->vertexGridIndex[pSlab->vertexCount] = gridIndex;
+        *pIndex = pSlab->vertexCount;
+        pt = (float*)pSlab->vertices[pSlab->vertexCount++];
+    }
+    else
+    {
+        int retCode = checkVertexListSize();
+        if (retCode >= MW_BEGIN_ERRORS) return retCode;
+
+        *pIndex = gModel.vertexCount;
+        pt = (float*)gModel.vertices[gModel.vertexCount++];
+        assert(gModel.vertexCount <= gModel.vertexListSize);
+    }
+    pt[X] = x;
+    pt[Y] = y;
+    pt[Z] = z;
+    return MW_NO_ERROR;
+}
+
+static FaceRecord* allocSlabFaceRecord(FaceSlab* pSlab)
+{
+    if ((pSlab->faceRecordPool == NULL) || (pSlab->faceRecordPool->count >= FACE_RECORD_POOL_SIZE))
+    {
+        FaceRecordPool* pFRP = (FaceRecordPool*)malloc(sizeof(FaceRecordPool));
+        if (pFRP == NULL)
+        {
+            return NULL;
+        }
+        pFRP->count = 0;
+        pFRP->pPrev = pSlab->faceRecordPool;
+        pSlab->faceRecordPool = pFRP;
+    }
+    return &(pSlab->faceRecordPool->fr[pSlab->faceRecordPool->count++]);
+}
+
+// Add a face to the slab, noting what made it, for finishing it off when merging.
+static int addSlabFace(FaceSlab* pSlab, FaceRecord* face, int boxIndex, int faceDirection, int dataVal, int fluidHeights, int firstFace)
+{
+    FaceSource* pSource;
+    if (pSlab->faceCount == pSlab->faceSize)
+    {
+        int newSize = (int)(pSlab->faceSize * 1.4 + 1024);
+        FaceRecord** faceList = (FaceRecord**)realloc(pSlab->faceList, newSize * sizeof(FaceRecord*));
+        FaceSource* faceSource = faceList ? (FaceSource*)realloc(pSlab->faceSource, newSize * sizeof(FaceSource)) : NULL;
+        if (faceList)
+            pSlab->faceList = faceList;
+        if (faceSource == NULL)
+        {
+            return MW_WORLD_EXPORT_TOO_LARGE;
+        }
+        pSlab->faceSource = faceSource;
+        pSlab->faceSize = newSize;
+    }
+    pSource = &pSlab->faceSource[pSlab->faceCount];
+    pSource->boxIndex = boxIndex;
+    pSource->faceDirection = (unsigned char)faceDirection;
+    pSource->dataVal = (unsigned char)dataVal;
+    pSource->firstFace = (firstFace != 0);
+    pSource->fluidHeights = (fluidHeights != 0);
+    pSlab->faceList[pSlab->faceCount++] = face;
+    return MW_NO_ERROR;
+}
+
+// check if a solid block is next to something that causes a face to be created
+// Make the faces of a full block. If pSlab is set, they're added to the slab, else to the model.
+static int checkAndCreateFaces(FaceSlab* pSlab, int boxIndex, IPoint loc)
+{
+    int faceDirection;
+    int neighborType;
+    int type = gBoxData.type[boxIndex];
+    int computeHeights = 1;
+    int isFullBlock = 0;	// to make compiler happy
+    float heights[4];
+    int heightIndices[4];
+    int testPartial = gModel.options->pEFD->chkExportAll;
+    int retCode = MW_NO_ERROR;
+
+    // only solid blocks should be passed in here.
+    assert(type != BLOCK_AIR);
+
+    for (faceDirection = 0; faceDirection < 6; faceDirection++)
+    {
+        int neighborBoxIndex = boxIndex + gFaceOffset[faceDirection];
+        neighborType = gBoxData.type[neighborBoxIndex];
+
+        // Could be added someday:
         // Check here if the face faces down and is on the border.
         // If so, don't output it.
         // Note that this works only for full blocks - bottoms of other blocks will not be deleted.
@@ -17724,26 +18879,22 @@ static int checkAndCreateFaces(int boxIndex, IPoint loc)
                 else
                 {
                     // save partial block for water and lava
-                    retCode |= saveSpecialVertices(boxIndex, faceDirection, loc, heights, heightIndices);
+                    retCode |= saveSpecialVertices(pSlab, boxIndex, faceDirection, loc, heights, heightIndices);
                     if (retCode >= MW_BEGIN_ERRORS) return retCode;
 
-                    // note that there's a "transform", which really is just that the
-                    // top of the block is different.
-                    // But, if all four heights are the same, we don't have to mark this as TBD. Getting the
-                    // right normal now means we can simplify these meshes later. Also, don't have to compute a separate normal later.
-                    gUsingTransform = (heights[0] != heights[1]) || (heights[1] != heights[2]) || (heights[2] != heights[3]);
-                    saveFaceLoop(boxIndex, faceDirection, heights, heightIndices, (faceDirection == 0));
-                    gUsingTransform = 0;
+                    retCode |= saveFaceLoop(pSlab, boxIndex, faceDirection, heights, heightIndices, (faceDirection == 0));
+                    if (retCode >= MW_BEGIN_ERRORS) return retCode;
                 }
             }
             else
             {
             SaveFullBlock:
                 // normal face save: not fluid, etc.
-                retCode |= saveVertices(boxIndex, faceDirection, loc);
+                retCode |= saveVertices(pSlab, boxIndex, faceDirection, loc);
                 if (retCode >= MW_BEGIN_ERRORS) return retCode;
 
-                saveFaceLoop(boxIndex, faceDirection, NULL, NULL, (faceDirection == 0));
+                retCode |= saveFaceLoop(pSlab, boxIndex, faceDirection, NULL, NULL, (faceDirection == 0));
+                if (retCode >= MW_BEGIN_ERRORS) return retCode;
             }
         }
     }
@@ -17938,11 +19089,11 @@ static int neighborMayCoverFace(int neighborType, int view3D, int testPartial, i
 static int lesserBlockCoversWholeFace(int faceDirection, int neighborBoxIndex, int view3D)
 {
     // we have partial blocks possible. Check if neighbor's type exists at all
-    int type = gBoxData[neighborBoxIndex].type;
+    int type = gBoxData.type[neighborBoxIndex];
     // not air?
     if (type > BLOCK_AIR)
     {
-        int neighborDataVal = gBoxData[neighborBoxIndex].data;
+        int neighborDataVal = gBoxData.data[neighborBoxIndex];
         // a minor block exists, so check its coverage given the face direction
         switch (type)
         {
@@ -18238,7 +19389,7 @@ static int cornerHeights(int boxIndex, float heights[4])
         // OK, compute heights.
         int i;
         // hmmmm, not sure what this was for, but dataHeight is no longer accessed...
-        //int dataHeight = gBoxData[boxIndex].data;
+        //int dataHeight = gBoxData.data[boxIndex];
         //if ( dataHeight >= 8 )
         //{
         //    dataHeight = 0;
@@ -18285,7 +19436,7 @@ static float computeUpperCornerHeight(int boxIndex, int x, int z)
         if (sameFluid(boxIndex, neighbor[i]))
         {
             // matches, so get neighbor's stored height
-            int neighborDataVal = gBoxData[neighbor[i]].data;
+            int neighborDataVal = gBoxData.data[neighbor[i]];
 
             // if height is "full", add it times 10
             if (neighborDataVal >= 8 || neighborDataVal == 0)
@@ -18304,7 +19455,7 @@ static float computeUpperCornerHeight(int boxIndex, int x, int z)
             weight++;
         }
         // if neighbor is not considered solid, add one more
-        else if ((gBoxData[neighbor[i]].origType == BLOCK_AIR) || (gBlockDefinitions[gBoxData[neighbor[i]].origType].flags & BLF_DNE_FLUID))
+        else if ((gBoxData.origType[neighbor[i]] == BLOCK_AIR) || (gBlockDefinitions[gBoxData.origType[neighbor[i]]].flags & BLF_DNE_FLUID))
         {
             heightSum += 1.0f;
             weight++;
@@ -18339,24 +19490,23 @@ static float getFluidHeightPercent(int dataVal)
 static int sameFluid(int fluidBI, int typeBI)
 {
     // I think this is likely overkill, but the waterlogged and invisible edge of block code is so convoluted at this point, I'm testing both types, just to be safe
-    if (IS_WATER(gBoxData[fluidBI].type, fluidBI) || IS_WATER(gBoxData[fluidBI].origType, fluidBI)) {
-        return (IS_WATER(gBoxData[typeBI].type, typeBI) || IS_WATER(gBoxData[typeBI].origType, typeBI));
+    if (IS_WATER(gBoxData.type[fluidBI], fluidBI) || IS_WATER(gBoxData.origType[fluidBI], fluidBI)) {
+        return (IS_WATER(gBoxData.type[typeBI], typeBI) || IS_WATER(gBoxData.origType[typeBI], typeBI));
     }
     else
     {
-        assert((gBoxData[fluidBI].origType == BLOCK_LAVA) || (gBoxData[fluidBI].origType == BLOCK_STATIONARY_LAVA));
-        return ((gBoxData[typeBI].origType == BLOCK_LAVA) || (gBoxData[typeBI].origType == BLOCK_STATIONARY_LAVA));
+        assert((gBoxData.origType[fluidBI] == BLOCK_LAVA) || (gBoxData.origType[fluidBI] == BLOCK_STATIONARY_LAVA));
+        return ((gBoxData.origType[typeBI] == BLOCK_LAVA) || (gBoxData.origType[typeBI] == BLOCK_STATIONARY_LAVA));
     }
 }
 
 // check if each face vertex has an index;
 // if it doesn't, give it one and save out the vertex location itself
-static int saveSpecialVertices(int boxIndex, int faceDirection, IPoint loc, float heights[4], int heightIndices[4])
+static int saveSpecialVertices(FaceSlab* pSlab, int boxIndex, int faceDirection, IPoint loc, float heights[4], int heightIndices[4])
 {
     int vertexIndex;
     int i;
     IPoint offset;
-    float* pt;
     int retCode = MW_NO_ERROR;
 
     // four vertices to output, check that they exist
@@ -18388,44 +19538,25 @@ static int saveSpecialVertices(int boxIndex, int faceDirection, IPoint loc, floa
             else if (heightIndices[heightLoc] == NO_INDEX_SET)
             {
                 // save the vertex for this location.
-                // need to give an index and write out vertex location
-                retCode |= checkVertexListSize();
+                // need to give an index and write out vertex location; it's not shared, so isn't in the grid
+                retCode |= addFaceVertex(pSlab, -1, (float)(loc[X] + offset[X]), (float)loc[Y] + heights[heightLoc], (float)(loc[Z] + offset[Z]), &heightIndices[heightLoc]);
                 if (retCode >= MW_BEGIN_ERRORS) return retCode;
-
-                heightIndices[heightLoc] = gModel.vertexCount;
-                pt = (float*)gModel.vertices[gModel.vertexCount];
-
-                pt[X] = (float)(loc[X] + offset[X]);
-                pt[Y] = (float)loc[Y] + heights[heightLoc];
-                pt[Z] = (float)(loc[Z] + offset[Z]);
-
-                gModel.vertexCount++;
-                assert(gModel.vertexCount <= gModel.vertexListSize);
             }
         }
         else
         {
         UseGridLoc:
-            if (gModel.vertexIndices[vertexIndex] == NO_INDEX_SET)
+            int* pGridEntry = vertexGridEntry(pSlab, vertexIndex);
+            if (*pGridEntry == NO_INDEX_SET)
             {
                 // need to give an index and write out vertex location
-                retCode |= checkVertexListSize();
-                if (retCode >= MW_BEGIN_ERRORS) return retCode;
-
-                gModel.vertexIndices[vertexIndex] = gModel.vertexCount;
-                pt = (float*)gModel.vertices[gModel.vertexCount];
-
                 // for now, we use exactly the same coordinates as Minecraft does.
                 //xOut = (float)(1-gWorld2BoxOffset[X] + xloc + xoff);
                 //yOut = (float)(1-gWorld2BoxOffset[Y] + yloc + yoff);
                 //zOut = (float)(1-gWorld2BoxOffset[Z] + zloc + zoff);
                 // centered on origin, good for Blender import. I put Y==0, X & Z centered
-                pt[X] = (float)(loc[X] + offset[X]);
-                pt[Y] = (float)(loc[Y] + offset[Y]);
-                pt[Z] = (float)(loc[Z] + offset[Z]);
-
-                gModel.vertexCount++;
-                assert(gModel.vertexCount <= gModel.vertexListSize);
+                retCode |= addFaceVertex(pSlab, vertexIndex, (float)(loc[X] + offset[X]), (float)(loc[Y] + offset[Y]), (float)(loc[Z] + offset[Z]), pGridEntry);
+                if (retCode >= MW_BEGIN_ERRORS) return retCode;
             }
         }
     }
@@ -18434,12 +19565,11 @@ static int saveSpecialVertices(int boxIndex, int faceDirection, IPoint loc, floa
 
 // check if each face vertex has an index;
 // if it doesn't, give it one and save out the vertex location itself
-static int saveVertices(int boxIndex, int faceDirection, IPoint loc)
+static int saveVertices(FaceSlab* pSlab, int boxIndex, int faceDirection, IPoint loc)
 {
     int vertexIndex;  // cppcheck-suppress 398
     int i;
     IPoint offset;
-    float* pt;
     int retCode = MW_NO_ERROR;
 
     // four vertices to output, check that they exist
@@ -18461,50 +19591,45 @@ static int saveVertices(int boxIndex, int faceDirection, IPoint loc)
             return retCode | MW_INTERNAL_ERROR;
         }
 
-        if (gModel.vertexIndices[vertexIndex] == NO_INDEX_SET)
+        int* pGridEntry = vertexGridEntry(pSlab, vertexIndex);
+        if (*pGridEntry == NO_INDEX_SET)
         {
             // need to give an index and write out vertex location
-            retCode |= checkVertexListSize();
-            if (retCode >= MW_BEGIN_ERRORS) return retCode;
-
-            gModel.vertexIndices[vertexIndex] = gModel.vertexCount;
-            pt = (float*)gModel.vertices[gModel.vertexCount];
-
             // for now, we use exactly the same coordinates as Minecraft does.
             //xOut = (float)(1-gWorld2BoxOffset[X] + xloc + xoff);
             //yOut = (float)(1-gWorld2BoxOffset[Y] + yloc + yoff);
             //zOut = (float)(1-gWorld2BoxOffset[Z] + zloc + zoff);
             // centered on origin, good for Blender import. I put Y==0, X & Z centered
-            pt[X] = (float)(loc[X] + offset[X]);
-            pt[Y] = (float)(loc[Y] + offset[Y]);
-            pt[Z] = (float)(loc[Z] + offset[Z]);
-
-            gModel.vertexCount++;
-            assert(gModel.vertexCount <= gModel.vertexListSize);
+            retCode |= addFaceVertex(pSlab, vertexIndex, (float)(loc[X] + offset[X]), (float)(loc[Y] + offset[Y]), (float)(loc[Z] + offset[Z]), pGridEntry);
+            if (retCode >= MW_BEGIN_ERRORS) return retCode;
         }
     }
     return retCode;
 }
 
-static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int heightIndices[4], int firstFace)
+// Make a face of a full block. If pSlab is set, the face is added to the slab, and its UVs are made when the slab is
+// merged into the model; else it's added to the model.
+static int saveFaceLoop(FaceSlab* pSlab, int boxIndex, int faceDirection, float heights[4], int heightIndices[4], int firstFace)
 {
     int i;
     FaceRecord* face;
     int dataVal = 0;
-    unsigned short originalType = gBoxData[boxIndex].type;
-    int computedSpecialUVs = 0;
-    int specialUVindices[4];
-    int regularUVindices[4];
+    unsigned short originalType = gBoxData.type[boxIndex];
     int retCode = MW_NO_ERROR;
 
-    face = allocFaceRecordFromPool();
+    face = pSlab ? allocSlabFaceRecord(pSlab) : allocFaceRecordFromPool();
+    if (face == NULL)
+        return MW_WORLD_EXPORT_TOO_LARGE;
 
     // if we sort, we want to keep faces in the order generated, which is
     // generally cache-coherent (and also just easier to view in the file)
     face->faceIndex = firstFaceModifier(firstFace, gModel.faceCount);
 
-    // always the same normal, which directly corresponds to the normals[6] array in gModel
-    face->normalIndex = gUsingTransform ? COMPUTE_NORMAL : (short)faceDirection;
+    // always the same normal, which directly corresponds to the normals[6] array in gModel.
+    // A fluid's top may slope, in which case the normal is computed later. But, if all four heights are the same,
+    // we don't have to mark this as TBD. Getting the right normal now means we can simplify these meshes later.
+    face->normalIndex = (heights && ((heights[0] != heights[1]) || (heights[1] != heights[2]) || (heights[2] != heights[3]))) ?
+        COMPUTE_NORMAL : (short)faceDirection;
 
     // get four face indices for the four corners
     for (i = 0; i < 4; i++)
@@ -18528,75 +19653,6 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
                 // use the vertex added in for this location
                 assert(heightIndices[heightLoc] != NO_INDEX_SET);
                 face->vertexIndex[i] = heightIndices[heightLoc];
-
-                // Since we're saving a special location, we also need a special UV index
-                // to go along with it and use later.
-                // Check the direction - top and bottom don't need these, sides do.
-                if (gModel.exportTexture && !computedSpecialUVs && (faceDirection != DIRECTION_BLOCK_BOTTOM) && (faceDirection != DIRECTION_BLOCK_TOP))
-                {
-                    int j;
-                    computedSpecialUVs = 1;
-
-                    // Add the new UV here, and save its index in an array that is then used
-                    // to replace the regular UV index array location.
-                    for (j = 0; j < 4; j++)
-                    {
-                        int type, swatchLoc;
-                        float u = ((j == 1) || (j == 2)) ? 1.0f : 0.0f;
-                        float v;
-                        if ((j == 2) || (j == 3))
-                        {
-                            switch (faceDirection)
-                            {
-                            case DIRECTION_BLOCK_SIDE_LO_X:
-                                v = (u == 0.0f) ? heights[0] : heights[1];
-                                break;
-                            case DIRECTION_BLOCK_SIDE_HI_X:
-                                v = (u == 0.0f) ? heights[3] : heights[2];
-                                break;
-                            case DIRECTION_BLOCK_SIDE_LO_Z:
-                                v = (u == 0.0f) ? heights[2] : heights[0];
-                                break;
-                            case DIRECTION_BLOCK_SIDE_HI_Z:
-                                v = (u == 0.0f) ? heights[1] : heights[3];
-                                break;
-                            default:
-                                v = 0.0f;
-                                assert(0);
-                            }
-                        }
-                        else
-                        {
-                            // bottom of fluid is always 0.0
-                            v = 0.0f;
-                        }
-
-                        type = gBoxData[boxIndex].type;
-                        if (gModel.options->exportFlags & EXPT_OUTPUT_TEXTURE_SWATCHES)
-                            // we used to check if the block had no textures, but now all blocks have textures, or are invisible
-                            //    !( gBlockDefinitions[type].flags & BLF_IMAGE_TEXTURE) )
-                        {
-                            // use a solid color
-                            swatchLoc = type;
-                        }
-                        else
-                        {
-                            swatchLoc = SWATCH_INDEX(gBlockDefinitions[type].txrX, gBlockDefinitions[type].txrY);
-                            // special: if type is lava, use flowing lava; if water, use flowing water or overlay water
-                            if (IS_WATER(type, boxIndex)) {
-                                if ((faceDirection != DIRECTION_BLOCK_BOTTOM) && (faceDirection != DIRECTION_BLOCK_TOP))
-                                {
-                                    int neighborType = gBoxData[boxIndex + gFaceOffset[faceDirection]].origType;
-                                    swatchLoc = ((neighborType == BLOCK_GLASS) || (neighborType == BLOCK_STAINED_GLASS)) ? SWATCH_INDEX(15, 25) : SWATCH_INDEX(8, 26);
-                                }
-                            }
-                            else if ((type == BLOCK_LAVA) || (type == BLOCK_STATIONARY_LAVA)) {
-                                swatchLoc = SWATCH_INDEX(9, 26);
-                            }
-                        }
-                        specialUVindices[j] = saveTextureUV(swatchLoc, type, u, v);
-                    }
-                }
             }
         }
         else
@@ -18608,8 +19664,8 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
                 offset[Z] * gBoxSize[Y];
 
             // should already be set by saveSpecialVertices or saveVertices
-            assert(gModel.vertexIndices[vertexIndex] >= 0);
-            face->vertexIndex[i] = gModel.vertexIndices[vertexIndex];
+            assert(*vertexGridEntry(pSlab, vertexIndex) >= 0);
+            face->vertexIndex[i] = *vertexGridEntry(pSlab, vertexIndex);
         }
     }
 
@@ -18619,7 +19675,7 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
         // as the material
         if (gModel.options->exportFlags & EXPT_DEBUG_SHOW_GROUPS)
         {
-            face->materialType = (short)getMaterialUsingGroup(gBoxData[boxIndex].group);
+            face->materialType = (short)getMaterialUsingGroup(gBoxData.group[boxIndex]);
             face->materialDataVal = 0;
         }
         else
@@ -18628,55 +19684,55 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
             // have been set to what is above the block before now (in the filter code).
             // If the value is not 0 (air), use that material instead
             int special = 0;
-            if (gBoxData[boxIndex].flatFlags)
+            if (gBoxData.flatFlags[boxIndex])
             {
                 switch (faceDirection)
                 {
                 case DIRECTION_BLOCK_TOP:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_ABOVE)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_ABOVE)
                     {
-                        face->materialType = gBoxData[boxIndex + 1].origType;
-                        dataVal = gBoxData[boxIndex + 1].data;    // this should still be intact, even if neighbor block is cleared to air
+                        face->materialType = gBoxData.origType[boxIndex + 1];
+                        dataVal = gBoxData.data[boxIndex + 1];    // this should still be intact, even if neighbor block is cleared to air
                         special = 1;
                     }
                     break;
                 case DIRECTION_BLOCK_BOTTOM:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_BELOW)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_BELOW)
                     {
-                        face->materialType = gBoxData[boxIndex - 1].origType;
-                        dataVal = gBoxData[boxIndex - 1].data;    // this should still be intact, even if neighbor block is cleared to air
+                        face->materialType = gBoxData.origType[boxIndex - 1];
+                        dataVal = gBoxData.data[boxIndex - 1];    // this should still be intact, even if neighbor block is cleared to air
                         special = 1;
                     }
                     break;
                 case DIRECTION_BLOCK_SIDE_LO_X:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_LO_X)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_LO_X)
                     {
-                        face->materialType = gBoxData[boxIndex - gBoxSizeYZ].origType;
-                        dataVal = gBoxData[boxIndex - gBoxSizeYZ].data;
+                        face->materialType = gBoxData.origType[boxIndex - gBoxSizeYZ];
+                        dataVal = gBoxData.data[boxIndex - gBoxSizeYZ];
                         special = 1;
                     }
                     break;
                 case DIRECTION_BLOCK_SIDE_HI_X:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_HI_X)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_HI_X)
                     {
-                        face->materialType = gBoxData[boxIndex + gBoxSizeYZ].origType;
-                        dataVal = gBoxData[boxIndex + gBoxSizeYZ].data;
+                        face->materialType = gBoxData.origType[boxIndex + gBoxSizeYZ];
+                        dataVal = gBoxData.data[boxIndex + gBoxSizeYZ];
                         special = 1;
                     }
                     break;
                 case DIRECTION_BLOCK_SIDE_LO_Z:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_LO_Z)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_LO_Z)
                     {
-                        face->materialType = gBoxData[boxIndex - gBoxSize[Y]].origType;
-                        dataVal = gBoxData[boxIndex - gBoxSize[Y]].data;
+                        face->materialType = gBoxData.origType[boxIndex - gBoxSize[Y]];
+                        dataVal = gBoxData.data[boxIndex - gBoxSize[Y]];
                         special = 1;
                     }
                     break;
                 case DIRECTION_BLOCK_SIDE_HI_Z:
-                    if (gBoxData[boxIndex].flatFlags & FLAT_FACE_HI_Z)
+                    if (gBoxData.flatFlags[boxIndex] & FLAT_FACE_HI_Z)
                     {
-                        face->materialType = gBoxData[boxIndex + gBoxSize[Y]].origType;
-                        dataVal = gBoxData[boxIndex + gBoxSize[Y]].data;
+                        face->materialType = gBoxData.origType[boxIndex + gBoxSize[Y]];
+                        dataVal = gBoxData.data[boxIndex + gBoxSize[Y]];
                         special = 1;
                     }
                     break;
@@ -18690,7 +19746,7 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
             {
                 // no flattening, normal storage.
                 face->materialType = originalType;
-                dataVal = gBoxData[boxIndex].data;
+                dataVal = gBoxData.data[boxIndex];
                 face->materialDataVal = getSignificantMaterial(face->materialType, dataVal);
             }
             else
@@ -18701,7 +19757,7 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
                 {
                     assert(0);
                     face->materialType = originalType;
-                    dataVal = gBoxData[boxIndex].data;
+                    dataVal = gBoxData.data[boxIndex];
                     face->materialDataVal = getSignificantMaterial(face->materialType, dataVal);
                     return retCode | MW_INTERNAL_ERROR;
                 }
@@ -18716,27 +19772,15 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
     }
     // else no material, so type is not needed
 
-    if (gModel.exportTexture)
+    if (pSlab)
     {
-        // I guess we really don't need the swatch location returned; its
-        // main effect is to set the proper indices in the texture map itself
-        // and note that the swatch is being used
-        (int)getSwatch(face->materialType, dataVal, faceDirection, boxIndex, computedSpecialUVs ? NULL : regularUVindices);
-
-        if (computedSpecialUVs)
-            for (i = 0; i < 4; i++)
-                face->uvIndex[i] = (short)specialUVindices[i];
-        else
-            for (i = 0; i < 4; i++)
-                face->uvIndex[i] = (short)regularUVindices[i];
-
+        // the UVs are made, in order, when the slab is merged
+        return retCode | addSlabFace(pSlab, face, boxIndex, faceDirection, dataVal, heights != NULL, firstFace);
+    }
 
-        // if we're exporting the full texture, then a composite was used:
-        // we might then actually want to use the original type
-        //if ( Options.exportFlags & EXPT_OUTPUT_TEXTURE_IMAGES_OR_TILES )
-        //{
-        //    face->type = originalType;
-        //}
+    if (gModel.exportTexture)
+    {
+        saveFaceUVs(face, boxIndex, faceDirection, dataVal, heights);
     }
 
     retCode |= checkFaceListSize();
@@ -18749,36 +19793,146 @@ static int saveFaceLoop(int boxIndex, int faceDirection, float heights[4], int h
     return retCode;
 }
 
-// this gives us different materials for debug output, a set of various essentially random materials
-static int getMaterialUsingGroup(int groupID)
-{
-    // material 11 is the second lava color swatch. Counting up from here is a colorful
-    // stretch of different materials.
-    int type = (11 + groupID) % NUM_BLOCKS_MAP;
-    return type;
-}
-
-static void randomlyRotateTopAndBottomFace(int faceDirection, int boxIndex, int* localIndices, bool halfOnly /*= false*/, bool allFaces /*= false*/)
+// Make the UVs for a face of a full block. heights are set for the sides and top of fluids not filling the block.
+static void saveFaceUVs(FaceRecord* face, int boxIndex, int faceDirection, int dataVal, float heights[4])
 {
-    if (gModel.instancing || gModel.options->pEFD->chkDecimate || gModel.dontRandomizeRotations) {
-        // don't rotate when instancing, since only one block is going to be set.
-        // An alternative would be to set a rotation value for the block.
-        // Decimation also needs to avoid rotation, see https://github.com/erich666/Mineways/issues/60
-        return;
-    }
-    int angle;  // cppcheck-suppress 398
-    if (allFaces || (faceDirection == DIRECTION_BLOCK_TOP) || (faceDirection == DIRECTION_BLOCK_BOTTOM)) {
-        // random rotation based on location - not same algorithm as Minecraft, but same idea
-        randomRotation(boxIndex, angle);
-        if (halfOnly) {
-            // rotate 180 or not at all
-            angle = (angle >= 180) ? 180 : 0;
-        }
-        if (angle != 0) {
-            rotateIndices(localIndices, angle);
-        }
-    }
-}
+    int i;
+    int computedSpecialUVs = 0;
+    int specialUVindices[4];
+    int regularUVindices[4];
+
+    for (i = 0; heights && (i < 4); i++)
+    {
+        IPoint offset;
+        Vec2Op(offset, =, gFaceToVertexOffset[faceDirection][i]);
+
+        // is this corner at the top of the fluid, below the top of the block?
+        if ((offset[Y] == 1) && (heights[2 * offset[X] + offset[Z]] < 1.0f))
+        {
+            // Since we're saving a special location, we also need a special UV index
+            // to go along with it and use later.
+            // Check the direction - top and bottom don't need these, sides do.
+            if (!computedSpecialUVs && (faceDirection != DIRECTION_BLOCK_BOTTOM) && (faceDirection != DIRECTION_BLOCK_TOP))
+            {
+                int j;
+                computedSpecialUVs = 1;
+
+                // Add the new UV here, and save its index in an array that is then used
+                // to replace the regular UV index array location.
+                for (j = 0; j < 4; j++)
+                {
+                    int type, swatchLoc;
+                    float u = ((j == 1) || (j == 2)) ? 1.0f : 0.0f;
+                    float v;
+                    if ((j == 2) || (j == 3))
+                    {
+                        switch (faceDirection)
+                        {
+                        case DIRECTION_BLOCK_SIDE_LO_X:
+                            v = (u == 0.0f) ? heights[0] : heights[1];
+                            break;
+                        case DIRECTION_BLOCK_SIDE_HI_X:
+                            v = (u == 0.0f) ? heights[3] : heights[2];
+                            break;
+                        case DIRECTION_BLOCK_SIDE_LO_Z:
+                            v = (u == 0.0f) ? heights[2] : heights[0];
+                            break;
+                        case DIRECTION_BLOCK_SIDE_HI_Z:
+                            v = (u == 0.0f) ? heights[1] : heights[3];
+                            break;
+                        default:
+                            v = 0.0f;
+                            assert(0);
+                        }
+                    }
+                    else
+                    {
+                        // bottom of fluid is always 0.0
+                        v = 0.0f;
+                    }
+
+                    type = gBoxData.type[boxIndex];
+                    if (gModel.options->exportFlags & EXPT_OUTPUT_TEXTURE_SWATCHES)
+                        // we used to check if the block had no textures, but now all blocks have textures, or are invisible
+                        //    !( gBlockDefinitions[type].flags & BLF_IMAGE_TEXTURE) )
+                    {
+                        // use a solid color
+                        swatchLoc = type;
+                    }
+                    else
+                    {
+                        swatchLoc = SWATCH_INDEX(gBlockDefinitions[type].txrX, gBlockDefinitions[type].txrY);
+                        // special: if type is lava, use flowing lava; if water, use flowing water or overlay water
+                        if (IS_WATER(type, boxIndex)) {
+                            if ((faceDirection != DIRECTION_BLOCK_BOTTOM) && (faceDirection != DIRECTION_BLOCK_TOP))
+                            {
+                                int neighborType = gBoxData.origType[boxIndex + gFaceOffset[faceDirection]];
+                                swatchLoc = ((neighborType == BLOCK_GLASS) || (neighborType == BLOCK_STAINED_GLASS)) ? SWATCH_INDEX(15, 25) : SWATCH_INDEX(8, 26);
+                            }
+                        }
+                        else if ((type == BLOCK_LAVA) || (type == BLOCK_STATIONARY_LAVA)) {
+                            swatchLoc = SWATCH_INDEX(9, 26);
+                        }
+                    }
+                    specialUVindices[j] = saveTextureUV(swatchLoc, type, u, v);
+                }
+            }
+        }
+    }
+
+    {
+        // I guess we really don't need the swatch location returned; its
+        // main effect is to set the proper indices in the texture map itself
+        // and note that the swatch is being used
+        (int)getSwatch(face->materialType, dataVal, faceDirection, boxIndex, computedSpecialUVs ? NULL : regularUVindices);
+
+        if (computedSpecialUVs)
+            for (i = 0; i < 4; i++)
+                face->uvIndex[i] = (short)specialUVindices[i];
+        else
+            for (i = 0; i < 4; i++)
+                face->uvIndex[i] = (short)regularUVindices[i];
+
+
+        // if we're exporting the full texture, then a composite was used:
+        // we might then actually want to use the original type
+        //if ( Options.exportFlags & EXPT_OUTPUT_TEXTURE_IMAGES_OR_TILES )
+        //{
+        //    face->type = originalType;
+        //}
+    }
+}
+
+// this gives us different materials for debug output, a set of various essentially random materials
+static int getMaterialUsingGroup(int groupID)
+{
+    // material 11 is the second lava color swatch. Counting up from here is a colorful
+    // stretch of different materials.
+    int type = (11 + groupID) % NUM_BLOCKS_MAP;
+    return type;
+}
+
+static void randomlyRotateTopAndBottomFace(int faceDirection, int boxIndex, int* localIndices, bool halfOnly /*= false*/, bool allFaces /*= false*/)
+{
+    if (gModel.instancing || gModel.options->pEFD->chkDecimate || gModel.dontRandomizeRotations) {
+        // don't rotate when instancing, since only one block is going to be set.
+        // An alternative would be to set a rotation value for the block.
+        // Decimation also needs to avoid rotation, see https://github.com/erich666/Mineways/issues/60
+        return;
+    }
+    int angle;  // cppcheck-suppress 398
+    if (allFaces || (faceDirection == DIRECTION_BLOCK_TOP) || (faceDirection == DIRECTION_BLOCK_BOTTOM)) {
+        // random rotation based on location - not same algorithm as Minecraft, but same idea
+        randomRotation(boxIndex, angle);
+        if (halfOnly) {
+            // rotate 180 or not at all
+            angle = (angle >= 180) ? 180 : 0;
+        }
+        if (angle != 0) {
+            rotateIndices(localIndices, angle);
+        }
+    }
+}
 
 // reflect randomly, and rotate 180 if on top or bottom
 static void randomlyRotate180AndReflect(int faceDirection, int boxIndex, int* localIndices)
@@ -19018,7 +20172,7 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
             SWATCH_SWITCH_SIDE_BOTTOM(faceDirection, 3, 0, 2, 0);
             // check if block above is snow (or flagged as "snowy"); if so, use snow side tile; note we
             // check against the original type, since the snow block is likely to be flattened
-            if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData[backgroundIndex + 1].origType == BLOCK_SNOW))
+            if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData.origType[backgroundIndex + 1] == BLOCK_SNOW))
             {
                 if (faceDirection != DIRECTION_BLOCK_TOP && faceDirection != DIRECTION_BLOCK_BOTTOM)
                 {
@@ -19052,7 +20206,7 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 // same as grass block: switch to snow covered look
                 // check if block above is snow (or flagged as "snowy"); if so, use snow side tile; note we
                 // check against the original type, since the snow block is likely to be flattened
-                if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData[backgroundIndex + 1].origType == BLOCK_SNOW))
+                if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData.origType[backgroundIndex + 1] == BLOCK_SNOW))
                 {
                     if (faceDirection != DIRECTION_BLOCK_TOP && faceDirection != DIRECTION_BLOCK_BOTTOM)
                     {
@@ -20824,11 +21978,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 if (faceDirection == DIRECTION_BLOCK_SIDE_LO_Z)
                 {
                     swatchLoc = SWATCH_INDEX(11, 1);
-                    if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
@@ -20837,11 +21991,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 {
                     // back of chest, on possibly long face
                     // is neighbor to north a chest, too?
-                    if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
@@ -20849,11 +22003,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 else if (faceDirection == DIRECTION_BLOCK_TOP || faceDirection == DIRECTION_BLOCK_BOTTOM) // top or bottom
                 {
                     // back of chest, on possibly long face - keep it a "side" unless changed by neighbor
-                    if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 14);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 14);
                     }
@@ -20866,12 +22020,12 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                     // front of chest, on possibly long face
                     swatchLoc = SWATCH_INDEX(11, 1);	// front
                     // is neighbor to east also a chest?
-                    if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
                     // else, is neighbor to west also a chest?
-                    else if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
@@ -20879,11 +22033,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 else if (faceDirection == DIRECTION_BLOCK_SIDE_LO_Z) // north
                 {
                     // back of chest, on possibly long face - keep it a "side" unless changed by neighbor
-                    if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
@@ -20891,11 +22045,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 else if (faceDirection == DIRECTION_BLOCK_TOP || faceDirection == DIRECTION_BLOCK_BOTTOM) // top or bottom
                 {
                     // back of chest, on possibly long face - keep it a "side" unless changed by neighbor
-                    if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 14);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 14);
                     }
@@ -20905,11 +22059,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 if (faceDirection == DIRECTION_BLOCK_SIDE_LO_X) // west
                 {
                     swatchLoc = SWATCH_INDEX(11, 1);
-                    if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
@@ -20918,11 +22072,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 {
                     // back of chest, on possibly long face
                     // is neighbor to north a chest, too?
-                    if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
@@ -20930,11 +22084,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 else if (faceDirection == DIRECTION_BLOCK_TOP || faceDirection == DIRECTION_BLOCK_BOTTOM) // top or bottom
                 {
                     // back of chest, on possibly long face - keep it a "side" unless changed by neighbor
-                    if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 14);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 14);
                     }
@@ -20945,11 +22099,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 if (faceDirection == DIRECTION_BLOCK_SIDE_HI_X)
                 {
                     swatchLoc = SWATCH_INDEX(11, 1);
-                    if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
@@ -20958,11 +22112,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 {
                     // back of chest, on possibly long face
                     // is neighbor to north a chest, too?
-                    if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
@@ -20970,11 +22124,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 else if (faceDirection == DIRECTION_BLOCK_TOP || faceDirection == DIRECTION_BLOCK_BOTTOM) // top or bottom
                 {
                     // back of chest, on possibly long face - keep it a "side" unless changed by neighbor
-                    if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 14);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 14);
                     }
@@ -20988,11 +22142,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 // We leave this code here for older worlds encountered.
                 if (faceDirection == DIRECTION_BLOCK_SIDE_LO_Z)
                 {
-                    if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
@@ -21001,22 +22155,22 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 {
                     // back of chest, on possibly long face
                     // is neighbor to north a chest, too?
-                    if (gBoxData[backgroundIndex - gBoxSizeYZ].origType == type)
+                    if (gBoxData.origType[backgroundIndex - gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
-                    else if (gBoxData[backgroundIndex + gBoxSizeYZ].origType == type)
+                    else if (gBoxData.origType[backgroundIndex + gBoxSizeYZ] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
                 }
                 else if (faceDirection == DIRECTION_BLOCK_SIDE_HI_X)
                 {
-                    if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 2);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 2);
                     }
@@ -21025,11 +22179,11 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
                 {
                     // back of chest, on possibly long face
                     // is neighbor to north a chest, too?
-                    if (gBoxData[backgroundIndex + gBoxSize[Y]].origType == type)
+                    if (gBoxData.origType[backgroundIndex + gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(9, 3);
                     }
-                    else if (gBoxData[backgroundIndex - gBoxSize[Y]].origType == type)
+                    else if (gBoxData.origType[backgroundIndex - gBoxSize[Y]] == type)
                     {
                         swatchLoc = SWATCH_INDEX(10, 3);
                     }
@@ -21532,7 +22686,7 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
         case BLOCK_VINES:						// getSwatch
             // special case (and I'm still not sure about this), if background is air, then
             // just use the default vine, whatever it is
-            if (gBoxData[backgroundIndex].type == BLOCK_AIR || gBoxData[backgroundIndex].type == BLOCK_VINES)
+            if (gBoxData.type[backgroundIndex] == BLOCK_AIR || gBoxData.type[backgroundIndex] == BLOCK_VINES)
             {
                 swatchLoc = SWATCH_INDEX(15, 8);
             }
@@ -21674,7 +22828,7 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
             // same as grass block: switch to snow covered look
             // check if block above is snow (or flagged as "snowy"); if so, use snow side tile; note we
             // check against the original type, since the snow block is likely to be flattened
-            if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData[backgroundIndex + 1].origType == BLOCK_SNOW))
+            if (gIs13orNewer ? (dataVal & SNOWY_BIT) : (gBoxData.origType[backgroundIndex + 1] == BLOCK_SNOW))
             {
                 if (faceDirection != DIRECTION_BLOCK_TOP && faceDirection != DIRECTION_BLOCK_BOTTOM)
                 {
@@ -22254,7 +23408,7 @@ static int getSwatch(int type, int dataVal, int faceDirection, int backgroundInd
             // if sides are next to a glass block, use overlay water instead.
             if ((faceDirection != DIRECTION_BLOCK_BOTTOM) && (faceDirection != DIRECTION_BLOCK_TOP))
             {
-                neighborType = gBoxData[backgroundIndex + gFaceOffset[faceDirection]].origType;
+                neighborType = gBoxData.origType[backgroundIndex + gFaceOffset[faceDirection]];
                 swatchLoc = ((neighborType == BLOCK_GLASS) || (neighborType == BLOCK_STAINED_GLASS)) ? SWATCH_INDEX(15, 25) : SWATCH_INDEX(8, 26);
             }
             break;
@@ -23071,7 +24225,7 @@ static int getCompositeSwatch(int swatchLoc, int backgroundIndex, int faceDirect
     else
     {
         gModel.alreadyAskedForComposite = true;
-        backgroundSwatchLoc = getSwatch(gBoxData[backgroundIndex].type, gBoxData[backgroundIndex].data, faceDirection, backgroundIndex, NULL);
+        backgroundSwatchLoc = getSwatch(gBoxData.type[backgroundIndex], gBoxData.data[backgroundIndex], faceDirection, backgroundIndex, NULL);
     }
 
 
@@ -23316,10 +24470,10 @@ static int saveTextureUV(int swatchLoc, int type, float u, float v)
 }
 
 
-static void freeModel(Model* pModel)
+// Free the vertices and faces. The UVs, normals and materials are left alone, as when exporting in tiles these are
+// kept from tile to tile.
+static void freeModelGeometry(Model* pModel)
 {
-    int catIndex;
-
     if (pModel->vertices)
     {
         free(pModel->vertices);
@@ -23330,20 +24484,7 @@ static void freeModel(Model* pModel)
         free(pModel->vertexIndices);
         pModel->vertexIndices = NULL;
     }
-
-    if (pModel->uvIndexList)
-    {
-        int i;
-        free(pModel->uvIndexList);
-        pModel->uvIndexList = NULL;
-
-        // free all per-swatch UVRecord lists
-        for (i = 0; i < NUM_MAX_SWATCHES; i++)
-        {
-            free(pModel->uvSwatches[i].records);
-            pModel->uvSwatches[i].records = NULL;
-        }
-    }
+    pModel->vertexCount = 0;
 
     if (pModel->faceList)
     {
@@ -23372,6 +24513,28 @@ static void freeModel(Model* pModel)
         pModel->faceList = NULL;
         pModel->faceSize = 0;
     }
+    pModel->faceCount = 0;
+}
+
+static void freeModel(Model* pModel)
+{
+    int catIndex;
+
+    freeModelGeometry(pModel);
+
+    if (pModel->uvIndexList)
+    {
+        int i;
+        free(pModel->uvIndexList);
+        pModel->uvIndexList = NULL;
+
+        // free all per-swatch UVRecord lists
+        for (i = 0; i < NUM_MAX_SWATCHES; i++)
+        {
+            free(pModel->uvSwatches[i].records);
+            pModel->uvSwatches[i].records = NULL;
+        }
+    }
 
     for (catIndex = 0; catIndex < TOTAL_CATEGORIES; catIndex++) {
         if (pModel->pInputTerrainImage[catIndex])
@@ -23852,34 +25015,398 @@ static int mosaicUVtoSeparateUV()
     return retCode;
 }
 
+// OBJ text is formatted by a set of threads, see runChunkJobs(), each taking a range of this many lines at a time; the
+// ranges are then written out in order, a round of them at a time.
+#define OBJ_LINES_PER_RANGE 16384
+#define OBJ_RANGES_PER_THREAD 4
+// room left for each line, or set of group and material lines, as it's formatted
+#define OBJ_LINE_ROOM 1024
+
+#define OUTPUT_NORMALS
+
+typedef struct ObjText {
+    char* text;
+    size_t used;
+    size_t size;
+} ObjText;
+
+// The group and material lines to put in front of faces. Each header runs from its start to the next one's start.
+typedef struct ObjHeaders {
+    ObjText text;
+    int* face;
+    size_t* start;
+    int count;
+    int size;
+} ObjHeaders;
+
+#define WERROR_HEADER(x) if(x) { retCode |= MW_WORLD_EXPORT_TOO_LARGE; goto Exit; }
+
+// Make sure there's room for this many more characters, and return where they go; NULL if out of memory.
+static char* reserveObjText(ObjText* pText, size_t room)
+{
+    if (pText->size - pText->used < room) {
+        size_t newSize = (pText->size > 0) ? 2 * pText->size : OBJ_LINES_PER_RANGE * 64;
+        while (newSize - pText->used < room) {
+            newSize *= 2;
+        }
+        char* newText = (char*)realloc(pText->text, newSize);
+        if (newText == NULL)
+            return NULL;
+        pText->text = newText;
+        pText->size = newSize;
+    }
+    return pText->text + pText->used;
+}
+
+// Add a line to go in front of the given face. Faces must be added in order. Returns non-zero if out of memory.
+static int addOBJHeader(ObjHeaders* pHeaders, int face, const char* format, ...)
+{
+    if ((pHeaders->count == 0) || (pHeaders->face[pHeaders->count - 1] != face)) {
+        assert((pHeaders->count == 0) || (pHeaders->face[pHeaders->count - 1] < face));
+        if (pHeaders->count == pHeaders->size) {
+            int newSize = (pHeaders->size > 0) ? 2 * pHeaders->size : 256;
+            int* newFace = (int*)realloc(pHeaders->face, newSize * sizeof(int));
+            if (newFace == NULL)
+                return 1;
+            pHeaders->face = newFace;
+            size_t* newStart = (size_t*)realloc(pHeaders->start, newSize * sizeof(size_t));
+            if (newStart == NULL)
+                return 1;
+            pHeaders->start = newStart;
+            pHeaders->size = newSize;
+        }
+        pHeaders->face[pHeaders->count] = face;
+        pHeaders->start[pHeaders->count] = pHeaders->text.used;
+        pHeaders->count++;
+    }
+
+    char* dst = reserveObjText(&pHeaders->text, OBJ_LINE_ROOM);
+    if (dst == NULL)
+        return 1;
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(dst, OBJ_LINE_ROOM, format, args);
+    va_end(args);
+    assert((length >= 0) && (length < OBJ_LINE_ROOM));
+    pHeaders->text.used += (length < 0) ? 0 : ((length < OBJ_LINE_ROOM) ? length : OBJ_LINE_ROOM - 1);
+    return 0;
+}
+
+// Return which header goes in front of this face, or -1 if none does.
+static int findOBJHeader(ObjHeaders* pHeaders, int face)
+{
+    int low = 0;
+    int high = pHeaders->count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (pHeaders->face[mid] < face)
+            low = mid + 1;
+        else if (pHeaders->face[mid] > face)
+            high = mid - 1;
+        else
+            return mid;
+    }
+    return -1;
+}
+
+static void freeObjHeaders(ObjHeaders* pHeaders)
+{
+    free(pHeaders->text.text);
+    free(pHeaders->face);
+    free(pHeaders->start);
+    memset(pHeaders, 0, sizeof(ObjHeaders));
+}
+
+// Write count lines to the model file, formatted by formatLine(line, pText), which adds the text for that line to
+// pText and returns false if out of memory. Lines are formatted by several threads at once, so formatLine must only
+// read the model. If itemName is given, progress is shown, going from progressStart over half the output's share.
+template <typename Func>
+static int writeOBJLines(int count, const wchar_t* itemName, float progressStart, Func formatLine)
+{
+    int numRanges = EXPORT_MAX_THREADS * OBJ_RANGES_PER_THREAD;
+    ObjText* ranges = (ObjText*)calloc(numRanges, sizeof(ObjText));
+    if (ranges == NULL)
+        return MW_WORLD_EXPORT_TOO_LARGE;
+
+    wchar_t numString1[100];
+    wchar_t numString2[100];
+    wchar_t statusString[1024];
+    if (itemName != NULL)
+        prettifyNumber(count, numString2);
+
+    int retCode = MW_NO_ERROR;
+    for (int roundStart = 0; roundStart < count; roundStart += numRanges * OBJ_LINES_PER_RANGE)
+    {
+        // only as many ranges as there are lines left
+        int roundRanges = (count - roundStart + OBJ_LINES_PER_RANGE - 1) / OBJ_LINES_PER_RANGE;
+        if (roundRanges > numRanges)
+            roundRanges = numRanges;
+        std::atomic<bool> outOfMemory(false);
+        runChunkJobs(roundRanges, [&](int range, int) {
+            ObjText* pText = &ranges[range];
+            pText->used = 0;
+            int start = roundStart + range * OBJ_LINES_PER_RANGE;
+            int end = (count - start < OBJ_LINES_PER_RANGE) ? count : start + OBJ_LINES_PER_RANGE;
+            for (int line = start; line < end; line++) {
+                if (!formatLine(line, pText)) {
+                    outOfMemory = true;
+                    break;
+                }
+            }
+        });
+
+        if (outOfMemory) {
+            retCode = MW_WORLD_EXPORT_TOO_LARGE;
+            break;
+        }
+        for (int range = 0; range < roundRanges && retCode == MW_NO_ERROR; range++) {
+            if ((ranges[range].used > 0) && OutBuf_Write(gModelFile, ranges[range].text, ranges[range].used)) {
+                assert(0);
+                retCode = MW_CANNOT_WRITE_TO_FILE;
+            }
+        }
+        if (retCode != MW_NO_ERROR)
+            break;
+
+        if (itemName != NULL) {
+            int done = (count - roundStart < numRanges * OBJ_LINES_PER_RANGE) ? count : roundStart + numRanges * OBJ_LINES_PER_RANGE;
+            prettifyNumber(done, numString1);
+            swprintf_s(statusString, 1024, L"Writing %s of %s %s", numString1, numString2, itemName);
+            UPDATE_STATUS(progressStart + gProgress.absolute.output * 0.5f * ((float)done / (float)count), statusString);
+        }
+    }
+
+    for (int range = 0; range < numRanges; range++) {
+        free(ranges[range].text);
+    }
+    free(ranges);
+    return retCode;
+}
+
 // return 0 if no write
 static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC)
 {
-    // set to 1 if you want absolute (positive) indices used in the faces
-    int absoluteIndices = (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_REL_COORDINATES) ? 0 : 1;
+    int retCode = beginOBJFile(pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+    if (retCode >= MW_BEGIN_ERRORS)
+        return retCode;
 
-    wchar_t objFileNameWithSuffix[MAX_PATH_AND_FILE];
+    retCode |= writeOBJGeometry(0, 0);
 
-    char outputString[MAX_PATH_AND_FILE];
-    char mtlName[MAX_PATH_AND_FILE];
+    return endOBJFile(retCode);
+}
 
-    int i, j, groupCount, index;
+// Read in, process and write out the selection a tile at a time, so that memory use depends on the size of a tile
+// instead of the size of the whole selection. Each tile is EXPORT_TILE_CHUNKS chunks on a side, and also reads in the
+// blocks just past its sides, so that blocks at its edges are made just as they would be in a single export.
+static int writeOBJBoxInTiles(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC)
+{
+    int retCode = MW_NO_ERROR;
+    int tileRetCode;
+    bool fileOpen = false;
+    int normalsWritten = 0;
+    int uvsWritten = 0;
+    int totalBlocks = 0;
+    int totalFaces = 0;
+    IBox filledBox;
+    wchar_t statusString[1024];
 
-    unsigned char outputMaterial[NUM_BLOCKS];
+    // the tiles report no progress of their own, as each would go from start to end
+    ProgressCallback* pCallback = gpCallback;
+    static ProgressCallback noCallback = NULL;
+
+    // there's no scaling to the model's size when tiling, so the scale is known from the start
+    gModel.scale = gModel.options->pEFD->blockSizeVal[gModel.options->pEFD->fileType] * MM_TO_METERS;
+    gXformScale = 1.0f;
+
+    VecScalar(tightenedWorldBox->min, =, INT_MAX);
+    VecScalar(tightenedWorldBox->max, =, INT_MIN);
+    VecScalar(filledBox.min, =, INT_MAX);
+    VecScalar(filledBox.max, =, INT_MIN);
+
+    int tileWidth = 16 * EXPORT_TILE_CHUNKS;
+    int startTileX = (int)floor((float)worldBox->min[X] / (float)tileWidth);
+    int endTileX = (int)floor((float)worldBox->max[X] / (float)tileWidth);
+    int startTileZ = (int)floor((float)worldBox->min[Z] / (float)tileWidth);
+    int endTileZ = (int)floor((float)worldBox->max[Z] / (float)tileWidth);
+    int tileCount = (endTileX - startTileX + 1) * (endTileZ - startTileZ + 1);
+    int tileNum = 0;
+
+    for (int tileX = startTileX; tileX <= endTileX; tileX++)
+    {
+        for (int tileZ = startTileZ; tileZ <= endTileZ; tileZ++)
+        {
+            gpCallback = pCallback;
+            swprintf_s(statusString, 1024, L"Export tile %d of %d", tileNum + 1, tileCount);
+            UPDATE_STATUS(gProgress.start.readBlocks + (gProgress.absolute.readBlocks + gProgress.absolute.makeFaces + gProgress.absolute.output) * ((float)tileNum / (float)tileCount), statusString);
+            gpCallback = &noCallback;
+            tileNum++;
+
+            // the part of the selection in this tile
+            IBox tileWorldBox = *worldBox;
+            tileWorldBox.min[X] = max(tileWorldBox.min[X], tileX * tileWidth);
+            tileWorldBox.max[X] = min(tileWorldBox.max[X], (tileX + 1) * tileWidth - 1);
+            tileWorldBox.min[Z] = max(tileWorldBox.min[Z], tileZ * tileWidth);
+            tileWorldBox.max[Z] = min(tileWorldBox.max[Z], (tileZ + 1) * tileWidth - 1);
+
+            // also read in the blocks just past the sides that are inside the selection; these are made, so that
+            // their neighbors in the tile are right, but what they output is thrown away.
+            IBox readWorldBox = tileWorldBox;
+            if (readWorldBox.min[X] > worldBox->min[X]) readWorldBox.min[X]--;
+            if (readWorldBox.max[X] < worldBox->max[X]) readWorldBox.max[X]++;
+            if (readWorldBox.min[Z] > worldBox->min[Z]) readWorldBox.min[Z]--;
+            if (readWorldBox.max[Z] < worldBox->max[Z]) readWorldBox.max[Z]++;
+
+            IBox tileBox;
+            initializeWorldData(&tileBox, readWorldBox.min[X], readWorldBox.min[Y], readWorldBox.min[Z], readWorldBox.max[X], readWorldBox.max[Y], readWorldBox.max[Z]);
+
+            // tileBox comes back with the solid bounds of the blocks read in
+            tileRetCode = populateBox(pWorldGuide, pCBC, &tileBox);
+            if (tileNum == tileCount)
+            {
+                // no more chunks to read
+                regionFreeBuffers();
+            }
+            if (tileRetCode >= MW_BEGIN_ERRORS)
+            {
+                retCode |= tileRetCode;
+                goto Exit;
+            }
+            if (tileRetCode >= MW_BEGIN_NOTHING_TO_DO)
+            {
+                // nothing in this tile; keep any warnings and move on
+                retCode |= tileRetCode & (MW_BEGIN_NOTHING_TO_DO - 1);
+                goto NextTile;
+            }
+            retCode |= tileRetCode;
 
-    int retCode = MW_NO_ERROR;
+            Vec3Op(gTileBox.min, =, tileWorldBox.min, +, gWorld2BoxOffset);
+            Vec3Op(gTileBox.max, =, tileWorldBox.max, +, gWorld2BoxOffset);
+            gTileBox.min[Y] = 0;
+            gTileBox.max[Y] = gBoxSize[Y] - 1;
 
-    char worldNameUnderlined[MAX_PATH_AND_FILE];
-    int prevType;
+            retCode |= initializeModelData();
+            if (retCode >= MW_BEGIN_ERRORS)
+            {
+                goto Exit;
+            }
 
-    FaceRecord* pFace;
+            tileRetCode = filterBox(pCBC);
+            if (tileRetCode >= MW_BEGIN_ERRORS)
+            {
+                retCode |= tileRetCode;
+                goto Exit;
+            }
+            if (tileRetCode >= MW_BEGIN_NOTHING_TO_DO)
+            {
+                retCode |= tileRetCode & (MW_BEGIN_NOTHING_TO_DO - 1);
+                goto NextTile;
+            }
+            retCode |= tileRetCode;
 
-    int vt[4];
+            {
+                // count this tile's blocks, and add where they are to the box the whole model fills
+                Point dimensions;
+                IBox filledTileBox;
+                totalBlocks += getDimensionsAndCount(dimensions, &filledTileBox);
+                if (filledTileBox.min[X] <= filledTileBox.max[X])
+                {
+                    Vec2Op(filledTileBox.min, -=, gWorld2BoxOffset);
+                    Vec2Op(filledTileBox.max, -=, gWorld2BoxOffset);
+                    addBoundsToBounds(filledTileBox, &filledBox);
+                }
+            }
+            addBoundsToBounds(tileBox, tightenedWorldBox);
 
-#define OUTPUT_NORMALS
-#ifdef OUTPUT_NORMALS
-    int outputFaceDirection;
-#endif
+            retCode |= generateBlockDataAndStatistics(&tileBox, worldBox);
+            if (retCode >= MW_BEGIN_ERRORS)
+            {
+                goto Exit;
+            }
+
+            if (gModel.faceCount > 0)
+            {
+                // the file is made when there's first something to put in it
+                if (!fileOpen)
+                {
+                    gpCallback = pCallback;
+                    retCode |= beginOBJFile(pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+                    gpCallback = &noCallback;
+                    if (retCode >= MW_BEGIN_ERRORS)
+                    {
+                        goto Exit;
+                    }
+                    fileOpen = true;
+                }
+
+                retCode |= writeOBJGeometry(normalsWritten, uvsWritten);
+                if (retCode >= MW_BEGIN_ERRORS)
+                {
+                    goto Exit;
+                }
+                normalsWritten = gModel.normalListCount;
+                uvsWritten = gModel.uvIndexCount;
+                gModel.vertexIndexBase += gModel.vertexCount;
+                totalFaces += gModel.faceCount;
+            }
+
+        NextTile:
+            freeModelGeometry(&gModel);
+            freeBoxData();
+            if (gBiomeArray)
+            {
+                free(gBiomeArray);
+                gBiomeArray = NULL;
+            }
+        }
+    }
+
+    if (!fileOpen)
+    {
+        // there really was nothing in the selection
+        retCode |= MW_NO_BLOCKS_FOUND;
+        goto Exit;
+    }
+
+    // the counts are for the whole model, so are written at the end; beginOBJFile() wrote the settings
+    gModel.vertexCount = gModel.vertexIndexBase;
+    gModel.faceCount = totalFaces;
+    gModel.blockCount = totalBlocks;
+    Vec3Op(gFilledBoxSize, =, 1.0f + (float)filledBox.max, -, (float)filledBox.min);
+    gStats.numBlocks = gModel.blockCount;
+    gStats.density = (float)gStats.numBlocks / (float)(gFilledBoxSize[X] * gFilledBoxSize[Y] * gFilledBoxSize[Z]);
+
+    // on error, the file has been closed
+    retCode |= writeStatistics(gModelFile, NULL, pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC, STATS_COUNTS);
+    if (retCode >= MW_BEGIN_ERRORS)
+    {
+        fileOpen = false;
+    }
+
+Exit:
+    gpCallback = pCallback;
+    freeModelGeometry(&gModel);
+    freeBoxData();
+    if (gBiomeArray)
+    {
+        free(gBiomeArray);
+        gBiomeArray = NULL;
+    }
+
+    if (fileOpen)
+    {
+        retCode = endOBJFile(retCode);
+    }
+    return retCode;
+}
+
+// Create the OBJ file and write out what goes before the geometry. On error the file is left closed.
+static int beginOBJFile(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC)
+{
+    wchar_t objFileNameWithSuffix[MAX_PATH_AND_FILE];
+
+    int retCode = MW_NO_ERROR;
+
+    char worldNameUnderlined[MAX_PATH_AND_FILE];
 
     int exportMaterials = gModel.options->exportFlags & EXPT_OUTPUT_MATERIALS;
 
@@ -23891,17 +25418,21 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
     addOutputFilenameToList(objFileNameWithSuffix);
     if (gModelFile == INVALID_HANDLE_VALUE)
         return retCode | MW_CANNOT_CREATE_FILE;
+    // collect the output and write it out in large pieces; if this fails, everything is written directly
+    OutBuf_Attach(gModelFile);
 
     wchar_t statusString[1024];
     swprintf_s(statusString, 1024, L"Writing OBJ file %s", getFilename(objFileNameWithSuffix));
     UPDATE_STATUS(-999.0f, statusString);
 
-    sprintf_s(outputString, 256, "# Wavefront OBJ file made by Mineways version %d.%02d, http://mineways.com\n", gMinewaysMajorVersion, gMinewaysMinorVersion);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Printf(gModelFile, "# Wavefront OBJ file made by Mineways version %d.%02d, http://mineways.com\n", gMinewaysMajorVersion, gMinewaysMinorVersion));
 
-    retCode |= writeStatistics(gModelFile, NULL, pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+    // When exporting in tiles, the counts and sizes aren't known until all tiles are done, so are written at the
+    // end instead. The settings still go first, so that importing the file restores them.
+    // on error, the file has been closed
+    retCode |= writeStatistics(gModelFile, NULL, pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC, gModel.exportInTiles ? STATS_SETTINGS : STATS_ALL);
     if (retCode >= MW_BEGIN_ERRORS)
-        goto Exit;
+        return retCode;
 
     // If we use materials, say where the file is
     if (exportMaterials)
@@ -23909,70 +25440,110 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
         char justMtlFileName[MAX_PATH_AND_FILE];
         sprintf_s(justMtlFileName, MAX_PATH_AND_FILE, "%s.mtl", gOutputFileRootCleanChar);
 
-        sprintf_s(outputString, 256, "\nmtllib %s\n", justMtlFileName);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Printf(gModelFile, "\nmtllib %s\n", justMtlFileName));
     }
 
     convertWcharPathUnderlined(worldNameUnderlined, pWorldGuide->world, false);
 
-    int mkGroupsObjs = (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MAKE_GROUPS_OBJECTS);
-    if (!mkGroupsObjs) {
+    if (!(gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MAKE_GROUPS_OBJECTS)) {
         // Output just one object. Else we output an object every time we output a group
         // Object name
-        sprintf_s(outputString, 256, "\no %s__%d_%d_%d_to_%d_%d_%d\n", worldNameUnderlined,
+        WERROR_MODEL(OutBuf_Printf(gModelFile, "\no %s__%d_%d_%d_to_%d_%d_%d\n", worldNameUnderlined,
             worldBox->min[X], worldBox->min[Y], worldBox->min[Z],
-            worldBox->max[X], worldBox->max[Y], worldBox->max[Z]);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            worldBox->max[X], worldBox->max[Y], worldBox->max[Z]));
     }
 
+    return retCode;
+}
+
+// Write out the model's normals, texture coordinates, vertices and faces. When exporting in tiles, this is called for
+// each tile: firstNormal and firstUV are how many normals and texture coordinates were already written by earlier
+// tiles, and the face's vertices are numbered after the gModel.vertexIndexBase vertices already written.
+// On error the file is left open, for endOBJFile() to close.
+static int writeOBJGeometry(int firstNormal, int firstUV)
+{
+    // set to 1 if you want absolute (positive) indices used in the faces
+    int absoluteIndices = (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_REL_COORDINATES) ? 0 : 1;
+
+    char mtlName[MAX_PATH_AND_FILE];
+
+    int i, groupCount;
+
+    unsigned char outputMaterial[NUM_BLOCKS];
+
+    int retCode = MW_NO_ERROR;
+
+    int prevType;
+
+    FaceRecord* pFace;
+
+    // group and material lines, made ahead of the faces they go in front of
+    ObjHeaders headers;
+    memset(&headers, 0, sizeof(ObjHeaders));
+
+    int exportMaterials = gModel.options->exportFlags & EXPT_OUTPUT_MATERIALS;
+    int mkGroupsObjs = (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MAKE_GROUPS_OBJECTS);
+    // is this the first set of geometry in the file?
+    bool firstTile = (gModel.vertexIndexBase == 0);
+
 #ifdef OUTPUT_NORMALS
     // write out normals, texture coordinates, vertices, and then faces grouped by material
-    for (i = 0; i < gModel.normalListCount; i++)
-    {
-        sprintf_s(outputString, 256, "vn %g %g %g\n", gModel.normals[i][0], gModel.normals[i][1], gModel.normals[i][2]);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-    }
+    retCode |= writeOBJLines(gModel.normalListCount - firstNormal, NULL, 0.0f, [&](int normal, ObjText* pText) -> bool {
+        char* dst = reserveObjText(pText, OBJ_LINE_ROOM);
+        if (dst == NULL)
+            return false;
+        normal += firstNormal;
+        pText->used += OutBuf_Sprintf(dst, OBJ_LINE_ROOM, "vn %g %g %g\n", gModel.normals[normal][0], gModel.normals[normal][1], gModel.normals[normal][2]);
+        return true;
+    });
+    if (retCode >= MW_BEGIN_ERRORS)
+        goto Exit;
 #endif
 
     if (gModel.exportTexture)
     {
         if (gModel.exportTiles) {
-            // go from the "UVs for one giant mosaic" to "UVs per tile" -
-            // happily, all coordinates are powers of two, so this process is lossless
-            retCode = mosaicUVtoSeparateUV();
-            if (retCode >= MW_BEGIN_ERRORS)
-                goto Exit;
-        }
-        else {
-            // just output as-is
-            int prevSwatch = -1;
-            for (i = 0; i < gModel.uvIndexCount; i++)
-            {
-                retCode |= writeOBJTextureUV(gModel.uvIndexList[i].uc, gModel.uvIndexList[i].vc, prevSwatch != gModel.uvIndexList[i].swatchLoc, gModel.uvIndexList[i].swatchLoc);
-                prevSwatch = gModel.uvIndexList[i].swatchLoc;
+            // the grid of UVs is written out just once, by the first tile when exporting in tiles
+            if (gModel.uvGridListCount == 0) {
+                if (gModel.exportInTiles) {
+                    // later tiles may use any location, so write them all
+                    for (i = 0; i < (NUM_UV_GRID_RESOLUTION + 1) * (NUM_UV_GRID_RESOLUTION + 1); i++) {
+                        gModel.uvGridList[i] = 1;
+                    }
+                }
+                // go from the "UVs for one giant mosaic" to "UVs per tile" -
+                // happily, all coordinates are powers of two, so this process is lossless
+                retCode = mosaicUVtoSeparateUV();
                 if (retCode >= MW_BEGIN_ERRORS)
                     goto Exit;
             }
         }
-    }
-
-    // every 5% update the progress
-    int noteProgress = 1 + (int)((float)gModel.vertexCount / (0.5f * gProgress.absolute.output / 0.05f));
-    wchar_t numString1[100];
-    wchar_t numString2[100];
-    prettifyNumber(gModel.vertexCount, numString2);
-    for (i = 0; i < gModel.vertexCount; i++)
-    {
-        if (i % noteProgress == noteProgress-1) {
-            prettifyNumber(i + 1, numString1);
-            swprintf_s(statusString, 1024, L"Writing %s of %s vertices", numString1, numString2);
-            UPDATE_STATUS(gProgress.start.output + gProgress.absolute.output * 0.5f * ((float)i / (float)gModel.vertexCount), statusString);
+        else {
+            // just output as-is, with a comment whenever the swatch changes
+            retCode |= writeOBJLines(gModel.uvIndexCount - firstUV, NULL, 0.0f, [&](int uv, ObjText* pText) -> bool {
+                char* dst = reserveObjText(pText, OBJ_LINE_ROOM);
+                if (dst == NULL)
+                    return false;
+                uv += firstUV;
+                int prevSwatch = (uv > 0) ? gModel.uvIndexList[uv - 1].swatchLoc : -1;
+                pText->used += formatOBJTextureUV(dst, OBJ_LINE_ROOM, gModel.uvIndexList[uv].uc, gModel.uvIndexList[uv].vc, prevSwatch != gModel.uvIndexList[uv].swatchLoc, gModel.uvIndexList[uv].swatchLoc);
+                return true;
+            });
+            if (retCode >= MW_BEGIN_ERRORS)
+                goto Exit;
         }
-
-        sprintf_s(outputString, 256, "v %g %g %g\n", gModel.vertices[i][X], gModel.vertices[i][Y], gModel.vertices[i][Z]);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
     }
 
+    retCode |= writeOBJLines(gModel.vertexCount, L"vertices", gProgress.start.output, [&](int vertex, ObjText* pText) -> bool {
+        char* dst = reserveObjText(pText, OBJ_LINE_ROOM);
+        if (dst == NULL)
+            return false;
+        pText->used += OutBuf_Sprintf(dst, OBJ_LINE_ROOM, "v %g %g %g\n", gModel.vertices[vertex][X], gModel.vertices[vertex][Y], gModel.vertices[vertex][Z]);
+        return true;
+    });
+    if (retCode >= MW_BEGIN_ERRORS)
+        goto Exit;
+
     prevType = -1;
     int prevDataVal = -1;
     int prevSwatchLoc = -1;
@@ -23985,10 +25556,13 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
     if (exportMaterials)
     {
         // should there be just one single material in this OBJ file?
-        if (!(gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MATERIAL_PER_BLOCK) && !gModel.exportTiles)
+        if (!(gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MATERIAL_PER_BLOCK) && !gModel.exportTiles && firstTile)
         {
-            sprintf_s(outputString, 256, "\nusemtl %s\n", MINECRAFT_SINGLE_MATERIAL);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            if (OutBuf_Printf(gModelFile, "\nusemtl %s\n", MINECRAFT_SINGLE_MATERIAL))
+            {
+                retCode |= MW_CANNOT_WRITE_TO_FILE;
+                goto Exit;
+            }
         }
     }
 
@@ -23996,21 +25570,12 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
     // for whether to search for a material change (but not necessarily make a group)
     bool subtypeMaterial = subtypeGroup || gModel.exportTiles;
 
-    // how often to update progress? # of faces per 5%
-    noteProgress = 1 + (int)((float)gModel.faceCount / (0.5f * gProgress.absolute.output / 0.05f));
-
-    prettifyNumber(gModel.faceCount, numString2);
+    // The group and material lines depend on the faces before them, and note which materials are used, so they
+    // are made first, in order; the face lines are then formatted in parallel, with these put in front of their faces.
     for (i = 0; i < gModel.faceCount; i++)
     {
         pFace = gModel.faceList[i];
 
-        // every 4% or so check on progress
-        if (i % noteProgress == noteProgress-1) {
-            prettifyNumber(i + 1, numString1);
-            swprintf_s(statusString, 1024, L"Writing %s of %s faces", numString1, numString2);
-            UPDATE_STATUS(gProgress.start.output + gProgress.absolute.output * 0.5f * (1.0f + ((float)i / (float)gModel.faceCount)), statusString);
-        }
-
         if (exportMaterials)
         {
             // should there be more than one material or group output in this OBJ file?
@@ -24028,7 +25593,8 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                     // New material definitely found, so make a new one to be output.
                     prevType = gModel.faceList[i]->materialType;
                     prevDataVal = gModel.faceList[i]->materialDataVal;
-                    prevSwatchLoc = gModel.uvIndexList[gModel.faceList[i]->uvIndex[0]].swatchLoc;
+                    // the swatch is only needed, and UVs only set, when exporting tiles
+                    prevSwatchLoc = gModel.exportTiles ? gModel.uvIndexList[gModel.faceList[i]->uvIndex[0]].swatchLoc : -1;
                     // New ID encountered, so output it: material name, and group.
                     // Group isn't really required, but can be useful.
                     // Output group only if we're not already using it for individual blocks.
@@ -24064,11 +25630,9 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                                 // Since the material can vary and repeat, use block names.
                                 // New group for each block (materials not sorted)
                                 if (mkGroupsObjs) {
-                                    sprintf_s(outputString, 256, "o block_%05d\n", groupCount + 1);   // don't increment it here
-                                    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                                    WERROR_HEADER(addOBJHeader(&headers, i, "o block_%05d\n", groupCount + 1));   // don't increment it here
                                 }
-                                sprintf_s(outputString, 256, "g block_%05d\n", ++groupCount);
-                                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                                WERROR_HEADER(addOBJHeader(&headers, i, "g block_%05d\n", ++groupCount));
                             }
 
                             // new material per tile ID
@@ -24076,8 +25640,7 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                             assert(prevSwatchLoc < TOTAL_TILES);
                             // TODO: could someday store mtlName in this same table; no need to convert every time
                             WcharToChar(gTilesTable[prevSwatchLoc].filename, mtlName, MAX_PATH_AND_FILE);
-                            sprintf_s(outputString, 256, "usemtl %s\n", mtlName);
-                            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                            WERROR_HEADER(addOBJHeader(&headers, i, "usemtl %s\n", mtlName));
                             // note in an array that this separate tile should be output as a material
                             gModel.tileList[CATEGORY_RGBA][prevSwatchLoc] = true;  // means has a texture
                             assert(gModel.mtlCount < NUM_SUBMATERIALS);
@@ -24088,14 +25651,11 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                             {
                                 // new group for objects of same type (which are sorted)
                                 if (mkGroupsObjs) {
-                                    sprintf_s(outputString, 256, "o %s\n", mtlName);
-                                    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                                    WERROR_HEADER(addOBJHeader(&headers, i, "o %s\n", mtlName));
                                 }
-                                sprintf_s(outputString, 256, "g %s\n", mtlName);
-                                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                                WERROR_HEADER(addOBJHeader(&headers, i, "g %s\n", mtlName));
                             }
-                            sprintf_s(outputString, 256, "\nusemtl %s\n", mtlName);
-                            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                            WERROR_HEADER(addOBJHeader(&headers, i, "\nusemtl %s\n", mtlName));
                             if (subtypeMaterial) {
                                 // We can't use outputMaterial, a simple array of types. We need to
                                 // instead check the whole previous list and see if the material's
@@ -24132,19 +25692,16 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                     else
                     {
                         // don't output by individual block: output by group, and/or by material, or by tile, or none at all (one material for scene)
-                        strcpy_s(outputString, 256, "\n");
-                        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                        WERROR_HEADER(addOBJHeader(&headers, i, "\n"));
 
                         // don't output group if just the tile ID differed and the block type didn't
                         if ((gModel.options->exportFlags & EXPT_OUTPUT_OBJ_SEPARATE_TYPES) && newGroupPossible)
                         {
                             // new group for objects of same type (which are sorted)
                             if (mkGroupsObjs) {
-                                sprintf_s(outputString, 256, "o %s\n", mtlName);
-                                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                                WERROR_HEADER(addOBJHeader(&headers, i, "o %s\n", mtlName));
                             }
-                            sprintf_s(outputString, 256, "g %s\n", mtlName);
-                            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                            WERROR_HEADER(addOBJHeader(&headers, i, "g %s\n", mtlName));
                         }
                         if (gModel.exportTiles) {
                             // new material per tile ID
@@ -24152,8 +25709,7 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                             assert(prevSwatchLoc < TOTAL_TILES);
                             WcharToChar(gTilesTable[prevSwatchLoc].filename, mtlName, MAX_PATH_AND_FILE);
                             assert(strlen(mtlName));    // if hit, means a bad swatchLoc was assigned
-                            sprintf_s(outputString, 256, "usemtl %s\n", mtlName);
-                            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                            WERROR_HEADER(addOBJHeader(&headers, i, "usemtl %s\n", mtlName));
                             // note in an array that this separate tile should be output as a material
                             gModel.tileList[CATEGORY_RGBA][prevSwatchLoc] = true;  // means has a texture
                             assert(gModel.mtlCount < NUM_SUBMATERIALS);
@@ -24161,10 +25717,13 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                         else if (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MATERIAL_PER_BLOCK)
                         {
                             // new material per family
-                            sprintf_s(outputString, 256, "usemtl %s\n", mtlName);
-                            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-                            gModel.mtlList[gModel.mtlCount++] = prevType << 8 | prevDataVal;
-                            assert(gModel.mtlCount < NUM_SUBMATERIALS);
+                            WERROR_HEADER(addOBJHeader(&headers, i, "usemtl %s\n", mtlName));
+                            // when exporting in tiles, an earlier tile may have already listed the material
+                            if (!gModel.exportInTiles || !isOBJMaterialListed(prevType, prevDataVal, subtypeMaterial))
+                            {
+                                gModel.mtlList[gModel.mtlCount++] = prevType << 8 | prevDataVal;
+                                assert(gModel.mtlCount < NUM_SUBMATERIALS);
+                            }
                         }
                         // else don't output material, there's only one for the whole scene
                     }
@@ -24172,9 +25731,6 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
             }
         }
 
-        ///////////////////////////////////////
-        // Output the actual face
-
         // if we're outputting each individual block in its own group, set a unique group name here.
         // TODO: slightly annoying, this means the material gets output before the group for tiled textures.
         // Doesn't matter for functionality, just looks a bit odd.
@@ -24199,279 +25755,337 @@ static int writeOBJBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedW
                 strcpy_s(typeName, 256, commentName);
             }
             // with number: sprintf_s(outputString, 256, "# type: %s %d\n", typeName, groupCount + 1);
-            sprintf_s(outputString, 256, "# type: %s\n", typeName);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_HEADER(addOBJHeader(&headers, i, "# type: %s\n", typeName));
 
             if (mkGroupsObjs) {
-                sprintf_s(outputString, 256, "o block_%05d\n", groupCount + 1);   // don't increment it here
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_HEADER(addOBJHeader(&headers, i, "o block_%05d\n", groupCount + 1));   // don't increment it here
             }
-            sprintf_s(outputString, 256, "g block_%05d\n", ++groupCount);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_HEADER(addOBJHeader(&headers, i, "g block_%05d\n", ++groupCount));
         }
+    }
 
+    ///////////////////////////////////////
+    // Output the actual faces
+    retCode |= writeOBJLines(gModel.faceCount, L"faces", gProgress.start.output + gProgress.absolute.output * 0.5f,
+        [&](int face, ObjText* pText) -> bool {
+            char* dst;
+            int header = findOBJHeader(&headers, face);
+            if (header >= 0) {
+                size_t length = ((header + 1 < headers.count) ? headers.start[header + 1] : headers.text.used) - headers.start[header];
+                dst = reserveObjText(pText, length);
+                if (dst == NULL)
+                    return false;
+                memcpy(dst, headers.text.text + headers.start[header], length);
+                pText->used += length;
+            }
+            dst = reserveObjText(pText, OBJ_LINE_ROOM);
+            if (dst == NULL)
+                return false;
+            pText->used += formatOBJFace(dst, OBJ_LINE_ROOM, gModel.faceList[face], absoluteIndices);
+            return true;
+        });
+
+Exit:
+    freeObjHeaders(&headers);
+    return retCode;
+}
+
+// Close the OBJ file and, if all went well, write out its materials file.
+static int endOBJFile(int retCode)
+{
+    if (OutBuf_Close(gModelFile))
+        retCode |= MW_CANNOT_WRITE_TO_FILE;
+
+    // should we call it a day here?
+    if (retCode >= MW_BEGIN_ERRORS) return retCode;
+
+    // write materials file
+    if (gModel.options->exportFlags & EXPT_OUTPUT_MATERIALS)
+    {
+        // write material file
+        retCode |= writeOBJMtlFile();
+        if (retCode >= MW_BEGIN_ERRORS) return retCode;
+    }
+
+    return retCode;
+}
+
+// Is the material already in the list for the materials file? Only the type is checked, unless subtypes are separate materials.
+static bool isOBJMaterialListed(int type, int dataVal, bool subtypeMaterial)
+{
+    for (int i = 0; i < gModel.mtlCount; i++)
+    {
+        if (subtypeMaterial ? (gModel.mtlList[i] == (unsigned int)(type << 8 | dataVal)) : ((int)(gModel.mtlList[i] >> 8) == type))
+            return true;
+    }
+    return false;
+}
+
+// Format a face's "f" line into dst, returning its length. Called by several threads at once.
+static int formatOBJFace(char* dst, size_t size, FaceRecord* pFace, int absoluteIndices)
+{
+    int length = 0;
+    int j, index;
+    // when exporting in tiles, the vertices written out by earlier tiles come first
+    int firstVertex = gModel.vertexIndexBase + 1;
+    int vt[4];
 #ifdef OUTPUT_NORMALS
-        assert(pFace->normalIndex >= 0);
-        if (absoluteIndices)
-        {
-            outputFaceDirection = pFace->normalIndex + 1;
-        }
-        else
-        {
-            outputFaceDirection = pFace->normalIndex - gModel.normalListCount;
-        }
+    int outputFaceDirection;
 #endif
 
-        // First, are there texture coordinates?
-        if (gModel.exportTexture)
-        {
 #ifdef OUTPUT_NORMALS
-            // if output per tile, then we use the UV values to find the index to the new index in the grid
-            if (gModel.exportTiles) {
-                // decode swatch coordinates into a canonical index
-                for (j = 0; j < 4; j++) {
-                    // is it a swatch value, or a simplify extended value? [2] is always a non- [0,1] range UV index. So confusing... :)
-                    // Negative indices means "negate and use this value-1 as an X & Y indexed location"
-                    if (pFace->uvIndex[j] >= 0) {
-                        index = (int)((((int)(gModel.uvIndexList[pFace->uvIndex[j]].uc * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale) +
-                            (NUM_UV_GRID_RESOLUTION + 1) * (int)(16 - ((((int)((1.0f - gModel.uvIndexList[pFace->uvIndex[j]].vc) * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale));
-                        vt[j] = gModel.uvGridList[index];
-                    }
-                    else {
-                        // super-simple: we have the index already, encoded as a negative number minus one. Just negate and subtract one from it.
-                        index = -pFace->uvIndex[j] - 1;
-                        vt[j] = gModel.simplifyUVGridList[index];
-                    }
+    assert(pFace->normalIndex >= 0);
+    if (absoluteIndices)
+    {
+        outputFaceDirection = pFace->normalIndex + 1;
+    }
+    else
+    {
+        outputFaceDirection = pFace->normalIndex - gModel.normalListCount;
+    }
+#endif
+
+    // First, are there texture coordinates?
+    if (gModel.exportTexture)
+    {
+#ifdef OUTPUT_NORMALS
+        // if output per tile, then we use the UV values to find the index to the new index in the grid
+        if (gModel.exportTiles) {
+            // decode swatch coordinates into a canonical index
+            for (j = 0; j < 4; j++) {
+                // is it a swatch value, or a simplify extended value? [2] is always a non- [0,1] range UV index. So confusing... :)
+                // Negative indices means "negate and use this value-1 as an X & Y indexed location"
+                if (pFace->uvIndex[j] >= 0) {
+                    index = (int)((((int)(gModel.uvIndexList[pFace->uvIndex[j]].uc * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale) +
+                        (NUM_UV_GRID_RESOLUTION + 1) * (int)(16 - ((((int)((1.0f - gModel.uvIndexList[pFace->uvIndex[j]].vc) * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale));
+                    vt[j] = gModel.uvGridList[index];
                 }
-            }
-            else {
-                // else just get the UVs
-                for (j = 0; j < 4; j++) {
-                    vt[j] = pFace->uvIndex[j] + 1;
+                else {
+                    // super-simple: we have the index already, encoded as a negative number minus one. Just negate and subtract one from it.
+                    index = -pFace->uvIndex[j] - 1;
+                    vt[j] = gModel.simplifyUVGridList[index];
                 }
             }
+        }
+        else {
+            // else just get the UVs
+            for (j = 0; j < 4; j++) {
+                vt[j] = pFace->uvIndex[j] + 1;
+            }
+        }
 
-            // with normals - not really needed by most renderers, but good to include;
-            // GLC, for example, does smoothing if normals are not present.
-            // Check if last two vertices match - if so, output a triangle instead 
-            if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        // with normals - not really needed by most renderers, but good to include;
+        // GLC, for example, does smoothing if normals are not present.
+        // Check if last two vertices match - if so, output a triangle instead 
+        if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        {
+            // triangle
+            if (absoluteIndices)
             {
-                // triangle
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
-                        pFace->vertexIndex[0] + 1, vt[0], outputFaceDirection,
-                        pFace->vertexIndex[1] + 1, vt[1], outputFaceDirection,
-                        pFace->vertexIndex[2] + 1, vt[2], outputFaceDirection
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1, outputFaceDirection,
-                        pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1, outputFaceDirection,
-                        pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1, outputFaceDirection
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                    pFace->vertexIndex[0] + firstVertex, vt[0], outputFaceDirection,
+                    pFace->vertexIndex[1] + firstVertex, vt[1], outputFaceDirection,
+                    pFace->vertexIndex[2] + firstVertex, vt[2], outputFaceDirection
+                );
             }
             else
             {
-                // Output a quad
-                // if normal sums negative, rotate order by one so that dumb tessellators
-                // match up the faces better, which should make matching face removal work better. I hope.
-                int offset = 0;
-                assert(pFace->normalIndex >= 0);
-                int idx = pFace->normalIndex;
-                if (gModel.normals[idx][X] + gModel.normals[idx][Y] + gModel.normals[idx][Z] < 0.0f)
-                    offset = 1;
+                length = OutBuf_Sprintf(dst, size, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1, outputFaceDirection,
+                    pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1, outputFaceDirection,
+                    pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1, outputFaceDirection
+                );
+            }
+        }
+        else
+        {
+            // Output a quad
+            // if normal sums negative, rotate order by one so that dumb tessellators
+            // match up the faces better, which should make matching face removal work better. I hope.
+            int offset = 0;
+            assert(pFace->normalIndex >= 0);
+            int idx = pFace->normalIndex;
+            if (gModel.normals[idx][X] + gModel.normals[idx][Y] + gModel.normals[idx][Z] < 0.0f)
+                offset = 1;
 
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
-                        pFace->vertexIndex[offset] + 1, vt[offset], outputFaceDirection,
-                        pFace->vertexIndex[offset + 1] + 1, vt[offset + 1], outputFaceDirection,
-                        pFace->vertexIndex[offset + 2] + 1, vt[offset + 2], outputFaceDirection,
-                        pFace->vertexIndex[(offset + 3) % 4] + 1, vt[(offset + 3) % 4], outputFaceDirection
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
-                        pFace->vertexIndex[offset] - gModel.vertexCount, vt[offset] - gModel.uvIndexCount - 1, outputFaceDirection,
-                        pFace->vertexIndex[offset + 1] - gModel.vertexCount, vt[offset + 1] - gModel.uvIndexCount - 1, outputFaceDirection,
-                        pFace->vertexIndex[offset + 2] - gModel.vertexCount, vt[offset + 2] - gModel.uvIndexCount - 1, outputFaceDirection,
-                        pFace->vertexIndex[(offset + 3) % 4] - gModel.vertexCount, vt[(offset + 3) % 4] - gModel.uvIndexCount - 1, outputFaceDirection
-                    );
-                }
+            if (absoluteIndices)
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                    pFace->vertexIndex[offset] + firstVertex, vt[offset], outputFaceDirection,
+                    pFace->vertexIndex[offset + 1] + firstVertex, vt[offset + 1], outputFaceDirection,
+                    pFace->vertexIndex[offset + 2] + firstVertex, vt[offset + 2], outputFaceDirection,
+                    pFace->vertexIndex[(offset + 3) % 4] + firstVertex, vt[(offset + 3) % 4], outputFaceDirection
+                );
+            }
+            else
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                    pFace->vertexIndex[offset] - gModel.vertexCount, vt[offset] - gModel.uvIndexCount - 1, outputFaceDirection,
+                    pFace->vertexIndex[offset + 1] - gModel.vertexCount, vt[offset + 1] - gModel.uvIndexCount - 1, outputFaceDirection,
+                    pFace->vertexIndex[offset + 2] - gModel.vertexCount, vt[offset + 2] - gModel.uvIndexCount - 1, outputFaceDirection,
+                    pFace->vertexIndex[(offset + 3) % 4] - gModel.vertexCount, vt[(offset + 3) % 4] - gModel.uvIndexCount - 1, outputFaceDirection
+                );
             }
+        }
 #else
-            // check if last two vertices match - if so, output a triangle instead 
-            if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        // check if last two vertices match - if so, output a triangle instead 
+        if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        {
+            // triangle
+            if (absoluteIndices)
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d %d/%d %d/%d\n",
+                    pFace->vertexIndex[0] + firstVertex, vt[0],
+                    pFace->vertexIndex[1] + firstVertex, vt[1],
+                    pFace->vertexIndex[2] + firstVertex, vt[2]
+                );
+            }
+            else
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d %d/%d %d/%d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1,
+                    pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1,
+                    pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1
+                );
+            }
+        }
+        else
+        {
+            if (absoluteIndices)
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d %d/%d %d/%d %d/%d\n",
+                    pFace->vertexIndex[0] + firstVertex, vt[0],
+                    pFace->vertexIndex[1] + firstVertex, vt[1],
+                    pFace->vertexIndex[2] + firstVertex, vt[2],
+                    pFace->vertexIndex[3] + firstVertex, vt[3]
+                );
+            }
+            else
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d/%d %d/%d %d/%d %d/%d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1,
+                    pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1,
+                    pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1,
+                    pFace->vertexIndex[3] - gModel.vertexCount, vt[3] - gModel.uvIndexCount - 1
+                );
+            }
+        }
+#endif
+    }
+    else
+    {
+#ifdef OUTPUT_NORMALS
+        // check if last two vertices match - if so, output a triangle instead 
+        if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        {
+            // triangle
+            if (absoluteIndices)
             {
-                // triangle
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d/%d %d/%d %d/%d\n",
-                        pFace->vertexIndex[0] + 1, vt[0],
-                        pFace->vertexIndex[1] + 1, vt[1],
-                        pFace->vertexIndex[2] + 1, vt[2]
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d/%d %d/%d %d/%d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1,
-                        pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1,
-                        pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d//%d %d//%d %d//%d\n",
+                    pFace->vertexIndex[0] + firstVertex, outputFaceDirection,
+                    pFace->vertexIndex[1] + firstVertex, outputFaceDirection,
+                    pFace->vertexIndex[2] + firstVertex, outputFaceDirection
+                );
             }
             else
             {
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d/%d %d/%d %d/%d %d/%d\n",
-                        pFace->vertexIndex[0] + 1, vt[0],
-                        pFace->vertexIndex[1] + 1, vt[1],
-                        pFace->vertexIndex[2] + 1, vt[2],
-                        pFace->vertexIndex[3] + 1, vt[3]
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d/%d %d/%d %d/%d %d/%d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount, vt[0] - gModel.uvIndexCount - 1,
-                        pFace->vertexIndex[1] - gModel.vertexCount, vt[1] - gModel.uvIndexCount - 1,
-                        pFace->vertexIndex[2] - gModel.vertexCount, vt[2] - gModel.uvIndexCount - 1,
-                        pFace->vertexIndex[3] - gModel.vertexCount, vt[3] - gModel.uvIndexCount - 1
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d//%d %d//%d %d//%d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount, outputFaceDirection,
+                    pFace->vertexIndex[1] - gModel.vertexCount, outputFaceDirection,
+                    pFace->vertexIndex[2] - gModel.vertexCount, outputFaceDirection
+                );
             }
-#endif
         }
         else
         {
-#ifdef OUTPUT_NORMALS
-            // check if last two vertices match - if so, output a triangle instead 
-            if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
-            {
-                // triangle
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d//%d %d//%d %d//%d\n",
-                        pFace->vertexIndex[0] + 1, outputFaceDirection,
-                        pFace->vertexIndex[1] + 1, outputFaceDirection,
-                        pFace->vertexIndex[2] + 1, outputFaceDirection
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d//%d %d//%d %d//%d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount, outputFaceDirection,
-                        pFace->vertexIndex[1] - gModel.vertexCount, outputFaceDirection,
-                        pFace->vertexIndex[2] - gModel.vertexCount, outputFaceDirection
-                    );
-                }
+            // Output a quad
+            // if normal sums negative, rotate order by one so that dumb tessellators
+            // match up the faces better, which should make matching face removal work better. I hope.
+            int offset = 0;
+            assert(pFace->normalIndex >= 0);
+            int idx = pFace->normalIndex;
+            if (gModel.normals[idx][X] + gModel.normals[idx][Y] + gModel.normals[idx][Z] < 0.0f)
+                offset = 1;
+            if (absoluteIndices)
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d//%d %d//%d %d//%d %d//%d\n",
+                    pFace->vertexIndex[offset] + firstVertex, outputFaceDirection,
+                    pFace->vertexIndex[offset + 1] + firstVertex, outputFaceDirection,
+                    pFace->vertexIndex[offset + 2] + firstVertex, outputFaceDirection,
+                    pFace->vertexIndex[(offset + 3) % 4] + firstVertex, outputFaceDirection
+                );
             }
             else
             {
-                // Output a quad
-                // if normal sums negative, rotate order by one so that dumb tessellators
-                // match up the faces better, which should make matching face removal work better. I hope.
-                int offset = 0;
-                assert(pFace->normalIndex >= 0);
-                int idx = pFace->normalIndex;
-                if (gModel.normals[idx][X] + gModel.normals[idx][Y] + gModel.normals[idx][Z] < 0.0f)
-                    offset = 1;
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d//%d %d//%d %d//%d %d//%d\n",
-                        pFace->vertexIndex[offset] + 1, outputFaceDirection,
-                        pFace->vertexIndex[offset + 1] + 1, outputFaceDirection,
-                        pFace->vertexIndex[offset + 2] + 1, outputFaceDirection,
-                        pFace->vertexIndex[(offset + 3) % 4] + 1, outputFaceDirection
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d//%d %d//%d %d//%d %d//%d\n",
-                        pFace->vertexIndex[offset] - gModel.vertexCount, outputFaceDirection,
-                        pFace->vertexIndex[offset + 1] - gModel.vertexCount, outputFaceDirection,
-                        pFace->vertexIndex[offset + 2] - gModel.vertexCount, outputFaceDirection,
-                        pFace->vertexIndex[(offset + 3) % 4] - gModel.vertexCount, outputFaceDirection
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d//%d %d//%d %d//%d %d//%d\n",
+                    pFace->vertexIndex[offset] - gModel.vertexCount, outputFaceDirection,
+                    pFace->vertexIndex[offset + 1] - gModel.vertexCount, outputFaceDirection,
+                    pFace->vertexIndex[offset + 2] - gModel.vertexCount, outputFaceDirection,
+                    pFace->vertexIndex[(offset + 3) % 4] - gModel.vertexCount, outputFaceDirection
+                );
             }
+        }
 #else
-            // check if last two vertices match - if so, output a triangle instead 
-            if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        // check if last two vertices match - if so, output a triangle instead 
+        if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
+        {
+            // triangle
+            if (absoluteIndices)
             {
-                // triangle
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d %d %d\n",
-                        pFace->vertexIndex[0] + 1,
-                        pFace->vertexIndex[1] + 1,
-                        pFace->vertexIndex[2] + 1
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d %d %d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount,
-                        pFace->vertexIndex[1] - gModel.vertexCount,
-                        pFace->vertexIndex[2] - gModel.vertexCount
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d %d %d\n",
+                    pFace->vertexIndex[0] + firstVertex,
+                    pFace->vertexIndex[1] + firstVertex,
+                    pFace->vertexIndex[2] + firstVertex
+                );
             }
             else
             {
-                if (absoluteIndices)
-                {
-                    sprintf_s(outputString, 256, "f %d %d %d %d\n",
-                        pFace->vertexIndex[0] + 1,
-                        pFace->vertexIndex[1] + 1,
-                        pFace->vertexIndex[2] + 1,
-                        pFace->vertexIndex[3] + 1
-                    );
-                }
-                else
-                {
-                    sprintf_s(outputString, 256, "f %d %d %d %d\n",
-                        pFace->vertexIndex[0] - gModel.vertexCount,
-                        pFace->vertexIndex[1] - gModel.vertexCount,
-                        pFace->vertexIndex[2] - gModel.vertexCount,
-                        pFace->vertexIndex[3] - gModel.vertexCount
-                    );
-                }
+                length = OutBuf_Sprintf(dst, size, "f %d %d %d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount,
+                    pFace->vertexIndex[1] - gModel.vertexCount,
+                    pFace->vertexIndex[2] - gModel.vertexCount
+                );
             }
-#endif
         }
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-    }
-
-Exit:
-    PortaClose(gModelFile);
-
-    // should we call it a day here?
-    if (retCode >= MW_BEGIN_ERRORS) return retCode;
-
-    // write materials file
-    if (exportMaterials)
-    {
-        // write material file
-        retCode |= writeOBJMtlFile();
-        if (retCode >= MW_BEGIN_ERRORS) return retCode;
+        else
+        {
+            if (absoluteIndices)
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d %d %d %d\n",
+                    pFace->vertexIndex[0] + firstVertex,
+                    pFace->vertexIndex[1] + firstVertex,
+                    pFace->vertexIndex[2] + firstVertex,
+                    pFace->vertexIndex[3] + firstVertex
+                );
+            }
+            else
+            {
+                length = OutBuf_Sprintf(dst, size, "f %d %d %d %d\n",
+                    pFace->vertexIndex[0] - gModel.vertexCount,
+                    pFace->vertexIndex[1] - gModel.vertexCount,
+                    pFace->vertexIndex[2] - gModel.vertexCount,
+                    pFace->vertexIndex[3] - gModel.vertexCount
+                );
+            }
+        }
+#endif
     }
-
-    return retCode;
+    return length;
 }
 
-
 static int writeOBJTextureUV(float u, float v, int addComment, int swatchLoc)
 {
     char outputString[1024];
 
+    int length = formatOBJTextureUV(outputString, 1024, u, v, addComment, swatchLoc);
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, length));
+
+    return MW_NO_ERROR;
+}
+
+// Format a "vt" line, with a comment in front if asked, into dst, returning its length. Called by several threads at once.
+static int formatOBJTextureUV(char* dst, size_t size, float u, float v, int addComment, int swatchLoc)
+{
     // we go a bit nuts with the precision here, not sure it helps, but can't hurt; used to use just "%g"
     if (addComment)
     {
@@ -24479,25 +26093,19 @@ static int writeOBJTextureUV(float u, float v, int addComment, int swatchLoc)
             char outName[MAX_PATH_AND_FILE];
             WcharToChar(gTilesTable[swatchLoc].filename, outName, MAX_PATH_AND_FILE);
             assert(strlen(outName) > 0);
-            sprintf_s(outputString, 1024, "# %s\nvt %.9f %.9f\n",
+            return OutBuf_Sprintf(dst, size, "# %s\nvt %.9f %.9f\n",
                 outName,
                 u, v);
         }
         else {
             // old "by block" code, not really useful - better to use tiles.h name
-            sprintf_s(outputString, 1024, "# %s type\nvt %.9f %.9f\n",
+            return OutBuf_Sprintf(dst, size, "# %s type\nvt %.9f %.9f\n",
                 gBlockDefinitions[gModel.uvSwatchToType[swatchLoc]].name,
                 u, v);
         }
     }
-    else
-    {
-        sprintf_s(outputString, 1024, "vt %.9f %.9f\n",
-            u, v);
-    }
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-
-    return MW_NO_ERROR;
+    return OutBuf_Sprintf(dst, size, "vt %.9f %.9f\n",
+        u, v);
 }
 
 
@@ -25967,6 +27575,8 @@ static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tigh
     addOutputFilenameToList(stlFileNameWithSuffix);
     if (gModelFile == INVALID_HANDLE_VALUE)
         return MW_CANNOT_CREATE_FILE;
+    // collect the output and write it out in large pieces; if this fails, everything is written directly
+    OutBuf_Attach(gModelFile);
 
     convertWcharPathUnderlined(worldNameUnderlined, pWorldGuide->world, false);
 
@@ -25977,11 +27587,11 @@ static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tigh
         // make it all 0x20 as we will output exactly 80 characters
         strcpy_s(outputString, 256, "COLOR=");
         // start to write file
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, 6));
-        WERROR_MODEL(PortaWrite(gModelFile, &allFF, 4));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, 6));
+        WERROR_MODEL(OutBuf_Write(gModelFile, &allFF, 4));
         // in the example file, all the rest was 0x20's (space)
         memset(outputString, 0x20, 256);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, 70));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, 70));
     }
     else
     {
@@ -25992,11 +27602,11 @@ static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tigh
             worldBox->min[X], worldBox->min[Y], worldBox->min[Z],
             worldBox->max[X], worldBox->max[Y], worldBox->max[Z]);
         // start to write file
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, 80));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, 80));
     }
 
     // number of triangles in model, unsigned int
-    WERROR_MODEL(PortaWrite(gModelFile, &numTri, 4));
+    WERROR_MODEL(OutBuf_Write(gModelFile, &numTri, 4));
 
     int noteProgress = 1 + (int)((float)gModel.faceCount / (gProgress.absolute.output / 0.04f));
 
@@ -26037,12 +27647,12 @@ static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tigh
         for (i = 0; i < faceTriCount; i++)
         {
             // 3 float normals
-            WERROR_MODEL(PortaWrite(gModelFile, &gModel.normals[pFace->normalIndex], 12));
+            WERROR_MODEL(OutBuf_Write(gModelFile, &gModel.normals[pFace->normalIndex], 12));
 
             // two triangles: 0 1 2 and 0 2 3 (or 1 2 3 and 1 3 0)
-            WERROR_MODEL(PortaWrite(gModelFile, vertex[offset], 12));
-            WERROR_MODEL(PortaWrite(gModelFile, vertex[offset + i + 1], 12));
-            WERROR_MODEL(PortaWrite(gModelFile, vertex[(offset + i + 2) % 4], 12));
+            WERROR_MODEL(OutBuf_Write(gModelFile, vertex[offset], 12));
+            WERROR_MODEL(OutBuf_Write(gModelFile, vertex[offset + i + 1], 12));
+            WERROR_MODEL(OutBuf_Write(gModelFile, vertex[(offset + i + 2) % 4], 12));
 
             if (writeColor)
             {
@@ -26074,12 +27684,13 @@ static int writeBinarySTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tigh
                     outColor = (1 << 15) | (r << 10) | (g << 5) | b;
                 }
             }
-            WERROR_MODEL(PortaWrite(gModelFile, &outColor, 2));
+            WERROR_MODEL(OutBuf_Write(gModelFile, &outColor, 2));
         }
     }
 
     // if not ok, then we will have closed the file earlier
-    PortaClose(gModelFile);
+    if (OutBuf_Close(gModelFile))
+        return MW_CANNOT_WRITE_TO_FILE;
 
     concatFileName3(statsFileName, gOutputFilePath, gOutputFileRoot, L".txt");
 
@@ -26123,6 +27734,8 @@ static int writeAsciiSTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tight
     addOutputFilenameToList(stlFileNameWithSuffix);
     if (gModelFile == INVALID_HANDLE_VALUE)
         return MW_CANNOT_CREATE_FILE;
+    // collect the output and write it out in large pieces; if this fails, everything is written directly
+    OutBuf_Attach(gModelFile);
 
     convertWcharPathUnderlined(worldNameUnderlined, pWorldGuide->world, false);
 
@@ -26131,7 +27744,7 @@ static int writeAsciiSTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tight
         worldBox->min[X], worldBox->min[Y], worldBox->min[Z],
         worldBox->max[X], worldBox->max[Y], worldBox->max[Z]);
     // start to write file
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     char facetNormalString[NORMAL_LIST_SIZE][256];
     for (i = 0; i < gModel.normalListCount; i++)
@@ -26188,29 +27801,26 @@ static int writeAsciiSTLBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tight
 
         for (i = 0; i < faceTriCount; i++)
         {
-            WERROR_MODEL(PortaWrite(gModelFile, facetNormalString[normalIndex], strlen(facetNormalString[normalIndex])));
-            WERROR_MODEL(PortaWrite(gModelFile, "outer loop\n", strlen("outer loop\n")));
+            WERROR_MODEL(OutBuf_Write(gModelFile, facetNormalString[normalIndex], strlen(facetNormalString[normalIndex])));
+            WERROR_MODEL(OutBuf_Write(gModelFile, "outer loop\n", strlen("outer loop\n")));
 
             // two triangles: 0 1 2 and 0 2 3 (or 1 2 3 and 1 3 0)
             pt = vertex[offset];
-            sprintf_s(outputString, 256, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z]));
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z])));
             pt = vertex[(offset + i + 1) % 4];	// shouldn't need % 4, but let's be safe, and makes cppcheck happy
-            sprintf_s(outputString, 256, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z]));
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z])));
             pt = vertex[(offset + i + 2) % 4];  // cppcheck-suppress 457 - no, this really is initialized
-            sprintf_s(outputString, 256, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z]));
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "vertex  %e %e %e\n", (double)((*pt)[X]), (double)((*pt)[Y]), (double)((*pt)[Z])));
 
-            WERROR_MODEL(PortaWrite(gModelFile, "endloop\nendfacet\n", strlen("endloop\nendfacet\n")));
+            WERROR_MODEL(OutBuf_Write(gModelFile, "endloop\nendfacet\n", strlen("endloop\nendfacet\n")));
         }
     }
 
-    sprintf_s(outputString, 256, "endsolid %s\n", worldNameUnderlined);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Printf(gModelFile, "endsolid %s\n", worldNameUnderlined));
 
     // if not ok, then we will have closed the file earlier
-    PortaClose(gModelFile);
+    if (OutBuf_Close(gModelFile))
+        return MW_CANNOT_WRITE_TO_FILE;
 
     concatFileName3(statsFileName, gOutputFilePath, gOutputFileRoot, L".txt");
 
@@ -26270,6 +27880,8 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
     addOutputFilenameToList(wrlFileNameWithSuffix);
     if (gModelFile == INVALID_HANDLE_VALUE)
         return retCode | MW_CANNOT_CREATE_FILE;
+    // collect the output and write it out in large pieces; if this fails, everything is written directly
+    OutBuf_Attach(gModelFile);
 
     exportSolidColors = ((gModel.options->exportFlags & EXPT_OUTPUT_MATERIALS) && !gModel.exportTexture) ? true : false;
 
@@ -26279,8 +27891,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
     WcharToChar(pWorldGuide->world, worldChar, MAX_PATH_AND_FILE);
     justWorldFileName = removePathChar(worldChar);
 
-    sprintf_s(outputString, 256, "#VRML V2.0 utf8\n\n# VRML 97 (VRML2) file made by Mineways version %d.%02d, http://mineways.com\n", gMinewaysMajorVersion, gMinewaysMinorVersion);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Printf(gModelFile, "#VRML V2.0 utf8\n\n# VRML 97 (VRML2) file made by Mineways version %d.%02d, http://mineways.com\n", gMinewaysMajorVersion, gMinewaysMinorVersion));
 
     retCode |= writeStatistics(gModelFile, NULL, pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
     if (retCode >= MW_BEGIN_ERRORS)
@@ -26295,7 +27906,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
     //for ( i = 0; i < 6; i++ )
     //{
     //    sprintf_s(outputString,256,"vn %g %g %g\n", gModel.normals[i][0], gModel.normals[i][1], gModel.normals[i][2]);
-    //    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     //}
 
     // output vertex coordinate loops
@@ -26331,19 +27942,18 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
             strcpy_s(mtlName, 256, gBlockDefinitions[gModel.faceList[currentFace]->materialType].name);
             changeCharToUnderline(' ', mtlName);
         }
-        sprintf_s(outputString, 256, shapeString,
+        WERROR_MODEL(OutBuf_Printf(gModelFile, shapeString,
             mtlName,
             gModel.print3D ? "TRUE" : "FALSE",
             firstShape ? "DEF" : "USE",
-            firstShape ? " Coordinate" : "");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            firstShape ? " Coordinate" : ""));
 
         // if first shape, output coords and texture coords
         if (firstShape)
         {
             // Note that we just dump everything to a single indexed face set coordinate list, which then gets reused
             strcpy_s(outputString, 256, "        {\n          point\n          [\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             int noteProgress = 1 + (int)((float)gModel.vertexCount / (0.5f * gProgress.absolute.output / 0.04f));
             for (j = 0; j < gModel.vertexCount; j++)
@@ -26355,13 +27965,13 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
                 if (j == gModel.vertexCount - 1)
                 {
                     // no comma at end
-                    sprintf_s(outputString, 256, "            %g %g %g\n", gModel.vertices[j][X], gModel.vertices[j][Y], gModel.vertices[j][Z]);
+                    OutBuf_Sprintf(outputString, 256, "            %g %g %g\n", gModel.vertices[j][X], gModel.vertices[j][Y], gModel.vertices[j][Z]);
                 }
                 else
                 {
-                    sprintf_s(outputString, 256, "            %g %g %g,\n", gModel.vertices[j][X], gModel.vertices[j][Y], gModel.vertices[j][Z]);
+                    OutBuf_Sprintf(outputString, 256, "            %g %g %g,\n", gModel.vertices[j][X], gModel.vertices[j][Y], gModel.vertices[j][Z]);
                 }
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             }
 
             // textures need texture coordinates output, only needed when texturing
@@ -26370,7 +27980,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
                 int prevSwatch = -1;
                 int k;
                 strcpy_s(outputString, 256, "          ]\n        }\n        texCoord DEF texCoord_Craft TextureCoordinate\n        {\n          point\n          [\n");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
                 for (k = 0; k < gModel.uvIndexCount; k++)
                 {
@@ -26382,14 +27992,14 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
             }
             // close up coordinates themselves
             strcpy_s(outputString, 256, "          ]\n        }\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         }
         else
         {
             if (gModel.exportTexture)
             {
                 strcpy_s(outputString, 256, "        texCoord USE texCoord_Craft\n");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             }
         }
 
@@ -26398,7 +28008,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
         dataVal = exportSingleMaterial ? 0x0 : gModel.faceList[currentFace]->materialDataVal;
 
         strcpy_s(outputString, 256, "        coordIndex\n        [\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
         // output face loops until next material is found, or all, if exporting no material
         while ((currentFace < gModel.faceCount) &&
@@ -26416,7 +28026,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
             if (pFace->vertexIndex[2] == pFace->vertexIndex[3])
             {
                 // export triangle
-                sprintf_s(outputString, 256, "          %d,%d,%d,-1%s\n",
+                OutBuf_Sprintf(outputString, 256, "          %d,%d,%d,-1%s\n",
                     pFace->vertexIndex[0],
                     pFace->vertexIndex[1],
                     pFace->vertexIndex[2],
@@ -26432,14 +28042,14 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
                 int i = pFace->normalIndex;
                 if (gModel.normals[i][X] + gModel.normals[i][Y] + gModel.normals[i][Z] < 0.0f)
                     offset = 1;
-                sprintf_s(outputString, 256, "          %d,%d,%d,%d,-1%s\n",
+                OutBuf_Sprintf(outputString, 256, "          %d,%d,%d,%d,-1%s\n",
                     pFace->vertexIndex[offset],
                     pFace->vertexIndex[offset + 1],
                     pFace->vertexIndex[offset + 2],
                     pFace->vertexIndex[(offset + 3) % 4],
                     commaString);
             }
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             currentFace++;
         }
@@ -26448,7 +28058,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
         if (gModel.exportTexture)
         {
             strcpy_s(outputString, 256, "        ]\n        texCoordIndex\n        [\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             endIndex = currentFace;
 
@@ -26460,7 +28070,7 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
 
                 if (pFace->uvIndex[2] == pFace->uvIndex[3])
                 {
-                    sprintf_s(outputString, 256, "          %d %d %d -1\n",
+                    OutBuf_Sprintf(outputString, 256, "          %d %d %d -1\n",
                         pFace->uvIndex[0],
                         pFace->uvIndex[1],
                         pFace->uvIndex[2]);
@@ -26475,19 +28085,19 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
                     int i = pFace->normalIndex;
                     if (gModel.normals[i][X] + gModel.normals[i][Y] + gModel.normals[i][Z] < 0.0f)
                         offset = 1;
-                    sprintf_s(outputString, 256, "          %d %d %d %d -1\n",
+                    OutBuf_Sprintf(outputString, 256, "          %d %d %d %d -1\n",
                         pFace->uvIndex[offset],
                         pFace->uvIndex[offset + 1],
                         pFace->uvIndex[offset + 2],
                         pFace->uvIndex[(offset + 3) % 4]);
                 }
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             }
         }
 
         // close up the geometry
         strcpy_s(outputString, 256, "        ]\n      }\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
         // now output material
         // - if a single material or if textures are output, we use the GENERIC_MATERIAL for the type to output
@@ -26503,17 +28113,18 @@ static int writeVRML2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightene
 
         // close up shape
         strcpy_s(outputString, 256, "    }\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
         firstShape = 0;
     }
 
     // close up Transform children
     strcpy_s(outputString, 256, "  ]\n}\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
 Exit:
-    PortaClose(gModelFile);
+    if (OutBuf_Close(gModelFile))
+        retCode |= MW_CANNOT_WRITE_TO_FILE;
 
     return retCode;
 }
@@ -26531,7 +28142,7 @@ static int writeVRMLAttributeShapeSplit(int type, int dataVal, char* mtlName, ch
     float ka, kd, ks, ke;      // cppcheck-suppress 398
     float alpha;
 
-    WERROR_MODEL(PortaWrite(gModelFile, attributeString, strlen(attributeString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, attributeString, strlen(attributeString)));
 
     if (type == GENERIC_MATERIAL)
     {
@@ -26563,82 +28174,664 @@ static int writeVRMLAttributeShapeSplit(int type, int dataVal, char* mtlName, ch
         tfString[0] = '\0';
     }
 
-    if (!gModel.print3D && (gBlockDefinitions[type].flags & BLF_EMITTER))
-    {
-        // emitter
-        bool subtypeMaterial = ((gModel.options->exportFlags & EXPT_OUTPUT_OBJ_SPLIT_BY_BLOCK_TYPE) != 0x0);
+    if (!gModel.print3D && (gBlockDefinitions[type].flags & BLF_EMITTER))
+    {
+        // emitter
+        bool subtypeMaterial = ((gModel.options->exportFlags & EXPT_OUTPUT_OBJ_SPLIT_BY_BLOCK_TYPE) != 0x0);
+
+        ke = getEmitterLevel(type, dataVal, subtypeMaterial, OBJ_EMITTER_POWER);
+        sprintf_s(keString, 256, "          emissiveColor %g %g %g\n", fRed * ke, fGreen * ke, fBlue * ke);
+    }
+    else
+    {
+        keString[0] = '\0';
+    }
+
+    sprintf_s(outputString, 1024,
+        "        material DEF %s Material\n"
+        "        {\n"
+        "          ambientIntensity %g\n"
+        "          diffuseColor %g %g %g\n"
+        "          specularColor %g %g %g\n"
+        "          shininess .5\n"
+        "%s"
+        "%s"
+        "        }\n",
+        mtlName,
+        ka,
+        kd * fRed, kd * fGreen, kd * fBlue,
+        ks * fRed, ks * fGreen, ks * fBlue,
+        keString,
+        tfString
+    );
+
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
+
+    if (textureOutputString != NULL)
+    {
+        WERROR_MODEL(OutBuf_Write(gModelFile, textureOutputString, strlen(textureOutputString)));
+    }
+
+    // close up appearance
+    strcpy_s(outputString, 256, "      }\n");
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
+
+    return MW_NO_ERROR;
+}
+
+static int writeVRMLTextureUV(float u, float v, int addComment, int swatchLoc)
+{
+    char outputString[1024];
+
+    if (addComment)
+    {
+        if (swatchLoc < TOTAL_TILES) {
+            char outName[MAX_PATH_AND_FILE];
+            WcharToChar(gTilesTable[swatchLoc].filename, outName, MAX_PATH_AND_FILE);
+            assert(strlen(outName) > 0);
+            OutBuf_Sprintf(outputString, 1024, "# %s\n            %g %g\n",
+                outName,
+                u, v);
+        }
+        else {
+            // old "by block family" code, which is less useful
+            OutBuf_Sprintf(outputString, 1024, "# %s\n            %g %g\n",
+                gBlockDefinitions[gModel.uvSwatchToType[swatchLoc]].name,
+                u, v);
+        }
+    }
+    else
+    {
+        OutBuf_Sprintf(outputString, 1024, "            %g %g\n",
+            u, v);
+    }
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
+
+    return MW_NO_ERROR;
+}
+
+
+//===============================================================================================
+
+// glTF 2.0 binary (GLB) output. The .glb file holds the geometry and materials: a JSON chunk describing the scene, followed
+// by a BIN chunk of vertex and index data. There is a single mesh, with one primitive per material. Each primitive has its own
+// interleaved vertex buffer - position, normal and, if textured, UV - with vertices shared by its triangles as possible,
+// plus an index buffer of 16-bit indices if the primitive has few enough vertices, 32-bit if not. Textures are not embedded:
+// they are written out by modifyAndWriteTextures() as for the other formats, the mosaic or the separate tiles, as PNG files
+// next to the .glb, and referenced by relative URI, so they must be kept with it.
+
+#define GLB_MAGIC           0x46546C67  // "glTF"
+#define GLB_VERSION         2
+#define GLB_CHUNK_JSON      0x4E4F534A  // "JSON"
+#define GLB_CHUNK_BIN       0x004E4942  // "BIN\0"
+
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT   5125
+#define GLTF_FLOAT          5126
+#define GLTF_ARRAY_BUFFER   34962
+#define GLTF_ELEMENT_ARRAY_BUFFER   34963
+#define GLTF_NEAREST        9728
+#define GLTF_NEAREST_MIPMAP_LINEAR  9986
+#define GLTF_REPEAT         10497
+
+// how faces are divided up into primitives
+#define GLB_SINGLE_MATERIAL     0
+#define GLB_MATERIAL_PER_TYPE   1
+#define GLB_MATERIAL_PER_TILE   2
+// material keys are block types or swatch locations
+#define GLB_MAX_KEYS    ((NUM_BLOCKS_DEFINED > TOTAL_TILES) ? NUM_BLOCKS_DEFINED : TOTAL_TILES)
+
+typedef struct GLBPrimitive {
+    int key;            // block type, swatch location, or 0 for a single material
+    int firstFace;      // in the list of faces sorted by material
+    int faceCount;
+    int vertexCount;    // after sharing
+    int indexCount;
+    float min[3];       // bounds of the positions, which glTF requires
+    float max[3];
+    unsigned int vertexOffset;  // byte offsets in the BIN chunk
+    unsigned int indexOffset;
+} GLBPrimitive;
+
+// A vertex is shared within a primitive by faces having the same position, UV and normal. Each model vertex has a list of
+// the UV and normal combinations used with it so far.
+typedef struct GLBVertexRef {
+    int next;           // next record for the same model vertex, or -1
+    short uvIndex;
+    short normalIndex;
+    int outIndex;       // vertex in the primitive's buffer
+} GLBVertexRef;
+
+typedef struct GLBVertexShare {
+    std::vector<int> stamp;     // primitive whose list each model vertex's head is for
+    std::vector<int> head;      // first record for each model vertex
+    std::vector<GLBVertexRef> refs;
+    int vertexCount;            // vertices so far in the primitive
+} GLBVertexShare;
+
+// Return the primitive's vertex for this position, UV and normal, adding it to the end if it's not yet used; isNew says if so.
+static int shareGLBVertex(GLBVertexShare& share, int primitive, int vertexIndex, short uvIndex, short normalIndex, bool& isNew)
+{
+    if (share.stamp[vertexIndex] != primitive) {
+        share.stamp[vertexIndex] = primitive;
+        share.head[vertexIndex] = -1;
+    }
+    for (int r = share.head[vertexIndex]; r >= 0; r = share.refs[r].next) {
+        if (share.refs[r].uvIndex == uvIndex && share.refs[r].normalIndex == normalIndex) {
+            isNew = false;
+            return share.refs[r].outIndex;
+        }
+    }
+    GLBVertexRef ref;
+    ref.next = share.head[vertexIndex];
+    ref.uvIndex = uvIndex;
+    ref.normalIndex = normalIndex;
+    ref.outIndex = share.vertexCount++;
+    share.head[vertexIndex] = (int)share.refs.size();
+    share.refs.push_back(ref);
+    isNew = true;
+    return ref.outIndex;
+}
+
+static int writeGLBBox(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, wchar_t* schemeSelected, ChangeBlockCommand* pCBC)
+{
+    wchar_t glbFileNameWithSuffix[MAX_PATH_AND_FILE];
+    wchar_t statsFileName[MAX_PATH_AND_FILE];
+    char tileName[MAX_PATH_AND_FILE];
+
+    HANDLE statsFile;
+
+    int faceNo, i, p;
+    int corner[6];
+    bool isNew;
+
+    int retCode = MW_NO_ERROR;
+
+    FaceRecord* pFace;
+
+    bool hasMaterials = (gModel.options->exportFlags & (EXPT_OUTPUT_MATERIALS | EXPT_OUTPUT_TEXTURE)) ? true : false;
+    bool hasUVs = gModel.exportTexture ? true : false;
+    int materialMode = !hasMaterials ? GLB_SINGLE_MATERIAL :
+        gModel.exportTiles ? GLB_MATERIAL_PER_TILE :
+        (gModel.options->exportFlags & EXPT_OUTPUT_OBJ_MTL_PER_TYPE) ? GLB_MATERIAL_PER_TYPE : GLB_SINGLE_MATERIAL;
+    int stride = hasUVs ? 8 * (int)sizeof(float) : 6 * (int)sizeof(float);
+
+    // Gather the faces by material, keeping their order otherwise. Primitives are in key order.
+    std::vector<int> keyCount(GLB_MAX_KEYS, 0);
+    std::vector<int> keyToPrimitive(GLB_MAX_KEYS, -1);
+    for (faceNo = 0; faceNo < gModel.faceCount; faceNo++) {
+        keyCount[getGLBMaterialKey(gModel.faceList[faceNo], materialMode)]++;
+    }
+    std::vector<GLBPrimitive> primitives;
+    int firstFace = 0;
+    for (i = 0; i < GLB_MAX_KEYS; i++) {
+        if (keyCount[i] > 0) {
+            GLBPrimitive prim;
+            memset(&prim, 0, sizeof(GLBPrimitive));
+            prim.key = i;
+            prim.firstFace = firstFace;
+            prim.faceCount = keyCount[i];
+            firstFace += keyCount[i];
+            keyToPrimitive[i] = (int)primitives.size();
+            primitives.push_back(prim);
+            // reuse the count as the next place to put a face for this key
+            keyCount[i] = prim.firstFace;
+        }
+    }
+    std::vector<int> faceOrder(gModel.faceCount);
+    for (faceNo = 0; faceNo < gModel.faceCount; faceNo++) {
+        faceOrder[keyCount[getGLBMaterialKey(gModel.faceList[faceNo], materialMode)]++] = faceNo;
+    }
+
+    int noteProgress = 1 + (int)((float)gModel.faceCount / (gProgress.absolute.output / 0.04f));
+    int facesDone = 0;
+
+    wchar_t numString1[100];
+    wchar_t numString2[100];
+    wchar_t statusString[1024];
+    prettifyNumber(gModel.faceCount, numString2);
+
+    // First pass: find how many vertices and indices each primitive has, and its bounds, so that the JSON can be written
+    // before the data.
+    GLBVertexShare share;
+    share.stamp.assign(gModel.vertexCount, -1);
+    share.head.resize(gModel.vertexCount);
+    unsigned long long binLength = 0;
+    for (p = 0; p < (int)primitives.size(); p++) {
+        GLBPrimitive& prim = primitives[p];
+        share.refs.clear();
+        share.vertexCount = 0;
+        for (i = 0; i < 3; i++) {
+            prim.min[i] = FLT_MAX;
+            prim.max[i] = -FLT_MAX;
+        }
+        for (faceNo = prim.firstFace; faceNo < prim.firstFace + prim.faceCount; faceNo++) {
+            if (facesDone++ % noteProgress == 0) {
+                UPDATE_PROGRESS(gProgress.start.output + gProgress.absolute.output * 0.5f * ((float)facesDone / (float)gModel.faceCount));
+            }
+            pFace = gModel.faceList[faceOrder[faceNo]];
+            int numCorners = 3 * getGLBFaceCorners(pFace, corner);
+            for (i = 0; i < numCorners; i++) {
+                int vertexIndex = pFace->vertexIndex[corner[i]];
+                shareGLBVertex(share, p, vertexIndex, hasUVs ? pFace->uvIndex[corner[i]] : 0, pFace->normalIndex, isNew);
+                if (isNew) {
+                    for (int axis = 0; axis < 3; axis++) {
+                        if (gModel.vertices[vertexIndex][axis] < prim.min[axis])
+                            prim.min[axis] = gModel.vertices[vertexIndex][axis];
+                        if (gModel.vertices[vertexIndex][axis] > prim.max[axis])
+                            prim.max[axis] = gModel.vertices[vertexIndex][axis];
+                    }
+                }
+            }
+            prim.indexCount += numCorners;
+        }
+        prim.vertexCount = share.vertexCount;
+
+        // vertex data is always a multiple of 4 bytes long; 16-bit indices may need padding after
+        prim.vertexOffset = (unsigned int)binLength;
+        binLength += (unsigned long long)prim.vertexCount * stride;
+        prim.indexOffset = (unsigned int)binLength;
+        binLength += ((unsigned long long)prim.indexCount * ((prim.vertexCount <= 65535) ? 2 : 4) + 3) & ~3ULL;
+        // GLB sizes are 32 bits, and this leaves room for the JSON
+        if (binLength > 0xF0000000ULL)
+            return MW_WORLD_EXPORT_TOO_LARGE;
+    }
+
+    // The JSON. Each primitive has four accessors, in order: position, normal, UV and indices, or three if there are no UVs.
+    int accessorsPerPrimitive = hasUVs ? 4 : 3;
+    std::string json;
+    appendGLBJson(json, "{\"asset\":{\"version\":\"2.0\",\"generator\":\"Mineways %d.%02d\"},", gMinewaysMajorVersion, gMinewaysMinorVersion);
+    json += "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"name\":";
+    appendGLBJsonString(json, gOutputFileRootCleanChar);
+    if (primitives.size() > 0) {
+        json += ",\"mesh\":0}],\"meshes\":[{\"name\":";
+        appendGLBJsonString(json, gOutputFileRootCleanChar);
+        json += ",\"primitives\":[";
+        for (p = 0; p < (int)primitives.size(); p++) {
+            int accessor = p * accessorsPerPrimitive;
+            appendGLBJson(json, "%s{\"attributes\":{\"POSITION\":%d,\"NORMAL\":%d", (p > 0) ? "," : "", accessor, accessor + 1);
+            if (hasUVs) {
+                appendGLBJson(json, ",\"TEXCOORD_0\":%d", accessor + 2);
+            }
+            appendGLBJson(json, "},\"indices\":%d", accessor + accessorsPerPrimitive - 1);
+            if (hasMaterials) {
+                appendGLBJson(json, ",\"material\":%d", p);
+            }
+            json += "}";
+        }
+        json += "]}]";
+    }
+    else {
+        json += "}]";
+    }
+
+    // Materials: one per primitive. Colors come from the block when there's no texture.
+    if (hasMaterials && primitives.size() > 0) {
+        json += ",\"materials\":[";
+        for (p = 0; p < (int)primitives.size(); p++) {
+            pFace = gModel.faceList[faceOrder[primitives[p].firstFace]];
+            int type = (materialMode == GLB_SINGLE_MATERIAL) ? BLOCK_STONE : pFace->materialType;
+            json += (p > 0) ? ",{\"name\":" : "{\"name\":";
+            if (materialMode == GLB_MATERIAL_PER_TILE) {
+                WcharToChar(gTilesTable[primitives[p].key].filename, tileName, MAX_PATH_AND_FILE);
+                appendGLBJsonString(json, tileName);
+            }
+            else if (materialMode == GLB_MATERIAL_PER_TYPE) {
+                appendGLBJsonString(json, gBlockDefinitions[type].name);
+            }
+            else {
+                appendGLBJsonString(json, gModel.exportTexture ? gOutputFileRootCleanChar : "Neutral_White");
+            }
+
+            float alpha = retrieveMtlAlpha(type);
+            json += ",\"pbrMetallicRoughness\":{";
+            if (gModel.exportTexture) {
+                // the texture gives the color; for the mosaic there's just the one texture
+                appendGLBJson(json, "\"baseColorTexture\":{\"index\":%d},", (materialMode == GLB_MATERIAL_PER_TILE) ? p : 0);
+            }
+            else {
+                // glTF colors are linear, Minecraft's sRGB
+                float color[3];
+                if (materialMode == GLB_SINGLE_MATERIAL) {
+                    color[0] = color[1] = color[2] = 1.0f;
+                }
+                else {
+                    color[0] = (gBlockDefinitions[type].color >> 16) / 255.0f;
+                    color[1] = ((gBlockDefinitions[type].color >> 8) & 0xff) / 255.0f;
+                    color[2] = (gBlockDefinitions[type].color & 0xff) / 255.0f;
+                }
+                for (i = 0; i < 3; i++) {
+                    color[i] = (color[i] <= 0.04045f) ? color[i] / 12.92f : (float)pow((color[i] + 0.055f) / 1.055f, 2.4f);
+                }
+                appendGLBJson(json, "\"baseColorFactor\":[%g,%g,%g,%g],", color[0], color[1], color[2], alpha);
+            }
+            json += "\"metallicFactor\":0,\"roughnessFactor\":1}";
+
+            // as for OBJ's map_d: cutouts or semitransparency when rendering
+            if (!gModel.print3D) {
+                if (gModel.exportTexture) {
+                    if ((gModel.options->exportFlags & EXPT_OUTPUT_TEXTURE_IMAGES_OR_TILES) &&
+                        (alpha < 1.0 || (gBlockDefinitions[type].flags & BLF_CUTOUTS)) &&
+                        !(gModel.options->pEFD->chkLeavesSolid && (gBlockDefinitions[type].flags & BLF_LEAF_PART)))
+                    {
+                        json += (alpha < 1.0f) ? ",\"alphaMode\":\"BLEND\"" : ",\"alphaMode\":\"MASK\"";
+                    }
+                }
+                else if (alpha < 1.0f) {
+                    json += ",\"alphaMode\":\"BLEND\"";
+                }
+                // viewers cull back faces unless told not to, and billboards are usually output single sided
+                if ((materialMode != GLB_SINGLE_MATERIAL) && !gModel.options->pEFD->chkDoubledBillboards &&
+                    (gBlockDefinitions[type].flags & (BLF_BILLBOARD | BLF_SMALL_BILLBOARD)))
+                {
+                    json += ",\"doubleSided\":true";
+                }
+            }
+            json += "}";
+
+            if (materialMode == GLB_MATERIAL_PER_TILE) {
+                // note in an array that this separate tile should be output
+                gModel.tileList[CATEGORY_RGBA][primitives[p].key] = true;
+            }
+        }
+        json += "]";
+
+        if (gModel.exportTexture) {
+            // blocky textures want nearest filtering
+            appendGLBJson(json, ",\"samplers\":[{\"magFilter\":%d,\"minFilter\":%d,\"wrapS\":%d,\"wrapT\":%d}],",
+                GLTF_NEAREST, GLTF_NEAREST_MIPMAP_LINEAR, GLTF_REPEAT, GLTF_REPEAT);
+            int numTextures = (materialMode == GLB_MATERIAL_PER_TILE) ? (int)primitives.size() : 1;
+            json += "\"textures\":[";
+            for (i = 0; i < numTextures; i++) {
+                appendGLBJson(json, "%s{\"sampler\":0,\"source\":%d}", (i > 0) ? "," : "", i);
+            }
+            json += "],\"images\":[";
+            for (i = 0; i < numTextures; i++) {
+                json += (i > 0) ? ",{\"uri\":" : "{\"uri\":";
+                if (materialMode == GLB_MATERIAL_PER_TILE) {
+                    // same file names as modifyAndWriteTextures() uses
+                    int swatchLoc = primitives[i].key;
+                    char uri[MAX_PATH_AND_FILE];
+                    WcharToChar(gTilesTable[swatchLoc].filename, tileName, MAX_PATH_AND_FILE);
+                    if (strlen(gModel.options->pEFD->tileDirString) > 0) {
+                        sprintf_s(uri, MAX_PATH_AND_FILE, "%s/%s%s", gModel.options->pEFD->tileDirString, tileName,
+                            (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED) ? "_y.png" : ".png");
+                    }
+                    else {
+                        sprintf_s(uri, MAX_PATH_AND_FILE, "%s%s", tileName,
+                            (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED) ? "_y.png" : ".png");
+                    }
+                    appendGLBJsonURI(json, uri);
+                }
+                else {
+                    char uri[MAX_PATH_AND_FILE];
+                    sprintf_s(uri, MAX_PATH_AND_FILE, "%s.png", gOutputFileRootCleanChar);
+                    appendGLBJsonURI(json, uri);
+                }
+                json += "}";
+            }
+            json += "]";
+        }
+    }
+
+    if (primitives.size() > 0) {
+        json += ",\"accessors\":[";
+        for (p = 0; p < (int)primitives.size(); p++) {
+            GLBPrimitive& prim = primitives[p];
+            int view = 2 * p;
+            appendGLBJson(json, "%s{\"bufferView\":%d,\"componentType\":%d,\"count\":%d,\"type\":\"VEC3\",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]}",
+                (p > 0) ? "," : "", view, GLTF_FLOAT, prim.vertexCount,
+                prim.min[X], prim.min[Y], prim.min[Z], prim.max[X], prim.max[Y], prim.max[Z]);
+            appendGLBJson(json, ",{\"bufferView\":%d,\"byteOffset\":12,\"componentType\":%d,\"count\":%d,\"type\":\"VEC3\"}",
+                view, GLTF_FLOAT, prim.vertexCount);
+            if (hasUVs) {
+                appendGLBJson(json, ",{\"bufferView\":%d,\"byteOffset\":24,\"componentType\":%d,\"count\":%d,\"type\":\"VEC2\"}",
+                    view, GLTF_FLOAT, prim.vertexCount);
+            }
+            appendGLBJson(json, ",{\"bufferView\":%d,\"componentType\":%d,\"count\":%d,\"type\":\"SCALAR\"}",
+                view + 1, (prim.vertexCount <= 65535) ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT, prim.indexCount);
+        }
+        json += "],\"bufferViews\":[";
+        for (p = 0; p < (int)primitives.size(); p++) {
+            GLBPrimitive& prim = primitives[p];
+            appendGLBJson(json, "%s{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u,\"byteStride\":%d,\"target\":%d}",
+                (p > 0) ? "," : "", prim.vertexOffset, (unsigned int)prim.vertexCount * stride, stride, GLTF_ARRAY_BUFFER);
+            appendGLBJson(json, ",{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u,\"target\":%d}",
+                prim.indexOffset, (unsigned int)prim.indexCount * ((prim.vertexCount <= 65535) ? 2 : 4), GLTF_ELEMENT_ARRAY_BUFFER);
+        }
+        appendGLBJson(json, "],\"buffers\":[{\"byteLength\":%u}]", (unsigned int)binLength);
+    }
+    json += "}";
+    // chunks must be 4-byte aligned; JSON is padded with spaces
+    while (json.size() % 4)
+        json += ' ';
+
+    concatFileName3(glbFileNameWithSuffix, gOutputFilePath, gOutputFileRoot, L".glb");
+
+    // create the GLB file
+    gModelFile = PortaCreate(glbFileNameWithSuffix);
+    addOutputFilenameToList(glbFileNameWithSuffix);
+    if (gModelFile == INVALID_HANDLE_VALUE)
+        return MW_CANNOT_CREATE_FILE;
+    // collect the output and write it out in large pieces; if this fails, everything is written directly
+    OutBuf_Attach(gModelFile);
+
+    unsigned int header[3];
+    header[0] = GLB_MAGIC;
+    header[1] = GLB_VERSION;
+    header[2] = (unsigned int)(12 + 8 + json.size() + ((binLength > 0) ? 8 + binLength : 0));
+    WERROR_MODEL(OutBuf_Write(gModelFile, header, 12));
+    header[0] = (unsigned int)json.size();
+    header[1] = GLB_CHUNK_JSON;
+    WERROR_MODEL(OutBuf_Write(gModelFile, header, 8));
+    WERROR_MODEL(OutBuf_Write(gModelFile, json.data(), json.size()));
+
+    if (binLength > 0) {
+        header[0] = (unsigned int)binLength;
+        header[1] = GLB_CHUNK_BIN;
+        WERROR_MODEL(OutBuf_Write(gModelFile, header, 8));
+
+        // Second pass: share the vertices the same way again, writing each new one out as it's found, then the indices.
+        std::vector<unsigned int> indices;
+        std::vector<unsigned short> shortIndices;
+        float vertexData[8];
+        for (p = 0; p < (int)primitives.size(); p++) {
+            GLBPrimitive& prim = primitives[p];
+            share.refs.clear();
+            share.vertexCount = 0;
+            indices.clear();
+            // different primitive numbers from the first pass, so every list starts out empty
+            int stampID = (int)primitives.size() + p;
+            for (faceNo = prim.firstFace; faceNo < prim.firstFace + prim.faceCount; faceNo++) {
+                if (facesDone++ % noteProgress == 0) {
+                    prettifyNumber(facesDone - gModel.faceCount, numString1);
+                    swprintf_s(statusString, 1024, L"Writing %s of %s faces", numString1, numString2);
+                    UPDATE_STATUS(gProgress.start.output + gProgress.absolute.output * 0.5f * ((float)facesDone / (float)gModel.faceCount), statusString);
+                }
+                pFace = gModel.faceList[faceOrder[faceNo]];
+                int numCorners = 3 * getGLBFaceCorners(pFace, corner);
+                for (i = 0; i < numCorners; i++) {
+                    int vertexIndex = pFace->vertexIndex[corner[i]];
+                    indices.push_back(shareGLBVertex(share, stampID, vertexIndex, hasUVs ? pFace->uvIndex[corner[i]] : 0, pFace->normalIndex, isNew));
+                    if (isNew) {
+                        vertexData[0] = gModel.vertices[vertexIndex][X];
+                        vertexData[1] = gModel.vertices[vertexIndex][Y];
+                        vertexData[2] = gModel.vertices[vertexIndex][Z];
+                        assert(pFace->normalIndex >= 0);
+                        vertexData[3] = gModel.normals[pFace->normalIndex][X];
+                        vertexData[4] = gModel.normals[pFace->normalIndex][Y];
+                        vertexData[5] = gModel.normals[pFace->normalIndex][Z];
+                        if (hasUVs) {
+                            getGLBTextureUV(pFace, corner[i], &vertexData[6]);
+                        }
+                        WERROR_MODEL(OutBuf_Write(gModelFile, vertexData, stride));
+                    }
+                }
+            }
+            assert(share.vertexCount == prim.vertexCount);
+            assert((int)indices.size() == prim.indexCount);
+
+            if (prim.vertexCount <= 65535) {
+                shortIndices.resize(indices.size());
+                for (i = 0; i < prim.indexCount; i++) {
+                    shortIndices[i] = (unsigned short)indices[i];
+                }
+                WERROR_MODEL(OutBuf_Write(gModelFile, shortIndices.data(), shortIndices.size() * 2));
+                if (prim.indexCount % 2) {
+                    unsigned short zero = 0;
+                    WERROR_MODEL(OutBuf_Write(gModelFile, &zero, 2));
+                }
+            }
+            else {
+                WERROR_MODEL(OutBuf_Write(gModelFile, indices.data(), indices.size() * 4));
+            }
+        }
+    }
+
+    // if not ok, then we will have closed the file earlier
+    if (OutBuf_Close(gModelFile))
+        return MW_CANNOT_WRITE_TO_FILE;
 
-        ke = getEmitterLevel(type, dataVal, subtypeMaterial, OBJ_EMITTER_POWER);
-        sprintf_s(keString, 256, "          emissiveColor %g %g %g\n", fRed * ke, fGreen * ke, fBlue * ke);
-    }
-    else
-    {
-        keString[0] = '\0';
+    // note that textures get written out in SaveVolume(), which calls this function.
+    // But we need this value computed, for the progress bar
+    for (i = 0; i < TOTAL_TILES; i++) {
+        if (gModel.tileList[CATEGORY_RGBA][i]) {
+            gModel.tileListCount++;
+        }
     }
 
-    sprintf_s(outputString, 1024,
-        "        material DEF %s Material\n"
-        "        {\n"
-        "          ambientIntensity %g\n"
-        "          diffuseColor %g %g %g\n"
-        "          specularColor %g %g %g\n"
-        "          shininess .5\n"
-        "%s"
-        "%s"
-        "        }\n",
-        mtlName,
-        ka,
-        kd * fRed, kd * fGreen, kd * fBlue,
-        ks * fRed, ks * fGreen, ks * fBlue,
-        keString,
-        tfString
-    );
+    concatFileName3(statsFileName, gOutputFilePath, gOutputFileRoot, L".txt");
 
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    // write the stats to a separate file
+    statsFile = PortaCreate(statsFileName);
+    addOutputFilenameToList(statsFileName);
+    if (statsFile == INVALID_HANDLE_VALUE)
+        return retCode | MW_CANNOT_CREATE_FILE;
 
-    if (textureOutputString != NULL)
-    {
-        WERROR_MODEL(PortaWrite(gModelFile, textureOutputString, strlen(textureOutputString)));
-    }
+    retCode |= writeStatistics(statsFile, NULL, pWorldGuide, worldBox, tightenedWorldBox, curDir, terrainFileName, schemeSelected, pCBC);
+    if (retCode >= MW_BEGIN_ERRORS) return retCode;
 
-    // close up appearance
-    strcpy_s(outputString, 256, "      }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    PortaClose(statsFile);
 
-    return MW_NO_ERROR;
+    return retCode;
 }
 
-static int writeVRMLTextureUV(float u, float v, int addComment, int swatchLoc)
+// Which primitive the face goes in: by swatch for tiles, by block type for colors or the mosaic, else all in one.
+static int getGLBMaterialKey(FaceRecord* pFace, int materialMode)
 {
-    char outputString[1024];
+    int key = 0;
+    if (materialMode == GLB_MATERIAL_PER_TILE) {
+        // uvIndex[0] is never a simplified, negative value
+        assert(pFace->uvIndex[0] >= 0);
+        key = gModel.uvIndexList[pFace->uvIndex[0]].swatchLoc;
+        assert(key < TOTAL_TILES);
+    }
+    else if (materialMode == GLB_MATERIAL_PER_TYPE) {
+        key = pFace->materialType;
+        assert(key >= 0 && key < NUM_BLOCKS_DEFINED);
+    }
+    return key;
+}
 
-    if (addComment)
-    {
-        if (swatchLoc < TOTAL_TILES) {
-            char outName[MAX_PATH_AND_FILE];
-            WcharToChar(gTilesTable[swatchLoc].filename, outName, MAX_PATH_AND_FILE);
-            assert(strlen(outName) > 0);
-            sprintf_s(outputString, 1024, "# %s\n            %g %g\n",
-                outName,
-                u, v);
+// Set the corners of the face's triangles, three per triangle, returning the number of triangles, 1 or 2.
+static int getGLBFaceCorners(FaceRecord* pFace, int corner[6])
+{
+    if (pFace->vertexIndex[2] == pFace->vertexIndex[3]) {
+        corner[0] = 0;
+        corner[1] = 1;
+        corner[2] = 2;
+        return 1;
+    }
+    // if normal sums negative, rotate order by one, as for the other formats, so that the diagonals match up
+    int offset = 0;
+    assert(pFace->normalIndex >= 0);
+    int i = pFace->normalIndex;
+    if (gModel.normals[i][X] + gModel.normals[i][Y] + gModel.normals[i][Z] < 0.0f)
+        offset = 1;
+    // two triangles: 0 1 2 and 0 2 3 (or 1 2 3 and 1 3 0)
+    corner[0] = offset;
+    corner[1] = offset + 1;
+    corner[2] = offset + 2;
+    corner[3] = offset;
+    corner[4] = offset + 2;
+    corner[5] = (offset + 3) % 4;
+    return 2;
+}
+
+// UV for a corner of a face, in the mosaic or in its own tile. glTF's V goes down the image, so is flipped.
+static void getGLBTextureUV(FaceRecord* pFace, int corner, float uv[2])
+{
+    float uc, vc;
+    if (gModel.exportTiles) {
+        // is it a swatch value, or a simplify extended value? See the same code for USD.
+        if (pFace->uvIndex[corner] >= 0) {
+            uc = (float)((((int)(gModel.uvIndexList[pFace->uvIndex[corner]].uc * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale) / (float)NUM_UV_GRID_RESOLUTION;
+            vc = (float)(16 - ((((int)((1.0f - gModel.uvIndexList[pFace->uvIndex[corner]].vc) * (float)gModel.textureResolution) % gModel.swatchSize) - 1.0f) * gModel.resScale)) / (float)NUM_UV_GRID_RESOLUTION;
         }
         else {
-            // old "by block family" code, which is less useful
-            sprintf_s(outputString, 1024, "# %s\n            %g %g\n",
-                gBlockDefinitions[gModel.uvSwatchToType[swatchLoc]].name,
-                u, v);
+            // simplified direct indices, negated and -1
+            int uvDecode = -pFace->uvIndex[corner] - 1;
+            uc = (float)(uvDecode % (SIMPLIFY_MAX_DIMENSION + 1));
+            vc = (float)int(uvDecode / (SIMPLIFY_MAX_DIMENSION + 1));
         }
     }
-    else
-    {
-        sprintf_s(outputString, 1024, "            %g %g\n",
-            u, v);
+    else {
+        uc = gModel.uvIndexList[pFace->uvIndex[corner]].uc;
+        vc = gModel.uvIndexList[pFace->uvIndex[corner]].vc;
     }
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    uv[0] = uc;
+    uv[1] = 1.0f - vc;
+}
 
-    return MW_NO_ERROR;
+static void appendGLBJson(std::string& json, const char* format, ...)
+{
+    char outputString[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(outputString, 1024, format, args);
+    va_end(args);
+    assert(length >= 0 && length < 1024);
+    json.append(outputString, (length < 0) ? 0 : (length < 1024) ? length : 1023);
+}
+
+// append a quoted JSON string
+static void appendGLBJsonString(std::string& json, const char* str)
+{
+    json += '"';
+    for (; *str; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += (char)c;
+        }
+        else if (c < 0x20) {
+            appendGLBJson(json, "\\u%04x", c);
+        }
+        else {
+            json += (char)c;
+        }
+    }
+    json += '"';
 }
 
+// append a quoted, relative URI, escaping anything that's not allowed as is
+static void appendGLBJsonURI(std::string& json, const char* uri)
+{
+    json += '"';
+    for (; *uri; uri++) {
+        unsigned char c = (unsigned char)*uri;
+        if (c == '\\') {
+            json += '/';
+        }
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+            json += (char)c;
+        }
+        else {
+            appendGLBJson(json, "%%%02X", c);
+        }
+    }
+    json += '"';
+}
 
 //===============================================================================================
 
@@ -26764,8 +28957,7 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
     }
 
     // topmost Xform
-    sprintf_s(outputString, 256, "\ndef Xform \"%s\"\n{\n", defaultPrim);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Printf(gModelFile, "\ndef Xform \"%s\"\n{\n", defaultPrim));
 
     // add camera - add it only if lights are export
     if (gModel.options->pEFD->scaleLightsVal > 0.0f) {
@@ -26793,21 +28985,21 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
     //        (float)tightenedWorldBox->max[X],
     //        (float)tightenedWorldBox->max[Y],
     //        (float)tightenedWorldBox->max[Z] );
-    //    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     //}
 
     strcpy_s(outputString, 256, "\n    def Xform \"Geom\"\n    {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     if (gXformScale != 1.0f) {
         strcpy_s(outputString, 256, "        double3 xformOp:rotateXYZ = (0, 0, 0)\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         sprintf_s(outputString,256, "        double3 xformOp:scale = (%f, %f, %f)\n", gXformScale, gXformScale, gXformScale);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "        double3 xformOp:translate = (0, 0, 0)\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "        uniform token[] xformOpOrder = [\"xformOp:translate\", \"xformOp:rotateXYZ\", \"xformOp:scale\"]\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     }
 
     // if we're instancing, we need to simply write out the instance locations and what blocks they refer to
@@ -26845,7 +29037,7 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
         // material library creation assumes everything's sorted by material, so do that now
         // TODO USD - may not really be needed, but could be more efficient
         UPDATE_STATUS(-999.0f, L"Sort by tile IDs");
-        qsort_s(gModel.faceList, gModel.faceCount, sizeof(FaceRecord*), tileUSDIdCompare, NULL);
+        sortFaces(gModel.faceList, gModel.faceCount, FACE_SORT_BY_USD_TILE_ID);
 
         // create material library
         if (retCode |= createMaterialsUSD(texturePath, "", materialLibraryNameWithSuffix, singleTerrainFile, noExtraPath)) {
@@ -26872,9 +29064,9 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
         if (gModel.instanceChunkSize == 0) {
             // just one chunk
             strcpy_s(outputString, 256, "        def PointInstancer \"pointinstancer\" {\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            point3f[] positions = [");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             InstanceLocation* pil = gModel.instanceLoc;
             for (i = 0; i < gModel.instanceLocCount; i++) {
@@ -26883,13 +29075,12 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
                     UPDATE_PROGRESS(gProgress.start.output + gProgress.absolute.output * ((float)i / doubleCount));
                     progressTick += progressIncrement;
                 }
-                sprintf_s(outputString, 256, "(%g, %g, %g)%s", pil->location[X], pil->location[Y], pil->location[Z], (i == gModel.instanceLocCount - 1) ? "]\n" : ",");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(gModelFile, "(%g, %g, %g)%s", pil->location[X], pil->location[Y], pil->location[Z], (i == gModel.instanceLocCount - 1) ? "]\n" : ","));
                 pil++;
             }
 
             strcpy_s(outputString, 256, "            int[] protoIndices = [");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             // reset and count second half
             progressTick = progressIncrement;
             pil = gModel.instanceLoc;
@@ -26899,14 +29090,13 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
                     UPDATE_PROGRESS(gProgress.start.output + gProgress.absolute.output * ((float)(i + gModel.instanceLocCount) / doubleCount));
                     progressTick += progressIncrement;
                 }
-                sprintf_s(outputString, 256, "%d%s", blockIndex[pil->index], (i == gModel.instanceLocCount - 1) ? "]\n" : ",");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(gModelFile, "%d%s", blockIndex[pil->index], (i == gModel.instanceLocCount - 1) ? "]\n" : ","));
                 pil++;
             }
 
             // output all instance names
             strcpy_s(outputString, 256, "            prepend rel prototypes = [");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             char instanceNameString[MAX_PATH_AND_FILE];
             for (i = 0; i < gModel.instanceCount; i++) {
                 //char instanceNameUnderlined[MAX_PATH_AND_FILE];
@@ -26916,14 +29106,12 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
                 // convertCharPathUnderlined(instanceNameUnderlined, instanceNameString, true);
 
                 //sprintf_s(outputString, 256, "<Blocks/%s>%s", instanceNameUnderlined, (i == gModel.instanceCount - 1) ? "]" : ",");
-                sprintf_s(outputString, 256, "<Blocks/%s>%s", instanceNameString, (i == gModel.instanceCount - 1) ? "]\n" : ",");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(gModelFile, "<Blocks/%s>%s", instanceNameString, (i == gModel.instanceCount - 1) ? "]\n" : ","));
             }
 
-            sprintf_s(outputString, 256, "            over \"Blocks\" (references = @./%s%s@) {}\n", gMaterialFileSubdirChar, blockLibraryName);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "            over \"Blocks\" (references = @./%s%s@) {}\n", gMaterialFileSubdirChar, blockLibraryName));
             strcpy_s(outputString, 256, "        }\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         }
         else {
             // The more involved "by chunk" instancer output
@@ -26933,22 +29121,20 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
             qsort_s(gModel.instanceLoc, gModel.instanceLocCount, sizeof(InstanceLocation), chunkUSDCompare, NULL);
 
             strcpy_s(outputString, 256, "        def Xform \"VoxelMap\" (\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            prepend apiSchemas = [\"InfiniteVoxelMapAPI\"]\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "        )\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "        {\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-            sprintf_s(outputString, 256, "            int3 chunkSize = (%d, %d, %d)\n\n", gModel.instanceChunkSize, gModel.instanceChunkSize, gModel.instanceChunkSize);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "            int3 chunkSize = (%d, %d, %d)\n\n", gModel.instanceChunkSize, gModel.instanceChunkSize, gModel.instanceChunkSize));
 
             strcpy_s(outputString, 256, "            def BlockLib \"BlockLib\"\n        {\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
-            sprintf_s(outputString, 256, "                over \"Blocks\" (references = @./%s%s@) {}\n", gMaterialFileSubdirChar, blockLibraryName);
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(gModelFile, "                over \"Blocks\" (references = @./%s%s@) {}\n", gMaterialFileSubdirChar, blockLibraryName));
             strcpy_s(outputString, 256, "            }\n\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             int* localBlockIndex = (int*)malloc(gModel.instanceCount * sizeof(int));
             int* absoluteIndex = (int*)malloc(gModel.instanceCount * sizeof(int));
@@ -26992,33 +29178,30 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
                     pil++;
                 }
 
-                sprintf_s(outputString, 256, "            def PointInstancer \"Chunk_%s\" {\n", chunkLocation);
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(gModelFile, "            def PointInstancer \"Chunk_%s\" {\n", chunkLocation));
                 strcpy_s(outputString, 256, "                point3f[] positions = [");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
                 pil = &gModel.instanceLoc[startInstance];
                 for (i = startInstance; i < endInstance; i++) {
-                    sprintf_s(outputString, 256, "(%g, %g, %g)%s", pil->location[X], pil->location[Y], pil->location[Z], (i == endInstance - 1) ? "]\n" : ",");
-                    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Printf(gModelFile, "(%g, %g, %g)%s", pil->location[X], pil->location[Y], pil->location[Z], (i == endInstance - 1) ? "]\n" : ","));
                     pil++;
                 }
 
                 strcpy_s(outputString, 256, "                int[] protoIndices = [");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
                 // reset and count second half
                 progressTick = progressIncrement;
                 pil = &gModel.instanceLoc[startInstance];
                 for (i = startInstance; i < endInstance; i++) {
                     assert(localBlockIndex[pil->index] >= 0);
-                    sprintf_s(outputString, 256, "%d%s", localBlockIndex[pil->index], (i == endInstance - 1) ? "]\n" : ",");
-                    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Printf(gModelFile, "%d%s", localBlockIndex[pil->index], (i == endInstance - 1) ? "]\n" : ","));
                     pil++;
                 }
 
                 // output all instance names
                 strcpy_s(outputString, 256, "                rel prototypes = [\n");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
                 char instanceNameString[MAX_PATH_AND_FILE];
                 for (i = 0; i < relIndex; i++) {
                     // get the particular instance out of the long list
@@ -27027,20 +29210,19 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
                     // convertCharPathUnderlined(instanceNameUnderlined, instanceNameString, true);
 
                     //sprintf_s(outputString, 256, "<Blocks/%s>%s\n", instanceNameUnderlined, (i == gModel.instanceCount - 1) ? "]" : ",");
-                    sprintf_s(outputString, 256, "                <../BlockLib/Blocks/%s>%s\n", instanceNameString, (i == relIndex - 1) ? "]" : ",");
-                    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Printf(gModelFile, "                <../BlockLib/Blocks/%s>%s\n", instanceNameString, (i == relIndex - 1) ? "]" : ","));
                 }
                 //sprintf_s(outputString, 256, "            over \"Blocks\" (references = @./%s@) {}\n", blockLibraryName);
-                //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            }\n");
-                WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
                 // and get ready for next instance
                 startInstance = endInstance;
             }
             // close VoxelMap
             strcpy_s(outputString, 256, "        } # close VoxelMap Xform\n");
-            WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
             free(absoluteIndex);
             free(localBlockIndex);
@@ -27056,7 +29238,7 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
 
     // close the Geom Xform
     strcpy_s(outputString, 256, "    } # close Geom Xform\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // export the materials to the main file
     if (!gModel.instancing) {
@@ -27076,8 +29258,7 @@ static int writeUSD2Box(WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightened
     }
 
     // close topmost world Xform
-    sprintf_s(outputString, 256, "} # close %s Xform\n\n", defaultPrim);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Printf(gModelFile, "} # close %s Xform\n\n", defaultPrim));
 
 Exit:
     if (retCode |= closeUSDFile(gModelFile)) {
@@ -27159,9 +29340,10 @@ static int openUSDFile(wchar_t* destination, PORTAFILE & modelFile)
     addOutputFilenameToList(destination);
     if (modelFile == INVALID_HANDLE_VALUE)
         return MW_CANNOT_CREATE_FILE;
+    OutBuf_Attach(modelFile);
 
     strcpy_s(outputString, 256, "#usda 1.0\n(\n");
-    WERROR_MODEL(PortaWrite(modelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(modelFile, outputString, strlen(outputString)));
 
     return 0;
 }
@@ -27181,10 +29363,10 @@ static int writeCommentUSD(char* commentString)
             *curOut++ = *curIn++;
         } while (*curIn);
         *curOut = (char)0;
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     }
     else {
-        WERROR_MODEL(PortaWrite(gModelFile, commentString, strlen(commentString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, commentString, strlen(commentString)));
     }
 
     return 0;
@@ -27195,124 +29377,124 @@ static int finishCommentsUSD(char* defaultPrim)
     char outputString[256];
     // close comments
     strcpy_s(outputString, 256, "\"\"\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // render settings - could make a separate function
     strcpy_s(outputString, 256, "    customLayerData = {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // Seen in one file, 
     //strcpy_s(outputString, 256, "        string source = '''Converted to usd by Mineways''' = {\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // A way to export a given camera. Maybe add a 3D camera description as a scripting option someday? TODO
     // Currently no 3D view within Mineways itself, of course. This view works well with QMAGNET's texture world
     static boolean exportCamera = true;
     if (exportCamera) {
         strcpy_s(outputString, 256, "        dictionary cameraSettings = {\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         sprintf_s(outputString, 256, "            string boundCamera = \"/%s/Camera\"\n", defaultPrim);
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "        }\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     }
     strcpy_s(outputString, 256, "        # hints for NVIDIA's USD Composer's rendering system:\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        dictionary renderSettings = {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     /* not supported any more, AFAIK
     strcpy_s(outputString, 256, "            double \"rtx:ambientOcclusion:rayLength\" = 1\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            bool \"rtx:indirectDiffuse:enabled\" = 1\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // no longer used
     //strcpy_s(outputString, 256, "            bool \"rtx:pathtracing:cached:enabled\" = 1\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double \"rtx:pathtracing:fireflyFilter:maxIntensityPerSample\" = 50000\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            bool \"rtx:pathtracing:lightcache:cached:enabled\" = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double \"rtx:pathtracing:maxBounces\" = 10\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double \"rtx:pathtracing:maxSpecularAndTransmissionBounces\" = 10\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     */
     // fog, if depth shading is on
     if (gModel.options->worldType & DEPTHSHADING) {
         strcpy_s(outputString, 256, "            double \"rtx:pathtracing:ptfog:asymmetry\" = -0.0828634\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "            double \"rtx:pathtracing:ptfog:density\" = 0.52\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "            bool \"rtx:pathtracing:ptfog:enabled\" = 1\n");
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     }
 
     // GI is good for the real-time version - should always be on, IMO:
     // But, this is now the default, under Real-Time renderer, Ray Tracing, Indirect Diffuse Lighting, Indirect Diffuse GI:
     //strcpy_s(outputString, 256, "            bool \"rtx:indirectDiffuse:enabled\" = 1\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // 0 means run forever - best to call it a day at some point, so it doesn't run forever
     // No longer needed - the default has been made 64 or 512 or whatever.
     //strcpy_s(outputString, 256, "            int \"rtx:pathtracing:totalSpp\" = 1000\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // no longer used
     //strcpy_s(outputString, 256, "            double \"rtx:post:aa:op\" = 3\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     /* not supported any more, AFAIK
     strcpy_s(outputString, 256, "            double \"rtx:post:dlss:execMode\" = 1\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     */
     /* not supported any more, AFAIK
     strcpy_s(outputString, 256, "            double \"rtx:post:lensFlares:cutoffFuzziness\" = 0.506608\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     */
     // Not really needed, turns lens flare on. Let the user figure that out instead...
     //strcpy_s(outputString, 256, "            bool \"rtx:post:lensFlares:enabled\" = 1\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     //strcpy_s(outputString, 256, "            double \"rtx:post:lensFlares:flareScale\" = 0.1\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     //strcpy_s(outputString, 256, "            double \"rtx:post:lensFlares:focalLength\" = 250\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // Used only because we make the light sources "reasonable", with an emission of 30 and 6 for Sun and DomeLight,
     // 1000 for nits for emission. See https://github.com/erich666/McUsd#omniverse-adjustments for a way to delete these
     // and use the "true" emission values: 1550, 310, and 53000.
     //strcpy_s(outputString, 256, "            double \"rtx:post:tonemap:cameraShutter\" = 10\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     //strcpy_s(outputString, 256, "            double \"rtx:post:tonemap:filmIso\" = 1000\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // If fireflies are suppressed in the path tracer, the result is considerably dimmer. OM-74000
     // Adjusting the emissives to a reasonable range seems to solve this one, so not necessary
     //strcpy_s(outputString, 256, "            bool \"rtx:pathtracing:fireflyFilter:enabled\" = 0\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // Slows performance down massively in real-time rendering mode (like 3X), but without it, semitransparent objects
     // do not display correctly. This is documented in Mineways' docs about OV Create.
     // A little more info at: https://github.com/erich666/McUsd#omniverse-adjustments
     // Found in Real-Time, Ray Tracing, Translucency area.
     strcpy_s(outputString, 256, "            bool \"rtx:raytracing:fractionalCutoutOpacity\" = 1\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // Reinhard gives a different look to HDR, sometimes better
     //strcpy_s(outputString, 256, "            double \"rtx:post:tonemap:op\" = 2\n");
-    //WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    //WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     strcpy_s(outputString, 256, "            token \"rtx:rendermode\" = \"PathTracing\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // Normally washes things out. Find this setting in Omniverse in the upper right, under
     // Render Settings tab, Renderer: Real-Time, Ray Tracing, Indirect Diffuse Light, Ambient Light Intensity
     strcpy_s(outputString, 256, "            float3 \"rtx:sceneDb:ambientLightColor\" = (0, 0, 0)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "    }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     sprintf_s(outputString, 256, "    defaultPrim = \"%s\"\n", defaultPrim);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // let's never touch metersPerUnit, it leads to confusion, e.g., https://github.com/erich666/McUsd/issues/3
     sprintf_s(outputString, 256, "    metersPerUnit = 0.01\n    upAxis = \"%s\"\n)\n", gModel.options->pEFD->chkMakeZUp[gModel.options->pEFD->fileType] ? "Z" : "Y");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     return 0;
 }
@@ -27338,59 +29520,59 @@ static int addCameraUSD()
     Vec2Op(loc, =, (float)(1.0/sqrt(3.0f)) * maxSize + 100.0f * center);
 
     strcpy_s(outputString, 256, "    def Camera \"Camera\" (\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        hide_in_stage_window = false\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        no_delete = false\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "    )\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "    {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float4[] clippingPlanes = []\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float2 clippingRange = (1, 10000000)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float focalLength = 18.147562\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float focusDistance = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float fStop = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float horizontalAperture = 20.955\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float horizontalApertureOffset = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     sprintf_s(outputString, 256, "        custom vector3d omni:kit:centerOfInterest = (0, 0, %f)\n", -maxSize);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        token projection = \"perspective\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        uniform token purpose = \"default\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        double shutter:close = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        double shutter:open = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        uniform token stereoRole = \"mono\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float verticalAperture = 15.2908\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float verticalApertureOffset = 0\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        token visibility = \"inherited\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     // really don't like YXZ here and below, ZXY is better, with -45,45,0. But this preserves the translations
     // For some reason, most files I've seen use float3 for (just) the camera for (just) rotate and scale
     strcpy_s(outputString, 256, "        float3 xformOp:rotateZXY = (-38, 45, 0)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        float3 xformOp:scale = (1, 1, 1)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     sprintf_s(outputString, 256, "        double3 xformOp:translate = (%f, %f, %f)\n", loc[0], loc[1], loc[2]);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        uniform token[] xformOpOrder = [\"xformOp:translate\", \"xformOp:rotateZXY\", \"xformOp:scale\"]\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "    }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     return 0;
 }
@@ -27624,23 +29806,23 @@ static int createMeshesUSD(wchar_t* blockLibraryPath, char *materialLibrary, boo
         // write comments for Import Settings and write globals
         // openUSDFile does this first line, always:
         //strcpy_s(outputString, 256, "    (\n");
-        //WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        //WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "defaultPrim=\"Blocks\"\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         sprintf_s(outputString, 256, "subLayers = [ @%s@ ]\n", materialLibrary);
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "    metersPerUnit = 1\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "    upAxis = \"Y\"\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, ")\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "def Scope \"Blocks\"\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "{\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
 
         // Go through all instances.
         // Sort each set of faces by the material.
@@ -27663,24 +29845,24 @@ static int createMeshesUSD(wchar_t* blockLibraryPath, char *materialLibrary, boo
             const char* subName = RetrieveBlockSubname(type, dataVal);
 
             sprintf_s(outputString, 256, "\n    def Xform \"Block_%d_%d\"\n    {\n", type, dataVal);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "        int blockType = %d\n", type);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "        int blockSubType = %d\n", dataVal);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "        string typeName = \"%s\"\n", gBlockDefinitions[type].name);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "        string subTypeName = \"%s\"\n", subName);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "        int blockFlags = %d\n\n", (int)gBlockDefinitions[type].flags);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             /* old, non-sorted method, without metadata
             char blockName[MAX_PATH_AND_FILE];
             nameFromHash(gModel.instance[i].hash, blockName);
             char blockNameUnderlined[MAX_PATH_AND_FILE];
             convertCharPathUnderlined(blockNameUnderlined, blockName, true);
             sprintf_s(outputString, 256, "\n    def Xform \"%s\"\n{\n", blockNameUnderlined);
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
             */
 
             int firstFaceNumber = gModel.instance[i].faceNumber;
@@ -27691,7 +29873,7 @@ static int createMeshesUSD(wchar_t* blockLibraryPath, char *materialLibrary, boo
 
             // sort
             UPDATE_STATUS(-999.0f, L"Sort by ID");
-            qsort_s(&gModel.faceList[firstFaceNumber], numFaces, sizeof(FaceRecord*), tileUSDIdCompare, NULL);
+            sortFaces(&gModel.faceList[firstFaceNumber], numFaces, FACE_SORT_BY_USD_TILE_ID);
 
             startRun = firstFaceNumber;
             // output meshes for the given block
@@ -27702,11 +29884,11 @@ static int createMeshesUSD(wchar_t* blockLibraryPath, char *materialLibrary, boo
             }
 
             strcpy_s(outputString, 256, "    }\n");
-            WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
         }
 
         strcpy_s(outputString, 256, "\n} # end Blocks\n");
-        WERROR_MODEL(PortaWrite(blockFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(blockFile, outputString, strlen(outputString)));
 
         if (retCode |= closeUSDFile(blockFile)) {
             // failed to quit - really, we're done, so nothing to do, but left in case someday we add more code below.
@@ -27848,7 +30030,7 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
         // consolidated mesh - just use the name of the texture associated with the material
         sprintf_s(outputString, 256, "\n        def Mesh \"%s\" (\n            prepend apiSchemas = [\"MaterialBindingAPI\"]\n        )\n        {\n", mtlName);
     }
-    WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
 
     // is mesh two-sided? If it's interior to an opaque, it doesn't have to be, which can be a bit faster to render.
     // Only Sketchfab cares, AFAIK. TODO - should test material.
@@ -27856,22 +30038,20 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
     unsigned int mtlFlags = gBlockDefinitions[gModel.faceList[startingFace]->materialType].flags;
     if (mtlFlags & (BLF_CUTOUTS | BLF_TRANSPARENT)) {
         strcpy_s(outputString, 256, "            bool doubleSided = 1\n");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
     }
 
     if (gModel.instancing) {
         strcpy_s(outputString, 256, "            int[] faceVertexCounts = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numFaces; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.faceVertexCounts[i], (i == numFaces - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.faceVertexCounts[i], (i == numFaces - 1) ? "]\n" : ", "));
         }
 
         strcpy_s(outputString, 256, "            int[] faceVertexIndices = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.indices[i], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.indices[i], (i == numVerts - 1) ? "]\n" : ", "));
         }
 
         // define SINGLE_MATERIAL to export a single white material
@@ -27879,18 +30059,15 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
         //#define SINGLE_MATERIAL
         //#define WHITE_MATERIAL
 #ifdef SINGLE_MATERIAL
-        sprintf_s(outputString, 256, "            rel material:binding = <%s%s/Looks/basic>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim);
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Printf(file, "            rel material:binding = <%s%s/Looks/basic>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim));
 #else
-        sprintf_s(outputString, 256, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName);
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Printf(file, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName));
 #endif
 
         strcpy_s(outputString, 256, "            normal3f[] normals = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "(%g, %g, %g)%s", gOutData.normals[i][X], gOutData.normals[i][Y], gOutData.normals[i][Z], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", gOutData.normals[i][X], gOutData.normals[i][Y], gOutData.normals[i][Z], (i == numVerts - 1) ? "]\n" : ", "));
         }
 
         // if we're writing out a huge array, take a moment and update the progress
@@ -27899,18 +30076,16 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
 
         // if ever needed: uniform token orientation = "rightHanded"
         strcpy_s(outputString, 256, "            point3f[] points = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "(%g, %g, %g)%s", gOutData.points[i][X], gOutData.points[i][Y], gOutData.points[i][Z], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", gOutData.points[i][X], gOutData.points[i][Y], gOutData.points[i][Z], (i == numVerts - 1) ? "]\n" : ", "));
         }
 
         strcpy_s(outputString, 256, "            texCoord2f[] primvars:st = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
             // "interpolation = "vertex"" is the default, see https://www.openusd.org/release/api/class_usd_geom_point_based.html#ae0ac6f60f8135799ba42a16fe466f89b 
-            sprintf_s(outputString, 256, "(%g, %g)%s", gOutData.uvs[i][X], gOutData.uvs[i][Y], (i == numVerts - 1) ? "] (\n            interpolation = \"vertex\"\n        )\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g)%s", gOutData.uvs[i][X], gOutData.uvs[i][Y], (i == numVerts - 1) ? "] (\n            interpolation = \"vertex\"\n        )\n" : ", "));
         }
 
     }
@@ -27922,27 +30097,24 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
         initializeBox(box);
         removeDuplicateVertices(box);
 
-        sprintf_s(outputString, 256, "            float3[] extent = [(%f, %f, %f), (%f, %f, %f)]\n",
+        WERROR_MODEL(OutBuf_Printf(gModelFile, "            float3[] extent = [(%f, %f, %f), (%f, %f, %f)]\n",
             (float)box.min[X],
             (float)box.min[Y],
             (float)box.min[Z],
             (float)box.max[X],
             (float)box.max[Y],
-            (float)box.max[Z] );
-        WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+            (float)box.max[Z] ));
 
         strcpy_s(outputString, 256, "            int[] faceVertexCounts = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numFaces; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.faceVertexCounts[i], (i == numFaces - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.faceVertexCounts[i], (i == numFaces - 1) ? "]\n" : ", "));
         }
 
         strcpy_s(outputString, 256, "            int[] faceVertexIndices = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", "));
         }
 
         // define SINGLE_MATERIAL to export a single white material
@@ -27950,33 +30122,28 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
         //#define SINGLE_MATERIAL
         //#define WHITE_MATERIAL
 #ifdef SINGLE_MATERIAL
-        sprintf_s(outputString, 256, "            rel material:binding = <%s%s/Looks/basic>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim);
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Printf(file, "            rel material:binding = <%s%s/Looks/basic>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim));
 #else
-        sprintf_s(outputString, 256, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName);
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Printf(file, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName));
 #endif
 
         strcpy_s(outputString, 256, "            point3f[] points = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < gOutData.vertCountWelded; i++) {
-            sprintf_s(outputString, 256, "(%g, %g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (gOutData.welded[i])[0][Z], (i == gOutData.vertCountWelded - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (gOutData.welded[i])[0][Z], (i == gOutData.vertCountWelded - 1) ? "]\n" : ", "));
         }
 
         removeDuplicateNormals();
 
         strcpy_s(outputString, 256, "            normal3f[] primvars:normals = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < gOutData.vertCountWelded; i++) {
-            sprintf_s(outputString, 256, "(%g, %g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (gOutData.welded[i])[0][Z], (i == gOutData.vertCountWelded - 1) ? "] (\n                interpolation = \"faceVarying\"\n            )\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (gOutData.welded[i])[0][Z], (i == gOutData.vertCountWelded - 1) ? "] (\n                interpolation = \"faceVarying\"\n            )\n" : ", "));
         }
         strcpy_s(outputString, 256, "            int[] primvars:normals:indices = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", "));
         }
 
         // if we're writing out a huge array, take a moment and update the progress
@@ -27986,28 +30153,26 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
         removeDuplicateTextureSTs();
 
         strcpy_s(outputString, 256, "            texCoord2f[] primvars:st = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < gOutData.vertCountWelded; i++) {
             // "interpolation = "vertex"" is the default, see https://www.openusd.org/release/api/class_usd_geom_point_based.html#ae0ac6f60f8135799ba42a16fe466f89b 
             //sprintf_s(outputString, 256, "(%g, %g)%s", gOutData.uvs[i][X], gOutData.uvs[i][Y], (i == numVerts - 1) ? "] (\n            interpolation = \"vertex\"\n        )\n" : ", ");
-            sprintf_s(outputString, 256, "(%g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (i == gOutData.vertCountWelded - 1) ? "] (\n                interpolation = \"faceVarying\"\n            )\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "(%g, %g)%s", (gOutData.welded[i])[0][X], (gOutData.welded[i])[0][Y], (i == gOutData.vertCountWelded - 1) ? "] (\n                interpolation = \"faceVarying\"\n            )\n" : ", "));
         }
         strcpy_s(outputString, 256, "            int[] primvars:st:indices = [");
-        WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
         for (i = 0; i < numVerts; i++) {
-            sprintf_s(outputString, 256, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", ");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.indicesWelded[i], (i == numVerts - 1) ? "]\n" : ", "));
         }
     }
 
     // critical if you are not defining subdivision surfaces, which is what USD assumes you're using
     // (I'm told 90% of the meshes in films are subdiv surfaces). See https://openusd.org/dev/api/class_usd_geom_mesh.html
     strcpy_s(outputString, 256, "            uniform token subdivisionScheme = \"none\"\n");
-    WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
 
     strcpy_s(outputString, 256, "        }\n");
-    WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
 
 #ifdef SPLIT_STRATEGY
     }
@@ -28022,36 +30187,31 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
             int numSegVertices = 0;
 
             // output mesh's arrays
-            sprintf_s(outputString, 256, "%s        def Mesh \"%s__%d\"\n    {\n", startingFace ? "\n" : "", mtlName, m);
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "%s        def Mesh \"%s__%d\"\n    {\n", startingFace ? "\n" : "", mtlName, m));
 
             strcpy_s(outputString, 256, "            int[] faceVertexCounts = [");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
             for (i = 0; i < numSegFaces; i++) {
-                sprintf_s(outputString, 256, "%d%s", gOutData.faceVertexCounts[i + startFace], (i == numSegFaces - 1) ? "]\n" : ", ");
-                WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.faceVertexCounts[i + startFace], (i == numSegFaces - 1) ? "]\n" : ", "));
 
                 // we also use this loop to count up how many vertices we'll output
                 numSegVertices += gOutData.faceVertexCounts[i];
             }
 
             strcpy_s(outputString, 256, "            int[] faceVertexIndices = [");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
             for (i = 0; i < numSegVertices; i++) {
                 // we could really just substitute "i" for the whole gOutData.indices list, since this is always 0,1,2,3...
                 // but, do this way, just in case
-                sprintf_s(outputString, 256, "%d%s", gOutData.indices[i + startVertex] - startVertex, (i == numSegVertices - 1) ? "]\n" : ", ");
-                WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(file, "%d%s", gOutData.indices[i + startVertex] - startVertex, (i == numSegVertices - 1) ? "]\n" : ", "));
             }
 
-            sprintf_s(outputString, 256, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Printf(file, "            rel material:binding = <%s%s/Looks/%s>\n", (prefixLook == NULL) ? "" : prefixLook, slashDefaultPrim, mtlName));
 
             strcpy_s(outputString, 256, "            normal3f[] normals = [");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
             for (i = 0; i < numSegVertices; i++) {
-                sprintf_s(outputString, 256, "(%g, %g, %g)%s", gOutData.normals[i + startVertex][X], gOutData.normals[i + startVertex][Y], gOutData.normals[i + startVertex][Z], (i == numSegVertices - 1) ? "]\n" : ", ");
-                WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", gOutData.normals[i + startVertex][X], gOutData.normals[i + startVertex][Y], gOutData.normals[i + startVertex][Z], (i == numSegVertices - 1) ? "]\n" : ", "));
             }
 
             // if we're writing out a huge array, take a moment and update the progress
@@ -28059,21 +30219,19 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
                 UPDATE_PROGRESS(gProgress.start.output + gProgress.absolute.output * ((float)startFace / (float)gModel.faceCount));
 
             strcpy_s(outputString, 256, "            point3f[] points = [");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
             for (i = 0; i < numSegVertices; i++) {
-                sprintf_s(outputString, 256, "(%g, %g, %g)%s", gOutData.points[i + startVertex][X], gOutData.points[i + startVertex][Y], gOutData.points[i + startVertex][Z], (i == numSegVertices - 1) ? "]\n" : ", ");
-                WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(file, "(%g, %g, %g)%s", gOutData.points[i + startVertex][X], gOutData.points[i + startVertex][Y], gOutData.points[i + startVertex][Z], (i == numSegVertices - 1) ? "]\n" : ", "));
             }
 
             strcpy_s(outputString, 256, "            texCoord2f[] primvars:st = [");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
             for (i = 0; i < numSegVertices; i++) {
-                sprintf_s(outputString, 256, "(%g, %g)%s", gOutData.uvs[i + startVertex][X], gOutData.uvs[i + startVertex][Y], (i == numSegVertices - 1) ? "] (\n            interpolation = \"vertex\"\n        )\n" : ", ");
-                WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Printf(file, "(%g, %g)%s", gOutData.uvs[i + startVertex][X], gOutData.uvs[i + startVertex][Y], (i == numSegVertices - 1) ? "] (\n            interpolation = \"vertex\"\n        )\n" : ", "));
             }
 
             strcpy_s(outputString, 256, "        }\n");
-            WERROR_MODEL(PortaWrite(file, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(file, outputString, strlen(outputString)));
 
             // compute next starting locations
             startVertex += numSegVertices;
@@ -28088,195 +30246,165 @@ static int outputUSDMesh(PORTAFILE file, int startingFace, int numFaces, int num
 static void removeDuplicateVertices(Box &box)
 {
     // input list is gOutData.indices. Output is gOutData.indicesWelded and vertCountWelded
-    gOutData.vertCountWelded = 0;
-    VertexHash* vhash;  // only used when a new hash is needed
-    // start at the absolute maximum needed
-    int vertCount = gOutData.vertCount;
-    vertCount = min(vertCount, gModel.vertexCount);
-    assert(vertCount <= gOutData.weldedHashSize);
-    // zero out the hash location list
-    memset(gOutData.vhashLocation, 0, vertCount * sizeof(VertexHash**));
-
-    // Go through list, make a hash of the vertex. Does vertex match one already encountered? Use the index stored with the hash record. Else set the hash record.
-    for (int i = 0; i < gOutData.vertCount; i++) {
-        // find hash for vertex, compare vertex to previous vertices if any at that hash position
-        int vertexIndex = gOutData.indices[i];
-        int hashLoc = hashVertex(&gOutData.points[vertexIndex]) % vertCount;
-        if (gOutData.vhashLocation[hashLoc]) {
-            // previous hash exists, test if it's the same location for this hash or any others
-            vhash = gOutData.vhashLocation[hashLoc];
-            while (vhash) {
-
-                //float x1 = (vhash->point)[0][X];
-                //float x2 = gOutData.points[vertexIndex][X];
-                //float y1 = (vhash->point)[0][Y];
-                //float y2 = gOutData.points[vertexIndex][Y];
-                //float z1 = (vhash->point)[0][Z];
-                //float z2 = gOutData.points[vertexIndex][Z];
-                //if ((x1 == x2) &&
-                //    (y1 == y2) &&
-                //    (z1 == z2)) {
-                if ((gOutData.points[vhash->dataLoc][X] == gOutData.points[vertexIndex][X]) &&
-                    (gOutData.points[vhash->dataLoc][Y] == gOutData.points[vertexIndex][Y]) &&
-                    (gOutData.points[vhash->dataLoc][Z] == gOutData.points[vertexIndex][Z]) ) {
-
-                    // match found, so note its matching index and move on
-                    gOutData.indicesWelded[i] = vhash->id;
-                    goto Done;
-                }
-                else {
-                    // points don't match, so go to next hash, if any
-                    vhash = vhash->pvh;
-                }
-            }
-        }
-        // end of list and no match found, add the new hash at this location, to the front of the list
-        // (I figure that, with locality, if a new vertex is found for the location, we should test it first in the linked list from now on)
-        vhash = &gOutData.vhashPool[gOutData.vertCountWelded];
-        vhash->id = gOutData.vertCountWelded;
-        vhash->dataLoc = i;
-        gOutData.welded[gOutData.vertCountWelded] = &gOutData.points[i];
-        vhash->pvh = gOutData.vhashLocation[hashLoc];
-        gOutData.vhashLocation[hashLoc] = vhash;
-
-        increaseBoxByVertex(box, (gOutData.welded[gOutData.vertCountWelded])[0]);
+    weldOutData((float*)gOutData.points, 3, false, &box);
+}
 
-        gOutData.vertCountWelded++;
-        assert(gOutData.vertCountWelded <= gOutData.weldedHashSize);
+static void removeDuplicateNormals()
+{
+    // all the corners of a face usually share its normal
+    weldOutData((float*)gOutData.normals, 3, true, NULL);
+}
 
-        // whatever happens, the vhash will have the ID.
-    Done:
-        gOutData.indicesWelded[i] = vhash->id;
-    }
+static void removeDuplicateTextureSTs()
+{
+    weldOutData((float*)gOutData.uvs, 2, false, NULL);
 }
 
-// extremely similar to the above. *** marks differences
-static void removeDuplicateNormals()
+// Find the unique values among gOutData.vertCount values in data, each of components floats: 3 for points and normals,
+// 2 for UVs. Sets gOutData.indicesWelded to the unique value for each, and gOutData.welded and vertCountWelded to the
+// unique values, in the order first found. If checkLast is set, each value is first compared with the last one found,
+// which is worth it only if runs of the same value are common. If pBox is given, it's increased by each unique value.
+static void weldOutData(float* data, int components, bool checkLast, Box* pBox)
 {
-    // input list is gOutData.indices. Output is gOutData.indicesWelded and vertCountWelded
+    int maxUnique = min(gOutData.vertCount, gOutData.weldedHashSize);
+    unsigned int tableSize = 1;
+    unsigned int mask;
+    int lastId = -1;
+
+    // never more than half full, so searches are short
+    while (tableSize < 2 * (unsigned int)maxUnique)
+        tableSize <<= 1;
+    assert(tableSize <= gOutData.weldTableSize);
+    mask = tableSize - 1;
+    memset(gOutData.weldTable, 0xff, tableSize * sizeof(int));
     gOutData.vertCountWelded = 0;
-    VertexHash* vhash;  // only used when a new hash is needed
-    // zero out the hash location list.
-    // For normals, we know that we can use the minimum between the number of vertices in the original mesh (gOutData.vertCount) divided by 4, or the number
-    // of total normals. 
-    int normalCount = gOutData.vertCount;
-    normalCount = min(normalCount, gModel.vertexCount);
-    assert(normalCount <= gOutData.weldedHashSize);
-    memset(gOutData.vhashLocation, 0, normalCount * sizeof(VertexHash**));  // *** instead of vertCount
-
-    // Go through list, make a hash of the normal. Does normal match one already encountered? Use the index stored with the hash record. Else set the hash record.
+
     for (int i = 0; i < gOutData.vertCount; i++) {
-        // find hash for vertex, compare vertex to previous vertices if any at that hash position
-        int vertexIndex = gOutData.indices[i];
-        int hashLoc = hashVertex(&gOutData.normals[vertexIndex]) % normalCount;  // *** instead of vertCount
-        if (gOutData.vhashLocation[hashLoc]) {
-            // previous hash exists, test if it's the same location for this hash or any others
-            vhash = gOutData.vhashLocation[hashLoc];
-            while (vhash) {
-
-                //float x1 = (vhash->point)[0][X];
-                //float x2 = gOutData.normals[vertexIndex][X];
-                //float y1 = (vhash->point)[0][Y];
-                //float y2 = gOutData.normals[vertexIndex][Y];
-                //float z1 = (vhash->point)[0][Z];
-                //float z2 = gOutData.normals[vertexIndex][Z];
-                //if ((x1 == x2) &&
-                //    (y1 == y2) &&
-                //    (z1 == z2)) {
-                if ((gOutData.normals[vhash->dataLoc][X] == gOutData.normals[vertexIndex][X]) && // ***
-                    (gOutData.normals[vhash->dataLoc][Y] == gOutData.normals[vertexIndex][Y]) &&
-                    (gOutData.normals[vhash->dataLoc][Z] == gOutData.normals[vertexIndex][Z])) {
-
-                    // match found, so note its matching index and move on
-                    gOutData.indicesWelded[i] = vhash->id;
-                    goto Done;
-                }
-                else {
-                    // normals don't match, so go to next hash, if any
-                    vhash = vhash->pvh;
-                }
+        float* value = &data[gOutData.indices[i] * components];
+        // is it the last value found, bit for bit?
+        if (checkLast && (lastId >= 0)) {
+            uint32_t* lastBits = (uint32_t*)gOutData.welded[lastId];
+            uint32_t* bits = (uint32_t*)value;
+            if ((bits[0] == lastBits[0]) && (bits[1] == lastBits[1]) && ((components < 3) || (bits[2] == lastBits[2]))) {
+                gOutData.indicesWelded[i] = lastId;
+                continue;
             }
         }
-        // end of list and no match found, add the new hash at this location, to the front of the list
-        // (I figure that, with locality, if a new vertex is found for the location, we should test it first in the linked list from now on)
-        vhash = &gOutData.vhashPool[gOutData.vertCountWelded];
-        vhash->id = gOutData.vertCountWelded;
-        vhash->dataLoc = i;
-        gOutData.welded[gOutData.vertCountWelded] = &gOutData.normals[i]; // ***
-        vhash->pvh = gOutData.vhashLocation[hashLoc];
-        gOutData.vhashLocation[hashLoc] = vhash;
-
-        gOutData.vertCountWelded++;
-        assert(gOutData.vertCountWelded <= gOutData.weldedHashSize);
-
-        // whatever happens, the vhash will have the ID.
-    Done:
-        gOutData.indicesWelded[i] = vhash->id;
+        unsigned long long key = weldKey(value, components);
+        int id;
+        unsigned int loc = WELD_TABLE_LOCATION(key, mask);
+        for (;;) {
+            id = gOutData.weldTable[loc];
+            if (id < 0) {
+                // not found, so a new unique value
+                id = gOutData.vertCountWelded++;
+                assert(gOutData.vertCountWelded <= maxUnique);
+                gOutData.weldTable[loc] = id;
+                gOutData.weldKeys[id] = key;
+                gOutData.welded[id] = (Point*)value;
+                if (pBox)
+                    increaseBoxByVertex(*pBox, *(Point*)value);
+                break;
+            }
+            if (weldKeyMatches(key, id, value, components))
+                break;
+            loc = (loc + 1) & mask;
+        }
+        gOutData.indicesWelded[i] = id;
+        lastId = id;
     }
 }
 
-// extremely similar to the above. *** marks differences
-static void removeDuplicateTextureSTs()
+// Does the value with this key match the unique value with this ID? A lattice key is the value itself; otherwise, check
+// that it's not just the same hash.
+static bool weldKeyMatches(unsigned long long key, int id, float* value, int components)
 {
-    // input list is gOutData.indices. Output is gOutData.indicesWelded and vertCountWelded
+    if (gOutData.weldKeys[id] != key)
+        return false;
+    if (!(key & WELD_OFF_LATTICE))
+        return true;
+    float* found = (float*)gOutData.welded[id];
+    return ((found[0] == value[0]) && (found[1] == value[1]) && ((components < 3) || (found[2] == value[2])));
+}
+
+// The key for welding a value: its lattice coordinates, packed, or a hash of its bits with WELD_OFF_LATTICE set. All the
+// components are tested for being on the lattice at once, with SSE2.
+static unsigned long long weldKey(float* value, int components)
+{
+    union {
+        float f;
+        uint32_t u;
+    } fu;
+    unsigned long long key;
+    int c;
+
+    __m128 v = _mm_setr_ps(value[0], value[1], (components > 2) ? value[2] : 0.0f, 0.0f);
+    __m128 q = _mm_mul_ps(v, _mm_set1_ps(WELD_LATTICE_SCALE));
+    __m128i iq = _mm_cvttps_epi32(q);
+    // on the lattice if a whole number, and in range; NaNs fail both
+    __m128 onLattice = _mm_and_ps(_mm_cmpeq_ps(_mm_cvtepi32_ps(iq), q),
+        _mm_cmplt_ps(_mm_and_ps(q, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))), _mm_set1_ps((float)WELD_LATTICE_LIMIT)));
+    // -0.0 is off the lattice, so that it is kept apart from 0.0, as it always was
+    __m128i negativeZero = _mm_cmpeq_epi32(_mm_castps_si128(v), _mm_set1_epi32((int)0x80000000));
+    if ((_mm_movemask_ps(onLattice) == 0xf) && (_mm_movemask_epi8(negativeZero) == 0)) {
+        int lattice[4];
+        _mm_storeu_si128((__m128i*)lattice, _mm_add_epi32(iq, _mm_set1_epi32(WELD_LATTICE_LIMIT)));
+        key = ((unsigned long long)lattice[0] << 21) | (unsigned long long)lattice[1];
+        if (components > 2)
+            key = (key << 21) | (unsigned long long)lattice[2];
+        return key;
+    }
+
+    key = 0xcbf29ce484222325ULL;
+    for (c = 0; c < components; c++) {
+        fu.f = value[c];
+        key = (key ^ fu.u) * 0x100000001b3ULL;
+    }
+    return key | WELD_OFF_LATTICE;
+}
+
+// Mix the bits of a weld key, so that nearby lattice locations land far apart in the table.
+static unsigned int weldMix(unsigned long long key)
+{
+    // the MurmurHash3 finalizer
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (unsigned int)key;
+}
+
+// How values used to be welded, kept for BenchmarkUSDWeld(): hash each value's float bits into lists, in a table of one
+// location per value.
+static void weldOutDataByFloatHash(float* data, int components, VertexHash** vhashLocation, VertexHash* vhashPool)
+{
+    int hashSize = min(gOutData.vertCount, gOutData.weldedHashSize);
+    VertexHash* vhash;
     gOutData.vertCountWelded = 0;
-    VertexHash* vhash;  // only used when a new hash is needed
-    // zero out the hash location list.
-    // For uvs, we know that we can use the minimum between the number of vertices in the original mesh (gOutData.vertCount), or the number
-    // of total uvs. 
-    int uvCount = gOutData.vertCount;
-    uvCount = min(uvCount, gModel.uvGridListCount + gModel.uvIndexCount);
-    assert(uvCount <= gOutData.weldedHashSize);
-    memset(gOutData.vhashLocation, 0, uvCount * sizeof(VertexHash**));  // *** instead of vertCount
-
-    // Go through list, make a hash of the normal. Does normal match one already encountered? Use the index stored with the hash record. Else set the hash record.
+    memset(vhashLocation, 0, hashSize * sizeof(VertexHash*));
+
     for (int i = 0; i < gOutData.vertCount; i++) {
-        // find hash for vertex, compare vertex to previous vertices if any at that hash position
-        int vertexIndex = gOutData.indices[i];
-        int hashLoc = hashTextureST(&gOutData.uvs[vertexIndex]) % uvCount;  // *** instead of vertCount
-        if (gOutData.vhashLocation[hashLoc]) {
-            // previous hash exists, test if it's the same location for this hash or any others
-            vhash = gOutData.vhashLocation[hashLoc];
-            while (vhash) {
-
-                //float x1 = (vhash->point)[0][X];
-                //float x2 = gOutData.uv[vertexIndex][X];
-                //float y1 = (vhash->point)[0][Y];
-                //float y2 = gOutData.uv[vertexIndex][Y];
-                //if ((x1 == x2) &&
-                //    (y1 == y2)) {
-                if ((gOutData.uvs[vhash->dataLoc][X] == gOutData.uvs[vertexIndex][X]) && // ***
-                    (gOutData.uvs[vhash->dataLoc][Y] == gOutData.uvs[vertexIndex][Y])) {
-
-                    // match found, so note its matching index and move on
-                    gOutData.indicesWelded[i] = vhash->id;
-                    goto Done;
-                }
-                else {
-                    // uv don't match, so go to next hash, if any
-                    vhash = vhash->pvh;
-                }
+        float* value = &data[gOutData.indices[i] * components];
+        int hashLoc = ((components == 3) ? hashVertex((Point*)value) : hashTextureST((Point2*)value)) % hashSize;
+        for (vhash = vhashLocation[hashLoc]; vhash; vhash = vhash->pvh) {
+            float* found = &data[vhash->dataLoc * components];
+            if ((found[0] == value[0]) && (found[1] == value[1]) && ((components < 3) || (found[2] == value[2]))) {
+                break;
             }
         }
-        // end of list and no match found, add the new hash at this location, to the front of the list
-        // (I figure that, with locality, if a new vertex is found for the location, we should test it first in the linked list from now on)
-        vhash = &gOutData.vhashPool[gOutData.vertCountWelded];
-        vhash->id = gOutData.vertCountWelded;
-        vhash->dataLoc = i;
-        gOutData.welded[gOutData.vertCountWelded] = (Point *)&gOutData.uvs[i]; // ***
-        vhash->pvh = gOutData.vhashLocation[hashLoc];
-        gOutData.vhashLocation[hashLoc] = vhash;
-
-        gOutData.vertCountWelded++;
-        assert(gOutData.vertCountWelded <= gOutData.weldedHashSize);
-
-        // whatever happens, the vhash will have the ID.
-    Done:
+        if (vhash == NULL) {
+            vhash = &vhashPool[gOutData.vertCountWelded];
+            vhash->id = gOutData.vertCountWelded;
+            vhash->dataLoc = gOutData.indices[i];
+            gOutData.welded[gOutData.vertCountWelded++] = (Point*)value;
+            vhash->pvh = vhashLocation[hashLoc];
+            vhashLocation[hashLoc] = vhash;
+        }
         gOutData.indicesWelded[i] = vhash->id;
     }
 }
 
-
 static unsigned int hashVertex(Point* point)
 {
     // An old hash, maybe good enough? Could use murmur or maybe something from https://www.jcgt.org/published/0009/03/02/
@@ -28362,15 +30490,22 @@ static boolean allocOutHashData()
     weldedCount = max(weldedCount, gModel.normalListCount);
     weldedCount = max(weldedCount, gModel.uvGridListCount + gModel.uvIndexCount);
 
+    return allocWeldTable(weldedCount);
+}
+
+static boolean allocWeldTable(int weldedCount)
+{
     gOutData.weldedHashSize = weldedCount;
-    // TODO: could make location list smaller, since we expect vertices to be shared, but then we need a
-    // different size number than vertsize.
-    gOutData.vhashLocation = (VertexHash**)malloc(weldedCount * sizeof(VertexHash*));
-    gOutData.vhashPool = (VertexHash*)malloc(weldedCount * sizeof(VertexHash));
+    // a power of two at least twice as large as the most unique values, so that it's never more than half full
+    gOutData.weldTableSize = 1;
+    while (gOutData.weldTableSize < 2 * (unsigned int)weldedCount)
+        gOutData.weldTableSize <<= 1;
+    gOutData.weldTable = (int*)malloc(gOutData.weldTableSize * sizeof(int));
+    gOutData.weldKeys = (unsigned long long*)malloc(weldedCount * sizeof(unsigned long long));
     gOutData.welded = (Point**)malloc(weldedCount * sizeof(Point*));
 
-    return ((gOutData.vhashLocation != NULL) &&
-        (gOutData.vhashPool != NULL) &&
+    return ((gOutData.weldTable != NULL) &&
+        (gOutData.weldKeys != NULL) &&
         (gOutData.welded != NULL));
 }
 
@@ -28427,16 +30562,16 @@ static void freeOutAndHashData()
         free(gOutData.uvs);
         free(gOutData.indices);
         free(gOutData.indicesWelded);
-        free(gOutData.vhashLocation);
-        free(gOutData.vhashPool);
+        free(gOutData.weldTable);
+        free(gOutData.weldKeys);
         free(gOutData.welded);
         gOutData.points = NULL;
         gOutData.normals = NULL;
         gOutData.uvs = NULL;
         gOutData.indices = NULL;
         gOutData.indicesWelded = NULL;
-        gOutData.vhashLocation = NULL;
-        gOutData.vhashPool = NULL;
+        gOutData.weldTable = NULL;
+        gOutData.weldKeys = NULL;
         gOutData.welded = NULL;
     }
     gOutData.vertsize = 0;
@@ -28454,6 +30589,89 @@ static void freeOutAndHashData()
     gOutData.vertCount = gOutData.faceCount = gOutData.splitCount = 0;
 }
 
+// For performance testing: make the points, normals and UVs of a large USD mesh, a made-up terrain of block tops and sides,
+// with some water and slabs, with the given number of faces. These are welded as the exporter used to, then on the
+// lattice, and the milliseconds each took are returned; sameOutput is set if they found the same unique values.
+// Returns non-zero if out of memory.
+int BenchmarkUSDWeld(int faces, double* floatHashMsec, double* latticeMsec, bool* sameOutput)
+{
+    int numVerts = 4 * faces;
+    // each column gives a top and a side face
+    int side = (int)sqrt((double)faces / 2.0) + 1;
+    int f, j, k;
+    int retCode = 0;
+    VertexHash** vhashLocation = (VertexHash**)malloc(numVerts * sizeof(VertexHash*));
+    VertexHash* vhashPool = (VertexHash*)malloc(numVerts * sizeof(VertexHash));
+    int* floatHashIndices = (int*)malloc(numVerts * sizeof(int));
+
+    *floatHashMsec = *latticeMsec = 0.0;
+    *sameOutput = true;
+    if ((vhashLocation == NULL) || (vhashPool == NULL) || (floatHashIndices == NULL) ||
+        !allocOutData(numVerts, faces) || !allocWeldTable(numVerts)) {
+        retCode = 1;
+        goto Exit;
+    }
+
+    for (f = 0; f < faces; f++) {
+        int column = f / 2;
+        int x = column % side;
+        int z = column / side;
+        float x0 = (float)(x - side / 2);
+        float z0 = (float)(z - side / 2);
+        float y0 = (float)(60 + (x * 7 + z * 13) % 5);
+        // water tops are off the lattice, and slabs are half height
+        float height = (column % 37 == 0) ? 8.0f / 9.0f : ((column % 11 == 0) ? 0.5f : 1.0f);
+        float corner[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+        for (j = 0; j < 4; j++) {
+            int iv = 4 * f + j;
+            gOutData.indices[iv] = iv;
+            if (f % 2 == 0) {
+                // top
+                Vec3Scalar(gOutData.points[iv], =, x0 + corner[j][0], y0 + height, z0 + corner[j][1]);
+                if (height == 8.0f / 9.0f) {
+                    Vec3Scalar(gOutData.normals[iv], =, 0.0995037f, 0.995037f, 0.0f);
+                }
+                else {
+                    Vec3Scalar(gOutData.normals[iv], =, 0.0f, 1.0f, 0.0f);
+                }
+                Vec2Scalar(gOutData.uvs[iv], =, corner[j][0], corner[j][1]);
+            }
+            else {
+                // side, facing +X
+                Vec3Scalar(gOutData.points[iv], =, x0 + 1.0f, y0 + corner[j][1] * height, z0 + corner[j][0]);
+                Vec3Scalar(gOutData.normals[iv], =, 1.0f, 0.0f, 0.0f);
+                Vec2Scalar(gOutData.uvs[iv], =, corner[j][0], corner[j][1] * height);
+            }
+        }
+        gOutData.faceVertexCounts[f] = 4;
+    }
+
+    for (k = 0; k < 3; k++) {
+        float* data = (k == 0) ? (float*)gOutData.points : ((k == 1) ? (float*)gOutData.normals : (float*)gOutData.uvs);
+        int components = (k == 2) ? 2 : 3;
+        int floatHashCount;
+
+        clock_t start = clock();
+        weldOutDataByFloatHash(data, components, vhashLocation, vhashPool);
+        *floatHashMsec += 1000.0 * (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+        floatHashCount = gOutData.vertCountWelded;
+        memcpy(floatHashIndices, gOutData.indicesWelded, numVerts * sizeof(int));
+
+        start = clock();
+        weldOutData(data, components, (k == 1), NULL);
+        *latticeMsec += 1000.0 * (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+        if ((floatHashCount != gOutData.vertCountWelded) || memcmp(floatHashIndices, gOutData.indicesWelded, numVerts * sizeof(int)))
+            *sameOutput = false;
+    }
+
+Exit:
+    freeOutAndHashData();
+    free(vhashLocation);
+    free(vhashPool);
+    free(floatHashIndices);
+    return retCode;
+}
+
 // if libraryFile is not NULL, we make a separate material library
 static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibraryFilename, bool singleTerrainFile, char *slashDefaultPrim)
 {
@@ -28476,23 +30694,23 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
             goto Exit;
         }
         strcpy_s(outputString, 256, "defaultPrim=\"Blocks\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "    metersPerUnit = 1\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "    upAxis = \"Y\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, ")\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "def Scope \"Blocks\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "{\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     }
 
     strcpy_s(outputString, 256, "\n    def Scope \"Looks\" (\n        kind = \"model\"\n    )\n    {\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
     // spin out all the shaders, one per tile.
 
@@ -28507,35 +30725,35 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
     isTileValueConstant(0, 0, value);
     tileAlphaStatus(0);
     strcpy_s(outputString, 256, "        def Material \"basic\"\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        {\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     sprintf_s(outputString, 256, "            token outputs:surface.connect = <%s/Looks/basic/PreviewSurface.outputs:surface>\n", slashDefaultPrim);
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "\n            def Shader \"PreviewSurface\"\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            {\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                uniform token info:id = \"UsdPreviewSurface\"\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                color3f inputs:diffuseColor = (1.0, 1.0, 1.0)\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                float inputs:metallic = 0\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                float inputs:opacity = 1\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                float inputs:roughness = 1\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                int inputs:useSpecularWorkflow = 0\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                token outputs:out\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "                token outputs:surface\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            }\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        }\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 #else
     char mtlName[MAX_PATH_AND_FILE];
 
@@ -28687,9 +30905,9 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
         }
 
         sprintf_s(outputString, 256, "%s        def Material \"%s\"\n", startRun ? "\n" : "", mtlName);
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "        {\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 #ifdef WHITE_MATERIAL
         // make compiler happy
         mdlPath;
@@ -28700,74 +30918,74 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
         tileIsAnEmitter(0, 0);
 
         sprintf_s(outputString, 256, "            token outputs:surface.connect = <%s/Looks/%s/PreviewSurface.outputs:surface>\n", slashDefaultPrim, mtlName);
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "\n            def Shader \"PreviewSurface\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "            {\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                uniform token info:id = \"UsdPreviewSurface\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                color3f inputs:diffuseColor = (1.0, 1.0, 1.0)\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                float inputs:metallic = 0\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                float inputs:opacity = 1\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                float inputs:roughness = 1\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                int inputs:useSpecularWorkflow = 0\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                token outputs:out\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "                token outputs:surface\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         strcpy_s(outputString, 256, "            }\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 #else
         // we normally output MDL descriptions, etc. Allow turning this off, so that UsdPreview (only) materials are used.
         if (gModel.exportMDL) {
             // displacement_connect seems to be something MDL likes to have, e.g., https://developer.nvidia.com/usd/mdlschema
             sprintf_s(outputString, 256, "            token outputs:mdl:displacement.connect = <%s%s/Looks/%s/Shader.outputs:out>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "            token outputs:mdl:surface.connect = <%s%s/Looks/%s/Shader.outputs:out>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "            token outputs:mdl:volume.connect = <%s%s/Looks/%s/Shader.outputs:out>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         }
         // put this one in alphabetical order for the MDL
         if (usePreviewSurface) {
             // I don't think this is needed - it's not hooked up
             //sprintf_s(outputString, 256, "        token outputs:displacement.connect = <%s%s/Looks/%s/PreviewSurface.outputs:displacement>\n", prefixPath, slashDefaultPrim, mtlName);
-            //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "            token outputs:surface.connect = <%s%s/Looks/%s/PreviewSurface.outputs:surface>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         }
         // continue
         if (gModel.exportMDL) {
             strcpy_s(outputString, 256, "\n            def Shader \"Shader\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            {\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                uniform token info:implementationSource = \"sourceAsset\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             // don't use any custom material for semitransparent (glass, water) materials
             if (gModel.customMaterial && !isSemitransparent) {
                 // TODOUSD UberNN, or make a MinecraftGlass.mdl file as a wrapper?
                 //sprintf_s(outputString, 256, "                uniform asset info:mdl:sourceAsset = @%s%s.mdl@\n", mdlPath, isSemitransparent ? "OmniSurfaceUber" : "Mineways");
-                //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 //sprintf_s(outputString, 256, "                uniform token info:mdl:sourceAsset:subIdentifier = \"%s\"\n", isSemitransparent ? "OmniSurfaceUber" : "Mineways");
-                //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                uniform asset info:mdl:sourceAsset = @./%sMineways.mdl@\n", mdlPath);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                uniform token info:mdl:sourceAsset:subIdentifier = \"Mineways\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             else {
                 // NOTE: no mdlPath, as OmniGlass, OmniPBR, and OmniPBR_Opacity are built-in MDL files
                 sprintf_s(outputString, 256, "                uniform asset info:mdl:sourceAsset = @Omni%s.mdl@\n", isSemitransparent ? "Glass" : (isCutout ? "PBR_Opacity" : "PBR"));
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                uniform token info:mdl:sourceAsset:subIdentifier = \"Omni%s\"\n", isSemitransparent ? "Glass" : (isCutout ? "PBR_Opacity" : "PBR"));
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // if true, then normals and roughness are output here and so don't need to be output later
@@ -28789,246 +31007,246 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                     // normal map?
                     if (gModel.tileList[CATEGORY_NORMALS][swatchLoc]) {
                         sprintf_s(outputString, 256, "                asset inputs:coat_normal_image = @%s/%s%s.png@ (\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_NORMALS]);
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n"); // "raw" is the right choice for normals - see Absolution.
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayGroup = \"Coat\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Normal Map Image\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                float inputs:coat_weight = 0.5 (\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayGroup = \"Coat\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Weight\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
 
                     sprintf_s(outputString, 256, "                asset inputs:diffuse_reflection_color_image = @%s/%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"auto\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Base\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Color Image\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     sprintf_s(outputString, 256, "                asset inputs:specular_reflection_color_image = @%s/%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"auto\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Specular\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Color Image\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     sprintf_s(outputString, 256, "                float inputs:specular_reflection_ior = %g (\n", ior);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 1.5\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 2.0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Specular\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"IOR\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     // if there is a specular roughness map, set roughness to 1 as it acts as a influence for the roughness map
                     sprintf_s(outputString, 256, "                float inputs:specular_reflection_roughness = %g (\n", gModel.tileList[CATEGORY_ROUGHNESS][swatchLoc] ? 1.0f : specRoughness);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0.2\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Specular\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Roughness\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     if (gModel.tileList[CATEGORY_ROUGHNESS][swatchLoc]) {
                         sprintf_s(outputString, 256, "                asset inputs:specular_reflection_roughness_image = @%s/%s%s.png@ (\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_ROUGHNESS]);
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    colorSpace = \"auto\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        asset default = @@\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Specular\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Roughness Image\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                         strcpy_s(outputString, 256, "                int inputs:specular_reflection_roughness_image_alpha_mode = 1 (\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        int default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayGroup = \"Specular\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Roughness Image Alpha Mode\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    renderType = \"OmniImage::alpha_mode\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    sdrMetadata = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        string __SDR__enum_value = \"alpha_default\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        string options = \"alpha_default:0|alpha_red:1|alpha_green:2|alpha_blue:3|alpha_white:4|alpha_black:5|alpha_luminanace:6|alpha_average:7\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
 
                     sprintf_s(outputString, 256, "                asset inputs:specular_transmission_color_image = @%s/%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"auto\"\n");  should not be auto, probably
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Transmission\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Color Image\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     sprintf_s(outputString, 256, "                float inputs:specular_transmission_scattering_depth = %g (\n", depth);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 3.4028235e38\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Transmission\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Depth\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                float inputs:specular_transmission_weight = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Transmission\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Weight\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 else {
                 */
@@ -29036,54 +31254,54 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                 // Standard transmitter material (doesn't include blocky look
                 // when meters, 0.001 is pretty good, the default
                 strcpy_s(outputString, 256, "                float inputs:depth = 0.001 (\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        float default = 0.001\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float max = 1000\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float min = 0\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Color\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Volume Absorption Scale\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                 sprintf_s(outputString, 256, "                float inputs:frosting_roughness = %g (\n", specRoughness);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        float default = 0\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float max = 1\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float min = 0\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Roughness\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Glass Roughness\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                 // hack: the very blue water color is way too much - tone it down
                 if (isWater) {
@@ -29095,29 +31313,29 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                         g = 255;
                 }
                 sprintf_s(outputString, 256, "                color3f inputs:glass_color = (%g, %g, %g) (\n", (float)r / 255.0f, (float)g / 255.0f, (float)b / 255.0f);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        float3 default = (1, 1, 1)\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float3 max = (0, 0, 0)\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float3 min = (0, 0, 0)\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Color\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Glass Color\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                 // don't output the water texture, as it becomes way too blue
                 if (!isWater) {
@@ -29126,87 +31344,87 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
 
                     // currently not alphabetized - TODO - kind of messy to do so
                     sprintf_s(outputString, 256, "                asset inputs:cutout_opacity_texture = @./%s/%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"auto\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Opacity Map\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     //
                     strcpy_s(outputString, 256, "                bool inputs:enable_opacity = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        bool default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Enable Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     //
                     sprintf_s(outputString, 256, "                asset inputs:glass_color_texture = @./%s/%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"sRGB\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Color\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Glass Color Texture\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
 
                 sprintf_s(outputString, 256, "                float inputs:glass_ior = %g (\n", ior);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        float default = 1.491\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float max = 4\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                            float min = 1\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Refraction\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Glass IOR\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 //}
             }
             else {
@@ -29214,23 +31432,23 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
 
                 // add the "_y" if synthesized - material name differs from tile file name in this case
                 sprintf_s(outputString, 256, "                asset inputs:diffuse_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags& SBIT_SYNTHESIZED)) ? "_y" : "");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    colorSpace = \"sRGB\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        asset default = @@\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Albedo\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Diffuse Texture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                 // emitter?
                 if (tileIsAnEmitter(pFace->materialType, swatchLoc)) {
@@ -29279,76 +31497,76 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                         //if (b < 25)
                         //    b = 25;
                         sprintf_s(outputString, 256, "                color3f inputs:emissive_color = (%g, %g, %g) (\n", (float)r / 255.0f, (float)g / 255.0f, (float)b / 255.0f);
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        float3 default = (1, 0.1, 0.1)\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                            float3 max = (10000, 10000, 10000)\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                            float3 min = (0, 0, 0)\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Emissive\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Emissive Color\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                         // same as the diffuse texture
                         sprintf_s(outputString, 256, "                asset inputs:emissive_color_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    colorSpace = \"sRGB\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        asset default = @@\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Emissive\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Emissive Color map\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                         // Omniverse rejiggers stuff and the emissive intensity needs to get multiplied by 90;
                         // I don't want all those 0's in the interface
                         sprintf_s(outputString, 256, "                float inputs:emissive_intensity = %g (\n", gModel.options->pEFD->scaleEmittersVal * emission * 90.0f);
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        float default = 90000\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                            float max = 1000000\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                            float min = 0\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Emissive\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Emissive Intensity\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                         // if there's a specific emitter texture available, use it, adding the "_e" suffix.
 #ifdef GENERATE_EMISSION_TILES
@@ -29360,42 +31578,42 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                         //sprintf_s(outputString, 256, "                asset inputs:emissive_mask_texture = @./%s%s%s.png@ (\n", texturePath, mtlName,
                         //    gModel.tileList[CATEGORY_EMISSION][swatchLoc] ? "_e" : 
                         //        (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                         strcpy_s(outputString, 256, "                    colorSpace = \"sRGB\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
 
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        asset default = @@\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Emissive\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Emissive Mask map\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                bool inputs:enable_emission = 1 (\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
 
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        bool default = 0\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Emissive\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Enable Emission\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                 }
 
@@ -29403,130 +31621,130 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                 if (isCutout) {
                     // cutout or transparent
                     strcpy_s(outputString, 256, "                bool inputs:enable_opacity = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
 
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        bool default = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Enable Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     // not actually needed by custom material Mineways.mdl. Warning given if set.
                     if (!gModel.customMaterial) {
                         strcpy_s(outputString, 256, "                bool inputs:enable_opacity_texture = 1 (\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         if (outputCustomData) {
 
                             strcpy_s(outputString, 256, "                    customData = {\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                        bool default = 0\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                             strcpy_s(outputString, 256, "                    }\n");
-                            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         }
                         strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    displayName = \"Enable Opacity Texture\"\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                )\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                 }
 
                 // normals? If custom material, output the normal strength UI
                 if (gModel.customMaterial && gModel.tileList[CATEGORY_NORMALS][swatchLoc]) {
                     strcpy_s(outputString, 256, "                float inputs:geometry_normal_strength = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 10\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = -10\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Normal\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Normal Map Strength\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
 
                 // metallic?
                 if (gModel.tileList[CATEGORY_METALLIC][swatchLoc]) {
                     sprintf_s(outputString, 256, "                asset inputs:metallic_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_METALLIC]);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
 
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Metallic Map\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                float inputs:metallic_texture_influence = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
 
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Metallic Map Influence\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 else {
                     // the default is 0 metallic
                     sprintf_s(outputString, 256, "                float inputs:metallic_constant = %g (\n", metallic);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Metallic Amount\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
             }
 
@@ -29541,45 +31759,45 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
             if (isSemitransparent) {
                 // slightly different naming - good times! Add "./" if the texture actually exists, else "@@"
                 sprintf_s(outputString, 256, "                asset inputs:normal_map_texture = @%s%s@ (\n", strlen(textureString) > 0 ? "./" : "", textureString);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        asset default = @@\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Normal\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Normal Map Texture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             else {
                 // Note how spelling is different, which is annoying: normal_map_texture above, normalmap_texture here.
                 // Yes, I've verified it: if you change the spelling, the load fails and gives a console warning.
                 sprintf_s(outputString, 256, "                asset inputs:normalmap_texture = @%s%s@ (\n", strlen(textureString) > 0 ? "./" : "", textureString);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n"); // must be raw. "auto" gives the bad result of patterning, see Absolution grass blocks for example.
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        asset default = @@\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Normal\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Normal Map\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // cutout? Part 2
@@ -29587,86 +31805,86 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                 // not actually needed by custom material Mineways.mdl. Warning given if set.
                 if (!gModel.customMaterial) {
                     strcpy_s(outputString, 256, "                int inputs:opacity_mode = 0 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
 
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        int default = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Opacity Mono Source\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    renderType = \"::base::mono_mode\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    sdrMetadata = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        string __SDR__enum_value = \"mono_average\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        string options = \"mono_alpha:0|mono_average:1|mono_luminance:2|mono_maximum:3\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
 
                 sprintf_s(outputString, 256, "                asset inputs:opacity_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags& SBIT_SYNTHESIZED)) ? "_y" : "");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 if (outputCustomData) {
 
                     strcpy_s(outputString, 256, "                    customData = {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                        asset default = @@\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Opacity Map\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                 // opacity threshold is 0.5 for cutouts (not used when glass?)
                 // only available in generic OmniPBR_Opacity.mdl, not in Minecraft.mdl currently
                 //if (!gModel.customMaterial) {
                 if (!gModel.customMaterial && isCutout) {
                     strcpy_s(outputString, 256, "                float inputs:opacity_threshold = 0.5 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Opacity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Opacity Threshold\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    doc = \"If negative, disable cutout_opacity; if 0, use fractional opacity values 'as is'; if > 0, remap opacity values to 1 when >= threshold and to 0 otherwise\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    hidden = false\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
             }
 
@@ -29675,81 +31893,81 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                 if (isSemitransparent) {
                     // slightly different naming - good times!
                     sprintf_s(outputString, 256, "                asset inputs:roughness_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_ROUGHNESS]);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Roughness\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Roughness Texture\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
                 else {
                     strcpy_s(outputString, 256, "                float inputs:reflection_roughness_texture_influence = 1 (\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        float default = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        dictionary range = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float max = 1\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                            float min = 0\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Roughness Map Influence\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     sprintf_s(outputString, 256, "                asset inputs:reflectionroughness_texture = @./%s%s%s.png@ (\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_ROUGHNESS]);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    colorSpace = \"raw\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     if (outputCustomData) {
 
                         strcpy_s(outputString, 256, "                    customData = {\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                        asset default = @@\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                         strcpy_s(outputString, 256, "                    }\n");
-                        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     }
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Roughness Map\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
             }
             else {
                 // only in Minecraft.mdl and OmniPBR.mdl, not in OmniGlass.mdl
                 if (!isSemitransparent) {
                     sprintf_s(outputString, 256, "                float inputs:reflection_roughness_constant = %g (\n", roughness);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayGroup = \"Reflectivity\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                    displayName = \"Roughness Amount\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                )\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
             }
 
@@ -29758,16 +31976,16 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
             // and they cause z-fighting.
             if (gModel.customMaterial && isCutout && emission > 0.0f) {
                 strcpy_s(outputString, 256, "                bool inputs:thin_walled = 1 (\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                    displayName = \"Thin-walled Material\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                )\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             strcpy_s(outputString, 256, "                token outputs:out\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            }\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         }
 
         // see https://graphics.pixar.com/usd/docs/UsdPreviewSurface-Proposal.html#UsdPreviewSurfaceProposal-TextureReader
@@ -29790,22 +32008,22 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
             bool tRepeat = (gTilesTable[swatchLoc].flags & SBIT_REPEAT_TOP_BOTTOM) ? true : false;
 
             strcpy_s(outputString, 256, "\n            def Shader \"PreviewSurface\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            {\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                uniform token info:id = \"UsdPreviewSurface\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
             // - diffuse input - we output both, just in case the texture is missing or the interpret can't figure it out.
             sprintf_s(outputString, 256, "                color3f inputs:diffuseColor = (%g, %g, %g)\n", (float)r / 255.0f, (float)g / 255.0f, (float)b / 255.0f);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "                color3f inputs:diffuseColor.connect = <%s%s/Looks/%s/diffuse_texture.outputs:rgb>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
             // - emissive input
             if (tileIsAnEmitter(pFace->materialType, swatchLoc)) {
                 sprintf_s(outputString, 256, "                color3f inputs:emissiveColor.connect = <%s%s/Looks/%s/emissive_texture.outputs:rgb>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // - ior input
@@ -29816,24 +32034,24 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                 //float specRoughness = isSlime ? 0.34f : 0.0f;   // TODOUSD - could also add ice someday and make it cloudy like this?
 
                 sprintf_s(outputString, 256, "                float inputs:ior = %g\n", ior);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // - metallic input
             if (gModel.tileList[CATEGORY_METALLIC][swatchLoc]) {
                 sprintf_s(outputString, 256, "                float inputs:metallic.connect = <%s%s/Looks/%s/metallic_texture.outputs:r>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             else {
                 sprintf_s(outputString, 256, "                float inputs:metallic = %g\n", metallic);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // - normal input
             if (gModel.tileList[CATEGORY_NORMALS][swatchLoc]) {
                 // was normal3f, which works, but is not strictly correct
                 sprintf_s(outputString, 256, "                float3 inputs:normal.connect = <%s%s/Looks/%s/normal_texture.outputs:rgb>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // - opacity input - this could be removed for textures without alphas, but for simplicity we always connect it
@@ -29846,164 +32064,164 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
             // 0.5 looks best, giving a nicer interpolation for the RTX Real-time renderer, for example, with smoother interpolation
             if (isCutout || isSemitransparent) {
                 sprintf_s(outputString, 256, "                float inputs:opacity.connect = <%s%s/Looks/%s/diffuse_texture.outputs:a>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                float inputs:opacityThreshold = %f\n", isSemitransparent ? 0.0f : 0.5f );
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             else {
                 // Possible addition: could output this (and roughness and metalness) as numbers
                 // anyway, just in case the textures are not found. But, I'd rather the user
                 // knew that the textures were not found.
                 sprintf_s(outputString, 256, "                float inputs:opacity = 1\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // - roughness input
             if (gModel.tileList[CATEGORY_ROUGHNESS][swatchLoc]) {
                 sprintf_s(outputString, 256, "                float inputs:roughness.connect = <%s%s/Looks/%s/roughness_texture.outputs:r>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             else {
                 sprintf_s(outputString, 256, "                float inputs:roughness = %g\n", roughness);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             strcpy_s(outputString, 256, "                int inputs:useSpecularWorkflow = 0\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
             // I don't think this is needed
             //strcpy_s(outputString, 256, "                token outputs:out\n");
-            //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                token outputs:surface\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            }\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));            
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));            
 
             // UV Reader
 
             // Generic primvar reader used in this case to read uv coordinates for required UsdUvTextures
 
             strcpy_s(outputString, 256, "\n            def Shader \"uv_reader\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            {\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                uniform token info:id = \"UsdPrimvarReader_float2\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                float2 inputs:fallback = (0, 0)\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                token inputs:varname = \"st\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                float2 outputs:result\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            }\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
             // Roughness
 
             if (gModel.tileList[CATEGORY_ROUGHNESS][swatchLoc]) {
                 strcpy_s(outputString, 256, "\n            def Shader \"roughness_texture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            {\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                uniform token info:id = \"UsdUVTexture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_ROUGHNESS]);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                token inputs:sourceColorSpace = \"raw\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                float2 inputs:st.connect = <%s%s/Looks/%s/uv_reader.outputs:result>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapS = \"%s\"\n", sRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapT = \"%s\"\n", tRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                float outputs:r\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            }\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // Normals
 
             if (gModel.tileList[CATEGORY_NORMALS][swatchLoc]) {
                 strcpy_s(outputString, 256, "\n            def Shader \"normal_texture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            {\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                uniform token info:id = \"UsdUVTexture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                float4 inputs:bias = (-1, 1, -1, -1)\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_NORMALS]);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 // yes, this scale of Y=-2 (and bias of 1.0 in the next line) seems weird to me, too, but seems to work. I don't love it.
                 strcpy_s(outputString, 256, "                float4 inputs:scale = (2, -2, 2, 2)\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                token inputs:sourceColorSpace = \"raw\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                float2 inputs:st.connect = <%s%s/Looks/%s/uv_reader.outputs:result>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapS = \"%s\"\n", sRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapT = \"%s\"\n", tRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                float3 outputs:rgb\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            }\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // Metallic
 
             if (gModel.tileList[CATEGORY_METALLIC][swatchLoc]) {
                 strcpy_s(outputString, 256, "\n            def Shader \"metallic_texture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            {\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                uniform token info:id = \"UsdUVTexture\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_METALLIC]);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                token inputs:sourceColorSpace = \"raw\"\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                float2 inputs:st.connect = <%s%s/Looks/%s/uv_reader.outputs:result>\n", prefixPath, slashDefaultPrim, mtlName);
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapS = \"%s\"\n", sRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 sprintf_s(outputString, 256, "                token inputs:wrapT = \"%s\"\n", tRepeat ? "repeat" : "clamp");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "                float outputs:r\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 strcpy_s(outputString, 256, "            }\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
 
             // Diffuse Texture
 
             strcpy_s(outputString, 256, "\n            def Shader \"diffuse_texture\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            {\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                uniform token info:id = \"UsdUVTexture\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, (gModel.exportTiles && (gTilesTable[swatchLoc].flags & SBIT_SYNTHESIZED)) ? "_y" : "");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "                token inputs:sourceColorSpace = \"sRGB\"\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "                float2 inputs:st.connect = <%s%s/Looks/%s/uv_reader.outputs:result>\n", prefixPath, slashDefaultPrim, mtlName);
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "                token inputs:wrapS = \"%s\"\n", sRepeat ? "repeat" : "clamp");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             sprintf_s(outputString, 256, "                token inputs:wrapT = \"%s\"\n", tRepeat ? "repeat" : "clamp");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             if (isCutout || isSemitransparent) {
                 strcpy_s(outputString, 256, "                float outputs:a\n");
-                WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             }
             strcpy_s(outputString, 256, "                float3 outputs:rgb\n");    // was color3f, which works, but is not strictly correct
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
             strcpy_s(outputString, 256, "            }\n");
-            WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+            WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
             // Emissive Texture
 
@@ -30034,17 +32252,17 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                     b = (unsigned char)(0.5f + ((float)b * 255.0f / max));
 
                     strcpy_s(outputString, 256, "\n            def Shader \"emissive_texture\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "            {\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                uniform token info:id = \"UsdUVTexture\"\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 #ifdef GENERATE_EMISSION_TILES
                     sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_EMISSION]);
 #else
                     sprintf_s(outputString, 256, "                asset inputs:file = @./%s%s%s.png@\n", texturePath, mtlName, gCatStrSuffixes[CATEGORY_RGBA]);
 #endif
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     // the emissive texture is a grayscale texture, so we (sadly) need to "add the color back in". This is a limitation of Minecraft's texture
                     // pack system, where the emissive texture is expected to be a grayscale image. We could take corrective actions, e.g.,
@@ -30056,9 +32274,9 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                     // do not use sRGB for the emitter color space - this generates an error in UsdView, which makes sense;
                     // it's a one-channel emitter that should get multiplied by the albedo texture
                     //strcpy_s(outputString, 256, "                token inputs:sourceColorSpace = \"sRGB\"\n");
-                    //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     sprintf_s(outputString, 256, "                float2 inputs:st.connect = <%s%s/Looks/%s/uv_reader.outputs:result>\n", prefixPath, slashDefaultPrim, mtlName);
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     // for when emitter textures are grayscale:
                     //float escale = gModel.options->pEFD->scaleEmittersVal * emission / 255.0f;
@@ -30066,22 +32284,22 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
                     // not this:
                     //float escale = 1000.0f * emission;
                     //sprintf_s(outputString, 256, "                float4 inputs:scale = (%g, %g, %g, 1.0)\n", escale, escale, escale);
-                    //WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    //WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
                     sprintf_s(outputString, 256, "                token inputs:wrapS = \"%s\"\n", sRepeat ? "repeat" : "clamp");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     sprintf_s(outputString, 256, "                token inputs:wrapT = \"%s\"\n", tRepeat ? "repeat" : "clamp");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "                float3 outputs:rgb\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                     strcpy_s(outputString, 256, "            }\n");
-                    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+                    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
                 }
             }
         }
 #endif
         strcpy_s(outputString, 256, "        }\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
         // go to next group
         startRun = nextStart;
@@ -30089,12 +32307,12 @@ static int createMaterialsUSD(char *texturePath, char *mdlPath, wchar_t *mtlLibr
 #endif
 
     strcpy_s(outputString, 256, "    }\n");
-    WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
 
     // doing instancing?
     if (mtlLibraryFilename != NULL) {
         strcpy_s(outputString, 256, "} # close Scope \"Blocks\"\n");
-        WERROR_MODEL(PortaWrite(materialFile, outputString, strlen(outputString)));
+        WERROR_MODEL(OutBuf_Write(materialFile, outputString, strlen(outputString)));
         if (retCode |= closeUSDFile(materialFile)) {
             // failed to quit - really, we're done, so nothing to do, but left in case someday we add more code below.
         }
@@ -30362,72 +32580,72 @@ static int createLightingUSD(char *texturePath)
     char outputString[256];
     boolean nightLight = (gModel.options->worldType & LIGHTING) ? true : false;
     strcpy_s(outputString, 256, "\n    def Xform \"Lights\"\n    {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     strcpy_s(outputString, 256, nightLight ? "        def DistantLight \"Moon\" (\n" : "        def DistantLight \"Sun\" (\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            prepend apiSchemas = [\"ShapingAPI\"]\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            kind = \"model\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        )\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:angle = 1\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // scale everything up by 52.0f, as we are no longer adjusting the camera's exposure, etc.
     float lightIntensity = (float)(gModel.options->pEFD->scaleLightsVal * 52.0f * (nightLight ? 2.0 / 30.0 : 30.0 / 30.0));
     sprintf_s(outputString, 256, "            float inputs:intensity = %f\n", lightIntensity);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:cone:angle = 180\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:cone:softness\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:focus\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            color3f inputs:shaping:focusTint\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            asset inputs:shaping:ies:file\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double3 xformOp:rotateZXY = (235, 325, 0)\n");  // x is altitude, y is azimuth, z does nothing
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double3 xformOp:translate = (0, 0, 0)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            uniform token[] xformOpOrder = [\"xformOp:translate\", \"xformOp:rotateZXY\"]\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     strcpy_s(outputString, 256, "\n        def DomeLight \"DomeLight\" (\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            prepend apiSchemas = [\"ShapingAPI\"]\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        )\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        {\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // low for the nighttime sky, but making it higher makes the background surrounding map too bright.
     // used to multiply by 52.0f - let's not
     lightIntensity = (float)(gModel.options->pEFD->scaleLightsVal * 52.0f * (nightLight ? 2.0 / 30.0 : 6.0 / 30.0));
     sprintf_s(outputString, 256, "            float inputs:intensity = %f\n", lightIntensity);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:cone:angle = 180\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:cone:softness\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            float inputs:shaping:focus\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            color3f inputs:shaping:focusTint\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            asset inputs:shaping:ies:file\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     sprintf_s(outputString, 256, nightLight ? "            asset inputs:texture:file = @./%s_domelight_night.png@\n" : "            asset inputs:texture:file = @./%s_domelight.png@\n", texturePath);
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            token inputs:texture:format = \"latlong\"\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     // TODO: someday should rotate this light and the previous light around X if Z is up axis:
     // if (gModel.options->pEFD->chkMakeZUp[gModel.options->pEFD->fileType])
@@ -30435,16 +32653,16 @@ static int createLightingUSD(char *texturePath)
     // transform is left in so as to be easy to "fix" for USD Composer, just set X to 270
     strcpy_s(outputString, 256, "            double3 xformOp:rotateZXY = (0, 0, 0)\n");
     //strcpy_s(outputString, 256, "            double3 xformOp:rotateZXY = (270, 0, 0)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            double3 xformOp:translate = (0, 0, 0)\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "            uniform token[] xformOpOrder = [\"xformOp:translate\", \"xformOp:rotateZXY\"]\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
     strcpy_s(outputString, 256, "        }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     strcpy_s(outputString, 256, "    }\n");
-    WERROR_MODEL(PortaWrite(gModelFile, outputString, strlen(outputString)));
+    WERROR_MODEL(OutBuf_Write(gModelFile, outputString, strlen(outputString)));
 
     return MW_NO_ERROR;
 }
@@ -30465,7 +32683,7 @@ static int writeMDLforUSD(wchar_t* filePath)
         // loop through lines in file and write
         const char** fileContents = mdlFileContents[fcount];
         for (int i = 0; i < fileLines; i++) {
-            WERROR_MODEL(PortaWrite(mdlFile, fileContents[i], strlen(fileContents[i])));
+            WERROR_MODEL(OutBuf_Write(mdlFile, fileContents[i], strlen(fileContents[i])));
         }
 
         PortaClose(mdlFile);
@@ -30479,8 +32697,7 @@ static int writeMDLforUSD(wchar_t* filePath)
 
 static int closeUSDFile(PORTAFILE& modelFile)
 {
-    PortaClose(modelFile);
-    return 0;
+    return OutBuf_Close(modelFile) ? MW_CANNOT_WRITE_TO_FILE : 0;
 }
 
 static int writeUSDTextures()
@@ -30742,14 +32959,14 @@ static int writeSchematicBox()
                 }
 
                 // if you're storing 1.13+ types, you're out of luck - converted to grass
-                if (gBoxData[boxIndex].type < 256) {
-                    type = (unsigned char)gBoxData[boxIndex].type;
-                    data = gBoxData[boxIndex].data;
+                if (gBoxData.type[boxIndex] < 256) {
+                    type = (unsigned char)gBoxData.type[boxIndex];
+                    data = gBoxData.data[boxIndex];
 
                     // for 1.13+ we properly use all the bits (separate faces) for huge mushrooms, instead of the old 0-15
                     // system in 1.12 and earlier. To keep it simple here, if a 1.13+ huge mushroom is found, we convert as possible
                     // here. May not work - we're crunching 64 possibilities down to 16.
-                    if (gIs13orNewer && (gBoxData[boxIndex].type == BLOCK_HUGE_BROWN_MUSHROOM || (gBoxData[boxIndex].type == BLOCK_HUGE_RED_MUSHROOM))) {
+                    if (gIs13orNewer && (gBoxData.type[boxIndex] == BLOCK_HUGE_BROWN_MUSHROOM || (gBoxData.type[boxIndex] == BLOCK_HUGE_RED_MUSHROOM))) {
                         // stem?
                         if (data & 0x40) {
                             // top or not?
@@ -30835,10 +33052,10 @@ static int writeSchematicBox()
                 }
                 // ignore or turn into bedrock if at end of list of valid blocks
                 // for this old-fashioned schematic file format.
-                if (gBoxData[boxIndex].type >= BLOCK_UNKNOWN)
+                if (gBoxData.type[boxIndex] >= BLOCK_UNKNOWN)
                 {
                     // unknown block?
-                    if (gBoxData[boxIndex].type == BLOCK_UNKNOWN)
+                    if (gBoxData.type[boxIndex] == BLOCK_UNKNOWN)
                     {
                         // convert to whatever "Set unknown block ID" is set to (default is 7 - Bedrock)
                         data = 0x0;
@@ -31254,7 +33471,7 @@ static int writeLines(HANDLE file, char** textLines, int lines)
     int i;
     for (i = 0; i < lines; i++)
     {
-        WERROR_SPECIFY(PortaWrite(file, textLines[i], strlen(textLines[i])), file);
+        WERROR_SPECIFY(OutBuf_Write(file, textLines[i], strlen(textLines[i])), file);
     }
 
     return MW_NO_ERROR;
@@ -31283,17 +33500,22 @@ static float min3(Point pt)
 }
 
 #define WRITE_STAT \
-    if (printFunc != NULL) { \
+    if (!(parts & statsPart)) { \
+        /* not writing out this part */ \
+    } \
+    else if (printFunc != NULL) { \
         if ((*printFunc)(outputString)) { \
             return MW_CANNOT_WRITE_TO_FILE; \
         } \
     } \
     else { \
-        WERROR_FH(PortaWrite(fh, outputString, strlen(outputString))); \
+        WERROR_FH(OutBuf_Write(fh, outputString, strlen(outputString))); \
     }
 
-static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, const wchar_t* schemeSelected, ChangeBlockCommand* pCBC)
+static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWorldGuide, IBox* worldBox, IBox* tightenedWorldBox, const wchar_t* curDir, const wchar_t* terrainFileName, const wchar_t* schemeSelected, ChangeBlockCommand* pCBC, int parts)
 {
+    // which part the lines being written belong to; WRITE_STAT writes only those in the parts asked for
+    int statsPart = STATS_SETTINGS;
     char outputString[256];
     char timeString[256];
     char formatString[256];
@@ -31394,10 +33616,12 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
         worldBox->max[X], worldBox->max[Y], worldBox->max[Z]);
     WRITE_STAT;
 
+    statsPart = STATS_COUNTS;
     sprintf_s(outputString, 256, "#   Non-empty selection location min to max: %d, %d, %d to %d, %d, %d\n\n",
         tightenedWorldBox->min[X], tightenedWorldBox->min[Y], tightenedWorldBox->min[Z],
         tightenedWorldBox->max[X], tightenedWorldBox->max[Y], tightenedWorldBox->max[Z]);
     WRITE_STAT;
+    statsPart = STATS_SETTINGS;
 
     // If STL, say which type of STL, etc.
     switch (gModel.options->pEFD->fileType)
@@ -31423,6 +33647,9 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
     case FILE_TYPE_VRML2:
         strcpy_s(formatString, 256, "VRML 2.0");
         break;
+    case FILE_TYPE_GLTF:
+        strcpy_s(formatString, 256, "glTF 2.0 binary");
+        break;
     default:
         strcpy_s(formatString, 256, "Unknown file type");
         assert(0);
@@ -31436,6 +33663,7 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
         char warningString[256];
         int isSculpteo = (gModel.options->pEFD->fileType == FILE_TYPE_WAVEFRONT_ABS_OBJ) || (gModel.options->pEFD->fileType == FILE_TYPE_WAVEFRONT_REL_OBJ);
 
+        statsPart = STATS_COUNTS;
         if (!isSculpteo)
         {
             // If we add materials, put the material chosen here.
@@ -31467,6 +33695,7 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
             WRITE_STAT;
         }
         gModel.options->cost = computeMaterialCost(gPhysMtl, gModel.scale, gModel.blockCount, gMinorBlockCount);
+        statsPart = STATS_SETTINGS;
 
         sprintf_s(outputString, 256, "# For %s printer, minimum wall is %g mm, maximum size is %g x %g x %g cm\n", gMtlCostTable[gPhysMtl].name, gMtlCostTable[gPhysMtl].minWall * METERS_TO_MM,
             gMtlCostTable[gPhysMtl].maxSize[0], gMtlCostTable[gPhysMtl].maxSize[1], gMtlCostTable[gPhysMtl].maxSize[2]);
@@ -31476,6 +33705,7 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
     sprintf_s(outputString, 256, "# Units for the model vertex data itself: %s\n", gUnitTypeTable[gModel.options->pEFD->comboModelUnits[gModel.options->pEFD->fileType]].name);
     WRITE_STAT;
 
+    statsPart = STATS_COUNTS;
     if (gModel.print3D)
     {
         float area, volume, sumOfDimensions;
@@ -31554,6 +33784,7 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
     sprintf_s(outputString, 256, "# block dimensions: X=%g by Y=%g (height) by Z=%g blocks\n", gFilledBoxSize[X], gFilledBoxSize[Y], gFilledBoxSize[Z]);
     WRITE_STAT;
     Vec2Op(gModel.options->dimensions, =, (int)gFilledBoxSize);
+    statsPart = STATS_SETTINGS;
 
     // lighting and elevation settings written out (the other two are more for underground).
     // These also (may) affect USD export.
@@ -31669,6 +33900,9 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
         sprintf_s(outputString, 256, "# Simplify mesh: %s\n", gModel.options->pEFD->chkDecimate ? "YES" : "no");
         WRITE_STAT;
 
+        sprintf_s(outputString, 256, "# Export in tiles: %s\n", gModel.options->pEFD->chkExportInTiles ? "YES" : "no");
+        WRITE_STAT;
+
         // 3D printing should not have billboard faces, so it's kinda ignored for that
         sprintf_s(outputString, 256, "# Double all billboard faces: %s\n", gModel.options->pEFD->chkDoubledBillboards ? "YES" : "no");
         WRITE_STAT;
@@ -31707,7 +33941,7 @@ static int writeStatistics(HANDLE fh, int (*printFunc)(char *), WorldGuide* pWor
 
     // now always on by default
     //sprintf_s(outputString,256,"# Merge flat blocks with neighbors: %s\n", gModel.options->pEFD->chkMergeFlattop ? "YES" : "no" );
-    //WERROR_FH(PortaWrite(fh, outputString, strlen(outputString) ));
+    //WERROR_FH(OutBuf_Write(fh, outputString, strlen(outputString) ));
 
     if (gModel.options->pEFD->radioRotate0)
         angle = 0;
@@ -33413,6 +35647,9 @@ static void getPathAndRoot(const wchar_t* src, int fileType, wchar_t* path, wcha
     case FILE_TYPE_VRML2:
         removeSuffix(root, tfilename, L".wrl");
         break;
+    case FILE_TYPE_GLTF:
+        removeSuffix(root, tfilename, L".glb");
+        break;
     case FILE_TYPE_SCHEMATIC:
         removeSuffix(root, tfilename, L".schematic");
         break;
@@ -33496,6 +35733,12 @@ static double myrand()
 
 //=============================================
 
+typedef struct AnalysisJob {
+    int bx;
+    int bz;
+    WorldBlock* block;
+} AnalysisJob;
+
 // return 0 if nothing found in volume
 int GetMinimumSelectionHeight(WorldGuide* pWorldGuide, Options* pOptions, int minx, int minz, int maxx, int maxz, int mapMinHeight, int mapMaxHeight, bool expandByOne, bool ignoreTransparent, int maxy)
 {
@@ -33512,55 +35755,117 @@ int GetMinimumSelectionHeight(WorldGuide* pWorldGuide, Options* pOptions, int mi
         maxz++;
     }
 
+    if (pOptions == NULL) {
+        pOptions = gModel.options;
+    }
+
+    // super-icky coding - this method gets called before SaveVolume, and CHUNK_INDEX quietly uses gMinHeight in it,
+    // so we have to set this global here.
+    gMinHeight = mapMinHeight;
+    gMaxHeight = mapMaxHeight;
+
     int edgestartxblock = (int)floor((float)minx / 16.0f);
     int edgestartzblock = (int)floor((float)minz / 16.0f);
     int edgeendxblock = (int)floor((float)maxx / 16.0f);
     int edgeendzblock = (int)floor((float)maxz / 16.0f);
-
+    int numChunks = (edgeendxblock - edgestartxblock + 1) * (edgeendzblock - edgestartzblock + 1);
+
+    // Reading in chunks can't be done in parallel, so the chunks are gathered a batch at a time and then analyzed
+    // by a set of threads, see runChunkJobs(). The batch is small compared to the cache, but a chunk found in the cache can still be
+    // its oldest entry and so get bumped out by one read in later, so the blocks are looked up again once the whole
+    // batch is read in. Any that have gone missing are put at the end of the list and done one by one afterwards.
+    AnalysisJob* jobs = (AnalysisJob*)malloc(2 * EXPORT_BATCH_SIZE * sizeof(AnalysisJob));
+    int numJobs = 0;
+    int chunk = 0;
     for (int blockX = edgestartxblock; blockX <= edgeendxblock; blockX++)
     {
         for (int blockZ = edgestartzblock; blockZ <= edgeendzblock; blockZ++)
         {
-            if (pOptions == NULL) {
-                pOptions = gModel.options;
+            WorldBlock* block = findAnalysisChunk(pWorldGuide, pOptions, blockX, blockZ, gMcVersion, gMinecraftWorldVersion);
+            chunk++;
+            if (jobs == NULL) {
+                // out of memory, so just do it the slow way
+                int heightFound = analyzeChunk(block, pOptions, blockX, blockZ, minx, mapMinHeight, minz, maxx, maxy, maxz, mapMinHeight, mapMaxHeight, ignoreTransparent);
+                if (heightFound < minHeightFound)
+                {
+                    minHeightFound = heightFound;
+                }
+                continue;
+            }
+
+            jobs[numJobs].bx = blockX;
+            jobs[numJobs].bz = blockZ;
+            numJobs++;
+            if (numJobs < EXPORT_BATCH_SIZE && chunk < numChunks)
+                continue;
+
+            // batch is read in, so now look up each chunk, using the lowest surface found earlier if it's known
+            int numToAnalyze = 0;
+            int numMissing = 0;
+            for (int i = 0; i < numJobs; i++) {
+                int heightFound;
+                void* data;
+                if (!Cache_Find(jobs[i].bx, jobs[i].bz, &data)) {
+                    jobs[EXPORT_BATCH_SIZE + numMissing] = jobs[i];
+                    numMissing++;
+                    continue;
+                }
+                block = (WorldBlock*)data;
+                if ((block == NULL) || (block->blockType == NBT_NO_SECTIONS))
+                    continue;
+                if (lowestSurfaceKnown(block, pOptions, jobs[i].bx, jobs[i].bz, minx, minz, maxx, maxy, maxz, ignoreTransparent, heightFound)) {
+                    if (heightFound < minHeightFound)
+                    {
+                        minHeightFound = heightFound;
+                    }
+                    continue;
+                }
+                jobs[numToAnalyze].bx = jobs[i].bx;
+                jobs[numToAnalyze].bz = jobs[i].bz;
+                jobs[numToAnalyze].block = block;
+                numToAnalyze++;
             }
 
-            int heightFound = analyzeChunk(pWorldGuide, pOptions, blockX, blockZ, minx, mapMinHeight, minz, maxx, maxy, maxz, mapMinHeight, mapMaxHeight, ignoreTransparent, gMcVersion, gMinecraftWorldVersion);
-            if (heightFound < minHeightFound)
-            {
-                minHeightFound = heightFound;
+            // Each thread keeps its own minimum, combined at the end. Nothing touches the cache from here on, and
+            // the blocks are all different, so the only thing written, each block's lowestSurface, is safe.
+            int threadMin[EXPORT_MAX_THREADS];
+            for (int t = 0; t < EXPORT_MAX_THREADS; t++) {
+                threadMin[t] = mapMaxHeight + 1;
+            }
+            runChunkJobs(numToAnalyze, [&](int job, int jobThread) {
+                int heightFound = analyzeChunk(jobs[job].block, pOptions, jobs[job].bx, jobs[job].bz, minx, mapMinHeight, minz, maxx, maxy, maxz, mapMinHeight, mapMaxHeight, ignoreTransparent);
+                if (heightFound < threadMin[jobThread])
+                    threadMin[jobThread] = heightFound;
+            });
+            for (int t = 0; t < EXPORT_MAX_THREADS; t++) {
+                if (threadMin[t] < minHeightFound)
+                {
+                    minHeightFound = threadMin[t];
+                }
+            }
+
+            for (int i = EXPORT_BATCH_SIZE; i < EXPORT_BATCH_SIZE + numMissing; i++) {
+                block = findAnalysisChunk(pWorldGuide, pOptions, jobs[i].bx, jobs[i].bz, gMcVersion, gMinecraftWorldVersion);
+                int heightFound = analyzeChunk(block, pOptions, jobs[i].bx, jobs[i].bz, minx, mapMinHeight, minz, maxx, maxy, maxz, mapMinHeight, mapMaxHeight, ignoreTransparent);
+                if (heightFound < minHeightFound)
+                {
+                    minHeightFound = heightFound;
+                }
             }
+            numJobs = 0;
         }
     }
+    free(jobs);
 
     return (minHeightFound == mapMaxHeight + 1) ? 0 : minHeightFound;
 }
 
-// find first (optional: non-transparent) block visible from above.
-// Returns mapMaxHeight + 1 if nothing was found
-static int analyzeChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int bz, int minx, int miny, int minz, int maxx, int maxy, int maxz, int mapMinHeight, int mapMaxHeight, bool ignoreTransparent, int mcVersion, int versionID)
+// Get the chunk from the cache, reading it in if needed. Returns NULL if there is no chunk.
+static WorldBlock* findAnalysisChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int bz, int mcVersion, int versionID)
 {
-    // super-icky coding - this method gets called before SaveVolume, and CHUNK_INDEX quietly uses gMinHeight in it,
-    // so we have to set this global here.
-    gMinHeight = mapMinHeight;
-    gMaxHeight = mapMaxHeight;
-    // the height we return, the lowest height found in the chunk
-    int minHeight = mapMaxHeight + 1;
-    // we do not need to convert into grid block space 0 to 383 - CHUNK_INDEX does this for us
-    //miny -= mapMinHeight;
-    //maxy -= mapMinHeight;
-
-    int chunkX, chunkZ;
-
-    int loopXmin, loopZmin;
-    int loopXmax, loopZmax;
-    int x, y, z;
-
-    int chunkIndex;
-
     WorldBlock* block;
     void* data;
-    bool found = (WorldBlock*)Cache_Find(bx, bz, &data);
+    bool found = Cache_Find(bx, bz, &data);
     block = (WorldBlock*)data;
 
     if (!found)
@@ -33577,12 +35882,53 @@ static int analyzeChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int
         }
         wcscat_s(pWorldGuide->directory, MAX_PATH_AND_FILE, gSeparator);
 
-        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, gBlockRetCode);
+        block = LoadBlock(pWorldGuide, bx, bz, mcVersion, versionID, false, gBlockRetCode, 0);
         Cache_Add(bx, bz, block);
     }
+    return block;
+}
+
+// If the chunk was analyzed as a whole earlier and the volume holds the whole chunk, the answer is already known:
+// return true and set heightFound.
+static bool lowestSurfaceKnown(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int minz, int maxx, int maxy, int maxz, bool ignoreTransparent, int& heightFound)
+{
+    int surface = block->lowestSurface[ignoreTransparent ? 1 : 0];
+    if ((surface < 0) || (block->surfaceColormap != GetMapColormap()) ||
+        !wholeChunkAnalyzed(block, pOptions, bx, bz, minx, minz, maxx, maxy, maxz))
+        return false;
+    heightFound = (surface == block->heightAlloc) ? gMaxHeight + 1 : surface + gMinHeight;
+    return true;
+}
+
+// Does the volume, which starts at the bottom of the world, hold everything in the chunk? The search for hidden
+// areas depends on where the top of the volume is, so any analysis with it on is not for the chunk as a whole.
+static bool wholeChunkAnalyzed(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int minz, int maxx, int maxy, int maxz)
+{
+    bool showobscured = (maxy != gMaxHeight) && (pOptions->worldType & HIDEOBSCURED);
+    return !showobscured && (minx <= bx * 16) && (maxx >= bx * 16 + 15) && (minz <= bz * 16) && (maxz >= bz * 16 + 15) &&
+        (maxy >= block->maxFilledHeight + gMinHeight);
+}
+
+// find first (optional: non-transparent) block visible from above.
+// Returns mapMaxHeight + 1 if nothing was found. Called by several threads at once, each with a different block.
+static int analyzeChunk(WorldBlock* block, Options* pOptions, int bx, int bz, int minx, int miny, int minz, int maxx, int maxy, int maxz, int mapMinHeight, int mapMaxHeight, bool ignoreTransparent)
+{
+    // the height we return, the lowest height found in the chunk
+    int minHeight = mapMaxHeight + 1;
+    // we do not need to convert into grid block space 0 to 383 - CHUNK_INDEX does this for us
+    //miny -= mapMinHeight;
+    //maxy -= mapMinHeight;
+
+    int chunkX, chunkZ;
+
+    int loopXmin, loopZmin;
+    int loopXmax, loopZmax;
+    int x, y, z;
+
+    int chunkIndex;
 
     if ((block == NULL) || (block->blockType == NBT_NO_SECTIONS)) //blank tile, nothing to do
-        return minHeight + mapMinHeight;
+        return minHeight;
 
     // loop through area of box that overlaps with this chunk
     chunkX = bx * 16;
@@ -33627,6 +35973,20 @@ static int analyzeChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int
                         break;
                     }
                     chunkIndex -= 256;
+                    // the rest of a section that's all this same block is solid, too
+                    if (block->sectionUniform & (1 << ((adj_maxy - gMinHeight) >> 4))) {
+                        int skip = (adj_maxy - gMinHeight) & 0xf;
+                        adj_maxy -= skip;
+                        chunkIndex -= skip * 256;
+                    }
+                }
+            }
+            else {
+                // everything above the top of the column is air, so start there
+                int columnTop = block->columnTop[(z - chunkZ) * 16 + (x - chunkX)] + gMinHeight;
+                if (columnTop < adj_maxy) {
+                    adj_maxy = columnTop;
+                    chunkIndex = CHUNK_INDEX(bx, bz, x, adj_maxy, z);
                 }
             }
             for (y = adj_maxy; y >= miny; y--) {
@@ -33645,11 +36005,25 @@ static int analyzeChunk(WorldGuide* pWorldGuide, Options* pOptions, int bx, int
                     break;
                 }
 
+                // if the rest of this section is all air, or all this same block, go to the top of the section below
+                int section = (y - gMinHeight) >> 4;
+                if (!(block->sectionMask & (1 << section)) || (block->sectionUniform & (1 << section))) {
+                    int skip = (y - gMinHeight) & 0xf;
+                    y -= skip;
+                    chunkIndex -= skip * 256;
+                }
+
                 // go to next lower layer
                 chunkIndex -= 256;
             }
         }
     }
+
+    // save the answer for the whole chunk, for next time
+    if (wholeChunkAnalyzed(block, pOptions, bx, bz, minx, minz, maxx, maxy, maxz) && miny == mapMinHeight) {
+        block->lowestSurface[ignoreTransparent ? 1 : 0] = (short)((minHeight == mapMaxHeight + 1) ? block->heightAlloc : minHeight - mapMinHeight);
+        block->surfaceColormap = GetMapColormap();
+    }
     return minHeight;
 }
 
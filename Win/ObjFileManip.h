@@ -314,6 +314,8 @@ typedef struct Model {
     int instanceLocListSize;
     InstanceLocation* instanceLoc;
     int instanceChunkSize;  // what size of chunks should instances be gathered into?
+    bool exportInTiles; // true when the selection is read in, processed and written out a tile at a time
+    int vertexIndexBase;    // when exporting in tiles, the number of vertices written out by the earlier tiles
     int biomeIndex;  // biome index used to color the export textures
     int groupCount;
     int groupCountSize;
@@ -356,6 +358,15 @@ void EnsureSuffix(wchar_t* dst, const wchar_t* src, const wchar_t* suffix);
 
 bool IsASubblock(int type, int dataVal);
 
+// For performance testing: weld the vertices of a large made-up USD mesh as the exporter used to, by float hash, and on
+// the 1/16 block lattice. Returns non-zero if out of memory.
+int BenchmarkUSDWeld(int faces, double* floatHashMsec, double* latticeMsec, bool* sameOutput);
+
+// For performance testing: read the volume into the export box with one thread and with a set of threads, and check
+// that every pass gives the same box. Returns an MW_ code.
+int BenchmarkExportRead(WorldGuide* pWorldGuide, Options* pOptions, int xmin, int ymin, int zmin, int xmax, int ymax, int zmax, int mapMinHeight, int mapMaxHeight,
+    int worldVersion, int passes, double* serialMsec, double* parallelMsec, bool* sameOutput);
+
 //
 //
 //#ifdef __cplusplus
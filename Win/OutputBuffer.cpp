@@ -0,0 +1,460 @@
+/*
+Copyright (c) 2011, Eric Haines
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "stdafx.h"
+#include "OutputBuffer.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+// needs C++17, which this file alone is compiled with
+#include <charconv>
+
+typedef struct OutputBuffer {
+    PORTAFILE file;
+    char* buffer;   // NULL if this buffer is not in use
+    size_t used;
+} OutputBuffer;
+
+static OutputBuffer gOutputBuffers[MAX_BUFFERED_FILES];
+// the buffer last written to, checked first, since usually one file is written to at a time
+static int gLastOutputBuffer = 0;
+
+// formatted lines longer than this are passed on to vsnprintf()
+#define MAX_FAST_LINE 1024
+
+static OutputBuffer* findOutputBuffer(PORTAFILE file);
+static int flushOutputBuffer(OutputBuffer* pob);
+static int appendToOutputBuffer(OutputBuffer* pob, const void* data, size_t length);
+static int formatText(char* dst, size_t room, const char* format, va_list args);
+static int printfSlowly(OutputBuffer* pob, PORTAFILE file, const char* format, va_list args);
+
+
+int OutBuf_Attach(PORTAFILE file)
+{
+    OutputBuffer* pob = findOutputBuffer(file);
+    if (pob != NULL)
+    {
+        // An earlier file with this same handle was never closed with OutBuf_Close(), which happens when writing
+        // fails partway through. Whatever it held was never going to be written, so drop it.
+        pob->used = 0;
+        return 0;
+    }
+    for (int i = 0; i < MAX_BUFFERED_FILES; i++)
+    {
+        if (gOutputBuffers[i].buffer == NULL)
+        {
+            gOutputBuffers[i].buffer = (char*)malloc(OUTPUT_BUFFER_SIZE);
+            if (gOutputBuffers[i].buffer == NULL)
+                return 1;
+            gOutputBuffers[i].file = file;
+            gOutputBuffers[i].used = 0;
+            gLastOutputBuffer = i;
+            return 0;
+        }
+    }
+    // more files open than expected
+    assert(0);
+    return 1;
+}
+
+int OutBuf_Write(PORTAFILE file, const void* data, size_t length)
+{
+    OutputBuffer* pob = findOutputBuffer(file);
+    if (pob == NULL)
+    {
+#ifdef WIN32
+        DWORD br;
+#endif
+        return PortaWrite(file, data, length);
+    }
+    return appendToOutputBuffer(pob, data, length);
+}
+
+int OutBuf_Sprintf(char* dst, size_t size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = (size > 0) ? formatText(dst, size - 1, format, argsCopy) : -1;
+    va_end(argsCopy);
+    if (length >= 0)
+    {
+        dst[length] = (char)0;
+    }
+    else
+    {
+        length = vsnprintf(dst, size, format, args);
+    }
+    va_end(args);
+    return length;
+}
+
+int OutBuf_Printf(PORTAFILE file, const char* format, ...)
+{
+    int retCode;
+    va_list args;
+    va_start(args, format);
+    OutputBuffer* pob = findOutputBuffer(file);
+    if (pob == NULL)
+    {
+        retCode = printfSlowly(NULL, file, format, args);
+    }
+    else
+    {
+        // make sure there's room for a line, then format it right into the buffer
+        if ((OUTPUT_BUFFER_SIZE - pob->used < MAX_FAST_LINE) && flushOutputBuffer(pob))
+        {
+            va_end(args);
+            return 1;
+        }
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        int length = formatText(pob->buffer + pob->used, MAX_FAST_LINE, format, argsCopy);
+        va_end(argsCopy);
+        if (length >= 0)
+        {
+            pob->used += length;
+            retCode = 0;
+        }
+        else
+        {
+            // too long, or something formatText() doesn't know how to do
+            retCode = printfSlowly(pob, file, format, args);
+        }
+    }
+    va_end(args);
+    return retCode;
+}
+
+int OutBuf_Flush(PORTAFILE file)
+{
+    OutputBuffer* pob = findOutputBuffer(file);
+    return (pob == NULL) ? 0 : flushOutputBuffer(pob);
+}
+
+int OutBuf_Close(PORTAFILE file)
+{
+    int retCode = 0;
+    OutputBuffer* pob = findOutputBuffer(file);
+    if (pob != NULL)
+    {
+        retCode = flushOutputBuffer(pob);
+        free(pob->buffer);
+        pob->buffer = NULL;
+    }
+    PortaClose(file);
+    return retCode;
+}
+
+int OutBuf_Benchmark(const wchar_t* fileName, int lines, double* unbufferedMBps, double* bufferedMBps, bool* sameOutput)
+{
+#ifdef WIN32
+    DWORD br;
+#endif
+    char outputString[256];
+    int retCode = 0;
+    size_t bytes = 0;
+
+    *unbufferedMBps = *bufferedMBps = 0.0;
+    *sameOutput = false;
+
+    // the sorts of lines found in an OBJ file: vertices, texture coordinates, and faces
+    for (int buffered = 0; buffered < 2 && !retCode; buffered++)
+    {
+        wchar_t benchFileName[MAX_PATH_AND_FILE];
+        swprintf_s(benchFileName, MAX_PATH_AND_FILE, L"%s%d.obj", fileName, buffered);
+        PORTAFILE file = PortaCreate(benchFileName);
+        if (file == INVALID_HANDLE_VALUE)
+            return 1;
+        if (buffered)
+            OutBuf_Attach(file);
+
+        clock_t start = clock();
+        for (int i = 0; i < lines && !retCode; i++)
+        {
+            // coordinates like those of a model scaled to some size, with the occasional exact value
+            float x = (float)(i % 317) * 0.0625f + 1.0f / (float)(1 + i % 7);
+            float y = (float)(i % 71) * -0.1f;
+            float z = (float)(i % 1021) * 3.3f;
+            if (buffered)
+            {
+                switch (i % 3)
+                {
+                case 0:
+                    retCode = OutBuf_Printf(file, "v %g %g %g\n", x, y, z);
+                    break;
+                case 1:
+                    retCode = OutBuf_Printf(file, "vt %.9f %.9f\n", x / 64.0f, y / 64.0f);
+                    break;
+                default:
+                    retCode = OutBuf_Printf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                        i, i / 3, 1, i + 1, i / 3 + 1, 1, i + 2, i / 3 + 2, 1, i + 3, i / 3 + 3, 1);
+                    break;
+                }
+            }
+            else
+            {
+                switch (i % 3)
+                {
+                case 0:
+                    sprintf_s(outputString, 256, "v %g %g %g\n", x, y, z);
+                    break;
+                case 1:
+                    sprintf_s(outputString, 256, "vt %.9f %.9f\n", x / 64.0f, y / 64.0f);
+                    break;
+                default:
+                    sprintf_s(outputString, 256, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                        i, i / 3, 1, i + 1, i / 3 + 1, 1, i + 2, i / 3 + 2, 1, i + 3, i / 3 + 3, 1);
+                    break;
+                }
+                retCode = PortaWrite(file, outputString, strlen(outputString));
+                bytes += strlen(outputString);
+            }
+        }
+        retCode |= OutBuf_Close(file);
+        double seconds = (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+        double mbps = (seconds > 0.0) ? (double)bytes / seconds / (1024.0 * 1024.0) : 0.0;
+        if (buffered)
+            *bufferedMBps = mbps;
+        else
+            *unbufferedMBps = mbps;
+    }
+    if (retCode)
+        return retCode;
+
+    // compare the two files, then delete them
+    char* data[2];
+    for (int i = 0; i < 2; i++)
+    {
+        wchar_t benchFileName[MAX_PATH_AND_FILE];
+        swprintf_s(benchFileName, MAX_PATH_AND_FILE, L"%s%d.obj", fileName, i);
+        data[i] = (char*)malloc(bytes);
+        PORTAFILE file = PortaOpen(benchFileName);
+        if (file == INVALID_HANDLE_VALUE || (data[i] != NULL && PortaRead(file, data[i], (unsigned int)bytes)))
+        {
+            free(data[i]);
+            data[i] = NULL;
+        }
+        if (file != INVALID_HANDLE_VALUE)
+            PortaClose(file);
+        DeleteFile(benchFileName);
+    }
+    *sameOutput = (data[0] != NULL) && (data[1] != NULL) && (memcmp(data[0], data[1], bytes) == 0);
+    free(data[0]);
+    free(data[1]);
+    return 0;
+}
+
+
+static OutputBuffer* findOutputBuffer(PORTAFILE file)
+{
+    if (gOutputBuffers[gLastOutputBuffer].buffer != NULL && gOutputBuffers[gLastOutputBuffer].file == file)
+        return &gOutputBuffers[gLastOutputBuffer];
+    for (int i = 0; i < MAX_BUFFERED_FILES; i++)
+    {
+        if (gOutputBuffers[i].buffer != NULL && gOutputBuffers[i].file == file)
+        {
+            gLastOutputBuffer = i;
+            return &gOutputBuffers[i];
+        }
+    }
+    return NULL;
+}
+
+static int flushOutputBuffer(OutputBuffer* pob)
+{
+#ifdef WIN32
+    DWORD br;
+#endif
+    int retCode = 0;
+    if (pob->used > 0)
+        retCode = PortaWrite(pob->file, pob->buffer, pob->used);
+    pob->used = 0;
+    return retCode;
+}
+
+static int appendToOutputBuffer(OutputBuffer* pob, const void* data, size_t length)
+{
+    if (pob->used + length > OUTPUT_BUFFER_SIZE)
+    {
+        if (flushOutputBuffer(pob))
+            return 1;
+        if (length > OUTPUT_BUFFER_SIZE)
+        {
+            // too big to buffer, so write it directly
+#ifdef WIN32
+            DWORD br;
+#endif
+            return PortaWrite(pob->file, data, length);
+        }
+    }
+    memcpy(pob->buffer + pob->used, data, length);
+    pob->used += length;
+    return 0;
+}
+
+// Format the text into dst, which has room for "room" characters. No terminating null is added. Returns the length
+// of the text, or -1 if it doesn't fit or the format has something other than the simple conversions listed in
+// OutputBuffer.h. std::to_chars() with a precision gives the same digits as printf() does, just without the overhead.
+static int formatText(char* dst, size_t room, const char* format, va_list args)
+{
+    char* p = dst;
+    char* end = dst + room;
+    const char* f = format;
+    while (*f)
+    {
+        if (*f != '%')
+        {
+            if (p == end)
+                return -1;
+            *p++ = *f++;
+            continue;
+        }
+        f++;
+        // a width is handled only for integers, as in "%05d"
+        bool zeroPad = (*f == '0');
+        int width = 0;
+        while (*f >= '0' && *f <= '9')
+            width = width * 10 + (*f++ - '0');
+        int precision = -1;
+        if (*f == '.')
+        {
+            f++;
+            precision = 0;
+            while (*f >= '0' && *f <= '9')
+                precision = precision * 10 + (*f++ - '0');
+        }
+        if (width > 0 && *f != 'd' && *f != 'i' && *f != 'u')
+            return -1;
+        std::to_chars_result result;
+        switch (*f)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        {
+            if (precision >= 0)
+                return -1;
+            char digits[16];
+            if (*f == 'u')
+                result = std::to_chars(digits, digits + 16, va_arg(args, unsigned int));
+            else
+                result = std::to_chars(digits, digits + 16, va_arg(args, int));
+            int length = (int)(result.ptr - digits);
+            int pad = (width > length) ? width - length : 0;
+            if (length + pad > end - p)
+                return -1;
+            const char* d = digits;
+            if (zeroPad && *d == '-')
+            {
+                // the sign goes before the zeroes
+                *p++ = *d++;
+                length--;
+            }
+            memset(p, zeroPad ? '0' : ' ', pad);
+            p += pad;
+            memcpy(p, d, length);
+            p += length;
+            f++;
+            continue;
+        }
+        case 'e':
+            result = std::to_chars(p, end, va_arg(args, double), std::chars_format::scientific, (precision < 0) ? 6 : precision);
+            break;
+        case 'f':
+            result = std::to_chars(p, end, va_arg(args, double), std::chars_format::fixed, (precision < 0) ? 6 : precision);
+            break;
+        case 'g':
+            result = std::to_chars(p, end, va_arg(args, double), std::chars_format::general, (precision < 0) ? 6 : precision);
+            break;
+        case 'c':
+            if (precision >= 0 || p == end)
+                return -1;
+            *p++ = (char)va_arg(args, int);
+            f++;
+            continue;
+        case 's':
+        {
+            if (precision >= 0)
+                return -1;
+            const char* str = va_arg(args, const char*);
+            size_t length = strlen(str);
+            if (length > (size_t)(end - p))
+                return -1;
+            memcpy(p, str, length);
+            p += length;
+            f++;
+            continue;
+        }
+        case '%':
+            if (precision >= 0 || p == end)
+                return -1;
+            *p++ = '%';
+            f++;
+            continue;
+        default:
+            // flags, and anything else
+            return -1;
+        }
+        if (result.ec != std::errc())
+            return -1;
+        p = result.ptr;
+        f++;
+    }
+    return (int)(p - dst);
+}
+
+// format the text with vsnprintf() and write it out, to the buffer if there is one
+static int printfSlowly(OutputBuffer* pob, PORTAFILE file, const char* format, va_list args)
+{
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = vsnprintf(NULL, 0, format, argsCopy);
+    va_end(argsCopy);
+    if (length < 0)
+        return 1;
+    char* outputString = (char*)malloc(length + 1);
+    if (outputString == NULL)
+        return 1;
+    vsnprintf(outputString, length + 1, format, args);
+    int retCode;
+    if (pob != NULL)
+    {
+        retCode = appendToOutputBuffer(pob, outputString, length);
+    }
+    else
+    {
+#ifdef WIN32
+        DWORD br;
+#endif
+        retCode = PortaWrite(file, outputString, length);
+    }
+    free(outputString);
+    return retCode;
+}
@@ -0,0 +1,62 @@
+/*
+Copyright (c) 2011, Eric Haines
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Buffered writing for the model exporters. A file created with PortaCreate() can have a buffer attached to it; from
+// then on, OutBuf_Write() and OutBuf_Printf() to that file collect their output in memory and write it out a large
+// piece at a time, instead of making a system call for every line. Writes to files without a buffer go straight
+// through, so these can be used on any file. Not thread safe: all writing is done by the exporting thread.
+// Needs stdafx.h included first, for PORTAFILE.
+
+// size of the buffer attached to each file
+#define OUTPUT_BUFFER_SIZE (1024*1024)
+// the most files that can have buffers at one time
+#define MAX_BUFFERED_FILES 4
+
+// Attach a buffer to the file; returns 0 if OK, non-zero if out of memory or out of buffers, in which case the
+// file's writes simply go straight through.
+int OutBuf_Attach(PORTAFILE file);
+// These return non-zero on failure, like PortaWrite()
+int OutBuf_Write(PORTAFILE file, const void* data, size_t length);
+// Supports %d, %i and %u with an optional width (e.g. "%05d"), %e, %f and %g with an optional precision (e.g. "%.9f"),
+// and %c, %s and %%. Output is the same as from sprintf_s(), but numbers are formatted much more quickly, by
+// std::to_chars(). Anything else in the format is passed on to vsnprintf().
+int OutBuf_Printf(PORTAFILE file, const char* format, ...);
+// The same fast formatting into a string, in place of sprintf_s(); returns the length of the string. This one touches
+// no buffers, so it can be called by several threads at once.
+int OutBuf_Sprintf(char* dst, size_t size, const char* format, ...);
+int OutBuf_Flush(PORTAFILE file);
+// Write out anything in the file's buffer, release the buffer, and close the file. Returns non-zero if the last
+// write failed.
+int OutBuf_Close(PORTAFILE file);
+
+// For performance testing: write "lines" lines of OBJ-style vertices, texture coordinates and faces, first as the
+// exporters used to, with sprintf_s() and a PortaWrite() per line, then with OutBuf_Printf(), and return the megabytes
+// per second for each. The two files are named fileName followed by "0.obj" and "1.obj", and are deleted afterwards;
+// sameOutput is set if they matched. Returns non-zero if the files can't be written.
+int OutBuf_Benchmark(const wchar_t* fileName, int lines, double* unbufferedMBps, double* bufferedMBps, bool* sameOutput);
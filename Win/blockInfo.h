@@ -269,8 +269,10 @@ extern UnitType gUnitTypeTable[];
 #define FILE_TYPE_VRML2             6
 // this is an entirely separate file type, only exportable through the schematic export option
 #define FILE_TYPE_SCHEMATIC         7
+// added after schematic, so that the values of the earlier types don't change
+#define FILE_TYPE_GLTF              8
 
-#define FILE_TYPE_TOTAL         8
+#define FILE_TYPE_TOTAL         9
 
 #ifdef SKETCHFAB
 // Sketchfab API field limits
@@ -298,7 +300,7 @@ typedef struct ExportFileData
 {
     // dialog file type last chosen in export dialog; this is used next time.
     // Note that this value is *not* valid during export itself; fileType is passed in.
-    int fileType;           // 0,1 - OBJ, 2 - USD, 3,4 - Binary STL, 5 - ASCII STL, 6 - VRML2, 7 - Schematic
+    int fileType;           // 0,1 - OBJ, 2 - USD, 3,4 - Binary STL, 5 - ASCII STL, 6 - VRML2, 7 - Schematic, 8 - glTF binary
 
     // in reality, the character fields could be kept private, but whatever
     char minxString[EP_FIELD_LENGTH];
@@ -357,6 +359,7 @@ typedef struct ExportFileData
     UINT chkLeavesSolid;    // should tree leaves be output as solid or semitransparent? Normally false, i.e., semitransparent for rendering. Doesn't affect 3D printing
     UINT chkBlockFacesAtBorders;    // should block faces be generated at the borders of the export? True for rendering. Doesn't affect 3D printing.
     UINT chkDecimate;    // Decimate meshes as possible
+    UINT chkExportInTiles;    // Read in, process and write out large OBJ renders a set of chunks at a time, to bound memory use
     UINT chkBiome;
     UINT chkCompositeOverlay;	// true means we'll make a composite texture of anything such as redstone wire that overlays a tile; false means make a separate floating object above the tile.
 
@@ -30,6 +30,7 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <mutex>
 
 /* a simple cache based on a hashtable with separate chaining */
 
@@ -107,6 +108,12 @@ void Change_Cache_Size(int size)
     gHashMaxEntries = size;
 }
 
+// how many chunks the cache can hold before it starts freeing the oldest
+int Cache_Max_Entries()
+{
+    return gHashMaxEntries;
+}
+
 // "data" here is the WorldBlock
 void Cache_Add(int bx, int bz, void* data)
 {
@@ -256,21 +263,28 @@ void Cache_Empty()
 **/
 
 static WorldBlock* last_block = NULL;
+// export reads in chunks with several threads at once, so last_block is locked
+static std::mutex last_block_mutex;
 
 WorldBlock* block_alloc(int minHeight, int maxHeight)
 {
     int height = maxHeight - minHeight + 1;
     WorldBlock* ret = NULL;
+    std::lock_guard<std::mutex> lock(last_block_mutex);
     // is a cached block available and is it the right size?
     if (last_block != NULL && last_block->heightAlloc == height)
     {
-        // use this cached block (clearing out just the optional entity storage first)
+        // use this cached block (clearing out just the optional entity and light storage first)
         ret = last_block;
         if (ret->entities != NULL) {
             free(ret->entities);
             ret->entities = NULL;
             ret->numEntities = 0;
         }
+        if (ret->light != NULL) {
+            free(ret->light);
+            ret->light = NULL;
+        }
         last_block = NULL;
         return ret;
     }
@@ -291,9 +305,8 @@ WorldBlock* block_alloc(int minHeight, int maxHeight)
 	    ret->data = (unsigned char*)malloc(16 * 16 * height * sizeof(unsigned char));
 	    if (ret->data == NULL)
 	        return NULL;
-	    ret->light = (unsigned char*)malloc(16 * 16 * height * sizeof(unsigned char) / 2);
-	    if (ret->light == NULL)
-	        return NULL;
+	    // light is allocated only when asked for, by block_alloc_light()
+	    ret->light = NULL;
 	    ret->entities = NULL;
 	    ret->numEntities = 0;
 	    ret->heightAlloc = height;    // for some betas of 1.17 it is 384 - change by checking versionID
@@ -304,6 +317,15 @@ WorldBlock* block_alloc(int minHeight, int maxHeight)
 	}
 }
 
+// The light array is needed only for drawing the map with lighting, so is allocated separately
+bool block_alloc_light(WorldBlock* block)
+{
+    if (block->light == NULL) {
+        block->light = (unsigned char*)malloc(16 * 16 * block->heightAlloc * sizeof(unsigned char) / 2);
+    }
+    return block->light != NULL;
+}
+
 // Given a WorldBlock that is no longer cached, save it away as "last_block" for immediate reuse if possible.
 // If there's already a last_block, get rid of that one and save this one instead (TODO: is there a better tie break?)
 void block_free(WorldBlock* block)
@@ -312,6 +334,7 @@ void block_free(WorldBlock* block)
     if (block == NULL)
         return;
 
+    std::lock_guard<std::mutex> lock(last_block_mutex);
     // keep latest freed block available in "last_block", so free the one already there
     if (last_block != NULL && last_block != block)
     {
@@ -366,8 +389,9 @@ void block_realloc(WorldBlock* block)
 
             unsigned char* grid = (unsigned char*)realloc(block->grid, 256 * heightAlloc);
             unsigned char* data = (unsigned char*)realloc(block->data, 256 * heightAlloc);
-            unsigned char* light = (unsigned char*)realloc(block->light, 128 * heightAlloc);
-            if (grid && data && light) {
+            // light is optional, realloc only if present
+            unsigned char* light = block->light ? (unsigned char*)realloc(block->light, 128 * heightAlloc) : NULL;
+            if (grid && data && (light || !block->light)) {
                 block->grid = grid;
                 block->data = data;
                 block->light = light;
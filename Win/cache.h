@@ -55,10 +55,18 @@ typedef struct WorldBlock {
     // someday we'll need the top four bits field when > 256 blocks
     // unsigned char add[16*16*128];   // the Add tag - see http://www.minecraftwiki.net/wiki/Anvil_file_format
     unsigned char *data;  // half-byte additional data about each block, i.e., subtype such as log type, etc. -> [16 * 16 * 384]
-    unsigned char *light; // half-byte lighting data -> [16 * 16 * 384/2]
+    unsigned char *light; // half-byte lighting data -> [16 * 16 * 384/2]; NULL if not read in, as it's needed only for map lighting
 
     unsigned char rendercache[16 * 16 * 4]; // bitmap of last render
     short heightmap[16 * 16]; // height of rendered block [x+z*16]
+    short selectHeight[16 * 16]; // height of first solid visible block, -1 if none, for drawing the selection over the render [x+z*16]
+    unsigned short renderType[16 * 16]; // type of the block at heightmap's height, with the high data bit folded in, for identifying what's shown [x+z*16]
+    unsigned char renderData[16 * 16]; // data value of that block [x+z*16]
+    short columnTop[16 * 16]; // highest level in each column that is not air [x+z*16], -1 if none; set when the block is read in
+    unsigned int sectionMask; // bit N is set if 16-level section N, i.e., levels N*16 through N*16+15, has anything other than air
+    unsigned int sectionUniform; // bit N is set if every voxel in section N has the same type and data value, which may be air; never set for sections above maxFilledHeight
+    short lowestSurface[2]; // lowest level over all columns of the first block seen from above, -1 if not yet found, heightAlloc if none; [0] any visible block, [1] opaque blocks only
+    unsigned short surfaceColormap; // color map when lowestSurface was found, as which blocks are transparent can change with it
     unsigned char biome[16 * 16];
     BlockEntity* entities;	// block entities, http://minecraft.wiki/w/Chunk_format#Block_entity_format
     int numEntities;	// number in the list, maximum of 16x16x256
@@ -68,15 +76,14 @@ typedef struct WorldBlock {
 
     int rendery;        // slice height for last render
     int renderopts;     // options bitmask for last render
-    int renderhilitID;	// the last selected area's ID tag
-    char rendermissing;  // the z-offset of a block that was missing
-    // when it was last rendered (for blocks on the
-    // left edge of the map, this might be +1)
+    char rendermissing;  // set if the block to the west wasn't loaded when this was last rendered,
+    // so the shading along the west edge is not quite right (for blocks on the left edge of the map)
     unsigned short colormap; //color map when this was rendered
     int blockType;		// 1 = normal, 2 = entirely empty; see nbt.h for the definitions
 } WorldBlock;
 
 void Change_Cache_Size(int size);
+int Cache_Max_Entries();
 bool Cache_Find(int bx, int bz, void** data);
 void Cache_Add(int bx, int bz, void* data);
 void Cache_Empty();
@@ -98,3 +105,4 @@ WorldBlock* block_alloc(int minHeight, int maxHeight);           // allocate mem
 void block_free(WorldBlock* block); // release memory for a block
 void block_force_free(WorldBlock* block); // no single block cache test - clears the cache, too
 void block_realloc(WorldBlock* block);   // realloc and copy over
+bool block_alloc_light(WorldBlock* block);  // allocate the optional light array, if not already there
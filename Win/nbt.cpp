@@ -29,6 +29,7 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #include "stdafx.h"
 #include <string.h>
 #include <assert.h>
+#include <mutex>
 
 // We know we won't run into names longer than 100 characters. The old code was
 // safe, but was also allocating strings all the time - seems slow.
@@ -64,6 +65,9 @@ typedef struct BiomeTranslator {
 
 static bool makeHash = true;
 static bool makeBiomeHash = true;
+// chunks can be read by several threads at once, so making the hash tables, and adding to the unknown block names, is locked
+static std::mutex hashMutex;
+static std::mutex unknownBlockMutex;
 static TranslationTuple* modTranslations = NULL;
 
 // if defined, only those data values that have an effect on graphics display (vs. sound or
@@ -1781,6 +1785,28 @@ int findIndexFromBiomeName(char* name)
 }
 
 
+// For BF_INFLATE, decompress until the buffer holds at least "needed" bytes. Returns -1 if the stream ends first or is bad.
+static int bfinflate(bfFile* pbf, int needed)
+{
+    if (needed > pbf->size)
+        return -1;
+    while (pbf->inflated < needed)
+    {
+        // inflate a bit past what's needed, so that small reads don't each call inflate()
+        int request = needed - pbf->inflated + 16 * 1024;
+        pbf->strm->next_out = pbf->buf + pbf->inflated;
+        pbf->strm->avail_out = (pbf->size - pbf->inflated < request) ? pbf->size - pbf->inflated : request;
+        int status = inflate(pbf->strm, Z_NO_FLUSH);
+        int got = (int)(pbf->strm->next_out - (pbf->buf + pbf->inflated));
+        pbf->inflated += got;
+        if (status == Z_STREAM_END)
+            return (pbf->inflated < needed) ? -1 : 0;
+        if ((status != Z_OK && status != Z_BUF_ERROR) || got == 0)
+            return -1;
+    }
+    return 0;
+}
+
 // return -1 if error (corrupt file)
 int bfread(bfFile* pbf, void* target, int len)
 {
@@ -1791,13 +1817,23 @@ int bfread(bfFile* pbf, void* target, int len)
     else if (pbf->type == BF_GZIP) {
         return gzread(pbf->gz, target, len);
     }
+    else if (pbf->type == BF_INFLATE) {
+        if (bfinflate(pbf, *pbf->offset + len) < 0) {
+            // callers such as readDword() don't check for errors, so give them zeroes
+            memset(target, 0, len);
+            return -1;
+        }
+        memcpy(target, pbf->buf + *pbf->offset, len);
+        *pbf->offset += len;
+    }
     return len;
 }
 
 // positive number returned is offset, 0 means no movement, -1 means error (corrupt file)
 int bfseek(bfFile* pbf, int offset, int whence)
 {
-    if (pbf->type == BF_BUFFER) {
+    // BF_INFLATE decompresses when read, not here
+    if (pbf->type == BF_BUFFER || pbf->type == BF_INFLATE) {
         if (whence == SEEK_CUR)
             *pbf->offset += offset;
         else if (whence == SEEK_SET)
@@ -2038,11 +2074,180 @@ unsigned char mod16(int val)
     return (unsigned char)(val & 0xf);
 }
 
+// Unpack "count" values, each "bits" long, from a long array as read in, i.e., big-endian longs. Values are packed
+// starting at the lowest bits of the first long. If "padded", the 1.16 (20w17a) and later format, values do not
+// cross from one long to the next, the leftover high bits are unused; otherwise they run straight on into the next long.
+// Anything past the end of the array is returned as 0.
+static void unpackLongArray(const unsigned char* packed, int numLongs, int bits, bool padded, int count, unsigned short* values)
+{
+    int n = 0;
+    if (bits > 0 && bits < 32) {
+        unsigned long long mask = (1ULL << bits) - 1;
+        if (padded) {
+            int perLong = 64 / bits;
+            for (int l = 0; l < numLongs && n < count; l++) {
+                const unsigned char* p = packed + 8 * l;
+                unsigned long long word = ((unsigned long long)p[0] << 56) | ((unsigned long long)p[1] << 48) | ((unsigned long long)p[2] << 40) | ((unsigned long long)p[3] << 32) |
+                    ((unsigned long long)p[4] << 24) | ((unsigned long long)p[5] << 16) | ((unsigned long long)p[6] << 8) | (unsigned long long)p[7];
+                for (int j = 0; j < perLong && n < count; j++, word >>= bits) {
+                    values[n++] = (unsigned short)(word & mask);
+                }
+            }
+        }
+        else {
+            unsigned long long word = 0;
+            unsigned long long nextWord = 0;
+            int loaded = -1;
+            for (long long bitpos = 0; n < count; n++, bitpos += bits) {
+                int l = (int)(bitpos >> 6);
+                int shift = (int)(bitpos & 63);
+                if (l >= numLongs)
+                    break;
+                if (l != loaded) {
+                    // load this long and the next, if any, as values can span the two
+                    for (int k = 0; k < 2; k++) {
+                        unsigned long long w = 0;
+                        if (l + k < numLongs) {
+                            const unsigned char* p = packed + 8 * (l + k);
+                            w = ((unsigned long long)p[0] << 56) | ((unsigned long long)p[1] << 48) | ((unsigned long long)p[2] << 40) | ((unsigned long long)p[3] << 32) |
+                                ((unsigned long long)p[4] << 24) | ((unsigned long long)p[5] << 16) | ((unsigned long long)p[6] << 8) | (unsigned long long)p[7];
+                        }
+                        if (k == 0)
+                            word = w;
+                        else
+                            nextWord = w;
+                    }
+                    loaded = l;
+                }
+                unsigned long long v = word >> shift;
+                if (shift + bits > 64)
+                    v |= nextWord << (64 - shift);
+                values[n] = (unsigned short)(v & mask);
+            }
+        }
+    }
+    for (; n < count; n++) {
+        values[n] = 0;
+    }
+}
+
+// is the chunk's Status one where it's completely generated, so that its heightmaps are final?
+static bool isFullStatus(const char* status)
+{
+    // 1.14 on use "full", 1.20 on "minecraft:full"; 1.13 used "postprocessed", and "fullchunk" just before that
+    return (strcmp(status, "full") == 0) || (strcmp(status, "minecraft:full") == 0) ||
+        (strcmp(status, "postprocessed") == 0) || (strcmp(status, "fullchunk") == 0);
+}
+
+// Read the WORLD_SURFACE heightmap, stored in 1.13 and later chunks, into surfaceTop: the level, counting up from minHeight,
+// of the highest block in each column [x+z*16] that is not air, or -1 if none. "container" is the offset of the compound
+// the heightmaps are in: Level in 1.13 through 1.17, the chunk itself in 1.18 on. Returns true if the heightmap was found
+// and the chunk is fully generated. Even then, the heightmap can be out of date, so is only a hint; see determineOccupancy().
+static bool readSurfaceHeights(bfFile* pbf, int container, int minHeight, int heightAlloc, short* surfaceTop)
+{
+    // 256 values of up to 16 bits each, at most
+    unsigned char packed[64 * 8];
+    int numLongs = 0;
+    bool fullStatus = false;
+    bool hasYPos = false;
+    int yPos = 0;
+    char thisName[MAX_NAME_LENGTH];
+
+    if (bfseek(pbf, container, SEEK_SET) < 0)
+        return false;
+    for (;;)
+    {
+        unsigned char type = 0;
+        if (bfread(pbf, &type, 1) < 0)
+            return false;
+        if (type == 0)
+            break;
+        int len = readWord(pbf);
+        if (len >= MAX_NAME_LENGTH || bfread(pbf, thisName, len) < 0)
+            return false;
+        thisName[len] = 0;
+        if (type == 8 && strcmp(thisName, "Status") == 0)
+        {
+            len = readWord(pbf);
+            if (len >= MAX_NAME_LENGTH || bfread(pbf, thisName, len) < 0)
+                return false;
+            thisName[len] = 0;
+            fullStatus = isFullStatus(thisName);
+        }
+        else if (type == 3 && strcmp(thisName, "yPos") == 0)
+        {
+            // 1.18 on: the lowest section's Y, which is where the heightmap values count up from
+            yPos = (int)readDword(pbf);
+            hasYPos = true;
+        }
+        else if (type == 10 && strcmp(thisName, "Heightmaps") == 0)
+        {
+            for (;;)
+            {
+                type = 0;
+                if (bfread(pbf, &type, 1) < 0)
+                    return false;
+                if (type == 0)
+                    break;
+                len = readWord(pbf);
+                if (len >= MAX_NAME_LENGTH || bfread(pbf, thisName, len) < 0)
+                    return false;
+                thisName[len] = 0;
+                if (type == 12 && strcmp(thisName, "WORLD_SURFACE") == 0)
+                {
+                    numLongs = (int)readDword(pbf);
+                    if (numLongs <= 0 || numLongs > 64)
+                        return false;
+                    if (bfread(pbf, packed, numLongs * 8) < 0)
+                        return false;
+                }
+                else if (skipType(pbf, type) < 0)
+                    return false;
+            }
+        }
+        else if (skipType(pbf, type) < 0)
+            return false;
+    }
+    if (!fullStatus || numLongs == 0)
+        return false;
+    // before 1.18 the values count up from 0, which is where our levels start only if the world starts there
+    if (!hasYPos && minHeight != 0)
+        return false;
+
+    // the number of bits per value depends on the dimension's height; find it from the array's length
+    int bits;
+    bool padded = false;
+    for (bits = 1; bits <= 16; bits++) {
+        int perLong = 64 / bits;
+        if (numLongs == (256 + perLong - 1) / perLong) {
+            padded = true;
+            break;
+        }
+        if (numLongs * 64 == 256 * bits)
+            break;
+    }
+    if (bits > 16)
+        return false;
+
+    unsigned short values[256];
+    unpackLongArray(packed, numLongs, bits, padded, 256, values);
+    int base = (hasYPos ? yPos * 16 : 0) - minHeight;
+    for (int i = 0; i < 256; i++) {
+        // a value is one above the highest block, 0 if none
+        int top = (values[i] == 0) ? -1 : base + values[i] - 1;
+        if (top >= heightAlloc || top < -1)
+            return false;
+        surfaceTop[i] = (short)top;
+    }
+    return true;
+}
+
 #define FORMAT_UP_THROUGH_1_12      0
 #define FORMAT_1_13_THROUGH_1_17    1
 #define FORMAT_1_18_AND_NEWER       2
-// return negative value on error, 1 on read OK, 2 on read and it's empty, and higher bits than 1 or 2 are warnings
-int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int & mfsHeight, char* unknownBlock, int unknownBlockID)
+// return negative value on error, 1 on read OK, 2 on read and it's empty, and higher bits than 1 or 2 are warnings.
+// surfaceTop, if not NULL, gets the chunk's stored WORLD_SURFACE heightmap, with surfaceFound set true if it was read in.
+int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int & mfsHeight, char* unknownBlock, int unknownBlockID, short* surfaceTop, bool& surfaceFound)
 {
     int len, nsections, i;
     int biome_save;
@@ -2059,6 +2264,8 @@ int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned
     bool needBiome = mcVersion >= 18;
     bool gotBiome = !needBiome; // start false only if needed.
 
+    surfaceFound = false;
+
     //Level/Blocks
     if (bfseek(pbf, 1, SEEK_CUR) < 0)
         return LINE_ERROR; //skip type
@@ -2067,6 +2274,8 @@ int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned
         return LINE_ERROR; //skip name ()
 
     int level_save = *pbf->offset;
+    // where the Heightmaps are: here for 1.18 on, in Level for earlier versions
+    int heightmap_save = level_save;
     //if (nbtFindElement(pbf, "Level") != 10) {
         // "Level" NOT found, so probably 1.18. However, the Amulet converter keeps Level in the data - ugh.
     // if "sections" (lowercase) is found, then it's 1.18+ format
@@ -2140,6 +2349,7 @@ int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned
     // on others they're after. So, read biome data, then rewind to find Sections.
     // Format info at http://wiki.vg/Map_Format, though don't trust order.
     biome_save = *pbf->offset;
+    heightmap_save = biome_save;
     memset(biome, 0, 16 * 16);
     int inttype = nbtFindElement(pbf, "Biomes");
     if (inttype != 7) {
@@ -2270,13 +2480,16 @@ int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned
 
 SectionsCode:
 
-    if (makeHash && (formatClass != FORMAT_UP_THROUGH_1_12)) {
-        makeHashTable();
-        makeHash = false;
-    }
-    if (makeBiomeHash && (mcVersion >= 18)) {
-        makeBiomeHashTable();
-        makeBiomeHash = false;
+    {
+        std::lock_guard<std::mutex> lock(hashMutex);
+        if (makeHash && (formatClass != FORMAT_UP_THROUGH_1_12)) {
+            makeHashTable();
+            makeHash = false;
+        }
+        if (makeBiomeHash && (mcVersion >= 18)) {
+            makeBiomeHashTable();
+            makeBiomeHash = false;
+        }
     }
 
     // does Sections have anything inside of it?
@@ -2302,7 +2515,9 @@ SectionsCode:
 
     memset(buff, 0, 16 * 16 * heightAlloc);
     memset(data, 0, 16 * 16 * heightAlloc);
-    memset(blockLight, 0, 16 * 16 * heightAlloc / 2);
+    // block light is optional, read only if there's somewhere to put it
+    if (blockLight != NULL)
+        memset(blockLight, 0, 16 * 16 * heightAlloc / 2);
 
     // the maximum relative height compared to Y, i.e., divided by 16 (not the allocation size, heightAlloc). For 1.18, for example, it should be 20,
     // with minHeight16 being -4
@@ -2390,7 +2605,7 @@ SectionsCode:
                 if (bfread(pbf, thisName, len) < 0)
                     return LINE_ERROR;
                 thisName[len] = 0;
-                if (strcmp(thisName, "BlockLight") == 0)
+                if (blockLight != NULL && strcmp(thisName, "BlockLight") == 0)
                 {
                     //found++;
                     ret = 1;
@@ -2456,7 +2671,7 @@ SectionsCode:
                 if (bfread(pbf, thisName, len) < 0)
                     return LINE_ERROR;
                 thisName[len] = 0;
-                if (strcmp(thisName, "BlockLight") == 0)
+                if (blockLight != NULL && strcmp(thisName, "BlockLight") == 0)
                 {
                     ret = 1;
                     len = readDword(pbf); //array length
@@ -2833,7 +3048,6 @@ SectionsCode:
                     int bitlength = bigbufflen / 64;
                     // is this the new 1.16 20w17a format?
                     bool uncompressed = (bigbufflen > 64 * bitlength);
-                    unsigned long int bitmask = (1 << bitlength) - 1;
 
                     unsigned char* bout = buff + 16 * 16 * 16 * (int)(y - minHeight16);
                     unsigned char* dout = data + 16 * 16 * 16 * (int)(y - minHeight16);
@@ -2844,49 +3058,10 @@ SectionsCode:
                         mfsHeight = sectionHeight;
                     }
 
-                    int bitpull = 0;
-                    for (i = 0; i < 16 * 256; i++, bitpull += bitlength) {
-                        // Pull out bits. Here is the lowest bit's index, if the array is thought of as one long string of bits.
-                        // That is, if you see "5" here, the bits in the 64-bit long long are in order 
-                        // which bb should we access for these bits? Divide by 8
-                    Restart:
-                        int bbindex = bitpull >> 3;
-                        // Have to count from top to bottom 8 bytes of each long long. I suspect if I read the long longs as bytes the order might be right.
-                        // But, this works.
-                        bbindex = (bbindex & 0xfff8) + 7 - (bbindex & 0x7);
-                        int bbshift = bitpull & 0x7;
-                        // get the top bits out of the topmost byte, on down the row
-                        int bits = (bigbuff[bbindex] >> bbshift) & bitmask;
-                        // Check if we got enough bits. If we had only a few bits retrieved, need to get more from the next byte.
-                        // 'While' is needed only when remainingBitLength > 0, as 3 bytes may be needed
-                        int remainingBitLength = bitlength - (8 - bbshift);
-                        while (remainingBitLength > 0) {
-                            if (bbindex & 0x7) {
-                                // one of the middle bytes, not the bottommost one
-                                bits |= (bigbuff[bbindex - 1] << (8 - bbshift)) & bitmask;
-                            }
-                            else {
-                                // Bottommost byte, and not enough bits left: need to jump to topmost byte of next long long and restart.
-                                // If this is the new format and the length of bigbufflen is greater than expected,
-                                // e.g., 5*64 is 320, but might be 342, then we have to add to bitpull (need to make that number
-                                // incremental up above) and pull entirely from the next +15 index, as shown here.
-                                if (uncompressed) {
-                                    // start on next long long
-                                    //bits = bigbuff[bbindex + 15] & bitmask;
-                                    bitpull += (8 - bbshift);
-                                    goto Restart;
-                                    //next iteration it will be: bbshift = 0;
-                                }
-                                else {
-                                    bits |= (bigbuff[bbindex + 15] << (8 - bbshift)) & bitmask;
-                                }
-                            }
-                            // a waste 99% of the time - any faster way? TODO - could unwind loops, could properly track bbindex and bbshift without
-                            // recomputing them each time. Maybe try some timing tests one day to see if it matters.
-                            remainingBitLength -= 8;
-                            bbindex--;
-                            bbshift = 0;
-                        }
+                    unsigned short indices[16 * 16 * 16];
+                    unpackLongArray(bigbuff, bigbufflen, bitlength, uncompressed, 16 * 16 * 16, indices);
+                    for (i = 0; i < 16 * 256; i++) {
+                        int bits = indices[i];
 
                         // sanity check
                         if (bits >= paletteLength) {
@@ -2944,6 +3119,10 @@ SectionsCode:
         // no real data found in the block - this can happen with modded worlds, etc.
         return NBT_NO_SECTIONS;   // means it's empty
     }
+    // 1.13 and on store heightmaps, which save looking for the top of each column later
+    if (surfaceTop != NULL && formatClass != FORMAT_UP_THROUGH_1_12) {
+        surfaceFound = readSurfaceHeights(pbf, heightmap_save, minHeight, heightAlloc, surfaceTop);
+    }
     if (formatClass == FORMAT_UP_THROUGH_1_12) {
         // 1.12 and earlier format - get TileEntities for data about heads, flower pots, standing banners
         if (nbtFindElement(pbf, "TileEntities") != 9)
@@ -3360,6 +3539,7 @@ static int readPalette(int& returnCode, bfFile* pbf, int mcVersion, unsigned cha
 
                         // Name not found for translation, so report an error and add it to the list
                         // is name already in string? Yes, there could be names inside names, but this isn't meant to be thorough.
+                        std::lock_guard<std::mutex> lock(unknownBlockMutex);
                         if (strstr(unknownBlock, unknownName) == NULL) {
                             // name is unique
                             size_t stringLength = strlen(unknownBlock);
@@ -4533,7 +4713,20 @@ static int readPalette(int& returnCode, bfFile* pbf, int mcVersion, unsigned cha
     return 0;
 }
 
-int nbtGetHeights(bfFile* pbf, int& minHeight, int& heightAlloc, int mcVersion)
+// the number of elements in the list about to be read, leaving the file where it was
+static int peekListLength(bfFile* pbf)
+{
+    int save = *pbf->offset;
+    unsigned char type;
+    if (bfread(pbf, &type, 1) < 0)
+        return -1;
+    int len = (int)readDword(pbf);
+    if (bfseek(pbf, save, SEEK_SET) < 0)
+        return -1;
+    return len;
+}
+
+int nbtGetHeights(bfFile* pbf, int& minHeight, int& heightAlloc)
 {
     int len, nsections;
 
@@ -4546,36 +4739,34 @@ int nbtGetHeights(bfFile* pbf, int& minHeight, int& heightAlloc, int mcVersion)
     if (bfseek(pbf, len, SEEK_CUR) < 0)
         return LINE_ERROR; //skip name ()
 
-    int level_save = *pbf->offset;
-    if (nbtFindElement(pbf, "Level") != 10) {
-        // is this 1.18 release or later?
-
-        // if not a 1.17 or earlier "Level" see if it's a newly-converted "sections" type
-        //if (bfseek(pbf, 1, SEEK_CUR) < 0)
-        //    return LINE_ERROR; //skip type
-        //len = readWord(pbf); //name length
-        //if (bfseek(pbf, len, SEEK_CUR) < 0)
-        //    return LINE_ERROR; //skip name ()
-        if (bfseek(pbf, level_save, SEEK_SET) < 0)
-            return LINE_ERROR; //rewind to start of section
-        if (nbtFindElement(pbf, "sections") != 9)
+    // 1.17 and earlier have Level/Sections, 1.18 and later have "sections" at the top. Look for either in a
+    // single pass, as searching for "Level" first would walk (and decompress) the whole of a 1.18+ chunk.
+    char thisName[MAX_NAME_LENGTH];
+    for (;;)
+    {
+        unsigned char rootType = 0;
+        if (bfread(pbf, &rootType, 1) < 0)
+            return LINE_ERROR;
+        if (rootType == 0)
+            return LINE_ERROR;
+        len = readWord(pbf);
+        if (len >= MAX_NAME_LENGTH || bfread(pbf, thisName, len) < 0)
+            return LINE_ERROR;
+        thisName[len] = 0;
+        if (rootType == 10 && strcmp(thisName, "Level") == 0) {
+            if (nbtFindElement(pbf, "Sections") != 9)
+                return LINE_ERROR;
+            break;
+        }
+        if (rootType == 9 && strcmp(thisName, "sections") == 0)
+            break;
+        if (skipType(pbf, rootType) < 0)
             return LINE_ERROR;
-
-        goto SectionsCode;
     }
 
-    if (nbtFindElement(pbf, "Sections") != 9)
-        return LINE_ERROR;
-
-SectionsCode:
-
-    // TODO: it'd be nicer to avoid this code duplication from above, but we
-    // need to read the palette fully currently. We really should just read the number
-    // of palette entries - it's all we need. But, that's trickier and more code.
-    if (makeHash) {
-        makeHashTable();
-        makeHash = false;
-    }
+    // Only the number of palette entries in each section is needed, not the palette itself, so the palettes
+    // and block data are skipped over. When reading from a BF_INFLATE buffer, nothing after the sections
+    // (block entities, heightmaps, structures) is decompressed.
 
     // does Sections have anything inside of it?
     {
@@ -4593,8 +4784,6 @@ SectionsCode:
     if (nsections < 0)
         return LINE_ERROR;
 
-    char thisName[MAX_NAME_LENGTH];
-
     int ret;
     unsigned char type;
     // read all slices that exist for this vertical block and process each
@@ -4616,9 +4805,6 @@ SectionsCode:
         // walk through all elements of each Palette array element
 
         int paletteLength = 0;
-        // could theoretically get higher...
-        unsigned char paletteBlockEntry[MAX_PALETTE];
-        unsigned char paletteDataEntry[MAX_PALETTE];
         for (;;)
         {
             ret = 0;
@@ -4633,13 +4819,10 @@ SectionsCode:
             thisName[len] = 0;
             if (strcmp(thisName, "Palette") == 0)
             {
-                ret = 1;
-
-                int retVal = readPalette(returnCode, pbf, mcVersion, paletteBlockEntry, paletteDataEntry, paletteLength, NULL, 0);
-                // did we hit an error?
-                if (retVal != 0) {
-                    return retVal;
-                }
+                // note the length, then skip it below
+                paletteLength = peekListLength(pbf);
+                if (paletteLength < 0)
+                    return LINE_ERROR;
             }
             // for 1.18:
             else if (strcmp(thisName, "block_states") == 0)
@@ -4650,7 +4833,6 @@ SectionsCode:
                 // folder of two things: palette and data
                 for (;;)
                 {
-                    int subret = 0;
                     type = 0;
                     if (bfread(pbf, &type, 1) < 0)
                         return LINE_ERROR;
@@ -4662,16 +4844,13 @@ SectionsCode:
                     thisName[len] = 0;
                     if (strcmp(thisName, "palette") == 0)
                     {
-                        subret = 1;
-                        int retVal = readPalette(returnCode, pbf, mcVersion, paletteBlockEntry, paletteDataEntry, paletteLength, NULL, 0);
-                        // did we hit an error?
-                        if (retVal != 0) {
-                            return retVal;
-                        }
-                    }
-                    if (!subret)
-                        if (skipType(pbf, type) < 0)
+                        // note the length, then skip it below
+                        paletteLength = peekListLength(pbf);
+                        if (paletteLength < 0)
                             return LINE_ERROR;
+                    }
+                    if (skipType(pbf, type) < 0)
+                        return LINE_ERROR;
                 }
             }
 
@@ -4788,6 +4967,56 @@ int nbtGetFileVersionId(bfFile* pbf, int* versionId)
     return 0;
 }
 
+// A world made with a custom overworld height may have the dimension type itself in level.dat, at
+// Data/WorldGenSettings/dimensions/minecraft:overworld/type, with min_y and height. Usually "type" is
+// instead the name of a built-in or data pack dimension type, a string, and this returns LINE_ERROR.
+int nbtGetLevelHeights(bfFile* pbf, int* minHeight, int* height)
+{
+    int len;
+    bool foundMin = false;
+    bool foundHeight = false;
+    char thisName[MAX_NAME_LENGTH];
+    if (bfseek(pbf, 1, SEEK_CUR) < 0)
+        return LINE_ERROR; //skip type
+    len = readWord(pbf); //name length
+    if (bfseek(pbf, len, SEEK_CUR) < 0)
+        return LINE_ERROR; //skip name ()
+    if (nbtFindElement(pbf, "Data") != 10)
+        return LINE_ERROR;
+    if (nbtFindElement(pbf, "WorldGenSettings") != 10)
+        return LINE_ERROR;
+    if (nbtFindElement(pbf, "dimensions") != 10)
+        return LINE_ERROR;
+    if (nbtFindElement(pbf, "minecraft:overworld") != 10)
+        return LINE_ERROR;
+    if (nbtFindElement(pbf, "type") != 10)
+        return LINE_ERROR;
+    // min_y and height can be in either order, so look at each element
+    for (;;)
+    {
+        unsigned char type = 0;
+        if (bfread(pbf, &type, 1) < 0)
+            return LINE_ERROR;
+        if (type == 0)
+            break;
+        len = readWord(pbf);
+        if (len >= MAX_NAME_LENGTH || bfread(pbf, thisName, len) < 0)
+            return LINE_ERROR;
+        thisName[len] = 0;
+        if (type == 3 && strcmp(thisName, "min_y") == 0) {
+            *minHeight = (int)readDword(pbf);
+            foundMin = true;
+        }
+        else if (type == 3 && strcmp(thisName, "height") == 0) {
+            *height = (int)readDword(pbf);
+            foundHeight = true;
+        }
+        else if (skipType(pbf, type) < 0)
+            return LINE_ERROR;
+    }
+    return (foundMin && foundHeight) ? 0 : LINE_ERROR;
+}
+
 /* currently not used:
 int nbtGetFileVersionName(bfFile* pbf, char* versionName, int stringLength)
 {
@@ -43,7 +43,8 @@ THE POSSIBILITY OF SUCH DAMAGE.
 //#define ZERO_WORLD_HEIGHT(versionID)   ((versionID >= 2685) ? -64 : 0)
 
 
-enum { BF_BUFFER, BF_GZIP };
+// BF_INFLATE is a buffer filled in from a zlib stream only as far as it's read
+enum { BF_BUFFER, BF_GZIP, BF_INFLATE };
 
 // for another 256 block types, this bit gets set in the dataVal field (we're out of bits with block IDs)
 // Note the next-to-highest bit is used for "waterlogged" so should be avoided if that property is part of the block's description
@@ -90,6 +91,10 @@ typedef struct {
     int _offset;
     gzFile gz;
     FILE* fptr;
+    // for BF_INFLATE
+    z_stream* strm;
+    int inflated;   // bytes of buf filled in so far
+    int size;       // size of buf
 } bfFile;
 
 typedef struct BlockEntity {
@@ -107,11 +112,12 @@ typedef struct TranslationTuple {
 } TranslationTuple;
 
 bfFile newNBT(const wchar_t* filename, int* err);
-int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int& mfsHeight, char* unknownBlock, int unknownBlockID);
-int nbtGetHeights(bfFile* pbf, int & minHeight, int & maxHeight, int mcVersion);
+int nbtGetBlocks(bfFile* pbf, unsigned char* buff, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int& mfsHeight, char* unknownBlock, int unknownBlockID, short* surfaceTop, bool& surfaceFound);
+int nbtGetHeights(bfFile* pbf, int & minHeight, int & maxHeight);
 int nbtGetSpawn(bfFile* pbf, int* x, int* y, int* z);
 int nbtGetFileVersion(bfFile* pbf, int* version);
 int nbtGetFileVersionId(bfFile* pbf, int* versionId);
+int nbtGetLevelHeights(bfFile* pbf, int* minHeight, int* height);
 // currently not used: int nbtGetFileVersionName(bfFile* pbf, char* versionName, int stringLength);
 int nbtGetLevelName(bfFile* pbf, char* levelName, int stringLength);
 int nbtGetPlayer(bfFile* pbf, int* px, int* py, int* pz);
@@ -61,6 +61,11 @@ deflated data is the chunk length - 1.
 */
 
 #include "stdafx.h"
+#include <assert.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 #define CHUNK_DEFLATE_MAX (1024 * 1024)  // 1MB limit for compressed chunks
 // had to kick this up due to F Seaworld 1.18 world test
@@ -68,22 +73,17 @@ deflated data is the chunk length - 1.
 
 #define RERROR(x) if(x) { PortaClose(regionFile); return 0; }
 
-static int regionPrepareBuffer(bfFile & bf, wchar_t* directory, int cx, int cz)
+// Read the compressed data for chunk cx, cz into buf, which must be CHUNK_DEFLATE_MAX in size.
+// chunkLength is the length of the data, which starts at buf+5. Returns 1 if found, 0 if not or on error.
+static int regionReadChunk(wchar_t* directory, int cx, int cz, unsigned char* buf, int& chunkLength)
 {
     wchar_t filename[256];
     PORTAFILE regionFile;
 #ifdef WIN32
     DWORD br;
 #endif
-    static unsigned char buf[CHUNK_DEFLATE_MAX];
-    static unsigned char out[CHUNK_INFLATE_MAX];
 
-    int sectorNumber, offset, chunkLength;
-
-    int status;
-
-    static z_stream strm;
-    static int strm_initialized = 0;
+    int sectorNumber, offset;
 
     // open the region file - note we get the new mca 1.2 file type here!
     swprintf_s(filename, 256, L"%sregion/r.%d.%d.mca", directory, cx >> 5, cz >> 5);
@@ -122,17 +122,72 @@ static int regionPrepareBuffer(bfFile & bf, wchar_t* directory, int cx, int cz)
     RERROR(buf[4] != 2);
 
     PortaClose(regionFile);
+    return 1;
+}
+
+// The buffers for reading in and decompressing a chunk. Export reads chunks with several threads at once, so each
+// thread has its own set, chosen by the caller. A set is allocated when first used. Set 0, used by the main thread,
+// is kept; the others are kept until the export is done reading chunks, see regionFreeBuffers().
+typedef struct RegionBuffers {
+    unsigned char* buf;
+    unsigned char* out;
+    z_stream strm;
+    int strm_initialized;
+} RegionBuffers;
+static RegionBuffers gRegionBuffers[REGION_BUFFER_SETS];
+
+static void freeRegionBufferSet(RegionBuffers& rb)
+{
+    if (rb.strm_initialized)
+        inflateEnd(&rb.strm);
+    free(rb.buf);
+    free(rb.out);
+    memset(&rb, 0, sizeof(RegionBuffers));
+}
+
+// free the buffer sets used by the threads reading chunks for export
+void regionFreeBuffers()
+{
+    for (int i = 1; i < REGION_BUFFER_SETS; i++)
+        freeRegionBufferSet(gRegionBuffers[i]);
+}
+
+static int regionPrepareBuffer(bfFile & bf, wchar_t* directory, int cx, int cz, int bufferSet)
+{
+    assert((bufferSet >= 0) && (bufferSet < REGION_BUFFER_SETS));
+    RegionBuffers& rb = gRegionBuffers[bufferSet];
+    z_stream& strm = rb.strm;
+
+    int chunkLength;
+
+    int status;
+
+    if (rb.buf == NULL) {
+        rb.buf = (unsigned char*)malloc(CHUNK_DEFLATE_MAX);
+        rb.out = (unsigned char*)malloc(CHUNK_INFLATE_MAX);
+        if (rb.buf == NULL || rb.out == NULL) {
+            free(rb.buf);
+            free(rb.out);
+            rb.buf = rb.out = NULL;
+            return 0;
+        }
+    }
+    unsigned char* buf = rb.buf;
+    unsigned char* out = rb.out;
+
+    if (!regionReadChunk(directory, cx, cz, buf, chunkLength))
+        return 0;
 
     // decompress chunk
 
 
-    if (!strm_initialized) {
+    if (!rb.strm_initialized) {
         // we re-use dynamically allocated memory
         strm.zalloc = (alloc_func)NULL;
         strm.zfree = (free_func)NULL;
         strm.opaque = NULL;
         inflateInit(&strm);
-        strm_initialized = 1;
+        rb.strm_initialized = 1;
     }
 
     strm.next_out = out;
@@ -160,32 +215,388 @@ static int regionPrepareBuffer(bfFile & bf, wchar_t* directory, int cx, int cz)
 // directory: the base world directory, e.g. "/home/ryan/.minecraft/saves/World1/" - note the trailing "/" is in place
 // cx, cz: the chunk's x and z offset
 // block: a 32KB buffer to write block data into
-// blockLight: a 16KB buffer to write block light into (not skylight)
+// blockLight: a 16KB buffer to write block light into (not skylight), or NULL to skip reading it
+// surfaceTop: 16x16 levels of the highest non-air block in each column, from the chunk's heightmap, if surfaceFound is set
+// bufferSet: which set of buffers to read the chunk with, 0 for the main thread, else one per thread reading chunks
 //
 // returns 1 on success, 0 on error or nothing found
-int regionGetBlocks(wchar_t* directory, int cx, int cz, unsigned char* block, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int & mfsHeight, char* unknownBlock, int unknownBlockID)
+int regionGetBlocks(wchar_t* directory, int cx, int cz, unsigned char* block, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int & mfsHeight, char* unknownBlock, int unknownBlockID, short* surfaceTop, bool& surfaceFound, int bufferSet)
 {
     bfFile bf;
 
-    int errCode = regionPrepareBuffer(bf, directory, cx, cz);
+    surfaceFound = false;
+
+    int errCode = regionPrepareBuffer(bf, directory, cx, cz, bufferSet);
     if (errCode <= 0) {
         // failed
         return errCode < 0 ? ERROR_INFLATE : 0;
     }
 
-    return nbtGetBlocks(&bf, block, data, blockLight, biome, entities, numEntities, mcVersion, minHeight, maxHeight, mfsHeight, unknownBlock, unknownBlockID);
+    return nbtGetBlocks(&bf, block, data, blockLight, biome, entities, numEntities, mcVersion, minHeight, maxHeight, mfsHeight, unknownBlock, unknownBlockID, surfaceTop, surfaceFound);
 }
 
-int regionTestHeights(wchar_t* directory, int& minHeight, int& maxHeight, int mcVersion, int cx, int cz)
+// Find the range of section heights in a chunk. This is done when a world is opened, so to be quick the chunk
+// is decompressed only as far as needed to get through its sections, and palettes are skipped, not read.
+int regionTestHeights(wchar_t* directory, int& minHeight, int& maxHeight, int cx, int cz)
 {
     bfFile bf;
+    z_stream strm;
+    int chunkLength;
+
+    // allocated here, as this is done just a few times, so the memory's not needed afterwards
+    unsigned char* buf = (unsigned char*)malloc(CHUNK_DEFLATE_MAX);
+    unsigned char* out = (unsigned char*)malloc(CHUNK_INFLATE_MAX);
+    if (buf == NULL || out == NULL) {
+        free(buf);
+        free(out);
+        return 0;
+    }
 
-    int errCode = regionPrepareBuffer(bf, directory, cx, cz);
-    if (errCode <= 0) {
-        // failed
-        return errCode < 0 ? ERROR_INFLATE : 0;
+    if (!regionReadChunk(directory, cx, cz, buf, chunkLength)) {
+        free(buf);
+        free(out);
+        return 0;
+    }
+
+    memset(&strm, 0, sizeof(z_stream));
+    if (inflateInit(&strm) != Z_OK) {
+        free(buf);
+        free(out);
+        return ERROR_INFLATE;
+    }
+    strm.avail_in = chunkLength - 1;
+    strm.next_in = buf + 5;
+
+    memset(&bf, 0, sizeof(bfFile));
+    bf.type = BF_INFLATE;
+    bf.buf = out;
+    bf._offset = 0;
+    bf.offset = &bf._offset;
+    bf.strm = &strm;
+    bf.inflated = 0;
+    bf.size = CHUNK_INFLATE_MAX;
+
+    int retCode = nbtGetHeights(&bf, minHeight, maxHeight);
+
+    inflateEnd(&strm);
+    free(buf);
+    free(out);
+    return retCode;
+}
+
+
+// how often, at most, a region file is looked at again to see if it's been saved since its header was read
+#define INVENTORY_RECHECK_MS    1000
+
+// A region file found by regionScanInventory, to be read by one of the threads
+typedef struct RegionScanJob {
+    wchar_t filename[MAX_PATH_AND_FILE];
+    int rx, rz;
+    long long modified;
+    RegionInventory* region;
+} RegionScanJob;
+
+static long long inventoryClock()
+{
+    return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifndef WIN32
+// Go on to the next file in the directory matching the pattern; returns false if there are no more.
+static bool portaFindMatch(PortaFindData* fd)
+{
+    size_t prefixLength = strlen(fd->prefix);
+    size_t suffixLength = strlen(fd->suffix);
+    struct dirent* entry;
+    while ((entry = readdir(fd->dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if ((length < prefixLength + suffixLength) || (!fd->wildcard && length != prefixLength) ||
+            strncmp(entry->d_name, fd->prefix, prefixLength) != 0 || strcmp(entry->d_name + length - suffixLength, fd->suffix) != 0)
+            continue;
+        char path[2 * MAX_PATH_AND_FILE];
+        snprintf(path, 2 * MAX_PATH_AND_FILE, "%s%s", fd->directory, entry->d_name);
+        if (stat(path, &fd->st) != 0 || mbstowcs(fd->name, entry->d_name, MAX_PATH_AND_FILE) == (size_t)-1)
+            continue;
+        fd->name[MAX_PATH_AND_FILE - 1] = (wchar_t)0;
+        return true;
+    }
+    return false;
+}
+
+// The first file matching the pattern, which may have one '*' in the file name. Returns NULL if there are none,
+// else fd, which is then the handle to pass to PortaFindClose().
+PortaFindData* portaFindFirst(const wchar_t* pattern, PortaFindData* fd)
+{
+    char path[MAX_PATH_AND_FILE];
+    if (wcstombs(path, pattern, MAX_PATH_AND_FILE) == (size_t)-1)
+        return NULL;
+    path[MAX_PATH_AND_FILE - 1] = (char)0;
+
+    // split into the directory, with its trailing '/', and the file name before and after the '*'
+    char* name = strrchr(path, '/');
+    name = (name == NULL) ? path : name + 1;
+    char* star = strchr(name, '*');
+    fd->wildcard = (star != NULL);
+    if (star != NULL) {
+        strcpy(fd->suffix, star + 1);
+        *star = (char)0;
+    }
+    else {
+        fd->suffix[0] = (char)0;
     }
+    strcpy(fd->prefix, name);
+    *name = (char)0;
+    strcpy(fd->directory, path);
+
+    fd->dir = opendir((fd->directory[0] == (char)0) ? "." : fd->directory);
+    if (fd->dir == NULL)
+        return NULL;
+    if (!portaFindMatch(fd)) {
+        closedir(fd->dir);
+        return NULL;
+    }
+    return fd;
+}
 
-    return nbtGetHeights(&bf, minHeight, maxHeight, mcVersion);
+bool portaFindNext(PortaFindData* fd)
+{
+    return portaFindMatch(fd);
+}
+#endif
+
+// the last write time of a file, or 0 if it's not there
+static long long regionFileModified(const wchar_t* filename)
+{
+    PORTAFIND_DATA fd;
+    PORTAFIND hFind = PortaFindFirst(filename, fd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return 0;
+    long long modified = PortaFindModified(fd);
+    PortaFindClose(hFind);
+    return modified;
 }
 
+// Read the 8KB header of a region file, noting which chunks are present. A missing or empty file has no chunks.
+// The chunk-present bits are decoded first and then stored a word at a time; the words are atomic, as export threads
+// may be looking at them when regionChunkPresent() reads a region again.
+static void regionReadInventory(const wchar_t* filename, RegionInventory* region)
+{
+    static const int HEADER_SIZE = 8192;
+    unsigned char header[HEADER_SIZE];
+    unsigned int present[32];
+    PORTAFILE regionFile;
+#ifdef WIN32
+    DWORD br;
+#endif
+
+    memset(present, 0, sizeof(present));
+    memset(region->timestamp, 0, sizeof(region->timestamp));
+    memset(region->sectors, 0, sizeof(region->sectors));
+
+    // a missing file, or one shorter than the header, reads as no chunks for whatever's not there
+    memset(header, 0, HEADER_SIZE);
+    regionFile = PortaOpen(filename);
+    if (regionFile != INVALID_HANDLE_VALUE) {
+        PortaRead(regionFile, header, HEADER_SIZE);
+        PortaClose(regionFile);
+    }
+
+    for (int i = 0; i < 32 * 32; i++) {
+        unsigned char* loc = header + 4 * i;
+        int offset = (loc[0] << 16) | (loc[1] << 8) | loc[2];
+        // the first two sectors are the header itself, so anything pointing there is bogus
+        if (offset >= 2 && loc[3] > 0) {
+            unsigned char* time = header + 4096 + 4 * i;
+            present[i >> 5] |= 1u << (i & 31);
+            region->timestamp[i] = ((unsigned int)time[0] << 24) | (time[1] << 16) | (time[2] << 8) | time[3];
+            region->sectors[i] = loc[3];
+        }
+    }
+    for (int w = 0; w < 32; w++) {
+        region->present[w] = present[w];
+    }
+}
+
+// total up the chunks saved in the regions of a dimension, and find their bounds
+static void totalInventory(ChunkInventory* inv)
+{
+    inv->numChunks = 0;
+    inv->compressedBytes = 0;
+    for (int r = 0; r < inv->numRegions; r++) {
+        RegionInventory* region = &inv->regions[r];
+        for (int i = 0; i < 32 * 32; i++) {
+            if (region->present[i >> 5] & (1u << (i & 31))) {
+                int cx = region->rx * 32 + (i & 31);
+                int cz = region->rz * 32 + (i >> 5);
+                if (inv->numChunks == 0) {
+                    inv->minCX = inv->maxCX = cx;
+                    inv->minCZ = inv->maxCZ = cz;
+                }
+                else {
+                    if (inv->minCX > cx) inv->minCX = cx;
+                    if (inv->maxCX < cx) inv->maxCX = cx;
+                    if (inv->minCZ > cz) inv->minCZ = cz;
+                    if (inv->maxCZ < cz) inv->maxCZ = cz;
+                }
+                inv->numChunks++;
+                inv->compressedBytes += 4096 * (long long)region->sectors[i];
+            }
+        }
+    }
+}
+
+static int compareRegions(const void* a, const void* b)
+{
+    const RegionInventory* ra = (const RegionInventory*)a;
+    const RegionInventory* rb = (const RegionInventory*)b;
+    if (ra->rz != rb->rz)
+        return (ra->rz < rb->rz) ? -1 : 1;
+    if (ra->rx != rb->rx)
+        return (ra->rx < rb->rx) ? -1 : 1;
+    return 0;
+}
+
+// Find which chunks exist in each directory (a world or DIM-1 or DIM1 directory, ending in a separator), reading
+// just the headers of the region files. The files of all the directories are read in parallel, as there can be
+// thousands of them. Any previous contents of the inventories are freed. Returns the total number of chunks found,
+// or -1 if out of memory.
+int regionScanInventory(wchar_t** directories, ChunkInventory* inventories, int numDirectories)
+{
+    int d, i;
+    int numJobs = 0;
+    int maxJobs = 0;
+    RegionScanJob* jobs = NULL;
+
+    for (d = 0; d < numDirectories; d++) {
+        regionFreeInventory(&inventories[d]);
+    }
+
+    // list the region files; each inventory gets an array of regions, filled in below
+    for (d = 0; d < numDirectories; d++) {
+        wchar_t search[MAX_PATH_AND_FILE];
+        PORTAFIND_DATA fd;
+        swprintf_s(search, MAX_PATH_AND_FILE, L"%sregion/r.*.mca", directories[d]);
+        PORTAFIND hFind = PortaFindFirst(search, fd);
+        if (hFind == INVALID_HANDLE_VALUE)
+            continue;
+        int firstJob = numJobs;
+        do {
+            int rx, rz;
+            if (PortaFindIsDirectory(fd) || swscanf_s(PortaFindName(fd), L"r.%d.%d.mca", &rx, &rz) != 2)
+                continue;
+            if (numJobs == maxJobs) {
+                maxJobs = (maxJobs == 0) ? 256 : maxJobs * 2;
+                RegionScanJob* newJobs = (RegionScanJob*)realloc(jobs, maxJobs * sizeof(RegionScanJob));
+                if (newJobs == NULL) {
+                    PortaFindClose(hFind);
+                    free(jobs);
+                    return -1;
+                }
+                jobs = newJobs;
+            }
+            swprintf_s(jobs[numJobs].filename, MAX_PATH_AND_FILE, L"%sregion/%s", directories[d], PortaFindName(fd));
+            jobs[numJobs].rx = rx;
+            jobs[numJobs].rz = rz;
+            jobs[numJobs].modified = PortaFindModified(fd);
+            numJobs++;
+            inventories[d].numRegions++;
+        } while (PortaFindNext(hFind, fd));
+        PortaFindClose(hFind);
+
+        if (inventories[d].numRegions > 0) {
+            inventories[d].regions = (RegionInventory*)malloc(inventories[d].numRegions * sizeof(RegionInventory));
+            if (inventories[d].regions == NULL) {
+                inventories[d].numRegions = 0;
+                free(jobs);
+                return -1;
+            }
+            long long now = inventoryClock();
+            for (i = firstJob; i < numJobs; i++) {
+                jobs[i].region = &inventories[d].regions[i - firstJob];
+                jobs[i].region->rx = jobs[i].rx;
+                jobs[i].region->rz = jobs[i].rz;
+                jobs[i].region->modified = jobs[i].modified;
+                jobs[i].region->checked = now;
+            }
+        }
+    }
+
+    // the work is mostly waiting on the disk, so more threads than cores would be fine, but there's little gain
+    if (numJobs > 0) {
+        std::atomic<int> nextJob(0);
+        int numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads < 1)
+            numThreads = 1;
+        if (numThreads > 8)
+            numThreads = 8;
+        if (numThreads > numJobs)
+            numThreads = numJobs;
+        auto worker = [&]() {
+            int job;
+            while ((job = nextJob++) < numJobs) {
+                regionReadInventory(jobs[job].filename, jobs[job].region);
+            }
+        };
+        std::thread* threads = new std::thread[numThreads - 1];
+        for (i = 0; i < numThreads - 1; i++) {
+            threads[i] = std::thread(worker);
+        }
+        // this thread helps, too
+        worker();
+        for (i = 0; i < numThreads - 1; i++) {
+            threads[i].join();
+        }
+        delete[] threads;
+    }
+    free(jobs);
+
+    // sort for lookup and total things up
+    int totalChunks = 0;
+    for (d = 0; d < numDirectories; d++) {
+        ChunkInventory* inv = &inventories[d];
+        qsort(inv->regions, inv->numRegions, sizeof(RegionInventory), compareRegions);
+        totalInventory(inv);
+        totalChunks += inv->numChunks;
+    }
+    return totalChunks;
+}
+
+void regionFreeInventory(ChunkInventory* inventory)
+{
+    free(inventory->regions);
+    memset(inventory, 0, sizeof(ChunkInventory));
+}
+
+// Whether a chunk is saved in the region files of the dimension in "directory", going by their headers. If the header
+// said the chunk wasn't there, and the region file has been written since, e.g., by Minecraft saving the world while
+// Mineways is running, its header is read again - looked at no more than every INVENTORY_RECHECK_MS for each region.
+// Region files that are new since the scan are not looked for; reloading the world finds them.
+bool regionChunkPresent(ChunkInventory* inventory, const wchar_t* directory, int cx, int cz)
+{
+    RegionInventory key;
+    key.rx = cx >> 5;
+    key.rz = cz >> 5;
+    RegionInventory* region = (RegionInventory*)bsearch(&key, inventory->regions, inventory->numRegions, sizeof(RegionInventory), compareRegions);
+    if (region == NULL)
+        return false;
+    int i = (cx & 31) + (cz & 31) * 32;
+    if (region->present[i >> 5] & (1u << (i & 31)))
+        return true;
+
+    // several export threads can be asking at once
+    static std::mutex recheckMutex;
+    std::lock_guard<std::mutex> lock(recheckMutex);
+    long long now = inventoryClock();
+    if (now - region->checked >= INVENTORY_RECHECK_MS) {
+        region->checked = now;
+        wchar_t filename[MAX_PATH_AND_FILE];
+        swprintf_s(filename, MAX_PATH_AND_FILE, L"%sregion/r.%d.%d.mca", directory, region->rx, region->rz);
+        long long modified = regionFileModified(filename);
+        if (modified != region->modified) {
+            region->modified = modified;
+            regionReadInventory(filename, region);
+            totalInventory(inventory);
+        }
+    }
+    return (region->present[i >> 5] & (1u << (i & 31))) != 0;
+}
@@ -28,7 +28,35 @@ THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
-#define ERROR_INFLATE	-9876
+#include <atomic>
 
-int regionGetBlocks(wchar_t* directory, int cx, int cz, unsigned char* block, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int& mfsHeight, char* unknownBlock, int unknownBlockID);
-int regionTestHeights(wchar_t* directory, int& minHeight, int& maxHeight, int mcVersion, int cx, int cz);
+#define ERROR_INFLATE	-9876
+// how many threads can read chunks at once, each with its own set of buffers
+#define REGION_BUFFER_SETS  16
+
+int regionGetBlocks(wchar_t* directory, int cx, int cz, unsigned char* block, unsigned char* data, unsigned char* blockLight, unsigned char* biome, BlockEntity* entities, int* numEntities, int mcVersion, int minHeight, int maxHeight, int& mfsHeight, char* unknownBlock, int unknownBlockID, short* surfaceTop, bool& surfaceFound, int bufferSet);
+void regionFreeBuffers();
+int regionTestHeights(wchar_t* directory, int& minHeight, int& maxHeight, int cx, int cz);
+
+// Which chunks are saved in one region file, read from its 8KB header
+typedef struct RegionInventory {
+    int rx, rz;                         // region coordinates, i.e., chunk coordinates >> 5
+    std::atomic<unsigned int> present[32];  // a bit per chunk, bit (cx & 31) of present[cz & 31], see regionReadInventory()
+    unsigned int timestamp[32 * 32];    // last time saved, in seconds since Jan 1, 1970; index (cx & 31) + (cz & 31) * 32
+    unsigned char sectors[32 * 32];     // compressed size, in 4KB sectors
+    long long modified;                 // region file's last write time when the header was read
+    long long checked;                  // when the file's write time was last looked at, in milliseconds
+} RegionInventory;
+
+// Which chunks are saved in a dimension's region directory
+typedef struct ChunkInventory {
+    int numRegions;
+    RegionInventory* regions;           // sorted by rz, then rx
+    int numChunks;
+    long long compressedBytes;          // sum of sectors used, times 4KB
+    int minCX, minCZ, maxCX, maxCZ;     // chunk bounds, valid only if numChunks > 0
+} ChunkInventory;
+
+int regionScanInventory(wchar_t** directories, ChunkInventory* inventories, int numDirectories);
+void regionFreeInventory(ChunkInventory* inventory);
+bool regionChunkPresent(ChunkInventory* inventory, const wchar_t* directory, int cx, int cz);
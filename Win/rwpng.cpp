@@ -155,6 +155,217 @@ void writepng_cleanup(progimage_info *im)
     im->image_data.clear();
 }
 
+// Streaming PNG output. lodepng wants the whole image in memory, which is a problem for huge map exports,
+// so here we write the chunks ourselves: IHDR, then IDAT chunks as zlib fills its buffer, then IEND.
+
+#define PNGSTREAM_IDAT_SIZE (256*1024)
+
+static void pngStreamPutU32(unsigned char* dst, unsigned int val)
+{
+    dst[0] = (unsigned char)(val >> 24);
+    dst[1] = (unsigned char)(val >> 16);
+    dst[2] = (unsigned char)(val >> 8);
+    dst[3] = (unsigned char)val;
+}
+
+static int pngStreamWriteChunk(pngstream_info* ps, const char* type, unsigned char* data, unsigned int len)
+{
+    unsigned char header[8];
+    unsigned char trailer[4];
+    pngStreamPutU32(header, len);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, header + 4, 4);
+    if (len > 0) {
+        crc = crc32(crc, data, len);
+    }
+    pngStreamPutU32(trailer, (unsigned int)crc);
+
+    if (fwrite(header, 8, 1, ps->fptr) != 1 ||
+        (len > 0 && fwrite(data, len, 1, ps->fptr) != 1) ||
+        fwrite(trailer, 4, 1, ps->fptr) != 1) {
+        ps->error = PNGSTREAM_WRITE_FAILED;
+    }
+    return ps->error;
+}
+
+// run deflate, writing out an IDAT each time the output buffer fills
+static int pngStreamDeflate(pngstream_info* ps, int flush)
+{
+    int zerr;
+    do {
+        zerr = deflate(&ps->zs, flush);
+        if (zerr == Z_STREAM_ERROR) {
+            ps->error = PNGSTREAM_ZLIB_FAILED;
+            return ps->error;
+        }
+        unsigned int have = PNGSTREAM_IDAT_SIZE - ps->zs.avail_out;
+        if (ps->zs.avail_out == 0 || (flush == Z_FINISH && have > 0)) {
+            if (pngStreamWriteChunk(ps, "IDAT", &ps->deflateBuf[0], have)) {
+                return ps->error;
+            }
+            ps->zs.next_out = &ps->deflateBuf[0];
+            ps->zs.avail_out = PNGSTREAM_IDAT_SIZE;
+        }
+        // keep going while zlib filled the whole buffer, or until it says it's all done when finishing
+    } while ((flush == Z_FINISH) ? (zerr != Z_STREAM_END) : (ps->zs.avail_in > 0));
+    return 0;
+}
+
+static int pngPaeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+// return 0 on success
+int writepngStreamOpen(pngstream_info* ps, int width, int height, int channels, wchar_t* filename)
+{
+    unsigned char ihdr[13];
+    static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+    assert(channels == 1 || channels == 3 || channels == 4);
+    ps->width = width;
+    ps->height = height;
+    ps->channels = channels;
+    ps->rowsWritten = 0;
+    ps->error = 0;
+
+    errno_t err = _wfopen_s(&ps->fptr, filename, L"wb");
+    if (err != 0 || ps->fptr == NULL) {
+        ps->fptr = NULL;
+        ps->error = PNGSTREAM_CANNOT_OPEN;
+        return ps->error;
+    }
+
+    memset(&ps->zs, 0, sizeof(z_stream));
+    if (deflateInit(&ps->zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        fclose(ps->fptr);
+        ps->fptr = NULL;
+        ps->error = PNGSTREAM_ZLIB_FAILED;
+        return ps->error;
+    }
+
+    size_t rowBytes = (size_t)width * channels;
+    ps->prevRow.assign(rowBytes, 0x0);
+    ps->filterRows.resize(5 * (rowBytes + 1));
+    ps->deflateBuf.resize(PNGSTREAM_IDAT_SIZE);
+    ps->zs.next_out = &ps->deflateBuf[0];
+    ps->zs.avail_out = PNGSTREAM_IDAT_SIZE;
+
+    pngStreamPutU32(ihdr, (unsigned int)width);
+    pngStreamPutU32(ihdr + 4, (unsigned int)height);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = (unsigned char)((channels == 4) ? 6 : ((channels == 3) ? 2 : 0));    // color type
+    ihdr[10] = 0;   // compression
+    ihdr[11] = 0;   // filter
+    ihdr[12] = 0;   // no interlace
+
+    if (fwrite(signature, 8, 1, ps->fptr) != 1) {
+        ps->error = PNGSTREAM_WRITE_FAILED;
+    }
+    else {
+        pngStreamWriteChunk(ps, "IHDR", ihdr, 13);
+    }
+    if (ps->error) {
+        deflateEnd(&ps->zs);
+        fclose(ps->fptr);
+        ps->fptr = NULL;
+    }
+    return ps->error;
+}
+
+// Add the next numRows rows, tightly packed, width * channels bytes per row.
+// Each row gets whichever of the five PNG filters gives the smallest sum of absolute differences,
+// the same heuristic lodepng uses by default, so file sizes are about what writepng() gives.
+int writepngStreamRows(pngstream_info* ps, unsigned char* rows, int numRows)
+{
+    if (ps->error) {
+        return ps->error;
+    }
+    if (ps->rowsWritten + numRows > ps->height) {
+        ps->error = PNGSTREAM_BAD_ROWS;
+        return ps->error;
+    }
+
+    int bpp = ps->channels;
+    size_t rowBytes = (size_t)ps->width * bpp;
+    for (int row = 0; row < numRows; row++) {
+        unsigned char* cur = rows + row * rowBytes;
+        unsigned char* prev = &ps->prevRow[0];
+        unsigned char* bestRow = NULL;
+        unsigned long bestSum = 0;
+        for (int filter = 0; filter < 5; filter++) {
+            unsigned char* out = &ps->filterRows[filter * (rowBytes + 1)];
+            unsigned long sum = 0;
+            out[0] = (unsigned char)filter;
+            for (size_t i = 0; i < rowBytes; i++) {
+                int a = (i >= (size_t)bpp) ? cur[i - bpp] : 0;
+                int b = prev[i];
+                int c = (i >= (size_t)bpp) ? prev[i - bpp] : 0;
+                unsigned char val;
+                switch (filter) {
+                default:
+                case 0: val = cur[i]; break;
+                case 1: val = (unsigned char)(cur[i] - a); break;
+                case 2: val = (unsigned char)(cur[i] - b); break;
+                case 3: val = (unsigned char)(cur[i] - ((a + b) >> 1)); break;
+                case 4: val = (unsigned char)(cur[i] - pngPaeth(a, b, c)); break;
+                }
+                out[i + 1] = val;
+                sum += (filter == 0) ? val : (unsigned long)abs((signed char)val);
+            }
+            if (bestRow == NULL || sum < bestSum) {
+                bestRow = out;
+                bestSum = sum;
+            }
+        }
+
+        ps->zs.next_in = bestRow;
+        ps->zs.avail_in = (uInt)(rowBytes + 1);
+        if (pngStreamDeflate(ps, Z_NO_FLUSH)) {
+            return ps->error;
+        }
+        memcpy(prev, cur, rowBytes);
+    }
+    ps->rowsWritten += numRows;
+    return 0;
+}
+
+// finish compression, write the IEND, close the file; return 0 on success.
+// Call this even after an error, so that everything gets released.
+int writepngStreamClose(pngstream_info* ps)
+{
+    if (ps->fptr == NULL) {
+        // never opened, or already closed
+        return ps->error;
+    }
+    if (!ps->error) {
+        if (ps->rowsWritten != ps->height) {
+            ps->error = PNGSTREAM_BAD_ROWS;
+        }
+        else if (!pngStreamDeflate(ps, Z_FINISH)) {
+            pngStreamWriteChunk(ps, "IEND", NULL, 0);
+        }
+    }
+    deflateEnd(&ps->zs);
+    if (fclose(ps->fptr) != 0 && !ps->error) {
+        ps->error = PNGSTREAM_WRITE_FAILED;
+    }
+    ps->fptr = NULL;
+    ps->prevRow.clear();
+    ps->filterRows.clear();
+    ps->deflateBuf.clear();
+    return ps->error;
+}
+
 progimage_info* allocateGrayscaleImage(progimage_info* source_ptr)
 {
     // allocate output image and fill it up
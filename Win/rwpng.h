@@ -28,6 +28,7 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "lodepng.h"
+#include "zlib.h"
 
 typedef struct _progimage_info {
     std::vector<unsigned char> image_data; //the raw pixels
@@ -42,6 +43,31 @@ int readpngheader(progimage_info* im, wchar_t* filename, LodePNGColorType& color
 int writepng(progimage_info *mainprog_ptr, int channels, wchar_t *filename);
 void writepng_cleanup(progimage_info *mainprog_ptr);
 
+// Incremental PNG writer: open with the full image size, then feed it rows top to bottom in as many
+// calls as you like, then close. Only one row of history is kept, so memory use is independent of image height.
+typedef struct _pngstream_info {
+    FILE* fptr = NULL;
+    z_stream zs;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int rowsWritten = 0;
+    int error = 0;
+    std::vector<unsigned char> prevRow;     // previous unfiltered row, for the Up/Average/Paeth filters
+    std::vector<unsigned char> filterRows;  // five candidate filtered rows, each with its filter type byte
+    std::vector<unsigned char> deflateBuf;  // compressed data waiting to go out as an IDAT chunk
+} pngstream_info;
+
+// errors returned, beyond zlib's own
+#define PNGSTREAM_CANNOT_OPEN   1
+#define PNGSTREAM_WRITE_FAILED  2
+#define PNGSTREAM_ZLIB_FAILED   3
+#define PNGSTREAM_BAD_ROWS      4
+
+int writepngStreamOpen(pngstream_info* ps, int width, int height, int channels, wchar_t* filename);
+int writepngStreamRows(pngstream_info* ps, unsigned char* rows, int numRows);
+int writepngStreamClose(pngstream_info* ps);
+
 progimage_info* allocateGrayscaleImage(progimage_info* source_ptr);
 progimage_info* allocateRGBImage(progimage_info* source_ptr);
 void copyOneChannel(progimage_info* dst, int channel, progimage_info* src, LodePNGColorType colortype);
@@ -97,6 +97,15 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #define PortaRead(h,buf,len) !ReadFile(h,buf,len,&br,NULL)
 #define PortaWrite(h,buf,len) !WriteFile(h,buf,(DWORD)len,&br,NULL)
 #define PortaClose(h) CloseHandle(h)
+// listing the files matching a pattern, e.g., "region/r.*.mca"
+#define PORTAFIND HANDLE
+#define PORTAFIND_DATA WIN32_FIND_DATAW
+#define PortaFindFirst(pattern,fd) FindFirstFileW(pattern,&(fd))
+#define PortaFindNext(h,fd) (FindNextFileW(h,&(fd))!=0)
+#define PortaFindClose(h) FindClose(h)
+#define PortaFindName(fd) ((fd).cFileName)
+#define PortaFindIsDirectory(fd) (((fd).dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)!=0)
+#define PortaFindModified(fd) (((long long)(fd).ftLastWriteTime.dwHighDateTime << 32) | (long long)(fd).ftLastWriteTime.dwLowDateTime)
 #endif
 
 #ifndef WIN32
@@ -111,6 +120,31 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #define PortaRead(h,buf,len) fread(buf,len,1,h)!=1
 #define PortaWrite(h,buf,len) fwrite(buf,len,1,h)!=1
 #define PortaClose(h) fclose(h)
+// fopen() and portaFindFirst() return NULL on failure
+#define INVALID_HANDLE_VALUE NULL
+// listing the files matching a pattern, e.g., "region/r.*.mca", which may have one '*' in the file name: the
+// directory is read with opendir() and each file matching is looked at with stat(), see portaFindFirst() in region.cpp
+#include <dirent.h>
+#include <sys/stat.h>
+typedef struct PortaFindData {
+    DIR* dir;
+    char directory[MAX_PATH_AND_FILE];
+    char prefix[MAX_PATH_AND_FILE];     // the file name before the '*', or the whole name if there's none
+    char suffix[MAX_PATH_AND_FILE];     // the file name after the '*'
+    bool wildcard;
+    wchar_t name[MAX_PATH_AND_FILE];    // the file found
+    struct stat st;
+} PortaFindData;
+PortaFindData* portaFindFirst(const wchar_t* pattern, PortaFindData* fd);
+bool portaFindNext(PortaFindData* fd);
+#define PORTAFIND PortaFindData*
+#define PORTAFIND_DATA PortaFindData
+#define PortaFindFirst(pattern,fd) portaFindFirst(pattern,&(fd))
+#define PortaFindNext(h,fd) portaFindNext(&(fd))
+#define PortaFindClose(h) closedir((h)->dir)
+#define PortaFindName(fd) ((fd).name)
+#define PortaFindIsDirectory(fd) S_ISDIR((fd).st.st_mode)
+#define PortaFindModified(fd) ((long long)(fd).st.st_mtime)
 #endif
 
 #if __STDC_VERSION__ >= 199901L